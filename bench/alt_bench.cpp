@@ -0,0 +1,196 @@
+/**
+ * @file alt_bench.cpp
+ * @brief Compares Dijkstra, bidirectional and ALT point-to-point queries on the Paris network and on
+ * synthetic multi-city networks, before and after slowing connections down.
+ */
+
+#include "../src/MetroNetworkParser.hpp"
+#include "../src/Navigation.hpp"
+#include "../src/Landmarks.hpp"
+
+#include <chrono>
+#include <random>
+#include <cstdlib>
+#include <iomanip>
+
+/**
+ * @brief Builds a multi-city network: square grid cities in a row, linked by a few long intercity connections.
+ * @param cities The number of cities.
+ * @param side The number of nodes per row and column of each city.
+ * @param seed The seed of the durations: uniform in [30, 480] seconds inside cities like c.csv, [1800, 3600] between them.
+ * @return The graph.
+ */
+std::shared_ptr<const travel::Graph> make_cities(uint32_t cities, uint32_t side, uint32_t seed)
+{
+    std::mt19937 random(seed);
+    std::uniform_int_distribution<uint64_t> local(30, 480), intercity(1800, 3600);
+    std::uniform_int_distribution<uint32_t> cell(0, side - 1);
+    std::unordered_map<uint64_t, std::unordered_map<uint64_t, uint64_t>> connections;
+    const uint64_t city_size = uint64_t(side) * side;
+    connections.reserve(cities * city_size);
+    for (uint32_t city = 0; city < cities; ++city)
+    {
+        const uint64_t first = city * city_size;
+        for (uint32_t r = 0; r < side; ++r)
+        {
+            for (uint32_t c = 0; c < side; ++c)
+            {
+                uint64_t id = first + uint64_t(r) * side + c;
+                if (c + 1 < side)
+                {
+                    connections[id][id + 1] = local(random);
+                    connections[id + 1][id] = local(random);
+                }
+                if (r + 1 < side)
+                {
+                    connections[id][id + side] = local(random);
+                    connections[id + side][id] = local(random);
+                }
+            }
+        }
+        if (city + 1 < cities)
+        {
+            for (int link = 0; link < 3; ++link)
+            {
+                uint64_t from = first + uint64_t(cell(random)) * side + cell(random);
+                uint64_t to = first + city_size + uint64_t(cell(random)) * side + cell(random);
+                uint64_t duration = intercity(random);
+                connections[from][to] = duration;
+                connections[to][from] = duration;
+            }
+        }
+    }
+    return std::make_shared<const travel::Graph>(connections, std::vector<uint64_t>());
+}
+
+/**
+ * @brief Slows a tenth of the connections down by up to 10 minutes, like a live disruption update.
+ * @param base The graph as loaded.
+ * @param seed The seed of the delays.
+ * @return A copy of the graph with the same dense indices.
+ */
+std::shared_ptr<const travel::Graph> slow_down(const travel::Graph& base, uint32_t seed)
+{
+    std::mt19937 random(seed);
+    std::uniform_int_distribution<uint32_t> delay(1, 600);
+    std::vector<std::pair<uint32_t, uint32_t>> overrides;
+    for (uint32_t e = 0; e < base.edge_count(); ++e)
+    {
+        if (random() % 10 == 0)
+        {
+            overrides.emplace_back(e, base.weight(e) + delay(random));
+        }
+    }
+    return std::make_shared<const travel::Graph>(base, overrides);
+}
+
+/**
+ * @brief Times point-to-point queries with every search on a graph, checking that they agree.
+ * @param label The name of the network.
+ * @param base The graph the landmarks are computed on.
+ * @param graph The graph searched: base itself, or base with slower connections.
+ * @param queries The number of random queries.
+ * @return False if a search returns another distance than Dijkstra.
+ */
+bool run(const std::string& label, const std::shared_ptr<const travel::Graph>& base, const std::shared_ptr<const travel::Graph>& graph, size_t queries)
+{
+    std::mt19937 random(7);
+    std::uniform_int_distribution<uint32_t> node(0, graph->node_count() - 1);
+    std::vector<std::pair<uint32_t, uint32_t>> pairs(queries);
+    for (auto& pair : pairs)
+    {
+        pair = std::make_pair(node(random), node(random));
+    }
+
+    std::cout << label << ": " << graph->node_count() << " nodes, " << graph->edge_count() << " connections" << std::endl;
+    travel::Navigation navigation(graph);
+    travel::QueryContext context;
+    std::vector<uint64_t> reference(queries);
+    bool ok = true;
+
+    auto report = [&](const std::string& name, double micros, uint64_t settled, const std::string& extra) {
+        std::cout << "  " << std::left << std::setw(22) << name << std::fixed << std::setprecision(1)
+                  << std::right << std::setw(10) << micros / queries << " us/query " << std::setw(10)
+                  << double(settled) / queries << " settled/query" << extra << std::endl;
+    };
+
+    uint64_t settled = 0;
+    auto begin = std::chrono::steady_clock::now();
+    for (size_t q = 0; q < queries; ++q)
+    {
+        navigation.computeShortestPath(context, graph->id_of(pairs[q].first), graph->id_of(pairs[q].second));
+        reference[q] = navigation.getShortestDistance(context, graph->id_of(pairs[q].second));
+        settled += context.settled;
+    }
+    report("dijkstra", std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - begin).count(), settled, "");
+
+    settled = 0;
+    begin = std::chrono::steady_clock::now();
+    for (size_t q = 0; q < queries; ++q)
+    {
+        navigation.computeBidirectionalPath(context, graph->id_of(pairs[q].first), graph->id_of(pairs[q].second));
+        ok = ok && navigation.getShortestDistance(context, graph->id_of(pairs[q].second)) == reference[q];
+        settled += context.settled;
+    }
+    report("bidirectional", std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - begin).count(), settled, "");
+
+    for (uint32_t count : {4u, 8u, 16u})
+    {
+        begin = std::chrono::steady_clock::now();
+        travel::Landmarks landmarks(*base, count);
+        double preprocessing = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+
+        settled = 0;
+        begin = std::chrono::steady_clock::now();
+        for (size_t q = 0; q < queries; ++q)
+        {
+            ok = ok && landmarks.query(context, *graph, pairs[q].first, pairs[q].second) == reference[q];
+            settled += context.settled;
+        }
+        std::ostringstream extra;
+        extra << std::fixed << std::setprecision(1) << "   (" << preprocessing << " ms, " << landmarks.memory_usage() / 1024 << " KiB)";
+        report("ALT " + std::to_string(count) + " landmarks",
+               std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - begin).count(), settled, extra.str());
+    }
+    if (!ok)
+    {
+        std::cerr << "Distances differ from Dijkstra on " << label << std::endl;
+    }
+    return ok;
+}
+
+/**
+ * @brief Runs the comparison on the Paris network, then on networks of increasing numbers of cities.
+ * @return 0 on success, 1 on error.
+ */
+int main(int argc, char* argv[])
+{
+    std::vector<uint32_t> cities = {4, 16};
+    if (argc > 1)
+    {
+        cities.clear();
+        for (int i = 1; i < argc; ++i)
+        {
+            cities.push_back(static_cast<uint32_t>(std::strtoul(argv[i], nullptr, 10)));
+        }
+    }
+
+    try
+    {
+        travel::MetroNetworkParser parser;
+        bool ok = run("Paris", parser.graph, parser.graph, 1000);
+        ok = ok && run("Paris, 10% slower", parser.graph, slow_down(*parser.graph, 1), 1000);
+        for (uint32_t count : cities)
+        {
+            std::shared_ptr<const travel::Graph> graph = make_cities(count, 100, count);
+            ok = ok && run(std::to_string(count) + " cities of 100x100", graph, graph, 200);
+            ok = ok && run(std::to_string(count) + " cities of 100x100, 10% slower", graph, slow_down(*graph, count), 200);
+        }
+        return ok ? 0 : 1;
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+}
@@ -0,0 +1,218 @@
+/**
+ * @file csv_bench.cpp
+ * @brief Measures the throughput of the CSV reader against the former getline/istringstream parsing.
+ */
+
+#include "../src/CsvReader.hpp"
+#include "../src/MappedFile.hpp"
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Checks the reader on the corner cases of RFC 4180 before timing it.
+ * @return True if every case parses as expected.
+ */
+bool self_check()
+{
+    struct Case {
+        const char* input;
+        std::vector<std::vector<std::string>> records;
+        size_t errors;
+    };
+    const std::vector<Case> cases = {
+        {"a,b,c\n1,2,3\n", {{"a", "b", "c"}, {"1", "2", "3"}}, 0},
+        {"a,b\r\n\r\n1,\r\n", {{"a", "b"}, {"1", ""}}, 0},
+        {"\"Voltaire (L\xC3\xA9on Blum)\",\"12, rue X\",3", {{"Voltaire (L\xC3\xA9on Blum)", "12, rue X", "3"}}, 0},
+        {"\"say \"\"hi\"\"\",\"multi\nline\",\"\"\nnext,", {{"say \"hi\"", "multi\nline", ""}, {"next", ""}}, 0},
+        {"\xEF\xBB\xBFid\nbad\"quote\nok\n\"x\"y\nlast\n", {{"id"}, {"ok"}, {"last"}}, 2},
+        {"a\n\"unterminated,\nb\n", {{"a"}}, 1},
+    };
+
+    bool ok = true;
+    for (size_t c = 0; c < cases.size(); ++c)
+    {
+        travel::CsvReader reader(cases[c].input);
+        std::vector<std::string_view> fields;
+        travel::CsvError error;
+        std::vector<std::vector<std::string>> records;
+        size_t errors = 0;
+        travel::CsvReader::Status status;
+        while ((status = reader.next(fields, error)) != travel::CsvReader::Status::End)
+        {
+            if (status == travel::CsvReader::Status::Error)
+            {
+                ++errors;
+                continue;
+            }
+            records.emplace_back(fields.begin(), fields.end());
+        }
+        if (records != cases[c].records || errors != cases[c].errors)
+        {
+            std::cerr << "Self-check failed on case " << c << std::endl;
+            ok = false;
+        }
+    }
+
+    uint64_t value = 0;
+    ok = ok && travel::CsvReader::parse_unsigned(" 42 ", value) && value == 42;
+    ok = ok && !travel::CsvReader::parse_unsigned("", value) && !travel::CsvReader::parse_unsigned("4x", value)
+            && !travel::CsvReader::parse_unsigned("99999999999999999999", value);
+    return ok;
+}
+
+/**
+ * @brief Repeats the data rows of a CSV file until the buffer reaches a target size.
+ * @param filename The CSV file, whose first line is a header.
+ * @param target_bytes The minimum size of the result.
+ * @return The header followed by the repeated rows.
+ */
+std::string replicate(const std::string& filename, size_t target_bytes)
+{
+    travel::MappedFile file(filename);
+    std::string_view text(file.data(), file.size());
+    size_t header_end = text.find('\n');
+    if (header_end == std::string_view::npos || header_end + 1 == text.size())
+    {
+        throw std::runtime_error("No data rows in " + filename);
+    }
+    std::string_view rows = text.substr(header_end + 1);
+    std::string buffer(text.substr(0, header_end + 1));
+    buffer.reserve(target_bytes + rows.size() + 1);
+    while (buffer.size() < target_bytes)
+    {
+        buffer.append(rows.data(), rows.size());
+        if (buffer.back() != '\n')
+        {
+            buffer.push_back('\n');
+        }
+    }
+    return buffer;
+}
+
+/**
+ * @brief Parses a buffer with CsvReader, converting the given integer column.
+ * @param buffer The CSV text.
+ * @param column The column holding an integer.
+ * @return A checksum of the parsed values, so the work cannot be optimized away.
+ */
+uint64_t parse_with_reader(const std::string& buffer, size_t column)
+{
+    travel::CsvReader reader(buffer);
+    std::vector<std::string_view> fields;
+    travel::CsvError error;
+    uint64_t sum = 0;
+    travel::CsvReader::Status status;
+    while ((status = reader.next(fields, error)) != travel::CsvReader::Status::End)
+    {
+        uint64_t value = 0;
+        if (status == travel::CsvReader::Status::Record && fields.size() > column
+            && travel::CsvReader::parse_unsigned(fields[column], value))
+        {
+            sum += value + fields.size();
+        }
+    }
+    return sum;
+}
+
+/**
+ * @brief Parses a buffer the way read_stations and read_connections used to.
+ * @param buffer The CSV text.
+ * @param column The column holding an integer.
+ * @return A checksum of the parsed values, so the work cannot be optimized away.
+ */
+uint64_t parse_with_streams(const std::string& buffer, size_t column)
+{
+    std::istringstream input(buffer);
+    std::string line;
+    uint64_t sum = 0;
+    while (std::getline(input, line))
+    {
+        std::istringstream iss(line);
+        std::vector<std::string> fields;
+        std::string field;
+        while (std::getline(iss, field, ','))
+        {
+            fields.push_back(field);
+        }
+        try
+        {
+            if (fields.size() > column)
+            {
+                sum += std::stoull(fields[column]) + fields.size();
+            }
+        }
+        catch (const std::exception&)
+        {
+        }
+    }
+    return sum;
+}
+
+/**
+ * @brief Times a parser on a buffer and prints its throughput.
+ * @param label The name of the measurement.
+ * @param buffer The CSV text.
+ * @param parse The parser.
+ * @param column The integer column passed to the parser.
+ * @return The checksum returned by the parser.
+ */
+uint64_t measure(const std::string& label, const std::string& buffer, uint64_t (*parse)(const std::string&, size_t), size_t column)
+{
+    auto begin = std::chrono::steady_clock::now();
+    uint64_t sum = parse(buffer, column);
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+    std::cout << "  " << std::left << std::setw(22) << label << ": " << buffer.size() / (1024.0 * 1024.0) / seconds << " MB/s ("
+              << seconds * 1000.0 << " ms)" << std::endl;
+    return sum;
+}
+
+/**
+ * @brief Runs the self-check, then times both parsers on enlarged copies of the station and connection files.
+ * @return 0 on success, 1 on error.
+ */
+int main(int argc, char* argv[])
+{
+    if (argc > 4)
+    {
+        std::cerr << "Usage: " << argv[0] << " [stations.csv] [connections.csv] [megabytes]" << std::endl;
+        return 1;
+    }
+    std::string stations = argc > 1 ? argv[1] : "src/data/s.csv";
+    std::string connections = argc > 2 ? argv[2] : "src/data/c.csv";
+    size_t megabytes = argc > 3 ? std::strtoul(argv[3], nullptr, 10) : 64;
+
+    if (!self_check())
+    {
+        return 1;
+    }
+
+    try
+    {
+        const std::pair<std::string, size_t> inputs[] = {{stations, 1}, {connections, 2}};
+        for (const auto& input : inputs)
+        {
+            std::string buffer = replicate(input.first, megabytes * 1024 * 1024);
+            std::cout << input.first << " repeated to " << buffer.size() / (1024 * 1024) << " MB" << std::endl;
+            uint64_t fast = measure("CsvReader", buffer, parse_with_reader, input.second);
+            uint64_t slow = measure("getline/istringstream", buffer, parse_with_streams, input.second);
+            if (fast != slow)
+            {
+                std::cerr << "Parsers disagree on " << input.first << std::endl;
+                return 1;
+            }
+        }
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,364 @@
+/**
+ * @file order_bench.cpp
+ * @brief Compares the node numberings of NodeOrder.hpp: point-to-point Dijkstra latency, cache misses
+ * and memory locality on the Paris network and on grid cities whose station IDs are shuffled.
+ */
+
+#include "../src/MetroNetworkParser.hpp"
+#include "../src/Navigation.hpp"
+#include "../src/NodeOrder.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <random>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+/**
+ * @brief A network to renumber, with the positions of its stations if known.
+ */
+struct Network
+{
+    std::string name;                                   /**< Shown in the report. */
+    std::shared_ptr<const travel::Graph> graph;         /**< The graph as loaded, numbered by station ID. */
+    std::vector<travel::GeoPoint> coordinates;          /**< Position of each dense index, empty if unknown. */
+};
+
+/**
+ * @brief Hardware cache miss counters of the calling thread, when the kernel lets the process read them.
+ */
+class CacheCounters
+{
+public:
+    CacheCounters()
+    {
+#ifdef __linux__
+        l1 = open(PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16));
+        last_level = open(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES);
+#endif
+    }
+
+    ~CacheCounters()
+    {
+#ifdef __linux__
+        if (l1 >= 0)
+            ::close(l1);
+        if (last_level >= 0)
+            ::close(last_level);
+#endif
+    }
+
+    CacheCounters(const CacheCounters&) = delete;
+    CacheCounters& operator=(const CacheCounters&) = delete;
+
+    /** @brief Whether the counters can be read; hardware counters are often hidden from containers and VMs. */
+    bool available() const { return l1 >= 0 && last_level >= 0; }
+
+    /** @brief Zeroes and starts both counters. */
+    void start()
+    {
+#ifdef __linux__
+        for (int fd : {l1, last_level})
+        {
+            if (fd >= 0)
+            {
+                ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+                ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+            }
+        }
+#endif
+    }
+
+    /**
+     * @brief Stops both counters.
+     * @param l1_misses Receives the L1 data cache read misses since start.
+     * @param last_level_misses Receives the last level cache misses since start.
+     */
+    void stop(uint64_t& l1_misses, uint64_t& last_level_misses)
+    {
+        l1_misses = read(l1);
+        last_level_misses = read(last_level);
+    }
+
+private:
+#ifdef __linux__
+    static int open(uint32_t type, uint64_t config)
+    {
+        perf_event_attr attributes;
+        std::memset(&attributes, 0, sizeof(attributes));
+        attributes.size = sizeof(attributes);
+        attributes.type = type;
+        attributes.config = config;
+        attributes.disabled = 1;
+        attributes.exclude_kernel = 1;
+        attributes.exclude_hv = 1;
+        return static_cast<int>(syscall(SYS_perf_event_open, &attributes, 0, -1, -1, 0));
+    }
+#endif
+
+    static uint64_t read(int fd)
+    {
+        uint64_t value = 0;
+#ifdef __linux__
+        if (fd >= 0)
+        {
+            ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+            if (::read(fd, &value, sizeof(value)) != sizeof(value))
+                value = 0;
+        }
+#else
+        (void)fd;
+#endif
+        return value;
+    }
+
+    int l1 = -1;            /**< L1 data cache read misses. */
+    int last_level = -1;    /**< Last level cache misses. */
+};
+
+/**
+ * @brief Builds square grid cities in a row, linked by a few long connections, with shuffled station IDs.
+ *
+ * Station IDs are a random permutation, like the IDs of s.csv, so numbering by ID scatters
+ * neighbouring stations over the whole node arrays. Stations are 500 m apart and placed around
+ * Paris to give them coordinates.
+ *
+ * @param cities The number of cities.
+ * @param side The number of stations per row and column of each city.
+ * @param seed The seed of the IDs and durations.
+ * @return The network with the position of every station.
+ */
+Network make_cities(uint32_t cities, uint32_t side, uint32_t seed)
+{
+    std::mt19937 random(seed);
+    std::uniform_int_distribution<uint64_t> local(30, 480), intercity(1800, 3600);
+    const uint64_t city_size = uint64_t(side) * side, count = cities * city_size;
+    std::vector<uint64_t> ids(count);
+    for (uint64_t i = 0; i < count; ++i)
+        ids[i] = 1000 + 7 * i;
+    std::shuffle(ids.begin(), ids.end(), random);
+
+    std::unordered_map<uint64_t, std::unordered_map<uint64_t, uint64_t>> connections;
+    connections.reserve(count);
+    auto link = [&](uint64_t a, uint64_t b, uint64_t duration) {
+        connections[ids[a]][ids[b]] = duration;
+        connections[ids[b]][ids[a]] = duration;
+    };
+    for (uint32_t city = 0; city < cities; ++city)
+    {
+        const uint64_t first = city * city_size;
+        for (uint32_t r = 0; r < side; ++r)
+        {
+            for (uint32_t c = 0; c < side; ++c)
+            {
+                const uint64_t at = first + uint64_t(r) * side + c;
+                if (c + 1 < side)
+                    link(at, at + 1, local(random));
+                if (r + 1 < side)
+                    link(at, at + side, local(random));
+            }
+        }
+        if (city + 1 < cities)
+        {
+            for (int bridge = 0; bridge < 3; ++bridge)
+                link(first + random() % city_size, first + city_size + random() % city_size, intercity(random));
+        }
+    }
+
+    Network network;
+    network.name = std::to_string(cities) + " cities of " + std::to_string(side) + "x" + std::to_string(side);
+    network.graph = std::make_shared<const travel::Graph>(connections, std::vector<uint64_t>());
+    network.coordinates.resize(count);
+    const double metres_per_degree = 111320, spacing = 500;
+    for (uint64_t i = 0; i < count; ++i)
+    {
+        const uint64_t city = i / city_size, r = (i % city_size) / side, c = i % side;
+        travel::GeoPoint& point = network.coordinates[network.graph->index_of(ids[i])];
+        point.latitude = 48.85 + r * spacing / metres_per_degree;
+        point.longitude = 2.35 + (city * (side + 40) + c) * spacing / (metres_per_degree * std::cos(48.85 * 3.14159265358979323846 / 180));
+    }
+    return network;
+}
+
+/**
+ * @brief Gets the mean distance between the dense indices of the two ends of an edge.
+ */
+double mean_edge_gap(const travel::Graph& graph)
+{
+    uint64_t total = 0;
+    for (uint32_t u = 0; u < graph.node_count(); ++u)
+    {
+        for (uint32_t e = graph.edges_begin(u); e < graph.edges_end(u); ++e)
+            total += u > graph.target(e) ? u - graph.target(e) : graph.target(e) - u;
+    }
+    return graph.edge_count() ? double(total) / graph.edge_count() : 0;
+}
+
+/**
+ * @brief Times the same queries on every numbering of a network and prints one row per numbering.
+ *
+ * The "lines/node" column counts the 64-byte lines of search labels touched per node reached:
+ * 1 when no two reached nodes share a line, 0.25 when each line holds four of them. It measures
+ * locality where the hardware counters cannot be read.
+ *
+ * @param network The network.
+ * @param queries The number of random queries.
+ * @return False if a numbering returns other durations than the station ID numbering.
+ */
+bool run(const Network& network, size_t queries)
+{
+    const travel::Graph& base = *network.graph;
+    std::mt19937 random(7);
+    std::uniform_int_distribution<uint32_t> node(0, base.node_count() - 1);
+    std::vector<std::pair<uint64_t, uint64_t>> pairs(queries);
+    for (auto& pair : pairs)
+        pair = std::make_pair(base.id_of(node(random)), base.id_of(node(random)));
+
+    std::cout << network.name << ": " << base.node_count() << " stations, " << base.edge_count() << " connections\n"
+              << "  " << std::left << std::setw(10) << "order" << std::right << std::setw(12) << "order ms" << std::setw(10) << "edge gap"
+              << std::setw(12) << "lines/node" << std::setw(12) << "p50 us" << std::setw(12) << "mean us" << std::setw(10) << "speedup"
+              << std::setw(14) << "L1D miss/q" << std::setw(14) << "LLC miss/q" << '\n';
+
+    CacheCounters counters;
+    std::vector<uint64_t> reference;
+    double baseline = 0;
+    bool ok = true;
+    const std::pair<const char*, travel::NodeOrder> orders[] = {
+        {"id", travel::NodeOrder::StationId}, {"bfs", travel::NodeOrder::BreadthFirst},
+        {"rcm", travel::NodeOrder::CuthillMcKee}, {"hilbert", travel::NodeOrder::Hilbert}};
+    for (const auto& order : orders)
+    {
+        if (order.second == travel::NodeOrder::Hilbert && network.coordinates.empty())
+            continue;
+        auto begin = std::chrono::steady_clock::now();
+        std::shared_ptr<const travel::Graph> graph = network.graph;
+        if (order.second != travel::NodeOrder::StationId)
+            graph = std::make_shared<const travel::Graph>(base, travel::compute_node_order(base, order.second, network.coordinates));
+        const double ordering = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+
+        travel::Navigation navigation(graph);
+        travel::QueryContext context;
+        // Locality of the labels, then one untimed pass so that the context is sized.
+        uint64_t lines = 0, reached = 0;
+        for (size_t q = 0; q < std::min<size_t>(queries, 50); ++q)
+        {
+            navigation.computeShortestPath(context, pairs[q].first, pairs[q].second);
+            uint32_t last_line = travel::Graph::npos;
+            for (uint32_t u = 0; u < graph->node_count(); ++u)
+            {
+                if (context.distance(u) != travel::QueryContext::infinity)
+                {
+                    ++reached;
+                    lines += u / 4 != last_line;
+                    last_line = u / 4;
+                }
+            }
+        }
+
+        std::vector<double> latencies(queries);
+        std::vector<uint64_t> durations(queries);
+        uint64_t l1_misses = 0, last_level_misses = 0;
+        counters.start();
+        begin = std::chrono::steady_clock::now();
+        for (size_t q = 0; q < queries; ++q)
+        {
+            const auto start = std::chrono::steady_clock::now();
+            navigation.computeShortestPath(context, pairs[q].first, pairs[q].second);
+            durations[q] = navigation.getShortestDistance(context, pairs[q].second);
+            latencies[q] = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+        }
+        const double total = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - begin).count();
+        counters.stop(l1_misses, last_level_misses);
+
+        if (reference.empty())
+        {
+            reference = durations;
+            baseline = total;
+        }
+        ok = ok && durations == reference;
+        std::sort(latencies.begin(), latencies.end());
+        std::cout << "  " << std::left << std::setw(10) << order.first << std::right << std::fixed << std::setprecision(1)
+                  << std::setw(12) << ordering << std::setw(10) << mean_edge_gap(*graph) << std::setprecision(2) << std::setw(12)
+                  << (reached ? double(lines) / reached : 0) << std::setprecision(1) << std::setw(12) << latencies[queries / 2]
+                  << std::setw(12) << total / queries << std::setprecision(2) << std::setw(9) << baseline / total << 'x';
+        if (counters.available())
+            std::cout << std::setprecision(0) << std::setw(14) << double(l1_misses) / queries << std::setw(14) << double(last_level_misses) / queries;
+        else
+            std::cout << std::setw(14) << "n/a" << std::setw(14) << "n/a";
+        std::cout << std::defaultfloat << '\n';
+    }
+    if (!ok)
+        std::cerr << "Durations differ between numberings on " << network.name << std::endl;
+    return ok;
+}
+
+/**
+ * @brief Prints the command line usage.
+ * @param program The name of the executable.
+ */
+void usage(const char* program)
+{
+    std::cerr << "Usage: " << program << " [--cities <n>] [--side <n>] [--queries <n>]\n"
+              << "  --cities   grid cities of the synthetic network (default 4)\n"
+              << "  --side     stations per row and column of each city (default 200)\n"
+              << "  --queries  timed point-to-point queries per numbering (default 300)\n"
+              << "Cache misses are read from the hardware counters when the kernel allows it (perf_event_paranoid).\n";
+}
+
+} // namespace
+
+/**
+ * @brief Runs the comparison on the Paris network, then on the synthetic cities.
+ * @return 0 on success, 1 on error or if the numberings disagree.
+ */
+int main(int argc, char* argv[])
+{
+    uint32_t cities = 4, side = 200;
+    size_t queries = 300;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::strcmp(argv[i], "--cities") == 0 && i + 1 < argc)
+            cities = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+        else if (std::strcmp(argv[i], "--side") == 0 && i + 1 < argc)
+            side = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+        else if (std::strcmp(argv[i], "--queries") == 0 && i + 1 < argc)
+            queries = std::strtoul(argv[++i], nullptr, 10);
+        else
+            cities = 0;
+    }
+    if (cities == 0 || side < 2 || queries == 0)
+    {
+        usage(argv[0]);
+        return 1;
+    }
+
+    bool ok = true;
+    try
+    {
+        Network paris;
+        paris.name = "paris";
+        {
+            travel::MetroNetworkParser parser;
+            paris.graph = parser.graph;
+        }
+        ok = run(paris, queries) && ok;
+        ok = run(make_cities(cities, side, 1), queries) && ok;
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,147 @@
+/**
+ * @file queue_bench.cpp
+ * @brief Compares the priority queues of the Dijkstra kernel on the Paris network and on synthetic grids.
+ */
+
+#include "../src/MetroNetworkParser.hpp"
+#include "../src/Navigation.hpp"
+
+#include <chrono>
+#include <random>
+#include <cstdlib>
+#include <iomanip>
+
+/**
+ * @brief Builds a grid network: each node is connected both ways to its four neighbours.
+ * @param side The number of nodes per row and column.
+ * @param seed The seed of the transfer times, uniform in [30, 480] seconds like c.csv.
+ * @return The graph.
+ */
+std::shared_ptr<const travel::Graph> make_grid(uint32_t side, uint32_t seed)
+{
+    std::mt19937 random(seed);
+    std::uniform_int_distribution<uint64_t> duration(30, 480);
+    std::unordered_map<uint64_t, std::unordered_map<uint64_t, uint64_t>> connections;
+    connections.reserve(size_t(side) * side);
+    for (uint32_t r = 0; r < side; ++r)
+    {
+        for (uint32_t c = 0; c < side; ++c)
+        {
+            uint64_t id = uint64_t(r) * side + c;
+            if (c + 1 < side)
+            {
+                connections[id][id + 1] = duration(random);
+                connections[id + 1][id] = duration(random);
+            }
+            if (r + 1 < side)
+            {
+                connections[id][id + side] = duration(random);
+                connections[id + side][id] = duration(random);
+            }
+        }
+    }
+    return std::make_shared<const travel::Graph>(connections, std::vector<uint64_t>());
+}
+
+/**
+ * @brief Times one-to-all and point-to-point searches with every queue strategy on a graph.
+ * @param label The name of the network.
+ * @param graph The network.
+ * @param searches The number of one-to-all searches and of point-to-point queries.
+ * @return False if the strategies disagree on a distance.
+ */
+bool run(const std::string& label, const std::shared_ptr<const travel::Graph>& graph, size_t searches)
+{
+    const char* names[] = {"binary heap", "radix heap", "indexed 4-ary heap"};
+    const travel::QueueStrategy strategies[] = {travel::QueueStrategy::BinaryHeap, travel::QueueStrategy::RadixHeap,
+                                                travel::QueueStrategy::IndexedDaryHeap};
+
+    std::mt19937 random(7);
+    std::uniform_int_distribution<uint32_t> node(0, graph->node_count() - 1);
+    std::vector<std::pair<uint64_t, uint64_t>> pairs(searches);
+    for (auto& pair : pairs)
+    {
+        pair = std::make_pair(graph->id_of(node(random)), graph->id_of(node(random)));
+    }
+
+    std::cout << label << ": " << graph->node_count() << " nodes, " << graph->edge_count() << " connections" << std::endl;
+    travel::Navigation navigation(graph);
+    travel::QueryContext context;
+    uint64_t reference = 0;
+    for (size_t s = 0; s < 3; ++s)
+    {
+        context.queue_strategy = strategies[s];
+        uint64_t checksum = 0;
+
+        auto begin = std::chrono::steady_clock::now();
+        for (const auto& pair : pairs)
+        {
+            navigation.computeShortestPath(context, pair.first);
+            checksum += navigation.getShortestDistance(context, pair.second);
+        }
+        double all = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count() / searches;
+
+        begin = std::chrono::steady_clock::now();
+        for (const auto& pair : pairs)
+        {
+            navigation.computeShortestPath(context, pair.first, pair.second);
+            checksum += navigation.getShortestDistance(context, pair.second);
+        }
+        double point = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - begin).count() / searches;
+
+        begin = std::chrono::steady_clock::now();
+        for (const auto& pair : pairs)
+        {
+            navigation.computeBidirectionalPath(context, pair.first, pair.second);
+            checksum += navigation.getShortestDistance(context, pair.second);
+        }
+        double bidirectional = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - begin).count() / searches;
+
+        std::cout << "  " << std::left << std::setw(20) << names[s] << std::fixed << std::setprecision(3)
+                  << " one-to-all " << std::setw(9) << all << " ms   point-to-point " << std::setw(10) << point
+                  << " us   bidirectional " << std::setw(10) << bidirectional << " us" << std::endl;
+        if (s == 0)
+        {
+            reference = checksum;
+        }
+        else if (checksum != reference)
+        {
+            std::cerr << "Distances differ between strategies on " << label << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Runs the comparison on the Paris network, then on grids of increasing size.
+ * @return 0 on success, 1 on error.
+ */
+int main(int argc, char* argv[])
+{
+    std::vector<uint32_t> sides = {100, 300, 600};
+    if (argc > 1)
+    {
+        sides.clear();
+        for (int i = 1; i < argc; ++i)
+        {
+            sides.push_back(static_cast<uint32_t>(std::strtoul(argv[i], nullptr, 10)));
+        }
+    }
+
+    try
+    {
+        travel::MetroNetworkParser parser;
+        bool ok = run("Paris", parser.graph, 1000);
+        for (uint32_t side : sides)
+        {
+            ok = ok && run("Grid " + std::to_string(side) + "x" + std::to_string(side), make_grid(side, side), side >= 500 ? 20 : 100);
+        }
+        return ok ? 0 : 1;
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+}
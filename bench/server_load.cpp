@@ -0,0 +1,287 @@
+/**
+ * @file server_load.cpp
+ * @brief Load generator of the routing daemon: pipelined route requests between random stations on
+ * several connections, with the throughput and the latency percentiles seen by the clients.
+ */
+
+#include "../src/MetroNetworkParser.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <deque>
+#include <random>
+#include <thread>
+
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+/**
+ * @brief Load settings, from the command line.
+ */
+struct Settings
+{
+    std::string address;        /**< The Unix socket path or loopback port of the daemon. */
+    std::string snapshot;       /**< The network the station IDs are drawn from, empty for the CSV files. */
+    size_t connections = 4;     /**< Client connections, one thread each. */
+    size_t depth = 16;          /**< Requests in flight on each connection. */
+    double seconds = 5;         /**< Time during which new requests are sent. */
+    uint64_t seed = 1;          /**< Seed of the station draws. */
+};
+
+/**
+ * @brief What one connection measured.
+ */
+struct ClientResult
+{
+    std::vector<uint64_t> latencies;    /**< Nanoseconds from sending each request to reading its response. */
+    uint64_t errors = 0;                /**< Responses other than ok and unreachable. */
+    std::string failure;                /**< Why the connection stopped early, empty if it did not. */
+};
+
+/**
+ * @brief Connects to the daemon.
+ * @param address A Unix socket path, or a port number on 127.0.0.1.
+ * @return The connected socket.
+ * @throws std::runtime_error if the daemon cannot be reached.
+ */
+int connect_to(const std::string& address)
+{
+    const bool tcp = !address.empty() && address.find_first_not_of("0123456789") == std::string::npos;
+    const int fd = ::socket(tcp ? AF_INET : AF_UNIX, SOCK_STREAM, 0);
+    int connected = -1;
+    if (fd >= 0 && tcp)
+    {
+        sockaddr_in target{};
+        target.sin_family = AF_INET;
+        target.sin_port = htons(static_cast<uint16_t>(std::stoul(address)));
+        target.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        connected = ::connect(fd, reinterpret_cast<const sockaddr*>(&target), sizeof(target));
+        const int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    }
+    else if (fd >= 0 && address.size() < sizeof(sockaddr_un::sun_path))
+    {
+        sockaddr_un target{};
+        target.sun_family = AF_UNIX;
+        std::memcpy(target.sun_path, address.c_str(), address.size() + 1);
+        connected = ::connect(fd, reinterpret_cast<const sockaddr*>(&target), sizeof(target));
+    }
+    if (connected != 0)
+    {
+        std::string error = std::strerror(errno);
+        if (fd >= 0)
+            ::close(fd);
+        throw std::runtime_error("Cannot connect to " + address + ": " + error + " (server_load)");
+    }
+    return fd;
+}
+
+/**
+ * @brief Writes a whole buffer to a blocking socket.
+ * @return False if the socket failed.
+ */
+bool send_all(int fd, const std::string& buffer)
+{
+    for (size_t sent = 0; sent < buffer.size();)
+    {
+        const ssize_t count = ::send(fd, buffer.data() + sent, buffer.size() - sent, 0);
+        if (count < 0 && errno == EINTR)
+            continue;
+        if (count <= 0)
+            return false;
+        sent += static_cast<size_t>(count);
+    }
+    return true;
+}
+
+/**
+ * @brief Keeps depth route requests in flight on one connection until the time is up, then drains them.
+ *
+ * Every response read is replaced by a new request, and the requests replacing one read are sent
+ * with a single call, like a client batching its queries would.
+ *
+ * @param settings The load settings.
+ * @param ids The station IDs to draw from.
+ * @param index The number of the connection, which seeds its draws.
+ * @param deadline The time after which no request is sent.
+ * @param result Receives the measurements.
+ */
+void run_client(const Settings& settings, const std::vector<uint64_t>& ids, size_t index, Clock::time_point deadline, ClientResult& result)
+{
+    int fd = -1;
+    try
+    {
+        fd = connect_to(settings.address);
+    }
+    catch (const std::exception& e)
+    {
+        result.failure = e.what();
+        return;
+    }
+    std::mt19937_64 random(settings.seed + index);
+    std::uniform_int_distribution<size_t> pick(0, ids.size() - 1);
+    std::deque<Clock::time_point> in_flight;
+    std::string requests, responses;
+    auto enqueue = [&](Clock::time_point now) {
+        requests += "route " + std::to_string(ids[pick(random)]) + ',' + std::to_string(ids[pick(random)]) + '\n';
+        in_flight.push_back(now);
+    };
+
+    for (size_t i = 0; i < settings.depth; ++i)
+        enqueue(Clock::now());
+    char chunk[65536];
+    while (!in_flight.empty())
+    {
+        if (!requests.empty())
+        {
+            if (!send_all(fd, requests))
+            {
+                result.failure = std::string("send: ") + std::strerror(errno);
+                break;
+            }
+            requests.clear();
+        }
+        const ssize_t count = ::recv(fd, chunk, sizeof(chunk), 0);
+        if (count < 0 && errno == EINTR)
+            continue;
+        if (count <= 0)
+        {
+            result.failure = count == 0 ? "connection closed by the daemon" : std::string("recv: ") + std::strerror(errno);
+            break;
+        }
+        responses.append(chunk, static_cast<size_t>(count));
+        const Clock::time_point now = Clock::now();
+        size_t begin = 0;
+        for (size_t end; !in_flight.empty() && (end = responses.find('\n', begin)) != std::string::npos; begin = end + 1)
+        {
+            result.latencies.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(now - in_flight.front()).count());
+            in_flight.pop_front();
+            if (responses.compare(begin, 3, "ok ") != 0 && responses.compare(begin, end - begin, "unreachable") != 0)
+                ++result.errors;
+            if (now < deadline)
+                enqueue(now);
+        }
+        responses.erase(0, begin);
+    }
+    ::close(fd);
+}
+
+/**
+ * @brief Gets a percentile of sorted values.
+ */
+double percentile(const std::vector<uint64_t>& sorted, double fraction)
+{
+    if (sorted.empty())
+        return 0;
+    return static_cast<double>(sorted[std::min(sorted.size() - 1, static_cast<size_t>(fraction * sorted.size()))]);
+}
+
+/**
+ * @brief Prints the command line usage.
+ * @param program The name of the executable.
+ */
+void usage(const char* program)
+{
+    std::cerr << "Usage: " << program << " <socket|port> [network.snapshot] [--connections <n>] [--depth <n>] [--seconds <s>] [--seed <n>]\n"
+              << "  --connections  client connections, one thread each (default 4)\n"
+              << "  --depth        pipelined requests in flight per connection (default 16)\n"
+              << "  --seconds      duration of the run (default 5)\n"
+              << "  --seed         seed of the random start and end stations (default 1)\n"
+              << "The stations are drawn from the snapshot, or from the CSV files of src/data; use the network the daemon serves.\n";
+}
+
+} // namespace
+
+/**
+ * @brief Loads the station IDs, runs the clients and prints the throughput and latency percentiles.
+ * @return 0 on success, 1 on error.
+ */
+int main(int argc, char* argv[])
+{
+    Settings settings;
+    bool ok = argc >= 2;
+    if (ok)
+        settings.address = argv[1];
+    for (int i = 2; ok && i < argc; ++i)
+    {
+        const bool has_value = i + 1 < argc;
+        if (std::strcmp(argv[i], "--connections") == 0 && has_value)
+            settings.connections = std::strtoul(argv[++i], nullptr, 10);
+        else if (std::strcmp(argv[i], "--depth") == 0 && has_value)
+            settings.depth = std::strtoul(argv[++i], nullptr, 10);
+        else if (std::strcmp(argv[i], "--seconds") == 0 && has_value)
+            settings.seconds = std::strtod(argv[++i], nullptr);
+        else if (std::strcmp(argv[i], "--seed") == 0 && has_value)
+            settings.seed = std::strtoull(argv[++i], nullptr, 10);
+        else if (argv[i][0] != '-' && settings.snapshot.empty())
+            settings.snapshot = argv[i];
+        else
+            ok = false;
+    }
+    if (!ok || settings.connections == 0 || settings.depth == 0)
+    {
+        usage(argv[0]);
+        return 1;
+    }
+
+    std::vector<uint64_t> ids;
+    try
+    {
+        std::unique_ptr<travel::MetroNetworkParser> parser(settings.snapshot.empty() ? new travel::MetroNetworkParser()
+                                                                                      : new travel::MetroNetworkParser(settings.snapshot));
+        const travel::StationTable& stations = parser->get_station_table();
+        for (uint32_t row = 0; row < stations.size(); ++row)
+            ids.push_back(stations.id(row));
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+    if (ids.empty())
+    {
+        std::cerr << "Error: the network has no station" << std::endl;
+        return 1;
+    }
+
+    std::vector<ClientResult> results(settings.connections);
+    std::vector<std::thread> clients;
+    const Clock::time_point begin = Clock::now();
+    const Clock::time_point deadline = begin + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(settings.seconds));
+    for (size_t i = 0; i < settings.connections; ++i)
+        clients.emplace_back(run_client, std::cref(settings), std::cref(ids), i, deadline, std::ref(results[i]));
+    for (std::thread& client : clients)
+        client.join();
+    const double elapsed = std::chrono::duration<double>(Clock::now() - begin).count();
+
+    std::vector<uint64_t> latencies;
+    uint64_t errors = 0;
+    for (const ClientResult& result : results)
+    {
+        latencies.insert(latencies.end(), result.latencies.begin(), result.latencies.end());
+        errors += result.errors;
+        if (!result.failure.empty())
+            std::cerr << "Error: " << result.failure << std::endl;
+    }
+    std::sort(latencies.begin(), latencies.end());
+    std::cout << settings.connections << " connections x " << settings.depth << " in flight: " << latencies.size() << " requests in "
+              << elapsed << " s, " << latencies.size() / elapsed << " requests/s, " << errors << " errors\n"
+              << "latency p50 " << percentile(latencies, 0.5) / 1000 << " us, p99 " << percentile(latencies, 0.99) / 1000
+              << " us, p999 " << percentile(latencies, 0.999) / 1000 << " us, max " << (latencies.empty() ? 0 : latencies.back() / 1000.0) << " us\n";
+    for (const ClientResult& result : results)
+    {
+        if (!result.failure.empty())
+            return 1;
+    }
+    return 0;
+}
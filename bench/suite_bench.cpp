@@ -0,0 +1,434 @@
+/**
+ * @file suite_bench.cpp
+ * @brief Reproducible benchmark suite of the load, search and lookup paths, on the Paris network and
+ * on scaled copies of it, with latency percentiles, throughput, allocations and a JSON report.
+ */
+
+#include "../src/MetroNetworkParser.hpp"
+#include "../src/Navigation.hpp"
+#include "../check/CountingAllocator.hpp"
+
+#include <cinttypes>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <iomanip>
+#include <random>
+
+namespace {
+
+/**
+ * @brief Latency distribution and cost of one benchmark.
+ */
+struct Result
+{
+    std::string name;        /**< The operation measured. */
+    size_t ops = 0;          /**< The number of timed operations. */
+    double p50 = 0;          /**< Median latency in nanoseconds. */
+    double p99 = 0;          /**< 99th percentile latency in nanoseconds. */
+    double p999 = 0;         /**< 99.9th percentile latency in nanoseconds. */
+    double mean = 0;         /**< Mean latency in nanoseconds. */
+    double throughput = 0;   /**< Operations per second over the whole loop. */
+    double allocs = 0;       /**< Calls to operator new per operation. */
+    double bytes = 0;        /**< Bytes allocated per operation. */
+};
+
+/**
+ * @brief The benchmarks of one network.
+ */
+struct NetworkReport
+{
+    std::string name;             /**< The network. */
+    size_t stations = 0;          /**< Its number of stations. */
+    size_t connections = 0;       /**< Its number of connections. */
+    std::vector<Result> results;  /**< One entry per operation. */
+};
+
+/**
+ * @brief Sends std::cout to nowhere while alive, to keep the constructors' messages out of the timings.
+ */
+class Silence
+{
+public:
+    Silence() : saved(std::cout.rdbuf(nullptr)) {}
+    ~Silence() { std::cout.rdbuf(saved); }
+
+private:
+    std::streambuf* saved;
+};
+
+volatile uint64_t sink = 0; /**< Consumes results so that the compiler keeps the measured calls. */
+
+/**
+ * @brief Times an operation, one call at a time.
+ * @param name The name of the operation.
+ * @param ops The number of calls.
+ * @param op The operation, called with the call number.
+ * @return The latency percentiles, throughput and allocations per call.
+ */
+template <typename Operation>
+Result measure(const std::string& name, size_t ops, Operation&& op)
+{
+    std::vector<double> latencies(ops);
+    Result result;
+    result.name = name;
+    result.ops = ops;
+
+    Silence silence;
+    const uint64_t allocations_before = counting_allocator::allocations.load();
+    const uint64_t bytes_before = counting_allocator::allocated_bytes.load();
+    const auto begin = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < ops; ++i)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        op(i);
+        latencies[i] = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    }
+    const double total = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - begin).count();
+    result.allocs = double(counting_allocator::allocations.load() - allocations_before) / ops;
+    result.bytes = double(counting_allocator::allocated_bytes.load() - bytes_before) / ops;
+
+    std::sort(latencies.begin(), latencies.end());
+    auto percentile = [&](double q) { return latencies[std::min(ops - 1, static_cast<size_t>(q * ops))]; };
+    result.p50 = percentile(0.5);
+    result.p99 = percentile(0.99);
+    result.p999 = percentile(0.999);
+    result.mean = total / ops;
+    result.throughput = ops / (total * 1e-9);
+    return result;
+}
+
+/**
+ * @brief Writes scaled copies of the Paris network as CSV files.
+ *
+ * Copy k shifts every station ID by k * 100000 and suffixes the station names with " k"; each copy
+ * is linked to the next one both ways by three 30-minute connections between random stations.
+ *
+ * @param stations_file The Paris stations CSV file.
+ * @param connections_file The Paris connections CSV file.
+ * @param copies The number of copies.
+ * @param directory The directory written to.
+ * @return The paths of the stations and connections files written.
+ */
+std::pair<std::string, std::string> write_scaled(const std::string& stations_file, const std::string& connections_file,
+                                                 uint32_t copies, const std::filesystem::path& directory)
+{
+    const uint64_t shift = 100000;
+    std::ifstream stations_in(stations_file), connections_in(connections_file);
+    if (!stations_in || !connections_in)
+    {
+        throw std::runtime_error("Cannot read the Paris network (write_scaled)");
+    }
+    std::vector<std::vector<std::string>> stations;
+    std::vector<std::string> connections;
+    std::string stations_header, connections_header, line;
+    std::getline(stations_in, stations_header);
+    while (std::getline(stations_in, line))
+    {
+        std::vector<std::string> fields;
+        std::stringstream row(line);
+        std::string field;
+        while (std::getline(row, field, ','))
+        {
+            fields.push_back(field);
+        }
+        if (fields.size() >= 5)
+        {
+            stations.push_back(fields);
+        }
+    }
+    std::getline(connections_in, connections_header);
+    while (std::getline(connections_in, line))
+    {
+        connections.push_back(line);
+    }
+
+    const std::string tag = "scaled_" + std::to_string(copies);
+    std::pair<std::string, std::string> paths((directory / (tag + "_s.csv")).string(), (directory / (tag + "_c.csv")).string());
+    std::ofstream stations_out(paths.first), connections_out(paths.second);
+    stations_out << stations_header << '\n';
+    connections_out << connections_header << '\n';
+    std::mt19937 random(copies);
+    std::uniform_int_distribution<size_t> pick(0, stations.size() - 1);
+    for (uint32_t copy = 0; copy < copies; ++copy)
+    {
+        const uint64_t offset = copy * shift;
+        const std::string suffix = copy == 0 ? "" : " " + std::to_string(copy);
+        for (const std::vector<std::string>& fields : stations)
+        {
+            stations_out << fields[0] << suffix << ',' << std::stoull(fields[1]) + offset;
+            for (size_t f = 2; f < fields.size(); ++f)
+            {
+                stations_out << ',' << fields[f];
+            }
+            stations_out << '\n';
+        }
+        for (const std::string& connection : connections)
+        {
+            uint64_t from = 0, to = 0, duration = 0;
+            if (std::sscanf(connection.c_str(), "%" SCNu64 ",%" SCNu64 ",%" SCNu64, &from, &to, &duration) == 3)
+            {
+                connections_out << from + offset << ',' << to + offset << ',' << duration << '\n';
+            }
+        }
+        if (copy + 1 < copies)
+        {
+            for (int link = 0; link < 3; ++link)
+            {
+                const uint64_t from = std::stoull(stations[pick(random)][1]) + offset;
+                const uint64_t to = std::stoull(stations[pick(random)][1]) + offset + shift;
+                connections_out << from << ',' << to << ",1800\n" << to << ',' << from << ",1800\n";
+            }
+        }
+    }
+    return paths;
+}
+
+/**
+ * @brief Runs every benchmark on one network.
+ * @param name The name of the network.
+ * @param stations_file The stations CSV file.
+ * @param connections_file The connections CSV file.
+ * @param queries The number of timed calls of each query benchmark.
+ * @param loads The number of timed CSV loads.
+ * @return The results.
+ */
+NetworkReport run(const std::string& name, const std::string& stations_file, const std::string& connections_file,
+                  size_t queries, size_t loads)
+{
+    NetworkReport report;
+    report.name = name;
+
+    report.results.push_back(measure("load_csv", loads, [&](size_t) {
+        travel::MetroNetworkParser loaded(stations_file, connections_file);
+        sink = sink + loaded.get_graph().edge_count();
+    }));
+
+    std::unique_ptr<travel::MetroNetworkParser> parser;
+    {
+        Silence silence;
+        parser.reset(new travel::MetroNetworkParser(stations_file, connections_file));
+    }
+    const travel::StationTable& table = parser->get_station_table();
+    const std::shared_ptr<const travel::Graph> graph = parser->graph;
+    report.stations = table.size();
+    report.connections = graph->edge_count();
+
+    report.results.push_back(measure("navigation_constructor", loads, [&](size_t) {
+        travel::Navigation navigation(graph);
+        sink = sink + 1;
+    }));
+
+    // Fixed workloads: random pairs, and the pairs farthest apart among 64 random origins.
+    std::mt19937 random(42);
+    std::uniform_int_distribution<uint32_t> node(0, graph->node_count() - 1);
+    std::uniform_int_distribution<uint32_t> row(0, static_cast<uint32_t>(table.size() - 1));
+    std::vector<std::pair<uint64_t, uint64_t>> pairs(queries), worst;
+    for (auto& pair : pairs)
+    {
+        pair = std::make_pair(graph->id_of(node(random)), graph->id_of(node(random)));
+    }
+    {
+        Silence silence;
+        travel::Navigation navigation(graph);
+        travel::QueryContext context;
+        for (int origin = 0; origin < 64; ++origin)
+        {
+            const uint32_t source = node(random);
+            navigation.computeShortestPath(context, graph->id_of(source));
+            uint32_t farthest = source;
+            for (uint32_t v = 0; v < graph->node_count(); ++v)
+            {
+                if (context.distance(v) != travel::QueryContext::infinity && context.distance(v) > context.distance(farthest))
+                {
+                    farthest = v;
+                }
+            }
+            worst.emplace_back(graph->id_of(source), graph->id_of(farthest));
+        }
+    }
+    std::vector<uint64_t> ids(queries);
+    std::vector<std::string> names(queries);
+    for (size_t i = 0; i < queries; ++i)
+    {
+        const travel::StationView station = table.view(row(random));
+        ids[i] = station.id;
+        std::string typed(station.name);
+        if (i % 2 == 1 && typed.size() > 3)
+        {
+            typed.erase(typed.size() / 2, 1); // One typo out of two
+        }
+        names[i] = typed;
+    }
+
+    parser->set_cache_budget(0, 0);
+    report.results.push_back(measure("compute_travel_random", queries, [&](size_t i) {
+        sink = sink + parser->compute_travel(pairs[i].first, pairs[i].second).size();
+    }));
+    report.results.push_back(measure("compute_travel_worst", queries, [&](size_t i) {
+        const auto& pair = worst[i % worst.size()];
+        sink = sink + parser->compute_travel(pair.first, pair.second).size();
+    }));
+    // Routes written into a buffer of the caller, timed once an untimed pass has grown the scratch of
+    // the thread; check/allocation_check asserts that they then allocate nothing.
+    std::vector<uint64_t> stations(graph->node_count());
+    auto plan_into = [&](size_t i) {
+        sink = sink + parser->plan_journey(pairs[i].first, pairs[i].second, stations.data(), stations.size()).stations;
+    };
+    for (size_t i = 0; i < queries; ++i)
+    {
+        plan_into(i);
+    }
+    report.results.push_back(measure("plan_journey_span", queries, plan_into));
+    parser->set_cache_budget(size_t(256) << 20, 0);
+    for (size_t i = 0; i < queries; ++i)
+    {
+        plan_into(i);
+    }
+    report.results.push_back(measure("plan_journey_span_hit", queries, plan_into));
+    parser->set_cache_budget(0, 0);
+    report.results.push_back(measure("search_stations", queries, [&](size_t i) {
+        sink = sink + parser->searchStations(names[i]).size();
+    }));
+    report.results.push_back(measure("get_station_by_id", queries, [&](size_t i) {
+        sink = sink + parser->get_station_by_id(ids[i]).name.size();
+    }));
+    return report;
+}
+
+/**
+ * @brief Prints the results of one network as a table.
+ * @param report The results.
+ */
+void print(const NetworkReport& report)
+{
+    std::cout << report.name << ": " << report.stations << " stations, " << report.connections << " connections\n"
+              << "  " << std::left << std::setw(24) << "operation" << std::right << std::setw(8) << "ops"
+              << std::setw(12) << "p50 us" << std::setw(12) << "p99 us" << std::setw(12) << "p999 us"
+              << std::setw(14) << "ops/s" << std::setw(10) << "allocs" << std::setw(12) << "bytes" << '\n';
+    for (const Result& result : report.results)
+    {
+        std::cout << "  " << std::left << std::setw(24) << result.name << std::right << std::setw(8) << result.ops
+                  << std::fixed << std::setprecision(2) << std::setw(12) << result.p50 / 1000 << std::setw(12)
+                  << result.p99 / 1000 << std::setw(12) << result.p999 / 1000 << std::setprecision(0) << std::setw(14)
+                  << result.throughput << std::setprecision(1) << std::setw(10) << result.allocs << std::setw(12)
+                  << result.bytes << '\n';
+    }
+    std::cout << std::defaultfloat;
+}
+
+/**
+ * @brief Writes every result as JSON, one object per network.
+ * @param filename The file written.
+ * @param reports The results.
+ * @param queries The number of timed calls of each query benchmark.
+ */
+void write_json(const std::string& filename, const std::vector<NetworkReport>& reports, size_t queries)
+{
+    std::ofstream out(filename);
+    if (!out)
+    {
+        throw std::runtime_error("Cannot write " + filename + " (write_json)");
+    }
+    out << std::fixed << std::setprecision(1) << "{\n  \"suite\": \"suite_bench\",\n  \"version\": 1,\n  \"seed\": 42,\n"
+        << "  \"queries\": " << queries << ",\n  \"networks\": [";
+    for (size_t n = 0; n < reports.size(); ++n)
+    {
+        const NetworkReport& report = reports[n];
+        out << (n ? "," : "") << "\n    {\"name\": \"" << report.name << "\", \"stations\": " << report.stations
+            << ", \"connections\": " << report.connections << ", \"results\": [";
+        for (size_t r = 0; r < report.results.size(); ++r)
+        {
+            const Result& result = report.results[r];
+            out << (r ? "," : "") << "\n      {\"name\": \"" << result.name << "\", \"ops\": " << result.ops
+                << ", \"p50_ns\": " << result.p50 << ", \"p99_ns\": " << result.p99 << ", \"p999_ns\": " << result.p999
+                << ", \"mean_ns\": " << result.mean << ", \"ops_per_s\": " << result.throughput
+                << ", \"allocs_per_op\": " << result.allocs << ", \"bytes_per_op\": " << result.bytes << "}";
+        }
+        out << "\n    ]}";
+    }
+    out << "\n  ]\n}\n";
+}
+
+/**
+ * @brief Prints the command line usage.
+ * @param program The name of the executable.
+ */
+void usage(const char* program)
+{
+    std::cerr << "Usage: " << program << " [--json <report.json>] [--queries <n>] [--scale <copies>]...\n"
+              << "  --json     also write the results as JSON\n"
+              << "  --queries  timed calls per query benchmark (default 10000)\n"
+              << "  --scale    also run on that many linked copies of the Paris network (default 4 and 16)\n";
+}
+
+} // namespace
+
+/**
+ * @brief Runs the suite on the Paris network, then on its scaled copies.
+ * @return 0 on success, 1 on error.
+ */
+int main(int argc, char* argv[])
+{
+    std::string json;
+    size_t queries = 10000;
+    std::vector<uint32_t> scales;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::strcmp(argv[i], "--json") == 0 && i + 1 < argc)
+        {
+            json = argv[++i];
+        }
+        else if (std::strcmp(argv[i], "--queries") == 0 && i + 1 < argc)
+        {
+            queries = std::strtoul(argv[++i], nullptr, 10);
+        }
+        else if (std::strcmp(argv[i], "--scale") == 0 && i + 1 < argc)
+        {
+            scales.push_back(static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10)));
+        }
+        else
+        {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if (scales.empty())
+    {
+        scales = {4, 16};
+    }
+    if (queries == 0)
+    {
+        usage(argv[0]);
+        return 1;
+    }
+
+    try
+    {
+        std::vector<NetworkReport> reports;
+        reports.push_back(run("paris", "src/data/s.csv", "src/data/c.csv", queries, 100));
+        print(reports.back());
+        const std::filesystem::path directory = std::filesystem::temp_directory_path();
+        for (uint32_t copies : scales)
+        {
+            std::pair<std::string, std::string> files = write_scaled("src/data/s.csv", "src/data/c.csv", copies, directory);
+            reports.push_back(run("paris_x" + std::to_string(copies), files.first, files.second, queries, copies >= 16 ? 10 : 20));
+            std::filesystem::remove(files.first);
+            std::filesystem::remove(files.second);
+            print(reports.back());
+        }
+        if (!json.empty())
+        {
+            write_json(json, reports, queries);
+            std::cout << "Wrote " << json << '\n';
+        }
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,75 @@
+/**
+ * @file CountingAllocator.hpp
+ * @brief Replaces the global operator new and delete with versions that count every allocation of the
+ * program. Include it from exactly one source file of a program: it defines the replacements.
+ */
+
+#pragma once
+#ifndef COUNTING_ALLOCATOR_HPP
+#define COUNTING_ALLOCATOR_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+
+namespace counting_allocator {
+
+inline std::atomic<uint64_t> allocations(0); /**< Calls to operator new since the start of the program. */
+inline std::atomic<uint64_t> allocated_bytes(0); /**< Bytes requested from operator new since the start of the program. */
+
+} // namespace counting_allocator
+
+/**
+ * @brief Counts every allocation of the program, then forwards it to malloc.
+ * @param size The number of bytes.
+ * @return The allocated block.
+ */
+void* operator new(std::size_t size)
+{
+    counting_allocator::allocations.fetch_add(1, std::memory_order_relaxed);
+    counting_allocator::allocated_bytes.fetch_add(size, std::memory_order_relaxed);
+    if (void* block = std::malloc(size ? size : 1))
+    {
+        return block;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size)
+{
+    return operator new(size);
+}
+
+// GCC inlines these replacements into the library's delete expressions, then reports free() of a
+// block from operator new; both replacements use malloc and free, so the pairing is right.
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+void operator delete(void* block) noexcept
+{
+    std::free(block);
+}
+
+void operator delete[](void* block) noexcept
+{
+    std::free(block);
+}
+
+void operator delete(void* block, std::size_t) noexcept
+{
+    std::free(block);
+}
+
+void operator delete[](void* block, std::size_t) noexcept
+{
+    std::free(block);
+}
+
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+
+#endif // COUNTING_ALLOCATOR_HPP
@@ -0,0 +1,99 @@
+/**
+ * @file allocation_check.cpp
+ * @brief Checks that plan_journey into a caller buffer performs no heap allocation once warmed up,
+ * with every search mode, on a route cache hit and on a shortest path tree hit.
+ */
+
+#include "../src/MetroNetworkParser.hpp"
+#include "CountingAllocator.hpp"
+
+#include <random>
+
+namespace {
+
+/**
+ * @brief Plans every journey twice into the same buffer and counts the allocations of the second pass.
+ * @param parser The network, configured by the caller.
+ * @param pairs The (start, end) station IDs.
+ * @param stations The buffer of the caller, large enough for any route.
+ * @param name The case, printed with its result.
+ * @return False if the second pass allocated.
+ */
+bool allocation_free(const travel::MetroNetworkParser& parser, const std::vector<std::pair<uint64_t, uint64_t>>& pairs,
+                     std::vector<uint64_t>& stations, const std::string& name)
+{
+    uint64_t sink = 0;
+    for (const auto& pair : pairs)
+    {
+        sink += parser.plan_journey(pair.first, pair.second, stations.data(), stations.size()).stations;
+    }
+    const uint64_t before = counting_allocator::allocations.load(std::memory_order_relaxed);
+    for (const auto& pair : pairs)
+    {
+        sink -= parser.plan_journey(pair.first, pair.second, stations.data(), stations.size()).stations;
+    }
+    const uint64_t allocated = counting_allocator::allocations.load(std::memory_order_relaxed) - before;
+    const bool ok = allocated == 0 && sink == 0;
+    std::cout << (ok ? "ok    " : "FAIL  ") << name << ": " << allocated << " allocations in " << pairs.size() << " queries\n";
+    return ok;
+}
+
+} // namespace
+
+/**
+ * @brief Runs the checks on the Paris network.
+ * @return 0 if no warmed-up query allocated, 1 otherwise.
+ */
+int main()
+{
+    bool ok = true;
+    try
+    {
+        travel::MetroNetworkParser parser;
+        parser.build_contraction_hierarchy();
+        parser.build_distance_table();
+        parser.build_landmarks();
+        parser.build_hub_labels();
+
+        const travel::Graph& graph = parser.get_graph();
+        std::mt19937 random(42);
+        std::uniform_int_distribution<uint32_t> node(0, graph.node_count() - 1);
+        std::vector<std::pair<uint64_t, uint64_t>> pairs(500);
+        for (auto& pair : pairs)
+        {
+            pair = std::make_pair(graph.id_of(node(random)), graph.id_of(node(random)));
+        }
+        std::vector<uint64_t> stations(graph.node_count());
+
+        const std::pair<travel::SearchMode, const char*> modes[] = {
+            {travel::SearchMode::Full, "full"}, {travel::SearchMode::PointToPoint, "point to point"},
+            {travel::SearchMode::Bidirectional, "bidirectional"}, {travel::SearchMode::ContractionHierarchy, "contraction hierarchy"},
+            {travel::SearchMode::AllPairs, "all pairs"}, {travel::SearchMode::Landmarks, "landmarks"},
+            {travel::SearchMode::HubLabels, "hub labels"}};
+        parser.set_cache_budget(0, 0);
+        for (const auto& mode : modes)
+        {
+            parser.set_search_mode(mode.first);
+            ok = allocation_free(parser, pairs, stations, std::string("search, ") + mode.second) && ok;
+        }
+
+        parser.set_search_mode(travel::SearchMode::PointToPoint);
+        parser.set_cache_budget(size_t(64) << 20, 0);
+        ok = allocation_free(parser, pairs, stations, "route cache hit") && ok;
+
+        // Every query from one origin, once its tree is cached.
+        parser.set_cache_budget(0, size_t(32) << 20);
+        parser.set_hot_source_threshold(1);
+        for (auto& pair : pairs)
+        {
+            pair.first = pairs.front().first;
+        }
+        ok = allocation_free(parser, pairs, stations, "tree cache hit") && ok;
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+    return ok ? 0 : 1;
+}
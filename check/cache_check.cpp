@@ -0,0 +1,144 @@
+/**
+ * @file cache_check.cpp
+ * @brief Checks that a hot origin of a scaled network answers from its cached shortest path tree,
+ * and that a network too large for the tree cache falls back to plain searches instead of
+ * building a tree that is never stored.
+ */
+
+#include "../src/MetroNetworkParser.hpp"
+
+#include <filesystem>
+#include <fstream>
+#include <random>
+
+namespace {
+
+/**
+ * @brief Writes a square grid network as CSV files.
+ * @param side The number of stations per row and column.
+ * @param directory The directory written to.
+ * @return The paths of the stations and connections files written.
+ */
+std::pair<std::string, std::string> write_grid(uint32_t side, const std::filesystem::path& directory)
+{
+    const std::string tag = "grid_" + std::to_string(side);
+    std::pair<std::string, std::string> paths((directory / (tag + "_s.csv")).string(), (directory / (tag + "_c.csv")).string());
+    std::ofstream stations(paths.first), connections(paths.second);
+    if (!stations || !connections)
+    {
+        throw std::runtime_error("Cannot write the grid network (write_grid)");
+    }
+    std::mt19937 random(side);
+    std::uniform_int_distribution<uint32_t> ride(30, 480);
+    stations << "string_name_station,uint32_s_id,string_short_line,string_adress_station,string_desc_line\n";
+    connections << "uint32_from_stop_id,uint32_to_stop_id,uint32_min_transfer_time\n";
+    for (uint32_t r = 0; r < side; ++r)
+    {
+        for (uint32_t c = 0; c < side; ++c)
+        {
+            const uint64_t id = 1 + uint64_t(r) * side + c;
+            stations << "Station " << r << '-' << c << ',' << id << ",G,Grid,(grid)\n";
+            if (c + 1 < side)
+            {
+                const uint32_t duration = ride(random);
+                connections << id << ',' << id + 1 << ',' << duration << '\n' << id + 1 << ',' << id << ',' << duration << '\n';
+            }
+            if (r + 1 < side)
+            {
+                const uint32_t duration = ride(random);
+                connections << id << ',' << id + side << ',' << duration << '\n' << id + side << ',' << id << ',' << duration << '\n';
+            }
+        }
+    }
+    return paths;
+}
+
+/**
+ * @brief Plans journeys from one origin to random destinations, then again with the caches off.
+ * @param parser The network.
+ * @param side The side of the grid.
+ * @param queries The number of destinations.
+ * @return False if a duration differs from the uncached search.
+ */
+bool same_durations(travel::MetroNetworkParser& parser, uint32_t side, uint32_t queries)
+{
+    std::mt19937 random(queries);
+    std::uniform_int_distribution<uint64_t> station(1, uint64_t(side) * side);
+    const uint64_t origin = station(random);
+    std::vector<uint64_t> destinations(queries);
+    std::vector<uint64_t> durations(queries);
+    for (uint32_t q = 0; q < queries; ++q)
+    {
+        destinations[q] = station(random);
+        durations[q] = parser.plan_journey(origin, destinations[q]).duration;
+    }
+    const travel::RouteCacheStats stats = parser.get_cache_stats();
+    parser.set_cache_budget(0, 0);
+    bool ok = true;
+    for (uint32_t q = 0; q < queries; ++q)
+    {
+        ok = ok && parser.plan_journey(origin, destinations[q]).duration == durations[q];
+    }
+    parser.set_cache_budget(stats.routes.budget, stats.trees.budget);
+    return ok;
+}
+
+/**
+ * @brief Prints the tree cache counters of a run and whether they match what was expected.
+ * @return The expectation.
+ */
+bool report(const std::string& name, const travel::CacheStats& trees, bool expected)
+{
+    std::cout << (expected ? "ok    " : "FAIL  ") << name << ": " << trees.insertions << " trees stored, " << trees.hits
+              << " tree hits, " << trees.rejections << " rejected, budget " << trees.budget << " bytes\n";
+    return expected;
+}
+
+} // namespace
+
+/**
+ * @brief Runs the checks on a grid whose trees fit the default tree cache, then on one whose trees do not.
+ * @return 0 if every check passes, 1 otherwise.
+ */
+int main()
+{
+    const uint32_t queries = 40;
+    bool ok = true;
+    try
+    {
+        const std::filesystem::path directory = std::filesystem::temp_directory_path() / "travel_cache_check";
+        std::filesystem::create_directories(directory);
+
+        // 90,000 stations: about 1 MiB per tree, within a 2 MiB shard of the default 32 MiB budget.
+        std::pair<std::string, std::string> files = write_grid(300, directory);
+        {
+            travel::MetroNetworkParser parser(files.first, files.second);
+            parser.set_hot_source_threshold(4);
+            const bool durations = same_durations(parser, 300, queries);
+            const travel::CacheStats trees = parser.get_cache_stats().trees;
+            ok = report("300x300, default budget", trees, durations && trees.insertions == 1 && trees.hits >= queries - 5) && ok;
+        }
+
+        // 202,500 stations: about 2.3 MiB per tree, more than a shard holds until the budget is raised.
+        files = write_grid(450, directory);
+        {
+            travel::MetroNetworkParser parser(files.first, files.second);
+            parser.set_hot_source_threshold(4);
+            bool durations = same_durations(parser, 450, queries);
+            travel::CacheStats trees = parser.get_cache_stats().trees;
+            ok = report("450x450, default budget", trees, durations && trees.insertions == 0 && trees.rejections == 0) && ok;
+
+            parser.set_cache_budget(size_t(16) << 20, size_t(64) << 20);
+            durations = same_durations(parser, 450, queries);
+            trees = parser.get_cache_stats().trees;
+            ok = report("450x450, 64 MiB budget", trees, durations && trees.insertions == 1 && trees.hits >= queries - 5) && ok;
+        }
+        std::filesystem::remove_all(directory);
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+    return ok ? 0 : 1;
+}
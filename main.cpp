@@ -4,26 +4,13 @@
  */
 
 #include "src/MetroNetworkParser.hpp"
-#include "src/Navigation.hpp"
+#include "src/Metrics.hpp"
+#include "src/BatchRunner.hpp"
+#include "src/RouteServer.hpp"
 
-/**
- * @brief Function to normalize the input string by converting it to lowercase and removing punctuation.
- * @param input The input string to be normalized.
- * @return The normalized string.
- */
-std::string normalize(const std::string &input)
-{
-    std::string result;
-    result.reserve(input.size());
-    for (char c : input)
-    {
-        if (!std::ispunct(static_cast<unsigned char>(c)))
-        {
-            result.push_back(std::tolower(static_cast<unsigned char>(c)));
-        }
-    }
-    return result;
-}
+#include <chrono>
+#include <csignal>
+#include <cstring>
 
 /**
  * @brief Function to get user input for station name and line, and validate it against the database.
@@ -43,14 +30,19 @@ bool updated_getUserInput(const std::string &prompt, std::string &stationName, s
         if (stationName == "exit")
             return false;
 
-        std::cout << "Enter " << prompt << " station line: ";
+        std::cout << "Enter " << prompt << " station line (leave empty for any line): ";
         getline(std::cin, line);
         if (line == "exit")
             return false;
 
         // Validate the provided station and line against the database
         try
-        {            
+        {
+            if (line.empty())
+            {
+                metroNetworkParser.get_stop_area(stationName);
+                return true; // Every line of the station will be considered
+            }
             uint64_t stationId = metroNetworkParser.get_station_id_by_name_and_line(stationName, line);
             if (stationId != std::numeric_limits<uint64_t>::max())
             {
@@ -65,7 +57,7 @@ bool updated_getUserInput(const std::string &prompt, std::string &stationName, s
             std::cout << "-------------------" << std::endl;
             std::cout << "No exact match found. Here are some suggestions based on your input:" << std::endl;
             std::cout << "-------------------" << std::endl;
-            auto suggestions = metroNetworkParser.searchStations(normalize(stationName));
+            auto suggestions = metroNetworkParser.searchStations(stationName);
             for (const auto &suggestion : suggestions)
             {
                 std::cout << suggestion.first << " (Line " << suggestion.second << ")" << std::endl;
@@ -78,13 +70,211 @@ bool updated_getUserInput(const std::string &prompt, std::string &stationName, s
     }
 }
 
+/**
+ * @brief Prints the command line usage.
+ * @param program The name of the executable.
+ */
+void usage(const char* program)
+{
+    std::cerr << "Usage: " << program << " [network.snapshot] [--timetable <stop_times.csv>] [--batch <queries.csv|->] [--format csv|jsonl|binary] [--output <file|->] [--unordered] [--threads <n>] [--serve <socket|port>]\n"
+              << "  --timetable  load the trips of a GTFS stop_times file and ask for a departure time\n"
+              << "  --batch      solve every start,end line of the file (- for stdin) instead of asking interactively\n"
+              << "  --format     output format of the batch results (default csv)\n"
+              << "  --output     write the batch results to a file instead of stdout (- for stdout)\n"
+              << "  --unordered  write results as they are done instead of in input order\n"
+              << "  --threads    worker threads of the batch or the daemon, default one per hardware thread\n"
+              << "  --serve      answer route, area, search and ping requests on a Unix socket, or on 127.0.0.1 for a port number\n";
+}
+
+travel::RouteServer* running_server = nullptr; /**< The daemon stopped by SIGINT and SIGTERM. */
+
+/**
+ * @brief Stops the running daemon.
+ */
+extern "C" void stop_server(int)
+{
+    if (running_server)
+    {
+        running_server->stop();
+    }
+}
+
+/**
+ * @brief Runs the daemon mode: serves requests until SIGINT or SIGTERM.
+ * @param parser The loaded network.
+ * @param options The address, workers and limits of the daemon.
+ * @return 0 on success, 1 on error.
+ */
+int run_server(const travel::MetroNetworkParser &parser, const travel::ServerOptions &options)
+{
+    try
+    {
+        travel::RouteServer server(parser, options);
+        running_server = &server;
+        std::signal(SIGINT, stop_server);
+        std::signal(SIGTERM, stop_server);
+        std::cerr << "Serving on " << options.address << std::endl;
+        auto begin = std::chrono::steady_clock::now();
+        travel::ServerStats stats = server.run();
+        running_server = nullptr;
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+        std::cerr << "Answered " << stats.requests << " requests (" << stats.errors << " errors) from " << stats.connections
+                  << " connections in " << stats.batches << " batches, " << seconds << " s\n";
+    }
+    catch (const std::exception &e)
+    {
+        running_server = nullptr;
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+    if (travel::Metrics::enabled)
+    {
+        std::cerr << travel::Metrics::prometheus();
+    }
+    return 0;
+}
+
+/**
+ * @brief Runs the batch mode: solves every query of the input and writes the results.
+ * @param parser The loaded network.
+ * @param input The queries file, - for stdin.
+ * @param output The results file, empty or - for stdout.
+ * @param options The format, order and parallelism.
+ * @return 0 on success, 1 on error.
+ */
+int run_batch(const travel::MetroNetworkParser &parser, const std::string &input, const std::string &output, const travel::BatchOptions &options)
+{
+    std::ifstream input_file;
+    if (input != "-")
+    {
+        input_file.open(input);
+        if (!input_file)
+        {
+            std::cerr << "Error: cannot read " << input << std::endl;
+            return 1;
+        }
+    }
+    std::ofstream output_file;
+    if (!output.empty() && output != "-")
+    {
+        output_file.open(output, std::ios::binary);
+        if (!output_file)
+        {
+            std::cerr << "Error: cannot write " << output << std::endl;
+            return 1;
+        }
+    }
+    try
+    {
+        auto begin = std::chrono::steady_clock::now();
+        travel::BatchRunner runner(parser, options);
+        travel::BatchStats stats = runner.run(input_file.is_open() ? static_cast<std::istream &>(input_file) : std::cin,
+                                              output_file.is_open() ? static_cast<std::ostream &>(output_file) : std::cout);
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+        std::cerr << "Solved " << stats.queries << " queries (" << stats.unreachable << " unreachable, " << stats.errors
+                  << " errors) in " << seconds << " s, " << stats.queries / seconds << " queries/s\n";
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+    if (travel::Metrics::enabled)
+    {
+        std::cerr << travel::Metrics::prometheus();
+    }
+    return 0;
+}
+
 /**
  * @brief The main function of the Metro Network program.
+ * @param argc The number of command line arguments.
+ * @param argv The command line arguments: an optional snapshot path loads the network from it instead of the CSV
+ * files, --batch switches to the non-interactive batch mode and --serve to the daemon mode (see usage).
  * @return 0 on successful execution.
  */
-int main()
+int main(int argc, char* argv[])
 {
-    travel::MetroNetworkParser metroNetworkParser;
+    std::string snapshot, batch, output, timetable;
+    travel::BatchOptions options;
+    travel::ServerOptions server_options;
+    for (int i = 1; i < argc; ++i)
+    {
+        bool has_value = i + 1 < argc;
+        if (std::strcmp(argv[i], "--batch") == 0 && has_value)
+        {
+            batch = argv[++i];
+        }
+        else if (std::strcmp(argv[i], "--serve") == 0 && has_value)
+        {
+            server_options.address = argv[++i];
+        }
+        else if (std::strcmp(argv[i], "--timetable") == 0 && has_value)
+        {
+            timetable = argv[++i];
+        }
+        else if (std::strcmp(argv[i], "--output") == 0 && has_value)
+        {
+            output = argv[++i];
+        }
+        else if (std::strcmp(argv[i], "--threads") == 0 && has_value)
+        {
+            options.threads = std::strtoul(argv[++i], nullptr, 10);
+        }
+        else if (std::strcmp(argv[i], "--format") == 0 && has_value)
+        {
+            std::string format = argv[++i];
+            if (format == "csv")
+                options.format = travel::BatchFormat::Csv;
+            else if (format == "jsonl")
+                options.format = travel::BatchFormat::JsonLines;
+            else if (format == "binary")
+                options.format = travel::BatchFormat::Binary;
+            else
+            {
+                usage(argv[0]);
+                return 1;
+            }
+        }
+        else if (std::strcmp(argv[i], "--unordered") == 0)
+        {
+            options.ordered = false;
+        }
+        else if (argv[i][0] != '-' && snapshot.empty())
+        {
+            snapshot = argv[i];
+        }
+        else
+        {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    std::unique_ptr<travel::MetroNetworkParser> parser;
+    try
+    {
+        parser.reset(!snapshot.empty() ? new travel::MetroNetworkParser(snapshot) : new travel::MetroNetworkParser());
+        if (!timetable.empty())
+        {
+            parser->load_timetable(timetable);
+        }
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+    travel::MetroNetworkParser &metroNetworkParser = *parser;
+    if (!batch.empty())
+    {
+        return run_batch(metroNetworkParser, batch, output, options);
+    }
+    if (!server_options.address.empty())
+    {
+        server_options.threads = options.threads;
+        return run_server(metroNetworkParser, server_options);
+    }
 
     std::string startStationName, startStationLine, endStationName, endStationLine;
     while (true)
@@ -103,21 +293,63 @@ int main()
 
         try
         {
-            travel::Navigation *navigation = metroNetworkParser.getNavigation();
-            uint64_t endStationId = metroNetworkParser.get_station_id_by_name_and_line(endStationName, endStationLine);
-            std::cout << "endStationId: " << endStationId << std::endl;
-            uint64_t startStationId = metroNetworkParser.get_station_id_by_name_and_line(startStationName, startStationLine);
-            std::cout << "startStationId: " << startStationId << std::endl;
+            // A station without a line stands for all its platforms
+            std::vector<uint64_t> startStationIds = startStationLine.empty()
+                ? metroNetworkParser.get_stop_area(startStationName)
+                : std::vector<uint64_t>{metroNetworkParser.get_station_id_by_name_and_line(startStationName, startStationLine)};
+            std::vector<uint64_t> endStationIds = endStationLine.empty()
+                ? metroNetworkParser.get_stop_area(endStationName)
+                : std::vector<uint64_t>{metroNetworkParser.get_station_id_by_name_and_line(endStationName, endStationLine)};
+
+            if (!timetable.empty())
+            {
+                std::cout << "Departure time (HH:MM:SS, leave empty for the fastest route at any time): ";
+                std::string departureText;
+                getline(std::cin, departureText);
+                uint32_t departure = 0;
+                if (!departureText.empty() && !travel::Timetable::parse_time(departureText, departure))
+                {
+                    throw std::runtime_error("Invalid departure time: " + departureText);
+                }
+                if (!departureText.empty())
+                {
+                    // One scan from every start platform, stopped at the first end platform reached
+                    travel::TimedJourney best = metroNetworkParser.plan_timed_journey(startStationIds, endStationIds, departure);
+                    std::cout << "\n ----------------- \n Timetable route from "
+                            << startStationName << " to " << endStationName
+                            << ": \n ----------------- \n" << std::endl;
+                    metroNetworkParser.display_timed_journey(best);
+
+                    std::cout << "Do you want to search for another path? (yes to continue): ";
+                    std::string answer;
+                    getline(std::cin, answer);
+                    if (answer != "yes")
+                    {
+                        std::cout << "Exiting program.\n";
+                        break;
+                    }
+                    continue;
+                }
+            }
 
             // compute_and_display_travel
             std::cout << "\n ----------------- \n Shortest Path from " 
                     << startStationName << " to " << endStationName 
                     << ": \n ----------------- \n"<< std::endl;
 
-            auto path = metroNetworkParser.compute_and_display_travel(startStationId, endStationId);
+            travel::Journey journey = startStationIds.size() == 1 && endStationIds.size() == 1
+                ? metroNetworkParser.plan_journey(startStationIds.front(), endStationIds.front())
+                : metroNetworkParser.plan_journey(startStationIds, endStationIds);
+            uint64_t startStationId = journey.segments.empty() ? startStationIds.front() : journey.segments.front().first;
+            uint64_t endStationId = journey.segments.empty() ? endStationIds.front() : journey.segments.back().second;
+            if (journey.segments.empty() && journey.duration == 0)
+            {
+                endStationId = startStationId; // Both areas share a platform, not a route of 0-second connections
+            }
+            metroNetworkParser.display_journey(journey, startStationId, endStationId);
 
             std::cout << " \n ----------------- \n Total Distance: " 
-                    << navigation->getShortestDistance(endStationId) 
+                    << journey.duration 
                     << " units \n -----------------\n"<< std::endl;
 
             //   Prompt for another search
@@ -135,5 +367,9 @@ int main()
         }    
 
     }
+    if (travel::Metrics::enabled)
+    {
+        std::cerr << travel::Metrics::prometheus();
+    }
     return 0;
 }
@@ -0,0 +1,56 @@
+/**
+ * @file ArrayRef.hpp
+ * @brief Contains the declaration of the ArrayRef class template.
+ */
+
+#pragma once
+#ifndef ARRAY_REF_HPP
+#define ARRAY_REF_HPP
+
+#include <cstddef>
+#include <vector>
+
+namespace travel {
+
+    /**
+     * @class ArrayRef
+     * @brief Non-owning read-only view of a contiguous array.
+     *
+     * Lets the routing structures point either into their own vectors or straight into a memory-mapped
+     * snapshot. The owner of the memory is kept alive separately (see Graph and ContractionHierarchy).
+     */
+    template <typename T>
+    class ArrayRef {
+    public:
+        /**
+         * @brief Constructs an empty view.
+         */
+        ArrayRef() : ptr(nullptr), length(0) {}
+
+        /**
+         * @brief Constructs a view of length elements starting at data.
+         * @param data The first element.
+         * @param length The number of elements.
+         */
+        ArrayRef(const T* data, size_t length) : ptr(data), length(length) {}
+
+        /**
+         * @brief Constructs a view of a vector's current contents.
+         * @param vector The vector, which must outlive the view and not be resized.
+         */
+        ArrayRef(const std::vector<T>& vector) : ptr(vector.data()), length(vector.size()) {}
+
+        const T& operator[](size_t i) const { return ptr[i]; } /**< Element access, unchecked. */
+        const T* data() const { return ptr; } /**< Pointer to the first element. */
+        size_t size() const { return length; } /**< Number of elements. */
+        bool empty() const { return length == 0; } /**< Whether the view is empty. */
+        const T* begin() const { return ptr; } /**< Iterator to the first element. */
+        const T* end() const { return ptr + length; } /**< Iterator past the last element. */
+
+    private:
+        const T* ptr; /**< The first element. */
+        size_t length; /**< The number of elements. */
+    };
+}
+
+#endif // ARRAY_REF_HPP
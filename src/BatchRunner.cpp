@@ -0,0 +1,323 @@
+#include "BatchRunner.hpp"
+#include "MetroNetworkParser.hpp"
+#include "ThreadPool.hpp"
+
+#include <charconv>
+#include <condition_variable>
+#include <cstring>
+#include <mutex>
+
+namespace travel {
+
+namespace {
+
+/**
+ * @brief The outcome of a query, as written in binary records.
+ */
+enum class Status : uint8_t { Found = 0, Unreachable = 1, Error = 2 };
+
+void appendNumber(std::string& buffer, uint64_t value) {
+    char digits[20];
+    buffer.append(digits, std::to_chars(digits, digits + sizeof(digits), value).ptr);
+}
+
+template <typename T>
+void appendRaw(std::string& buffer, T value) {
+    char bytes[sizeof(T)];
+    std::memcpy(bytes, &value, sizeof(T));
+    buffer.append(bytes, sizeof(T));
+}
+
+/**
+ * @brief Appends a CSV field, quoted if it holds a comma, a quote or a line break.
+ */
+void appendCsvField(std::string& buffer, std::string_view field) {
+    if (field.find_first_of(",\"\r\n") == std::string_view::npos) {
+        buffer.append(field);
+        return;
+    }
+    buffer.push_back('"');
+    for (char c : field) {
+        if (c == '"') {
+            buffer.push_back('"');
+        }
+        buffer.push_back(c);
+    }
+    buffer.push_back('"');
+}
+
+/**
+ * @brief Appends a JSON string literal, escaping quotes, backslashes and control characters.
+ */
+void appendJsonString(std::string& buffer, std::string_view text) {
+    static const char hex[] = "0123456789abcdef";
+    buffer.push_back('"');
+    for (char c : text) {
+        if (c == '"' || c == '\\') {
+            buffer.push_back('\\');
+            buffer.push_back(c);
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            buffer.append("\\u00");
+            buffer.push_back(hex[(c >> 4) & 0xF]);
+            buffer.push_back(hex[c & 0xF]);
+        } else {
+            buffer.push_back(c);
+        }
+    }
+    buffer.push_back('"');
+}
+
+/**
+ * @brief Removes surrounding spaces, tabs and carriage returns.
+ */
+std::string_view trim(std::string_view field) {
+    const size_t begin = field.find_first_not_of(" \t\r");
+    if (begin == std::string_view::npos) {
+        return std::string_view();
+    }
+    return field.substr(begin, field.find_last_not_of(" \t\r") - begin + 1);
+}
+
+} // namespace
+
+/**
+ * @brief Creates a runner on a loaded network.
+ *
+ * @param parser The network, queried concurrently through its thread-safe plan_journey.
+ * @param options The output format, order and parallelism.
+ */
+BatchRunner::BatchRunner(const MetroNetworkParser& parser, const BatchOptions& options)
+    : parser(parser), options(options) {
+    if (this->options.chunk_size == 0) {
+        this->options.chunk_size = 1;
+    }
+}
+
+/**
+ * @brief Solves every query of a stream on the worker threads.
+ *
+ * Each worker loops on: read the next chunk of lines, solve it into its buffer, wait for its turn if
+ * the output is ordered, write the buffer. Chunks are numbered as they are read, so the turn of a
+ * chunk comes right after the previous chunk of the input.
+ *
+ * @param in The queries, one per line.
+ * @param out The results, in the format of the options.
+ * @return The counts of the run.
+ * @throws std::runtime_error if the output cannot be written.
+ */
+BatchStats BatchRunner::run(std::istream& in, std::ostream& out) {
+    if (options.format == BatchFormat::Csv) {
+        out << "query,start,end,duration,hops,error\n";
+    } else if (options.format == BatchFormat::Binary) {
+        std::string header("METROBAT");
+        appendRaw<uint32_t>(header, 1);
+        appendRaw<uint32_t>(header, 0);
+        out.write(header.data(), header.size());
+    }
+
+    std::mutex read_mutex, write_mutex;
+    std::condition_variable turn;
+    uint64_t next_query = 0, next_chunk = 0, next_write = 0;
+    bool input_done = false, failed = !out;
+    BatchStats total;
+
+    ThreadPool pool(options.threads);
+    pool.parallel_for(pool.size(), [&](size_t) {
+        std::vector<std::string> lines(options.chunk_size);
+        std::string buffer;
+        std::vector<uint64_t> hops;
+        BatchStats stats;
+        while (true) {
+            uint64_t first = 0, chunk = 0;
+            size_t count = 0;
+            {
+                std::lock_guard<std::mutex> lock(read_mutex);
+                if (input_done) {
+                    break;
+                }
+                while (count < lines.size() && std::getline(in, lines[count])) {
+                    ++count;
+                }
+                input_done = count < lines.size();
+                first = next_query;
+                chunk = next_chunk++;
+                next_query += count;
+            }
+
+            buffer.clear();
+            for (size_t i = 0; i < count; ++i) {
+                solve(first + i, lines[i], buffer, hops, stats);
+            }
+
+            std::unique_lock<std::mutex> lock(write_mutex);
+            if (options.ordered) {
+                turn.wait(lock, [&] { return next_write == chunk || failed; });
+            }
+            if (!failed && !out.write(buffer.data(), buffer.size())) {
+                failed = true;
+            }
+            ++next_write;
+            turn.notify_all();
+        }
+        std::lock_guard<std::mutex> lock(write_mutex);
+        total.queries += stats.queries;
+        total.unreachable += stats.unreachable;
+        total.errors += stats.errors;
+    }, 1);
+
+    if (failed || !out.flush()) {
+        throw std::runtime_error("Cannot write the batch results (BatchRunner::run)");
+    }
+    return total;
+}
+
+/**
+ * @brief Solves one query and appends its result to a buffer.
+ *
+ * Queries between two station IDs write their route straight into the hops buffer of the worker, so
+ * once it has grown to the longest route they allocate nothing.
+ *
+ * @param number The position of the query in the input.
+ * @param line The query line.
+ * @param buffer The output buffer of the calling worker.
+ * @param hops The route buffer of the calling worker, grown to the longest route.
+ * @param stats The counts of the calling worker.
+ */
+void BatchRunner::solve(uint64_t number, const std::string& line, std::string& buffer, std::vector<uint64_t>& hops, BatchStats& stats) const {
+    const std::string_view query = trim(line);
+    if (query.empty() || query.front() == '#') {
+        return;
+    }
+    ++stats.queries;
+
+    const size_t comma = query.find(',');
+    const std::string_view start = trim(query.substr(0, comma));
+    const std::string_view end = comma == std::string_view::npos ? std::string_view() : trim(query.substr(comma + 1));
+    Status status = Status::Found;
+    uint64_t duration = std::numeric_limits<uint64_t>::max();
+    size_t hop_count = 0;
+    std::string error;
+    try {
+        if (start.empty() || end.empty()) {
+            throw std::runtime_error("expected start,end");
+        }
+        uint64_t start_id = 0, end_id = 0;
+        if (CsvReader::parse_unsigned(start, start_id) && CsvReader::parse_unsigned(end, end_id)) {
+            JourneyResult result = parser.plan_journey(start_id, end_id, hops.data(), hops.size());
+            if (result.stations > hops.size()) {
+                hops.resize(result.stations);
+                result = parser.plan_journey(start_id, end_id, hops.data(), hops.size());
+            }
+            duration = result.duration;
+            hop_count = result.stations;
+        } else {
+            Journey journey;
+            const std::vector<uint64_t> starts = resolve(std::string(start));
+            const std::vector<uint64_t> ends = resolve(std::string(end));
+            journey = parser.plan_journey(starts, ends);
+            // A route of no connection starts on a platform shared by both stations.
+            start_id = starts.front();
+            for (uint64_t id : starts) {
+                if (std::find(ends.begin(), ends.end(), id) != ends.end()) {
+                    start_id = id;
+                    break;
+                }
+            }
+            duration = journey.duration;
+            if (duration != std::numeric_limits<uint64_t>::max()) {
+                hop_count = journey.segments.size() + 1;
+                hops.resize(std::max(hops.size(), hop_count));
+                hops[0] = journey.segments.empty() ? start_id : journey.segments.front().first;
+                for (size_t i = 0; i < journey.segments.size(); ++i) {
+                    hops[i + 1] = journey.segments[i].second;
+                }
+            }
+        }
+        if (duration == std::numeric_limits<uint64_t>::max()) {
+            status = Status::Unreachable;
+            ++stats.unreachable;
+            hop_count = 0;
+        }
+    } catch (const std::exception& e) {
+        status = Status::Error;
+        error = e.what();
+        ++stats.errors;
+    }
+
+    switch (options.format) {
+    case BatchFormat::Csv:
+        appendNumber(buffer, number);
+        buffer.push_back(',');
+        appendCsvField(buffer, start);
+        buffer.push_back(',');
+        appendCsvField(buffer, end);
+        buffer.push_back(',');
+        if (status == Status::Found) {
+            appendNumber(buffer, duration);
+        }
+        buffer.push_back(',');
+        for (size_t i = 0; i < hop_count; ++i) {
+            if (i) {
+                buffer.push_back(' ');
+            }
+            appendNumber(buffer, hops[i]);
+        }
+        buffer.push_back(',');
+        appendCsvField(buffer, error);
+        buffer.push_back('\n');
+        break;
+    case BatchFormat::JsonLines:
+        buffer.append("{\"query\":");
+        appendNumber(buffer, number);
+        buffer.append(",\"start\":");
+        appendJsonString(buffer, start);
+        buffer.append(",\"end\":");
+        appendJsonString(buffer, end);
+        buffer.append(",\"duration\":");
+        if (status == Status::Found) {
+            appendNumber(buffer, duration);
+        } else {
+            buffer.append("null");
+        }
+        buffer.append(",\"hops\":[");
+        for (size_t i = 0; i < hop_count; ++i) {
+            if (i) {
+                buffer.push_back(',');
+            }
+            appendNumber(buffer, hops[i]);
+        }
+        buffer.push_back(']');
+        if (status == Status::Error) {
+            buffer.append(",\"error\":");
+            appendJsonString(buffer, error);
+        }
+        buffer.append("}\n");
+        break;
+    case BatchFormat::Binary:
+        appendRaw<uint64_t>(buffer, number);
+        appendRaw<uint8_t>(buffer, static_cast<uint8_t>(status));
+        appendRaw<uint64_t>(buffer, status == Status::Found ? duration : std::numeric_limits<uint64_t>::max());
+        appendRaw<uint32_t>(buffer, static_cast<uint32_t>(hop_count));
+        for (size_t i = 0; i < hop_count; ++i) {
+            appendRaw<uint64_t>(buffer, hops[i]);
+        }
+        break;
+    }
+}
+
+/**
+ * @brief Resolves a query field to station IDs.
+ *
+ * @param field A station ID or name.
+ * @return The ID, or every platform of the named station.
+ * @throws std::runtime_error if no station has this name.
+ */
+std::vector<uint64_t> BatchRunner::resolve(const std::string& field) const {
+    uint64_t id = 0;
+    if (CsvReader::parse_unsigned(field, id)) {
+        return {id};
+    }
+    return parser.get_stop_area(field);
+}
+
+} // namespace travel
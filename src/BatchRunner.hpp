@@ -0,0 +1,105 @@
+/**
+ * @file BatchRunner.hpp
+ * @brief Contains the declaration of the BatchRunner class.
+ */
+
+#pragma once
+#ifndef BATCH_RUNNER_HPP
+#define BATCH_RUNNER_HPP
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <istream>
+#include <ostream>
+
+namespace travel {
+    class MetroNetworkParser;  // Forward declaration
+
+    /**
+     * @brief The output formats of a batch run.
+     */
+    enum class BatchFormat {
+        Csv,        /**< Header, then query,start,end,duration,hops,error rows; hops separated by spaces. */
+        JsonLines,  /**< One JSON object per query. */
+        Binary      /**< Magic "METROBAT", uint32 version, uint32 reserved, then one record per query. */
+    };
+
+    /**
+     * @brief Settings of a batch run.
+     */
+    struct BatchOptions {
+        BatchFormat format = BatchFormat::Csv; /**< The output format. */
+        bool ordered = true; /**< Write results in input order; otherwise chunk by chunk as they finish. */
+        size_t threads = 0; /**< Worker threads, 0 for one per hardware thread. */
+        size_t chunk_size = 4096; /**< Queries read, solved and written together by one worker. */
+    };
+
+    /**
+     * @brief Counts of a batch run.
+     */
+    struct BatchStats {
+        uint64_t queries = 0; /**< Queries read. */
+        uint64_t unreachable = 0; /**< Queries whose destination cannot be reached. */
+        uint64_t errors = 0; /**< Queries that could not be parsed or name an unknown station. */
+    };
+
+    /**
+     * @class BatchRunner
+     * @brief Streams start,end queries through plan_journey on a pool of worker threads.
+     *
+     * Each input line holds a start and an end separated by a comma. A field made of digits is a station
+     * ID; anything else is a station name standing for all its platforms, like in the interactive mode.
+     * Empty lines and lines starting with '#' are skipped, but still count in the query numbers.
+     *
+     * Workers take the input a chunk of lines at a time, solve the chunk into their own output buffer and
+     * write it with a single call, so the stream sees few large writes. In ordered mode a chunk waits
+     * until the previous one is written; otherwise chunks are written as soon as they are done, and the
+     * query number of each result tells where it came from.
+     *
+     * Binary records are, in native byte order: uint64 query number, uint8 status (0 found, 1 unreachable,
+     * 2 error), uint64 duration (max() unless found), uint32 hop count, then the uint64 station IDs.
+     */
+    class BatchRunner {
+    public:
+        /**
+         * @brief Creates a runner on a loaded network.
+         * @param parser The network, queried concurrently through its thread-safe plan_journey.
+         * @param options The output format, order and parallelism.
+         */
+        BatchRunner(const MetroNetworkParser& parser, const BatchOptions& options);
+
+        /**
+         * @brief Solves every query of a stream.
+         * @param in The queries, one per line.
+         * @param out The results, in the format of the options.
+         * @return The counts of the run.
+         * @throws std::runtime_error if the output cannot be written.
+         */
+        BatchStats run(std::istream& in, std::ostream& out);
+
+    private:
+        /**
+         * @brief Solves one query and appends its result to a buffer.
+         * @param number The position of the query in the input.
+         * @param line The query line.
+         * @param buffer The output buffer of the calling worker.
+         * @param hops The route buffer of the calling worker, grown to the longest route.
+         * @param stats The counts of the calling worker.
+         */
+        void solve(uint64_t number, const std::string& line, std::string& buffer, std::vector<uint64_t>& hops, BatchStats& stats) const;
+
+        /**
+         * @brief Resolves a query field to station IDs.
+         * @param field A station ID or name.
+         * @return The ID, or every platform of the named station.
+         * @throws std::runtime_error if no station has this name.
+         */
+        std::vector<uint64_t> resolve(const std::string& field) const;
+
+        const MetroNetworkParser& parser; /**< The network queried. */
+        BatchOptions options; /**< The settings of the run. */
+    };
+}
+
+#endif // BATCH_RUNNER_HPP
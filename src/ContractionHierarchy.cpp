@@ -0,0 +1,518 @@
+#include "ContractionHierarchy.hpp"
+#include "Snapshot.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+
+namespace travel {
+
+namespace {
+
+/**
+ * @brief An edge of the graph being contracted, seen from one of its endpoints.
+ */
+struct DynamicEdge {
+    uint32_t node;   /**< The other endpoint. */
+    uint32_t weight; /**< The duration in seconds. */
+    uint32_t middle; /**< The bypassed node for shortcuts, Graph::npos otherwise. */
+};
+
+/**
+ * @brief Mutable graph and scratch state used while ordering and contracting the nodes.
+ */
+class Contractor {
+public:
+    /**
+     * @brief Copies the graph into per-node edge lists.
+     * @param graph The graph to contract.
+     */
+    explicit Contractor(const Graph& graph)
+    : out(graph.node_count()), in(graph.node_count()), contracted(graph.node_count(), 0),
+      contracted_neighbors(graph.node_count(), 0), distance(graph.node_count(), QueryContext::infinity) {
+        for (uint32_t u = 0; u < graph.node_count(); ++u) {
+            for (uint32_t e = graph.edges_begin(u); e < graph.edges_end(u); ++e) {
+                uint32_t v = graph.target(e);
+                if (v != u) {
+                    out[u].push_back(DynamicEdge{v, graph.weight(e), Graph::npos});
+                    in[v].push_back(DynamicEdge{u, graph.weight(e), Graph::npos});
+                }
+            }
+        }
+    }
+
+    /**
+     * @brief Computes the contraction priority of a node: edge difference plus contracted neighbours.
+     * @param v The node.
+     * @return The priority, lower is contracted first.
+     */
+    int64_t priority(uint32_t v) {
+        int64_t removed = 0;
+        for (const DynamicEdge& edge : in[v]) removed += !contracted[edge.node];
+        for (const DynamicEdge& edge : out[v]) removed += !contracted[edge.node];
+        int64_t added = static_cast<int64_t>(contract(v, false));
+        return added - removed + contracted_neighbors[v];
+    }
+
+    /**
+     * @brief Contracts a node, or only counts the shortcuts its contraction would need.
+     * @param v The node.
+     * @param apply True to insert the shortcuts, false to only count them.
+     * @return The number of shortcuts needed.
+     */
+    size_t contract(uint32_t v, bool apply) {
+        // Shortcuts only touch out[u] and in[x] with u, x != v, so in[v] and out[v] stay valid here.
+        size_t needed = 0;
+        for (const DynamicEdge& incoming : in[v]) {
+            uint32_t u = incoming.node;
+            if (contracted[u]) continue;
+
+            bool any_target = false;
+            uint64_t limit = 0;
+            for (const DynamicEdge& outgoing : out[v]) {
+                if (!contracted[outgoing.node] && outgoing.node != u) {
+                    any_target = true;
+                    limit = std::max<uint64_t>(limit, uint64_t(incoming.weight) + outgoing.weight);
+                }
+            }
+            if (!any_target) continue;
+            witnessSearch(u, v, limit);
+
+            for (const DynamicEdge& outgoing : out[v]) {
+                uint32_t x = outgoing.node;
+                if (contracted[x] || x == u) continue;
+                uint64_t via = uint64_t(incoming.weight) + outgoing.weight;
+                if (distance[x] > via) {
+                    ++needed;
+                    if (apply) addShortcut(u, x, static_cast<uint32_t>(via), v);
+                }
+            }
+            clearWitness();
+        }
+        return needed;
+    }
+
+    /**
+     * @brief Marks a node as contracted and bumps the counter of its remaining neighbours.
+     * @param v The node.
+     */
+    void remove(uint32_t v) {
+        contracted[v] = 1;
+        for (const DynamicEdge& edge : in[v]) if (!contracted[edge.node]) ++contracted_neighbors[edge.node];
+        for (const DynamicEdge& edge : out[v]) if (!contracted[edge.node]) ++contracted_neighbors[edge.node];
+    }
+
+    std::vector<std::vector<DynamicEdge>> out; /**< Outgoing edges of each node, contracted heads included. */
+    std::vector<std::vector<DynamicEdge>> in; /**< Incoming edges of each node, contracted tails included. */
+    std::vector<char> contracted; /**< Whether each node has been contracted. */
+    std::vector<int64_t> contracted_neighbors; /**< Number of already contracted neighbours of each node. */
+
+private:
+    /**
+     * @brief Bounded Dijkstra from a node in the remaining graph, skipping the node being contracted.
+     * @param source The start node.
+     * @param skip The node being contracted.
+     * @param limit Distances above this bound are not needed.
+     */
+    void witnessSearch(uint32_t source, uint32_t skip, uint64_t limit) {
+        // Giving up early only adds a superfluous shortcut, never a wrong distance.
+        const size_t settle_limit = 500;
+        size_t settled = 0;
+        distance[source] = 0;
+        touched.push_back(source);
+        queue.push(0, source);
+        while (!queue.empty() && settled < settle_limit) {
+            uint64_t d = queue.top().first;
+            uint32_t u = queue.top().second;
+            queue.pop();
+            if (d > distance[u]) continue;
+            if (d > limit) break;
+            ++settled;
+            for (const DynamicEdge& edge : out[u]) {
+                uint32_t x = edge.node;
+                if (x == skip || contracted[x]) continue;
+                uint64_t candidate = d + edge.weight;
+                if (candidate < distance[x]) {
+                    if (distance[x] == QueryContext::infinity) touched.push_back(x);
+                    distance[x] = candidate;
+                    queue.push(candidate, x);
+                }
+            }
+        }
+    }
+
+    /**
+     * @brief Resets the distances touched by the last witness search.
+     */
+    void clearWitness() {
+        for (uint32_t u : touched) distance[u] = QueryContext::infinity;
+        touched.clear();
+        queue.clear();
+    }
+
+    /**
+     * @brief Inserts a shortcut, or lowers an existing edge between the same nodes.
+     * @param u The tail of the shortcut.
+     * @param x The head of the shortcut.
+     * @param weight The duration of the bypassed path.
+     * @param middle The contracted node.
+     */
+    void addShortcut(uint32_t u, uint32_t x, uint32_t weight, uint32_t middle) {
+        bool found = false;
+        for (DynamicEdge& edge : out[u]) {
+            if (edge.node == x) {
+                found = true;
+                if (weight < edge.weight) { edge.weight = weight; edge.middle = middle; }
+            }
+        }
+        if (!found) out[u].push_back(DynamicEdge{x, weight, middle});
+        found = false;
+        for (DynamicEdge& edge : in[x]) {
+            if (edge.node == u) {
+                found = true;
+                if (weight < edge.weight) { edge.weight = weight; edge.middle = middle; }
+            }
+        }
+        if (!found) in[x].push_back(DynamicEdge{u, weight, middle});
+    }
+
+    std::vector<uint64_t> distance; /**< Witness search distances, infinity when untouched. */
+    std::vector<uint32_t> touched; /**< Nodes whose witness distance must be reset. */
+    QueryContext::MinQueue queue; /**< Witness search priority queue. */
+};
+
+/**
+ * @brief The arrays of a hierarchy built in memory.
+ */
+struct HierarchyArrays {
+    std::vector<uint32_t> rank;
+    std::vector<uint32_t> up_offsets, up_targets, up_weights, up_middles;
+    std::vector<uint32_t> down_offsets, down_sources, down_weights, down_middles;
+};
+
+/**
+ * @brief Packs per-node edge lists into sorted CSR arrays.
+ */
+void toCsr(std::vector<std::vector<DynamicEdge>>& lists, std::vector<uint32_t>& offsets,
+           std::vector<uint32_t>& nodes, std::vector<uint32_t>& weights, std::vector<uint32_t>& middles) {
+    offsets.assign(lists.size() + 1, 0);
+    for (size_t u = 0; u < lists.size(); ++u) {
+        std::sort(lists[u].begin(), lists[u].end(),
+                  [](const DynamicEdge& a, const DynamicEdge& b) { return a.node < b.node; });
+        offsets[u] = static_cast<uint32_t>(nodes.size());
+        for (const DynamicEdge& edge : lists[u]) {
+            nodes.push_back(edge.node);
+            weights.push_back(edge.weight);
+            middles.push_back(edge.middle);
+        }
+    }
+    offsets[lists.size()] = static_cast<uint32_t>(nodes.size());
+}
+
+/**
+ * @brief Checks that every shortcut middle read from a snapshot is a node.
+ * @return True if each middle is below node_count or Graph::npos for an original edge.
+ */
+bool valid_middles(ArrayRef<uint32_t> middles, uint32_t node_count) {
+    return std::all_of(middles.begin(), middles.end(), [node_count](uint32_t m) { return m < node_count || m == Graph::npos; });
+}
+
+} // namespace
+
+/**
+ * @brief Orders the nodes, contracts them and builds the upward search graphs.
+ *
+ * Nodes are picked with a lazily updated priority queue keyed by edge difference plus the number
+ * of already contracted neighbours. When a node is contracted, its edges to the remaining (hence
+ * more important) nodes become its upward edges.
+ *
+ * @param graph The graph to preprocess.
+ */
+ContractionHierarchy::ContractionHierarchy(const Graph& graph) {
+    const uint32_t n = graph.node_count();
+    Contractor contractor(graph);
+    std::shared_ptr<HierarchyArrays> arrays = std::make_shared<HierarchyArrays>();
+    std::vector<uint32_t>& rank = arrays->rank;
+    rank.assign(n, 0);
+
+    typedef std::pair<int64_t, uint32_t> Candidate;
+    std::vector<Candidate> heap;
+    heap.reserve(n);
+    for (uint32_t v = 0; v < n; ++v) {
+        heap.emplace_back(contractor.priority(v), v);
+    }
+    std::make_heap(heap.begin(), heap.end(), std::greater<Candidate>());
+
+    std::vector<std::vector<DynamicEdge>> up(n), down(n);
+    uint32_t order = 0;
+    while (!heap.empty()) {
+        std::pop_heap(heap.begin(), heap.end(), std::greater<Candidate>());
+        uint32_t v = heap.back().second;
+        heap.pop_back();
+
+        // Lazy update: re-evaluate and put the node back if it is no longer the cheapest.
+        int64_t current = contractor.priority(v);
+        if (!heap.empty() && current > heap.front().first) {
+            heap.emplace_back(current, v);
+            std::push_heap(heap.begin(), heap.end(), std::greater<Candidate>());
+            continue;
+        }
+
+        contractor.contract(v, true);
+        for (const DynamicEdge& edge : contractor.out[v]) {
+            if (!contractor.contracted[edge.node]) up[v].push_back(edge);
+        }
+        for (const DynamicEdge& edge : contractor.in[v]) {
+            if (!contractor.contracted[edge.node]) down[v].push_back(edge);
+        }
+        contractor.remove(v);
+        rank[v] = order++;
+    }
+
+    toCsr(up, arrays->up_offsets, arrays->up_targets, arrays->up_weights, arrays->up_middles);
+    toCsr(down, arrays->down_offsets, arrays->down_sources, arrays->down_weights, arrays->down_middles);
+
+    this->rank = arrays->rank;
+    up_offsets = arrays->up_offsets;
+    up_targets = arrays->up_targets;
+    up_weights = arrays->up_weights;
+    up_middles = arrays->up_middles;
+    down_offsets = arrays->down_offsets;
+    down_sources = arrays->down_sources;
+    down_weights = arrays->down_weights;
+    down_middles = arrays->down_middles;
+    storage = arrays;
+    shortcuts = static_cast<uint32_t>(
+        std::count_if(up_middles.begin(), up_middles.end(), [](uint32_t m) { return m != Graph::npos; }) +
+        std::count_if(down_middles.begin(), down_middles.end(), [](uint32_t m) { return m != Graph::npos; }));
+}
+
+/**
+ * @brief Uses the hierarchy stored in a snapshot in place, without copying it.
+ *
+ * Every offset, head, middle and rank is checked to stay in range, since the checksum only catches corruption.
+ *
+ * @param snapshot The mapped snapshot, kept alive by the hierarchy.
+ * @throws std::runtime_error if a hierarchy section is missing or inconsistent.
+ */
+ContractionHierarchy::ContractionHierarchy(const Snapshot& snapshot)
+: storage(snapshot.file()),
+  rank(snapshot.array<uint32_t>(SnapshotSection::HierarchyRank)),
+  up_offsets(snapshot.array<uint32_t>(SnapshotSection::HierarchyUpOffsets)),
+  up_targets(snapshot.array<uint32_t>(SnapshotSection::HierarchyUpTargets)),
+  up_weights(snapshot.array<uint32_t>(SnapshotSection::HierarchyUpWeights)),
+  up_middles(snapshot.array<uint32_t>(SnapshotSection::HierarchyUpMiddles)),
+  down_offsets(snapshot.array<uint32_t>(SnapshotSection::HierarchyDownOffsets)),
+  down_sources(snapshot.array<uint32_t>(SnapshotSection::HierarchyDownSources)),
+  down_weights(snapshot.array<uint32_t>(SnapshotSection::HierarchyDownWeights)),
+  down_middles(snapshot.array<uint32_t>(SnapshotSection::HierarchyDownMiddles)) {
+    if (up_offsets.size() != rank.size() + 1 || down_offsets.size() != rank.size() + 1 ||
+        up_weights.size() != up_targets.size() || up_middles.size() != up_targets.size() ||
+        down_weights.size() != down_sources.size() || down_middles.size() != down_sources.size() ||
+        up_offsets[rank.size()] != up_targets.size() || down_offsets[rank.size()] != down_sources.size() ||
+        !is_valid_csr(up_offsets, up_targets, node_count()) || !is_valid_csr(down_offsets, down_sources, node_count()) ||
+        !valid_middles(up_middles, node_count()) || !valid_middles(down_middles, node_count()) ||
+        std::any_of(rank.begin(), rank.end(), [this](uint32_t r) { return r >= node_count(); })) {
+        throw std::runtime_error("Inconsistent hierarchy sections in snapshot (ContractionHierarchy)");
+    }
+    shortcuts = static_cast<uint32_t>(
+        std::count_if(up_middles.begin(), up_middles.end(), [](uint32_t m) { return m != Graph::npos; }) +
+        std::count_if(down_middles.begin(), down_middles.end(), [](uint32_t m) { return m != Graph::npos; }));
+}
+
+/**
+ * @brief Registers the hierarchy arrays as snapshot sections.
+ *
+ * @param writer The snapshot being written; the hierarchy must outlive the write.
+ */
+void ContractionHierarchy::save(SnapshotWriter& writer) const {
+    writer.add(SnapshotSection::HierarchyRank, rank);
+    writer.add(SnapshotSection::HierarchyUpOffsets, up_offsets);
+    writer.add(SnapshotSection::HierarchyUpTargets, up_targets);
+    writer.add(SnapshotSection::HierarchyUpWeights, up_weights);
+    writer.add(SnapshotSection::HierarchyUpMiddles, up_middles);
+    writer.add(SnapshotSection::HierarchyDownOffsets, down_offsets);
+    writer.add(SnapshotSection::HierarchyDownSources, down_sources);
+    writer.add(SnapshotSection::HierarchyDownWeights, down_weights);
+    writer.add(SnapshotSection::HierarchyDownMiddles, down_middles);
+}
+
+/**
+ * @brief Computes the shortest distance between two nodes.
+ *
+ * Both searches only relax upward edges. A direction stops once its queue head cannot improve
+ * the best meeting distance; stale queue entries are skipped.
+ *
+ * @param context The scratch state of the calling thread.
+ * @param source The dense index of the starting node.
+ * @param target The dense index of the destination node.
+ * @return The shortest distance, QueryContext::infinity if the target is unreachable.
+ */
+uint64_t ContractionHierarchy::query(QueryContext& context, uint32_t source, uint32_t target) const {
+    context.prepare(node_count());
+    context.target = target;
+    context.setForward(source, 0, QueryContext::none);
+    context.setBackward(target, 0, QueryContext::none);
+    context.queue.push(0, source);
+    context.queueBackward.push(0, target);
+
+    QueryContext::MinQueue& forward = context.queue;
+    QueryContext::MinQueue& backward = context.queueBackward;
+    while (true) {
+        bool forward_open = !forward.empty() && forward.top().first < context.bestDistance;
+        bool backward_open = !backward.empty() && backward.top().first < context.bestDistance;
+        if (!forward_open && !backward_open) break;
+
+        if (forward_open && (!backward_open || forward.top().first <= backward.top().first)) {
+            uint64_t d = forward.top().first;
+            uint32_t u = forward.top().second;
+            forward.pop();
+            if (d > context.distance(u)) {
+                TRAVEL_COUNT(context.counters.stale);
+                continue;
+            }
+            ++context.settled;
+            uint64_t remaining = context.distanceBackward(u);
+            if (remaining != QueryContext::infinity && d + remaining < context.bestDistance) {
+                context.bestDistance = d + remaining;
+                context.meeting = u;
+            }
+            for (uint32_t e = up_offsets[u]; e < up_offsets[u + 1]; ++e) {
+                TRAVEL_COUNT(context.counters.relaxed);
+                uint32_t v = up_targets[e];
+                uint64_t candidate = d + up_weights[e];
+                if (candidate < context.distance(v)) {
+                    context.setForward(v, candidate, u);
+                    forward.push(candidate, v);
+                    TRAVEL_COUNT(context.counters.pushes);
+                }
+            }
+        } else {
+            uint64_t d = backward.top().first;
+            uint32_t v = backward.top().second;
+            backward.pop();
+            if (d > context.distanceBackward(v)) {
+                TRAVEL_COUNT(context.counters.stale);
+                continue;
+            }
+            ++context.settled;
+            uint64_t reached = context.distance(v);
+            if (reached != QueryContext::infinity && d + reached < context.bestDistance) {
+                context.bestDistance = d + reached;
+                context.meeting = v;
+            }
+            for (uint32_t e = down_offsets[v]; e < down_offsets[v + 1]; ++e) {
+                TRAVEL_COUNT(context.counters.relaxed);
+                uint32_t u = down_sources[e];
+                uint64_t candidate = d + down_weights[e];
+                if (candidate < context.distanceBackward(u)) {
+                    context.setBackward(u, candidate, v);
+                    backward.push(candidate, u);
+                    TRAVEL_COUNT(context.counters.pushes);
+                }
+            }
+        }
+    }
+    return context.bestDistance;
+}
+
+/**
+ * @brief Unpacks the route found by the last query into original connections.
+ *
+ * @param context The scratch state of the last query.
+ * @return The dense indices of the nodes on the route, empty if the target was unreachable.
+ */
+std::vector<uint32_t> ContractionHierarchy::unpackPath(const QueryContext& context) const {
+    std::vector<uint32_t> path;
+    unpackPath(context, path);
+    return path;
+}
+
+/**
+ * @brief Unpacks the route found by the last query into a vector whose capacity is reused.
+ *
+ * The upward half is first laid out front to back in a per-thread buffer, so that once a thread has
+ * unpacked a route of this length nothing is allocated.
+ *
+ * @param context The scratch state of the last query.
+ * @param path Receives the dense indices of the nodes on the route, none if the target was unreachable.
+ */
+void ContractionHierarchy::unpackPath(const QueryContext& context, std::vector<uint32_t>& path) const {
+    static thread_local std::vector<uint32_t> upward;
+    path.clear();
+    if (context.meeting == QueryContext::none) {
+        return;
+    }
+
+    size_t length = 0;
+    for (uint32_t at = context.meeting; at != QueryContext::none; at = context.previous(at)) {
+        ++length;
+    }
+    upward.resize(length);
+    for (uint32_t at = context.meeting; at != QueryContext::none; at = context.previous(at)) {
+        upward[--length] = at;
+    }
+
+    path.push_back(upward.front());
+    for (size_t i = 0; i + 1 < upward.size(); ++i) {
+        unpackEdge(upward[i], upward[i + 1], path);
+    }
+    for (uint32_t at = context.meeting; context.next(at) != QueryContext::none; at = context.next(at)) {
+        unpackEdge(at, context.next(at), path);
+    }
+}
+
+/**
+ * @brief Finds the upward edge between two nodes that are consecutive on a query route.
+ *
+ * An edge is stored at its less important endpoint: in the forward graph if it goes up, in the
+ * backward graph if it comes down. Both are sorted per node, so this is a binary search.
+ *
+ * @param from The tail of the edge.
+ * @param to The head of the edge.
+ * @param weight Receives the duration of the edge.
+ * @return The node bypassed by the edge, or Graph::npos for an original connection.
+ */
+uint32_t ContractionHierarchy::findEdge(uint32_t from, uint32_t to, uint32_t& weight) const {
+    if (rank[from] < rank[to]) {
+        const uint32_t* first = up_targets.begin() + up_offsets[from];
+        const uint32_t* last = up_targets.begin() + up_offsets[from + 1];
+        size_t e = std::lower_bound(first, last, to) - up_targets.begin();
+        weight = up_weights[e];
+        return up_middles[e];
+    }
+    const uint32_t* first = down_sources.begin() + down_offsets[to];
+    const uint32_t* last = down_sources.begin() + down_offsets[to + 1];
+    size_t e = std::lower_bound(first, last, from) - down_sources.begin();
+    weight = down_weights[e];
+    return down_middles[e];
+}
+
+/**
+ * @brief Expands an edge of a query route into original connections.
+ *
+ * Uses an explicit stack, kept by the thread between queries: a shortcut from -> to via m is
+ * replaced by from -> m followed by m -> to.
+ *
+ * @param from The tail of the edge.
+ * @param to The head of the edge.
+ * @param path Receives the nodes after from, up to and including to.
+ */
+void ContractionHierarchy::unpackEdge(uint32_t from, uint32_t to, std::vector<uint32_t>& path) const {
+    static thread_local std::vector<std::pair<uint32_t, uint32_t>> stack;
+    stack.assign(1, std::make_pair(from, to));
+    while (!stack.empty()) {
+        std::pair<uint32_t, uint32_t> edge = stack.back();
+        stack.pop_back();
+        uint32_t weight;
+        uint32_t middle = findEdge(edge.first, edge.second, weight);
+        if (middle == Graph::npos) {
+            path.push_back(edge.second);
+        } else {
+            stack.emplace_back(middle, edge.second);
+            stack.emplace_back(edge.first, middle);
+        }
+    }
+}
+
+} // namespace travel
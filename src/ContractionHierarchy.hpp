@@ -0,0 +1,129 @@
+/**
+ * @file ContractionHierarchy.hpp
+ * @brief Contains the declaration of the ContractionHierarchy class.
+ */
+
+#pragma once
+#ifndef CONTRACTION_HIERARCHY_HPP
+#define CONTRACTION_HIERARCHY_HPP
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "ArrayRef.hpp"
+#include "Graph.hpp"
+#include "QueryContext.hpp"
+
+namespace travel {
+
+    /**
+     * @class ContractionHierarchy
+     * @brief Contraction Hierarchies index over a Graph for fast point-to-point queries.
+     *
+     * Preprocessing contracts the nodes one by one in order of importance and inserts a shortcut
+     * u -> x whenever the only shortest path between two remaining neighbours goes through the
+     * contracted node. A query is then a bidirectional Dijkstra that only follows edges towards more
+     * important nodes, which settles a few dozen nodes instead of the whole network. Shortcuts remember
+     * the node they bypass so the path can be unpacked back into original connections.
+     *
+     * The index is immutable once built and is queried with a caller-owned QueryContext, so it is
+     * safe to share between threads. Node indices are the dense indices of the source Graph.
+     */
+    class ContractionHierarchy {
+    public:
+        /**
+         * @brief Constructs an empty hierarchy.
+         */
+        ContractionHierarchy() = default;
+
+        /**
+         * @brief Orders the nodes, contracts them and builds the upward search graphs.
+         * @param graph The graph to preprocess.
+         */
+        explicit ContractionHierarchy(const Graph& graph);
+
+        /**
+         * @brief Uses the hierarchy stored in a snapshot in place, without copying it.
+         * @param snapshot The mapped snapshot, kept alive by the hierarchy.
+         * @throws std::runtime_error if a hierarchy section is missing or inconsistent.
+         */
+        explicit ContractionHierarchy(const Snapshot& snapshot);
+
+        /**
+         * @brief Registers the hierarchy arrays as snapshot sections.
+         * @param writer The snapshot being written; the hierarchy must outlive the write.
+         */
+        void save(SnapshotWriter& writer) const;
+
+        /**
+         * @brief Computes the shortest distance between two nodes.
+         *
+         * Afterwards the context holds the meeting node and both search trees, so unpackPath can
+         * rebuild the route.
+         * @param context The scratch state of the calling thread.
+         * @param source The dense index of the starting node.
+         * @param target The dense index of the destination node.
+         * @return The shortest distance, QueryContext::infinity if the target is unreachable.
+         */
+        uint64_t query(QueryContext& context, uint32_t source, uint32_t target) const;
+
+        /**
+         * @brief Unpacks the route found by the last query into original connections.
+         * @param context The scratch state of the last query.
+         * @return The dense indices of the nodes on the route, empty if the target was unreachable.
+         */
+        std::vector<uint32_t> unpackPath(const QueryContext& context) const;
+
+        /**
+         * @brief Unpacks the route found by the last query into a vector whose capacity is reused.
+         * @param context The scratch state of the last query.
+         * @param path Receives the dense indices of the nodes on the route, none if the target was unreachable.
+         */
+        void unpackPath(const QueryContext& context, std::vector<uint32_t>& path) const;
+
+        /**
+         * @brief Gets the number of nodes in the hierarchy.
+         * @return The number of nodes.
+         */
+        uint32_t node_count() const { return static_cast<uint32_t>(rank.size()); }
+
+        /**
+         * @brief Gets the number of shortcuts added by the contraction.
+         * @return The number of shortcut edges in the upward graphs.
+         */
+        uint32_t shortcut_count() const { return shortcuts; }
+
+    private:
+        /**
+         * @brief Finds the upward edge between two nodes that are consecutive on a query route.
+         * @param from The tail of the edge.
+         * @param to The head of the edge.
+         * @param weight Receives the duration of the edge.
+         * @return The node bypassed by the edge, or Graph::npos for an original connection.
+         */
+        uint32_t findEdge(uint32_t from, uint32_t to, uint32_t& weight) const;
+
+        /**
+         * @brief Expands an edge of a query route into original connections.
+         * @param from The tail of the edge.
+         * @param to The head of the edge.
+         * @param path Receives the nodes after from, up to and including to.
+         */
+        void unpackEdge(uint32_t from, uint32_t to, std::vector<uint32_t>& path) const;
+
+        std::shared_ptr<const void> storage; /**< Owner of the arrays below: the hierarchy's own vectors or a mapped snapshot. */
+        ArrayRef<uint32_t> rank; /**< Contraction order of each node, higher is more important. */
+        ArrayRef<uint32_t> up_offsets; /**< Edge range of each node in the upward forward graph. */
+        ArrayRef<uint32_t> up_targets; /**< Head u -> v of each upward forward edge, rank[v] > rank[u], sorted per node. */
+        ArrayRef<uint32_t> up_weights; /**< Duration of each upward forward edge. */
+        ArrayRef<uint32_t> up_middles; /**< Bypassed node of each upward forward shortcut, Graph::npos for original edges. */
+        ArrayRef<uint32_t> down_offsets; /**< Edge range of each node in the upward backward graph. */
+        ArrayRef<uint32_t> down_sources; /**< Tail x -> v of each edge stored at v, rank[x] > rank[v], sorted per node. */
+        ArrayRef<uint32_t> down_weights; /**< Duration of each upward backward edge. */
+        ArrayRef<uint32_t> down_middles; /**< Bypassed node of each upward backward shortcut, Graph::npos for original edges. */
+        uint32_t shortcuts = 0; /**< Number of shortcut edges kept in the upward graphs. */
+    };
+}
+
+#endif // CONTRACTION_HIERARCHY_HPP
@@ -0,0 +1,181 @@
+#include "CsvReader.hpp"
+
+#include <charconv>
+#include <cstring>
+#include <algorithm>
+
+namespace travel {
+
+/**
+ * @brief Starts reading a buffer; a leading UTF-8 byte order mark is skipped.
+ *
+ * @param buffer The CSV text, which must outlive the reader and the returned fields.
+ */
+CsvReader::CsvReader(std::string_view buffer)
+: cursor(buffer.data()), end(buffer.data() + buffer.size()) {
+    if (buffer.size() >= 3 && std::memcmp(cursor, "\xEF\xBB\xBF", 3) == 0) {
+        cursor += 3;
+    }
+}
+
+/**
+ * @brief Reads the next record, skipping blank lines.
+ *
+ * @param fields Receives the fields of the record, without their quotes.
+ * @param error Receives the line and reason when the record is malformed.
+ * @return Whether a record, an error or the end of the buffer was reached.
+ */
+CsvReader::Status CsvReader::next(std::vector<std::string_view>& fields, CsvError& error) {
+    fields.clear();
+    scratch.clear();
+    unescaped.clear();
+
+    // Blank lines carry no record, not even an empty one
+    while (cursor != end && (*cursor == '\n' || *cursor == '\r')) {
+        if (*cursor == '\n') {
+            ++current_line;
+        }
+        ++cursor;
+    }
+    if (cursor == end) {
+        return Status::End;
+    }
+    record_line = current_line;
+
+    while (true) {
+        if (*cursor == '"') {
+            if (!read_quoted(fields, error)) {
+                return Status::Error;
+            }
+        } else {
+            const char* start = cursor;
+            while (cursor != end && *cursor != ',' && *cursor != '\n' && *cursor != '\r') {
+                if (*cursor == '"') {
+                    return fail(error, "quote inside an unquoted field");
+                }
+                ++cursor;
+            }
+            fields.emplace_back(start, static_cast<size_t>(cursor - start));
+        }
+
+        if (cursor == end) {
+            break;
+        }
+        if (*cursor == ',') {
+            ++cursor;
+            if (cursor == end) {
+                fields.emplace_back(); // Trailing empty field
+                break;
+            }
+            continue;
+        }
+        if (*cursor == '\r') {
+            ++cursor;
+            if (cursor != end && *cursor != '\n') {
+                return fail(error, "carriage return inside an unquoted field");
+            }
+            if (cursor == end) {
+                break;
+            }
+        }
+        if (*cursor == '\n') {
+            ++cursor;
+            ++current_line;
+            break;
+        }
+        return fail(error, "unexpected character after a closing quote");
+    }
+
+    // scratch no longer grows, so the unescaped views can point into it now
+    for (const auto& copy : unescaped) {
+        fields[copy.first] = std::string_view(scratch.data() + copy.second.first, copy.second.second);
+    }
+    return Status::Record;
+}
+
+/**
+ * @brief Reads a quoted field; the cursor is on the opening quote.
+ *
+ * @param fields Receives the field, or a placeholder for fields unescaped into scratch.
+ * @param error Receives the reason when the field is malformed.
+ * @return False if the field is malformed.
+ */
+bool CsvReader::read_quoted(std::vector<std::string_view>& fields, CsvError& error) {
+    ++cursor;
+    const char* start = cursor;
+    const char* segment = cursor;
+    size_t copy_offset = 0;
+    bool copied = false;
+    while (true) {
+        const char* quote = static_cast<const char*>(std::memchr(cursor, '"', static_cast<size_t>(end - cursor)));
+        if (quote == nullptr) {
+            current_line += static_cast<size_t>(std::count(cursor, end, '\n'));
+            cursor = end;
+            error.line = record_line;
+            error.message = "unterminated quoted field";
+            return false;
+        }
+        current_line += static_cast<size_t>(std::count(cursor, quote, '\n'));
+        if (quote + 1 != end && quote[1] == '"') {
+            // Escaped quote: keep the text up to and including one quote, skip the other
+            if (!copied) {
+                copied = true;
+                copy_offset = scratch.size();
+            }
+            scratch.append(segment, static_cast<size_t>(quote + 1 - segment));
+            segment = quote + 2;
+            cursor = quote + 2;
+            continue;
+        }
+        cursor = quote + 1;
+        if (copied) {
+            scratch.append(segment, static_cast<size_t>(quote - segment));
+            unescaped.emplace_back(fields.size(), std::make_pair(copy_offset, scratch.size() - copy_offset));
+            fields.emplace_back();
+        } else {
+            fields.emplace_back(start, static_cast<size_t>(quote - start));
+        }
+        return true;
+    }
+}
+
+/**
+ * @brief Reports an error and moves the cursor past the end of the current line.
+ *
+ * @param error Receives the line and reason.
+ * @param message What is wrong with the record.
+ * @return Status::Error.
+ */
+CsvReader::Status CsvReader::fail(CsvError& error, const char* message) {
+    error.line = record_line;
+    error.message = message;
+    const char* newline = static_cast<const char*>(std::memchr(cursor, '\n', static_cast<size_t>(end - cursor)));
+    if (newline == nullptr) {
+        cursor = end;
+    } else {
+        cursor = newline + 1;
+        ++current_line;
+    }
+    return Status::Error;
+}
+
+/**
+ * @brief Parses a whole field as an unsigned integer, ignoring surrounding spaces.
+ *
+ * @param field The field to parse.
+ * @param value Receives the parsed value.
+ * @return False if the field is empty, holds anything but digits or overflows.
+ */
+bool CsvReader::parse_unsigned(std::string_view field, uint64_t& value) {
+    while (!field.empty() && field.front() == ' ') {
+        field.remove_prefix(1);
+    }
+    while (!field.empty() && field.back() == ' ') {
+        field.remove_suffix(1);
+    }
+    const char* last = field.data() + field.size();
+    std::from_chars_result result = std::from_chars(field.data(), last, value);
+    return !field.empty() && result.ec == std::errc() && result.ptr == last;
+}
+
+} // namespace travel
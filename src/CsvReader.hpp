@@ -0,0 +1,104 @@
+/**
+ * @file CsvReader.hpp
+ * @brief Contains the declaration of the CsvReader class.
+ */
+
+#pragma once
+#ifndef CSV_READER_HPP
+#define CSV_READER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <utility>
+#include <string_view>
+
+namespace travel {
+
+    /**
+     * @brief A malformed record found while reading a CSV buffer.
+     */
+    struct CsvError {
+        size_t line = 0;      /**< The 1-based line the record starts on. */
+        std::string message;  /**< What is wrong with the record. */
+    };
+
+    /**
+     * @class CsvReader
+     * @brief Streaming RFC 4180 reader over an in-memory buffer, typically a MappedFile.
+     *
+     * Records are returned as string_views into the buffer, so reading a well-formed file allocates
+     * nothing once the caller's field vector has grown to the widest record. Quoted fields may hold
+     * commas and line breaks; only those containing an escaped quote ("") are copied, into a scratch
+     * string owned by the reader. Every view stays valid until the next call to next().
+     *
+     * Errors never throw: a malformed record is reported with its line number and the reader resumes
+     * at the following line, so one bad row does not abort a whole feed.
+     */
+    class CsvReader {
+    public:
+        /**
+         * @brief The outcome of CsvReader::next.
+         */
+        enum class Status {
+            Record,  /**< A record was read into the fields. */
+            Error,   /**< The record was malformed; the error is filled in and the line skipped. */
+            End      /**< The buffer is exhausted. */
+        };
+
+        /**
+         * @brief Starts reading a buffer; a leading UTF-8 byte order mark is skipped.
+         * @param buffer The CSV text, which must outlive the reader and the returned fields.
+         */
+        explicit CsvReader(std::string_view buffer);
+
+        /**
+         * @brief Reads the next record, skipping blank lines.
+         * @param fields Receives the fields of the record, without their quotes.
+         * @param error Receives the line and reason when the record is malformed.
+         * @return Whether a record, an error or the end of the buffer was reached.
+         */
+        Status next(std::vector<std::string_view>& fields, CsvError& error);
+
+        /**
+         * @brief Gets the line on which the last record started.
+         * @return The 1-based line number, 0 before the first record.
+         */
+        size_t line() const { return record_line; }
+
+        /**
+         * @brief Parses a whole field as an unsigned integer, ignoring surrounding spaces.
+         * @param field The field to parse.
+         * @param value Receives the parsed value.
+         * @return False if the field is empty, holds anything but digits or overflows.
+         */
+        static bool parse_unsigned(std::string_view field, uint64_t& value);
+
+    private:
+        /**
+         * @brief Reads a quoted field; the cursor is on the opening quote.
+         * @param fields Receives the field, or a placeholder for fields unescaped into scratch.
+         * @param error Receives the reason when the field is malformed.
+         * @return False if the field is malformed.
+         */
+        bool read_quoted(std::vector<std::string_view>& fields, CsvError& error);
+
+        /**
+         * @brief Reports an error and moves the cursor past the end of the current line.
+         * @param error Receives the line and reason.
+         * @param message What is wrong with the record.
+         * @return Status::Error.
+         */
+        Status fail(CsvError& error, const char* message);
+
+        const char* cursor; /**< The next unread byte. */
+        const char* end; /**< One past the last byte of the buffer. */
+        size_t current_line = 1; /**< The line the cursor is on. */
+        size_t record_line = 0; /**< The line the last record started on. */
+        std::string scratch; /**< Unescaped copies of the fields holding "" in the current record. */
+        std::vector<std::pair<size_t, std::pair<size_t, size_t>>> unescaped; /**< (field, (offset, length) in scratch) of those fields. */
+    };
+}
+
+#endif // CSV_READER_HPP
@@ -0,0 +1,396 @@
+#include "DistanceTable.hpp"
+#include "QueryContext.hpp"
+#include "Snapshot.hpp"
+#include "ThreadPool.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define DISTANCE_TABLE_X86 1
+#endif
+
+namespace travel {
+
+const uint32_t DistanceTable::unreachable;
+const uint16_t DistanceTable::none;
+const uint32_t DistanceTable::max_nodes;
+
+namespace {
+
+const uint32_t block = 64; /**< Side of the Floyd-Warshall tiles, a multiple of the 8 AVX2 lanes. */
+const uint32_t infinite = 0x3FFFFFFF; /**< Working duration of unreachable pairs; two of them add up without overflow. */
+const uint32_t auto_limit = 2048; /**< Largest graph Method::Auto builds with Floyd-Warshall. */
+
+/**
+ * @brief The arrays of a table built in memory.
+ */
+struct TableArrays {
+    std::vector<uint32_t> durations;
+    std::vector<uint16_t> next_hops;
+};
+
+/**
+ * @brief A function relaxing the tile (i0, j0) of a matrix through the nodes of the block k0.
+ */
+typedef void (*TileKernel)(uint32_t* matrix, size_t stride, uint32_t i0, uint32_t j0, uint32_t k0);
+
+/**
+ * @brief Relaxes the tile (i0, j0) through the intermediate nodes of the tile column k0.
+ *
+ * Plain min-plus product D[i][j] = min(D[i][j], D[i][k] + D[k][j]) with k outermost, as required
+ * when the tile being updated is also one of the tiles read: the diagonal tile, its row and column.
+ * The row k is not changed by step k (D[k][k] = 0), so a whole row can be relaxed at once.
+ */
+void relaxTileScalar(uint32_t* matrix, size_t stride, uint32_t i0, uint32_t j0, uint32_t k0) {
+    for (uint32_t k = k0; k < k0 + block; ++k) {
+        const uint32_t* row_k = matrix + k * stride;
+        for (uint32_t i = i0; i < i0 + block; ++i) {
+            uint32_t* row_i = matrix + i * stride;
+            const uint32_t via = row_i[k];
+            if (via >= infinite) {
+                continue;
+            }
+            for (uint32_t j = j0; j < j0 + block; ++j) {
+                row_i[j] = std::min(row_i[j], via + row_k[j]);
+            }
+        }
+    }
+}
+
+/**
+ * @brief relaxTileScalar() for a tile outside the row and column of k0, which only reads other tiles.
+ *
+ * Each row of the tile is finished against all of k0's block before moving to the next one.
+ */
+void relaxIndependentTileScalar(uint32_t* matrix, size_t stride, uint32_t i0, uint32_t j0, uint32_t k0) {
+    for (uint32_t i = i0; i < i0 + block; ++i) {
+        uint32_t* row_i = matrix + i * stride;
+        for (uint32_t k = k0; k < k0 + block; ++k) {
+            const uint32_t via = row_i[k];
+            if (via >= infinite) {
+                continue;
+            }
+            const uint32_t* row_k = matrix + k * stride;
+            for (uint32_t j = j0; j < j0 + block; ++j) {
+                row_i[j] = std::min(row_i[j], via + row_k[j]);
+            }
+        }
+    }
+}
+
+#ifdef DISTANCE_TABLE_X86
+/**
+ * @brief relaxTileScalar() eight columns at a time.
+ *
+ * Values never exceed 2 * infinite, so the signed AVX2 minimum is exact.
+ */
+__attribute__((target("avx2")))
+void relaxTileAvx2(uint32_t* matrix, size_t stride, uint32_t i0, uint32_t j0, uint32_t k0) {
+    for (uint32_t k = k0; k < k0 + block; ++k) {
+        const uint32_t* row_k = matrix + k * stride + j0;
+        for (uint32_t i = i0; i < i0 + block; ++i) {
+            uint32_t* row_i = matrix + i * stride;
+            if (row_i[k] >= infinite) {
+                continue;
+            }
+            const __m256i via = _mm256_set1_epi32(static_cast<int>(row_i[k]));
+            row_i += j0;
+            for (uint32_t q = 0; q < block / 8; ++q) {
+                __m256i candidate = _mm256_add_epi32(via, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(row_k + 8 * q)));
+                __m256i current = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(row_i + 8 * q));
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(row_i + 8 * q), _mm256_min_epi32(current, candidate));
+            }
+        }
+    }
+}
+
+/**
+ * @brief relaxIndependentTileScalar() with the 64 values of a tile row held in eight AVX2 registers.
+ *
+ * Values never exceed 2 * infinite, so the signed AVX2 minimum is exact.
+ */
+__attribute__((target("avx2")))
+void relaxIndependentTileAvx2(uint32_t* matrix, size_t stride, uint32_t i0, uint32_t j0, uint32_t k0) {
+    for (uint32_t i = i0; i < i0 + block; ++i) {
+        uint32_t* row_i = matrix + i * stride;
+        __m256i row[block / 8];
+        for (uint32_t q = 0; q < block / 8; ++q) {
+            row[q] = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(row_i + j0 + 8 * q));
+        }
+        for (uint32_t k = k0; k < k0 + block; ++k) {
+            if (row_i[k] >= infinite) {
+                continue;
+            }
+            const __m256i via = _mm256_set1_epi32(static_cast<int>(row_i[k]));
+            const uint32_t* row_k = matrix + k * stride + j0;
+            for (uint32_t q = 0; q < block / 8; ++q) {
+                __m256i candidate = _mm256_add_epi32(via, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(row_k + 8 * q)));
+                row[q] = _mm256_min_epi32(row[q], candidate);
+            }
+        }
+        for (uint32_t q = 0; q < block / 8; ++q) {
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(row_i + j0 + 8 * q), row[q]);
+        }
+    }
+}
+#endif
+
+/**
+ * @brief Picks the tile kernels for the processor running the build.
+ * @param dependent Receives the kernel of the tiles in the row and column of the diagonal tile.
+ * @param independent Receives the kernel of the other tiles.
+ */
+void selectTileKernels(TileKernel& dependent, TileKernel& independent) {
+    dependent = relaxTileScalar;
+    independent = relaxIndependentTileScalar;
+#ifdef DISTANCE_TABLE_X86
+    if (__builtin_cpu_supports("avx2")) {
+        dependent = relaxTileAvx2;
+        independent = relaxIndependentTileAvx2;
+    }
+#endif
+}
+
+/**
+ * @brief Computes the table with a blocked Floyd-Warshall.
+ *
+ * For each diagonal tile k: close the tile itself, then its row and column of tiles, then every
+ * other tile, whose updates only read tiles of row and column k; the last phase runs one row of
+ * tiles per task. Matrices are padded to whole tiles with isolated nodes.
+ *
+ * Working values are (duration << shift) + hops like the keys of searchRow(), so every connection
+ * costs at least 1. The next hop of (u, t) is then any neighbour v with w(u, v) + D[v][t] = D[u][t],
+ * whose own value is strictly smaller: the next hops cannot loop over zero-duration transfers, and
+ * recovering them afterwards (one pass over the edges per column) keeps them out of the kernel.
+ *
+ * @param shift The number of bits of a hop count, such that (total weight << shift) + nodes < infinite.
+ */
+void floydWarshall(const Graph& graph, ThreadPool& pool, uint32_t shift, TableArrays& table) {
+    const uint32_t n = graph.node_count();
+    const size_t stride = (n + block - 1) / block * block;
+    const uint32_t tiles = static_cast<uint32_t>(stride / block);
+    std::vector<uint32_t> values(stride * stride, infinite);
+    for (uint32_t u = 0; u < stride; ++u) {
+        values[u * stride + u] = 0;
+    }
+    for (uint32_t u = 0; u < n; ++u) {
+        for (uint32_t e = graph.edges_begin(u); e < graph.edges_end(u); ++e) {
+            const uint32_t v = graph.target(e);
+            if (v != u) {
+                values[u * stride + v] = std::min(values[u * stride + v], (graph.weight(e) << shift) + 1);
+            }
+        }
+    }
+
+    uint32_t* matrix = values.data();
+    TileKernel relax_dependent, relax;
+    selectTileKernels(relax_dependent, relax);
+    for (uint32_t kb = 0; kb < tiles; ++kb) {
+        const uint32_t k0 = kb * block;
+        relax_dependent(matrix, stride, k0, k0, k0);
+        for (uint32_t b = 0; b < tiles; ++b) {
+            if (b != kb) {
+                relax_dependent(matrix, stride, k0, b * block, k0);
+                relax_dependent(matrix, stride, b * block, k0, k0);
+            }
+        }
+        pool.parallel_for(tiles, [&](size_t ib) {
+            if (ib == kb) {
+                return;
+            }
+            for (uint32_t jb = 0; jb < tiles; ++jb) {
+                if (jb != kb) {
+                    relax(matrix, stride, static_cast<uint32_t>(ib) * block, jb * block, k0);
+                }
+            }
+        }, 1);
+    }
+
+    table.durations.resize(size_t(n) * n);
+    table.next_hops.assign(size_t(n) * n, DistanceTable::none);
+    pool.parallel_for(n, [&](size_t source) {
+        const uint32_t u = static_cast<uint32_t>(source);
+        const uint32_t* row_u = matrix + u * stride;
+        uint32_t* durations = table.durations.data() + size_t(u) * n;
+        uint16_t* next_hops = table.next_hops.data() + size_t(u) * n;
+        for (uint32_t t = 0; t < n; ++t) {
+            durations[t] = row_u[t] >= infinite ? DistanceTable::unreachable : row_u[t] >> shift;
+        }
+        for (uint32_t e = graph.edges_begin(u); e < graph.edges_end(u); ++e) {
+            const uint32_t v = graph.target(e);
+            const uint32_t* row_v = matrix + v * stride;
+            const uint32_t value = (graph.weight(e) << shift) + 1;
+            for (uint32_t t = 0; t < n; ++t) {
+                if (next_hops[t] == DistanceTable::none && t != u && row_u[t] < infinite && value + row_v[t] == row_u[t]) {
+                    next_hops[t] = static_cast<uint16_t>(v);
+                }
+            }
+        }
+    });
+}
+
+/**
+ * @brief Per-thread state of the one-to-all searches of the Dijkstra builder.
+ */
+struct RowScratch {
+    std::vector<uint64_t> key; /**< (duration << 16) + hops of each node, the lexicographic search key. */
+    std::vector<uint32_t> first; /**< First hop of each settled node. */
+    RadixQueue queue;
+};
+
+/**
+ * @brief Computes one row of the table with a one-to-all search.
+ *
+ * Keys order routes by duration, then by number of hops (at most max_nodes, hence 16 bits), so the
+ * sub-route from any node of a row's route is itself as short in hops as that node's own row: the
+ * next hops of successive rows always get closer to the destination.
+ */
+void searchRow(const Graph& graph, uint32_t source, TableArrays& table) {
+    static thread_local RowScratch scratch;
+    const uint32_t n = graph.node_count();
+    scratch.key.assign(n, QueryContext::infinity);
+    scratch.first.assign(n, DistanceTable::none);
+    scratch.queue.clear();
+    scratch.key[source] = 0;
+    scratch.queue.push(0, source);
+    while (!scratch.queue.empty()) {
+        const QueueEntry top = scratch.queue.top();
+        scratch.queue.pop();
+        const uint32_t u = top.second;
+        if (top.first != scratch.key[u]) {
+            continue;
+        }
+        for (uint32_t e = graph.edges_begin(u); e < graph.edges_end(u); ++e) {
+            const uint32_t v = graph.target(e);
+            const uint64_t key = top.first + (uint64_t(graph.weight(e)) << 16) + 1;
+            if (key < scratch.key[v]) {
+                scratch.key[v] = key;
+                scratch.first[v] = u == source ? v : scratch.first[u];
+                scratch.queue.push(key, v);
+            }
+        }
+    }
+
+    uint32_t* durations = table.durations.data() + size_t(source) * n;
+    uint16_t* next_hops = table.next_hops.data() + size_t(source) * n;
+    for (uint32_t v = 0; v < n; ++v) {
+        const uint64_t duration = scratch.key[v] >> 16;
+        durations[v] = scratch.key[v] == QueryContext::infinity || duration >= DistanceTable::unreachable
+                           ? DistanceTable::unreachable : static_cast<uint32_t>(duration);
+        next_hops[v] = v == source ? DistanceTable::none : static_cast<uint16_t>(scratch.first[v]);
+    }
+}
+
+} // namespace
+
+/**
+ * @brief Computes the table of a graph.
+ *
+ * Method::FloydWarshall falls back to Dijkstra rows when the total edge weight and hop count could
+ * overflow its 30-bit working values.
+ *
+ * @param graph The graph.
+ * @param pool The worker threads.
+ * @param method The algorithm.
+ * @throws std::runtime_error if the graph has more than max_nodes nodes.
+ */
+DistanceTable::DistanceTable(const Graph& graph, ThreadPool& pool, Method method) : nodes(graph.node_count()), requested(method) {
+    if (nodes > max_nodes) {
+        throw std::runtime_error("Too many stations for a distance table (DistanceTable)");
+    }
+    uint64_t total_weight = 0;
+    for (uint32_t e = 0; e < graph.edge_count(); ++e) {
+        total_weight += graph.weight(e);
+    }
+    if (method == Method::Auto) {
+        method = nodes <= auto_limit ? Method::FloydWarshall : Method::Dijkstra;
+    }
+    uint32_t shift = 0;
+    while ((uint64_t(1) << shift) <= nodes) {
+        ++shift;
+    }
+    if ((total_weight << shift) + nodes >= infinite) {
+        method = Method::Dijkstra;
+    }
+
+    std::shared_ptr<TableArrays> arrays = std::make_shared<TableArrays>();
+    if (method == Method::FloydWarshall) {
+        floydWarshall(graph, pool, shift, *arrays);
+    } else {
+        arrays->durations.resize(size_t(nodes) * nodes);
+        arrays->next_hops.resize(size_t(nodes) * nodes);
+        pool.parallel_for(nodes, [&](size_t source) { searchRow(graph, static_cast<uint32_t>(source), *arrays); });
+    }
+    durations = arrays->durations;
+    next_hops = arrays->next_hops;
+    storage = arrays;
+}
+
+/**
+ * @brief Uses the table stored in a snapshot in place, without copying it.
+ *
+ * Every next hop is checked to be a node, since the checksum only catches corruption.
+ *
+ * @param snapshot The mapped snapshot, kept alive by the table.
+ * @throws std::runtime_error if a table section is missing or inconsistent.
+ */
+DistanceTable::DistanceTable(const Snapshot& snapshot)
+: storage(snapshot.file()),
+  durations(snapshot.array<uint32_t>(SnapshotSection::DistanceTableDurations)),
+  next_hops(snapshot.array<uint16_t>(SnapshotSection::DistanceTableNextHops)) {
+    uint64_t side = 0;
+    while ((side + 1) * (side + 1) <= durations.size()) {
+        ++side;
+    }
+    if (side * side != durations.size() || next_hops.size() != durations.size() || side > max_nodes ||
+        std::any_of(next_hops.begin(), next_hops.end(), [side](uint16_t hop) { return hop != none && hop >= side; })) {
+        throw std::runtime_error("Inconsistent distance table sections in snapshot (DistanceTable)");
+    }
+    nodes = static_cast<uint32_t>(side);
+}
+
+/**
+ * @brief Registers the table arrays as snapshot sections.
+ *
+ * @param writer The snapshot being written; the table must outlive the write.
+ */
+void DistanceTable::save(SnapshotWriter& writer) const {
+    writer.add(SnapshotSection::DistanceTableDurations, durations);
+    writer.add(SnapshotSection::DistanceTableNextHops, next_hops);
+}
+
+/**
+ * @brief Rebuilds the shortest route between two nodes from the next hops.
+ *
+ * @param from The dense index of the origin.
+ * @param to The dense index of the destination.
+ * @return The dense indices of the nodes on the route, empty if to is unreachable.
+ */
+std::vector<uint32_t> DistanceTable::path(uint32_t from, uint32_t to) const {
+    std::vector<uint32_t> route;
+    path(from, to, route);
+    return route;
+}
+
+/**
+ * @brief Rebuilds the shortest route between two nodes into a vector whose capacity is reused.
+ *
+ * @param from The dense index of the origin.
+ * @param to The dense index of the destination.
+ * @param route Receives the dense indices of the nodes on the route, none if to is unreachable.
+ */
+void DistanceTable::path(uint32_t from, uint32_t to, std::vector<uint32_t>& route) const {
+    route.clear();
+    if (duration(from, to) == unreachable) {
+        return;
+    }
+    route.push_back(from);
+    for (uint32_t at = from; at != to && route.size() <= nodes;) {
+        at = next_hop(at, to);
+        route.push_back(at);
+    }
+}
+
+}
@@ -0,0 +1,143 @@
+/**
+ * @file DistanceTable.hpp
+ * @brief Contains the declaration of the DistanceTable class.
+ */
+
+#pragma once
+#ifndef DISTANCE_TABLE_HPP
+#define DISTANCE_TABLE_HPP
+
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <vector>
+
+#include "ArrayRef.hpp"
+#include "Graph.hpp"
+
+namespace travel {
+    class ThreadPool;  // Forward declaration
+    class Snapshot;  // Forward declaration
+    class SnapshotWriter;  // Forward declaration
+
+    /**
+     * @class DistanceTable
+     * @brief Precomputed durations and next hops between every pair of stations.
+     *
+     * Row-major node_count() x node_count() matrices of dense indices: the uint32 duration of the
+     * shortest route, and the uint16 first station after the origin on that route, so a duration is
+     * one load and a full route is rebuilt hop by hop without any search. The Paris network takes
+     * about 3.5 MB.
+     *
+     * Small graphs are built with a blocked Floyd-Warshall whose inner min-plus loop uses AVX2 when
+     * the processor has it; larger ones with one Dijkstra search per row on the thread pool. Both
+     * keep the route with the fewest hops among those of equal duration, so following the next hops
+     * of successive rows cannot loop over zero-duration transfers.
+     *
+     * The table is immutable once built and safe to share between threads.
+     */
+    class DistanceTable {
+    public:
+        static const uint32_t unreachable = std::numeric_limits<uint32_t>::max(); /**< Duration of unreachable pairs. */
+        static const uint16_t none = std::numeric_limits<uint16_t>::max(); /**< Next hop of unreachable and identical pairs. */
+        static const uint32_t max_nodes = none; /**< The largest supported number of nodes. */
+
+        /**
+         * @brief The algorithm computing the table.
+         */
+        enum class Method {
+            Auto,           /**< Floyd-Warshall up to 2048 nodes, Dijkstra above. */
+            FloydWarshall,  /**< Blocked Floyd-Warshall, vectorized with AVX2 when available. */
+            Dijkstra        /**< One one-to-all search per row, in parallel. */
+        };
+
+        /**
+         * @brief Constructs an empty table.
+         */
+        DistanceTable() = default;
+
+        /**
+         * @brief Computes the table of a graph.
+         * @param graph The graph.
+         * @param pool The worker threads.
+         * @param method The algorithm.
+         * @throws std::runtime_error if the graph has more than max_nodes nodes.
+         */
+        DistanceTable(const Graph& graph, ThreadPool& pool, Method method = Method::Auto);
+
+        /**
+         * @brief Uses the table stored in a snapshot in place, without copying it.
+         * @param snapshot The mapped snapshot, kept alive by the table.
+         * @throws std::runtime_error if a table section is missing or inconsistent.
+         */
+        explicit DistanceTable(const Snapshot& snapshot);
+
+        /**
+         * @brief Registers the table arrays as snapshot sections.
+         * @param writer The snapshot being written; the table must outlive the write.
+         */
+        void save(SnapshotWriter& writer) const;
+
+        /**
+         * @brief Gets the number of nodes.
+         * @return The number of rows and columns.
+         */
+        uint32_t node_count() const { return nodes; }
+
+        /**
+         * @brief Gets the algorithm the table was requested with, to rebuild it the same way.
+         * @return The method passed to the constructor, Method::Auto for a table read from a snapshot.
+         */
+        Method get_method() const { return requested; }
+
+        /**
+         * @brief Gets the duration of the shortest route between two nodes.
+         * @param from The dense index of the origin.
+         * @param to The dense index of the destination.
+         * @return The duration in seconds, or unreachable.
+         */
+        uint32_t duration(uint32_t from, uint32_t to) const { return durations[size_t(from) * nodes + to]; }
+
+        /**
+         * @brief Gets the first node after the origin on the shortest route between two nodes.
+         * @param from The dense index of the origin.
+         * @param to The dense index of the destination.
+         * @return The dense index of the next hop, or none if from == to or to is unreachable.
+         */
+        uint32_t next_hop(uint32_t from, uint32_t to) const {
+            uint16_t hop = next_hops[size_t(from) * nodes + to];
+            return hop == none ? Graph::npos : hop;
+        }
+
+        /**
+         * @brief Rebuilds the shortest route between two nodes from the next hops.
+         * @param from The dense index of the origin.
+         * @param to The dense index of the destination.
+         * @return The dense indices of the nodes on the route, empty if to is unreachable.
+         */
+        std::vector<uint32_t> path(uint32_t from, uint32_t to) const;
+
+        /**
+         * @brief Rebuilds the shortest route between two nodes into a vector whose capacity is reused.
+         * @param from The dense index of the origin.
+         * @param to The dense index of the destination.
+         * @param route Receives the dense indices of the nodes on the route, none if to is unreachable.
+         */
+        void path(uint32_t from, uint32_t to, std::vector<uint32_t>& route) const;
+
+        /**
+         * @brief Gets the memory used by the table.
+         * @return The size of both matrices in bytes.
+         */
+        size_t memory_usage() const { return durations.size() * sizeof(uint32_t) + next_hops.size() * sizeof(uint16_t); }
+
+    private:
+        std::shared_ptr<const void> storage; /**< Owner of the arrays below: the table's own vectors or a mapped snapshot. */
+        ArrayRef<uint32_t> durations; /**< Duration of each pair, row-major. */
+        ArrayRef<uint16_t> next_hops; /**< Next hop of each pair, row-major. */
+        uint32_t nodes = 0; /**< Number of rows and columns. */
+        Method requested = Method::Auto; /**< The method passed to the constructor. */
+    };
+}
+
+#endif // DISTANCE_TABLE_HPP
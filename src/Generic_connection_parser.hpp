@@ -7,13 +7,17 @@ namespace travel{
   public:
 
     const std::unordered_map<uint64_t,std::unordered_map<uint64_t,uint64_t> >& get_connections_hashmap() const{
+      this->materialize_connections();
       return this->connections_hashmap;
     }
 
   protected:
     virtual void read_connections(const std::string& _filename) = 0;
 
+    // Lets parsers that load the network from another source fill connections_hashmap on first use.
+    virtual void materialize_connections() const{}
+
   protected:
-    std::unordered_map<uint64_t,std::unordered_map<uint64_t,uint64_t> > connections_hashmap;
+    mutable std::unordered_map<uint64_t,std::unordered_map<uint64_t,uint64_t> > connections_hashmap;
   };
 }
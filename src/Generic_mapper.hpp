@@ -1,11 +1,24 @@
 #pragma once
 
 #include <vector>
+#include <limits>
 #include <utility>
 
 #include "Generic_connection_parser.hpp"
 
 namespace travel{
+  struct TravelMatrix{
+    static const uint32_t unreachable = std::numeric_limits<uint32_t>::max();
+
+    std::vector<uint64_t> sources;
+    std::vector<uint64_t> targets;
+    std::vector<uint32_t> durations; // row-major, sources.size() x targets.size()
+
+    uint32_t at(size_t _row, size_t _col) const{
+      return this->durations[_row * this->targets.size() + _col];
+    }
+  };
+
   class Generic_mapper: public Generic_connection_parser{
   public:
     virtual std::vector<std::pair<uint64_t,uint64_t> > compute_travel(uint64_t _start, uint64_t _end) = 0;
@@ -17,5 +30,22 @@ namespace travel{
     virtual std::vector<std::pair<uint64_t,uint64_t> > compute_and_display_travel(const std::string&, const std::string&){
       throw("Nothing here");
     }
+
+    virtual TravelMatrix compute_matrix(const std::vector<uint64_t>&, const std::vector<uint64_t>&){
+      throw("Nothing here");
+    }
+    virtual void compute_matrix_to_file(const std::vector<uint64_t>&, const std::vector<uint64_t>&, const std::string&){
+      throw("Nothing here");
+    }
+
+    // Duration only; the route is filled in too when a vector is passed. max() if unreachable.
+    virtual uint64_t compute_duration(uint64_t, uint64_t, std::vector<std::pair<uint64_t,uint64_t> >* = nullptr){
+      throw("Nothing here");
+    }
+
+    // Earliest arrival on the timetable leaving at the given time, in seconds after midnight; route as above.
+    virtual uint64_t compute_arrival(uint64_t, uint64_t, uint64_t, std::vector<std::pair<uint64_t,uint64_t> >* = nullptr){
+      throw("Nothing here");
+    }
   };
 }
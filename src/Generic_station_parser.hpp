@@ -20,13 +20,16 @@ namespace travel{
   public:
 
     const std::unordered_map<uint64_t, Station>& get_stations_hashmap() const{
+      this->materialize_stations();
       return this->stations_hashmap;
     }
 
   protected:
     virtual void read_stations(const std::string& _filename) = 0;
+    // Lets parsers that store stations in another form fill stations_hashmap on first use.
+    virtual void materialize_stations() const{}
 
   protected:
-    std::unordered_map<uint64_t, Station> stations_hashmap;
+    mutable std::unordered_map<uint64_t, Station> stations_hashmap;
   };
 }
@@ -0,0 +1,368 @@
+#include "Graph.hpp"
+#include "Snapshot.hpp"
+
+#include <algorithm>
+#include <functional>
+#include <stdexcept>
+#include <utility>
+
+namespace travel {
+
+const uint32_t Graph::npos;
+const uint32_t Graph::closed;
+
+namespace {
+
+/**
+ * @brief The arrays of a graph built in memory.
+ */
+struct GraphArrays {
+    std::vector<uint64_t> ids;
+    std::vector<uint64_t> lookup_ids;
+    std::vector<uint32_t> lookup_nodes;
+    std::vector<uint32_t> offsets;
+    std::vector<uint32_t> targets;
+    std::vector<uint32_t> weights;
+    std::vector<uint32_t> reverse_offsets;
+    std::vector<uint32_t> reverse_sources;
+    std::vector<uint32_t> reverse_weights;
+};
+
+/**
+ * @brief The arrays of a graph derived from another one, which they keep alive.
+ */
+struct DerivedGraphArrays {
+    std::shared_ptr<const void> base;
+    GraphArrays arrays;
+};
+
+/**
+ * @brief Builds the reverse adjacency from the forward arrays.
+ *
+ * Counting sort of the edges by head, keeping tails in ascending order.
+ *
+ * @param arrays The arrays whose forward part is filled.
+ * @param node_count The number of nodes.
+ */
+void build_reverse(GraphArrays& arrays, size_t node_count) {
+    std::vector<uint32_t>& reverse_offsets = arrays.reverse_offsets;
+    reverse_offsets.assign(node_count + 1, 0);
+    for (uint32_t target : arrays.targets) {
+        ++reverse_offsets[target + 1];
+    }
+    for (size_t v = 0; v < node_count; ++v) {
+        reverse_offsets[v + 1] += reverse_offsets[v];
+    }
+    arrays.reverse_sources.resize(arrays.targets.size());
+    arrays.reverse_weights.resize(arrays.targets.size());
+    std::vector<uint32_t> cursor(reverse_offsets.begin(), reverse_offsets.end() - 1);
+    for (uint32_t u = 0; u < node_count; ++u) {
+        for (uint32_t e = arrays.offsets[u]; e < arrays.offsets[u + 1]; ++e) {
+            uint32_t slot = cursor[arrays.targets[e]]++;
+            arrays.reverse_sources[slot] = u;
+            arrays.reverse_weights[slot] = arrays.weights[e];
+        }
+    }
+}
+
+} // namespace
+
+/**
+ * @brief Builds the CSR arrays from the parsed connections.
+ *
+ * Station IDs are sorted before being numbered so that the dense indices, and therefore the
+ * order in which a search visits ties, do not depend on hash map iteration order.
+ *
+ * @param connections The adjacency read by read_connections.
+ * @param extra_ids Station IDs that must get an index even if they have no connection.
+ * @throws std::runtime_error if a duration does not fit below Graph::closed.
+ */
+Graph::Graph(const std::unordered_map<uint64_t, std::unordered_map<uint64_t, uint64_t>>& connections,
+             const std::vector<uint64_t>& extra_ids) {
+    std::shared_ptr<GraphArrays> arrays = std::make_shared<GraphArrays>();
+    std::vector<uint64_t>& ids = arrays->ids;
+    std::vector<uint32_t>& offsets = arrays->offsets;
+    std::vector<uint32_t>& targets = arrays->targets;
+    std::vector<uint32_t>& weights = arrays->weights;
+
+    size_t edge_total = 0;
+    ids = extra_ids;
+    for (const auto& entry : connections) {
+        ids.push_back(entry.first);
+        for (const auto& neighbor : entry.second) {
+            ids.push_back(neighbor.first);
+        }
+        edge_total += entry.second.size();
+    }
+    std::sort(ids.begin(), ids.end());
+    ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+
+    std::unordered_map<uint64_t, uint32_t> index;
+    index.reserve(ids.size());
+    for (uint32_t i = 0; i < ids.size(); ++i) {
+        index.emplace(ids[i], i);
+    }
+
+    offsets.assign(ids.size() + 1, 0);
+    targets.reserve(edge_total);
+    weights.reserve(edge_total);
+
+    std::vector<std::pair<uint32_t, uint32_t>> row;
+    for (uint32_t u = 0; u < ids.size(); ++u) {
+        offsets[u] = static_cast<uint32_t>(targets.size());
+        auto it = connections.find(ids[u]);
+        if (it == connections.end()) {
+            continue;
+        }
+        row.clear();
+        for (const auto& neighbor : it->second) {
+            if (neighbor.second >= closed) {
+                throw std::runtime_error("Duration too large from " + std::to_string(ids[u]) + " to " + std::to_string(neighbor.first) + " (Graph)");
+            }
+            row.emplace_back(index.at(neighbor.first), static_cast<uint32_t>(neighbor.second));
+        }
+        std::sort(row.begin(), row.end());
+        for (const auto& edge : row) {
+            targets.push_back(edge.first);
+            weights.push_back(edge.second);
+        }
+    }
+    offsets[ids.size()] = static_cast<uint32_t>(targets.size());
+
+    build_reverse(*arrays, ids.size());
+
+    this->ids = arrays->ids;
+    this->lookup_ids = arrays->ids;
+    this->offsets = arrays->offsets;
+    this->targets = arrays->targets;
+    this->weights = arrays->weights;
+    this->reverse_offsets = arrays->reverse_offsets;
+    this->reverse_sources = arrays->reverse_sources;
+    this->reverse_weights = arrays->reverse_weights;
+    storage = arrays;
+}
+
+/**
+ * @brief Builds a copy of a graph with some edges reweighted or removed.
+ *
+ * Runs in linear time over the base arrays; the station IDs are not copied.
+ *
+ * @param base The graph to copy, kept alive by the new graph.
+ * @param overrides (edge index in base, new weight) pairs sorted by edge index; Graph::closed removes the edge.
+ */
+Graph::Graph(const Graph& base, const std::vector<std::pair<uint32_t, uint32_t>>& overrides) {
+    std::shared_ptr<DerivedGraphArrays> derived = std::make_shared<DerivedGraphArrays>();
+    derived->base = base.storage;
+    GraphArrays& arrays = derived->arrays;
+    const uint32_t nodes = base.node_count();
+
+    arrays.offsets.resize(nodes + 1);
+    arrays.targets.reserve(base.edge_count());
+    arrays.weights.reserve(base.edge_count());
+    auto next = overrides.begin();
+    for (uint32_t u = 0; u < nodes; ++u) {
+        arrays.offsets[u] = static_cast<uint32_t>(arrays.targets.size());
+        for (uint32_t e = base.offsets[u]; e < base.offsets[u + 1]; ++e) {
+            uint32_t weight = base.weights[e];
+            if (next != overrides.end() && next->first == e) {
+                weight = next->second;
+                ++next;
+            }
+            if (weight != closed) {
+                arrays.targets.push_back(base.targets[e]);
+                arrays.weights.push_back(weight);
+            }
+        }
+    }
+    arrays.offsets[nodes] = static_cast<uint32_t>(arrays.targets.size());
+    build_reverse(arrays, nodes);
+
+    ids = base.ids;
+    lookup_ids = base.lookup_ids;
+    lookup_nodes = base.lookup_nodes;
+    offsets = arrays.offsets;
+    targets = arrays.targets;
+    weights = arrays.weights;
+    reverse_offsets = arrays.reverse_offsets;
+    reverse_sources = arrays.reverse_sources;
+    reverse_weights = arrays.reverse_weights;
+    storage = derived;
+}
+
+/**
+ * @brief Builds a copy of a graph with its nodes renumbered.
+ *
+ * The rows are copied in the new order with their heads translated, then sorted again so that
+ * find_edge can keep its binary search. The sorted station IDs of the base graph are kept for
+ * index_of, with the new dense index of each.
+ *
+ * @param base The graph to renumber.
+ * @param order The base index of each new dense index, a permutation of [0, node_count()).
+ * @throws std::runtime_error if order is not a permutation of the nodes.
+ */
+Graph::Graph(const Graph& base, const std::vector<uint32_t>& order) {
+    const uint32_t nodes = base.node_count();
+    std::vector<uint32_t> rank(nodes, npos);
+    if (order.size() != nodes) {
+        throw std::runtime_error("Node order does not cover the graph (Graph)");
+    }
+    for (uint32_t i = 0; i < nodes; ++i) {
+        if (order[i] >= nodes || rank[order[i]] != npos) {
+            throw std::runtime_error("Node order is not a permutation (Graph)");
+        }
+        rank[order[i]] = i;
+    }
+
+    std::shared_ptr<GraphArrays> arrays = std::make_shared<GraphArrays>();
+    arrays->ids.resize(nodes);
+    arrays->offsets.resize(nodes + 1);
+    arrays->targets.reserve(base.edge_count());
+    arrays->weights.reserve(base.edge_count());
+    std::vector<std::pair<uint32_t, uint32_t>> row;
+    for (uint32_t u = 0; u < nodes; ++u) {
+        const uint32_t old = order[u];
+        arrays->ids[u] = base.ids[old];
+        arrays->offsets[u] = static_cast<uint32_t>(arrays->targets.size());
+        row.clear();
+        for (uint32_t e = base.offsets[old]; e < base.offsets[old + 1]; ++e) {
+            row.emplace_back(rank[base.targets[e]], base.weights[e]);
+        }
+        std::sort(row.begin(), row.end());
+        for (const auto& edge : row) {
+            arrays->targets.push_back(edge.first);
+            arrays->weights.push_back(edge.second);
+        }
+    }
+    arrays->offsets[nodes] = static_cast<uint32_t>(arrays->targets.size());
+    build_reverse(*arrays, nodes);
+
+    arrays->lookup_ids.assign(base.lookup_ids.begin(), base.lookup_ids.end());
+    arrays->lookup_nodes.resize(nodes);
+    for (uint32_t i = 0; i < nodes; ++i) {
+        arrays->lookup_nodes[i] = rank[base.lookup_nodes.empty() ? i : base.lookup_nodes[i]];
+    }
+
+    ids = arrays->ids;
+    lookup_ids = arrays->lookup_ids;
+    lookup_nodes = arrays->lookup_nodes;
+    offsets = arrays->offsets;
+    targets = arrays->targets;
+    weights = arrays->weights;
+    reverse_offsets = arrays->reverse_offsets;
+    reverse_sources = arrays->reverse_sources;
+    reverse_weights = arrays->reverse_weights;
+    storage = arrays;
+}
+
+/**
+ * @brief Uses the CSR arrays of a snapshot in place, without copying them.
+ *
+ * The checksum only catches corruption, so one pass over the arrays also checks that every offset,
+ * head and lookup entry stays in range before any search trusts them. A renumbered graph also
+ * stores its sorted station IDs and their dense indices.
+ *
+ * @param snapshot The mapped snapshot, kept alive by the graph.
+ * @throws std::runtime_error if a graph section is missing or inconsistent.
+ */
+Graph::Graph(const Snapshot& snapshot)
+: storage(snapshot.file()),
+  ids(snapshot.array<uint64_t>(SnapshotSection::GraphIds)),
+  offsets(snapshot.array<uint32_t>(SnapshotSection::GraphOffsets)),
+  targets(snapshot.array<uint32_t>(SnapshotSection::GraphTargets)),
+  weights(snapshot.array<uint32_t>(SnapshotSection::GraphWeights)),
+  reverse_offsets(snapshot.array<uint32_t>(SnapshotSection::GraphReverseOffsets)),
+  reverse_sources(snapshot.array<uint32_t>(SnapshotSection::GraphReverseSources)),
+  reverse_weights(snapshot.array<uint32_t>(SnapshotSection::GraphReverseWeights)) {
+    if (offsets.size() != ids.size() + 1 || reverse_offsets.size() != ids.size() + 1 ||
+        weights.size() != targets.size() || reverse_sources.size() != targets.size() ||
+        reverse_weights.size() != targets.size() ||
+        !is_valid_csr(offsets, targets, node_count()) || !is_valid_csr(reverse_offsets, reverse_sources, node_count()) ||
+        std::any_of(weights.begin(), weights.end(), [](uint32_t w) { return w >= closed; })) {
+        throw std::runtime_error("Inconsistent graph sections in snapshot (Graph)");
+    }
+    lookup_ids = ids;
+    if (snapshot.has(SnapshotSection::GraphLookupIds)) {
+        lookup_ids = snapshot.array<uint64_t>(SnapshotSection::GraphLookupIds);
+        lookup_nodes = snapshot.array<uint32_t>(SnapshotSection::GraphLookupNodes);
+        if (lookup_ids.size() != ids.size() || lookup_nodes.size() != ids.size() ||
+            std::any_of(lookup_nodes.begin(), lookup_nodes.end(), [this](uint32_t u) { return u >= node_count(); })) {
+            throw std::runtime_error("Inconsistent graph sections in snapshot (Graph)");
+        }
+    }
+    if (std::adjacent_find(lookup_ids.begin(), lookup_ids.end(), std::greater_equal<uint64_t>()) != lookup_ids.end()) {
+        throw std::runtime_error("Station IDs not sorted in snapshot (Graph)");
+    }
+}
+
+/**
+ * @brief Registers the CSR arrays as snapshot sections.
+ *
+ * @param writer The snapshot being written; the graph must outlive the write.
+ */
+void Graph::save(SnapshotWriter& writer) const {
+    writer.add(SnapshotSection::GraphIds, ids);
+    writer.add(SnapshotSection::GraphOffsets, offsets);
+    writer.add(SnapshotSection::GraphTargets, targets);
+    writer.add(SnapshotSection::GraphWeights, weights);
+    writer.add(SnapshotSection::GraphReverseOffsets, reverse_offsets);
+    writer.add(SnapshotSection::GraphReverseSources, reverse_sources);
+    writer.add(SnapshotSection::GraphReverseWeights, reverse_weights);
+    if (!lookup_nodes.empty()) {
+        writer.add(SnapshotSection::GraphLookupIds, lookup_ids);
+        writer.add(SnapshotSection::GraphLookupNodes, lookup_nodes);
+    }
+}
+
+/**
+ * @brief Translates a station ID to its dense index.
+ *
+ * A binary search in the sorted station IDs, whose position is the dense index unless the graph
+ * was renumbered.
+ *
+ * @param id The station ID.
+ * @return The dense index, or Graph::npos if the station is unknown.
+ */
+uint32_t Graph::index_of(uint64_t id) const {
+    const uint64_t* it = std::lower_bound(lookup_ids.begin(), lookup_ids.end(), id);
+    if (it == lookup_ids.end() || *it != id) {
+        return npos;
+    }
+    const uint32_t position = static_cast<uint32_t>(it - lookup_ids.begin());
+    return lookup_nodes.empty() ? position : lookup_nodes[position];
+}
+
+/**
+ * @brief Finds the edge between two nodes with a binary search in the tail's sorted row.
+ *
+ * @param u The dense index of the tail.
+ * @param v The dense index of the head.
+ * @return The edge index, or Graph::npos if there is no such edge.
+ */
+uint32_t Graph::find_edge(uint32_t u, uint32_t v) const {
+    const uint32_t* first = targets.begin() + offsets[u];
+    const uint32_t* last = targets.begin() + offsets[u + 1];
+    const uint32_t* it = std::lower_bound(first, last, v);
+    return it != last && *it == v ? static_cast<uint32_t>(it - targets.begin()) : npos;
+}
+
+/**
+ * @brief Checks that CSR arrays read from a snapshot can be walked without leaving them.
+ *
+ * @param offsets The edge range of each node, node_count + 1 entries.
+ * @param heads The node at the other end of each edge.
+ * @param node_count The number of nodes.
+ * @return True if the offsets start at 0, never decrease and end at the number of edges, and every head is a node.
+ */
+bool is_valid_csr(ArrayRef<uint32_t> offsets, ArrayRef<uint32_t> heads, uint32_t node_count) {
+    if (offsets.size() != size_t(node_count) + 1 || offsets[0] != 0 || offsets[node_count] != heads.size()) {
+        return false;
+    }
+    for (uint32_t u = 0; u < node_count; ++u) {
+        if (offsets[u] > offsets[u + 1]) {
+            return false;
+        }
+    }
+    return std::all_of(heads.begin(), heads.end(), [node_count](uint32_t v) { return v < node_count; });
+}
+
+} // namespace travel
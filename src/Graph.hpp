@@ -0,0 +1,200 @@
+/**
+ * @file Graph.hpp
+ * @brief Contains the declaration of the Graph class.
+ */
+
+#pragma once
+#ifndef GRAPH_HPP
+#define GRAPH_HPP
+
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <vector>
+#include <utility>
+#include <unordered_map>
+
+#include "ArrayRef.hpp"
+
+namespace travel {
+    class Snapshot;  // Forward declaration
+    class SnapshotWriter;  // Forward declaration
+
+    /**
+     * @class Graph
+     * @brief Immutable compressed sparse row (CSR) representation of the metro connections.
+     *
+     * Station IDs are remapped to dense indices in [0, node_count()). The outgoing edges of
+     * node u are stored contiguously in [edges_begin(u), edges_end(u)) of the target and
+     * weight arrays, so a search walks flat memory instead of chasing hash map buckets.
+     * Dense indices follow the station IDs until the graph is renumbered (see NodeOrder.hpp),
+     * after which index_of and id_of go through the stored permutation.
+     *
+     * The arrays are either owned by the graph or point straight into a memory-mapped snapshot;
+     * copies of a Graph share them.
+     */
+    class Graph {
+    public:
+        static const uint32_t npos = std::numeric_limits<uint32_t>::max(); /**< Index returned for unknown station IDs. */
+        static const uint32_t closed = std::numeric_limits<uint32_t>::max(); /**< Override weight that removes an edge. */
+
+        /**
+         * @brief Constructs an empty graph.
+         */
+        Graph() = default;
+
+        /**
+         * @brief Builds the CSR arrays from the parsed connections.
+         * @param connections The adjacency read by read_connections (from ID -> to ID -> duration).
+         * @param extra_ids Station IDs that must get an index even if they have no connection.
+         * @throws std::runtime_error if a duration does not fit below Graph::closed.
+         */
+        Graph(const std::unordered_map<uint64_t, std::unordered_map<uint64_t, uint64_t>>& connections,
+              const std::vector<uint64_t>& extra_ids = std::vector<uint64_t>());
+
+        /**
+         * @brief Uses the CSR arrays of a snapshot in place, without copying them.
+         * @param snapshot The mapped snapshot, kept alive by the graph.
+         * @throws std::runtime_error if a graph section is missing or inconsistent.
+         */
+        explicit Graph(const Snapshot& snapshot);
+
+        /**
+         * @brief Builds a copy of a graph with some edges reweighted or removed.
+         *
+         * The station IDs, and therefore the dense indices, are shared with the base graph.
+         * @param base The graph to copy, kept alive by the new graph.
+         * @param overrides (edge index in base, new weight) pairs sorted by edge index; Graph::closed removes the edge.
+         */
+        Graph(const Graph& base, const std::vector<std::pair<uint32_t, uint32_t>>& overrides);
+
+        /**
+         * @brief Builds a copy of a graph with its nodes renumbered.
+         *
+         * Node order[i] of the base graph becomes node i; station IDs, edges and durations are unchanged.
+         * @param base The graph to renumber.
+         * @param order The base index of each new dense index, a permutation of [0, node_count()).
+         * @throws std::runtime_error if order is not a permutation of the nodes.
+         */
+        Graph(const Graph& base, const std::vector<uint32_t>& order);
+
+        /**
+         * @brief Registers the CSR arrays as snapshot sections.
+         * @param writer The snapshot being written; the graph must outlive the write.
+         */
+        void save(SnapshotWriter& writer) const;
+
+        /**
+         * @brief Gets the number of nodes in the graph.
+         * @return The number of dense node indices.
+         */
+        uint32_t node_count() const { return static_cast<uint32_t>(ids.size()); }
+
+        /**
+         * @brief Gets the number of directed edges in the graph.
+         * @return The number of edges.
+         */
+        uint32_t edge_count() const { return static_cast<uint32_t>(targets.size()); }
+
+        /**
+         * @brief Translates a station ID to its dense index.
+         * @param id The station ID.
+         * @return The dense index, or Graph::npos if the station is unknown.
+         */
+        uint32_t index_of(uint64_t id) const;
+
+        /**
+         * @brief Translates a dense index back to its station ID.
+         * @param index The dense index.
+         * @return The station ID.
+         */
+        uint64_t id_of(uint32_t index) const { return ids[index]; }
+
+        /**
+         * @brief Finds the edge between two nodes.
+         * @param u The dense index of the tail.
+         * @param v The dense index of the head.
+         * @return The edge index, or Graph::npos if there is no such edge.
+         */
+        uint32_t find_edge(uint32_t u, uint32_t v) const;
+
+        /**
+         * @brief Gets the position of the first outgoing edge of a node.
+         * @param u The dense index of the node.
+         * @return The index of the first edge in the target and weight arrays.
+         */
+        uint32_t edges_begin(uint32_t u) const { return offsets[u]; }
+
+        /**
+         * @brief Gets the position one past the last outgoing edge of a node.
+         * @param u The dense index of the node.
+         * @return The index one past the last edge in the target and weight arrays.
+         */
+        uint32_t edges_end(uint32_t u) const { return offsets[u + 1]; }
+
+        /**
+         * @brief Gets the head of an edge.
+         * @param e The edge index.
+         * @return The dense index of the node the edge points to.
+         */
+        uint32_t target(uint32_t e) const { return targets[e]; }
+
+        /**
+         * @brief Gets the duration of an edge.
+         * @param e The edge index.
+         * @return The duration of the edge in seconds.
+         */
+        uint32_t weight(uint32_t e) const { return weights[e]; }
+
+        /**
+         * @brief Gets the position of the first incoming edge of a node in the reverse adjacency.
+         * @param v The dense index of the node.
+         * @return The index of the first reverse edge.
+         */
+        uint32_t reverse_edges_begin(uint32_t v) const { return reverse_offsets[v]; }
+
+        /**
+         * @brief Gets the position one past the last incoming edge of a node in the reverse adjacency.
+         * @param v The dense index of the node.
+         * @return The index one past the last reverse edge.
+         */
+        uint32_t reverse_edges_end(uint32_t v) const { return reverse_offsets[v + 1]; }
+
+        /**
+         * @brief Gets the tail of a reverse edge.
+         * @param e The reverse edge index.
+         * @return The dense index of the node the edge comes from.
+         */
+        uint32_t reverse_source(uint32_t e) const { return reverse_sources[e]; }
+
+        /**
+         * @brief Gets the duration of a reverse edge.
+         * @param e The reverse edge index.
+         * @return The duration of the edge in seconds.
+         */
+        uint32_t reverse_weight(uint32_t e) const { return reverse_weights[e]; }
+
+    private:
+        std::shared_ptr<const void> storage; /**< Owner of the arrays below: the graph's own vectors or a mapped snapshot. */
+        ArrayRef<uint64_t> ids; /**< Dense index -> station ID. */
+        ArrayRef<uint64_t> lookup_ids; /**< Station IDs sorted for the binary search of index_of; ids itself unless renumbered. */
+        ArrayRef<uint32_t> lookup_nodes; /**< Dense index of each entry of lookup_ids, empty unless renumbered. */
+        ArrayRef<uint32_t> offsets; /**< Edge range of each node, node_count() + 1 entries. */
+        ArrayRef<uint32_t> targets; /**< Head of each edge as a dense index. */
+        ArrayRef<uint32_t> weights; /**< Duration of each edge in seconds. */
+        ArrayRef<uint32_t> reverse_offsets; /**< Incoming edge range of each node, node_count() + 1 entries. */
+        ArrayRef<uint32_t> reverse_sources; /**< Tail of each reverse edge as a dense index. */
+        ArrayRef<uint32_t> reverse_weights; /**< Duration of each reverse edge in seconds. */
+    };
+
+    /**
+     * @brief Checks that CSR arrays read from a snapshot can be walked without leaving them.
+     * @param offsets The edge range of each node, node_count + 1 entries.
+     * @param heads The node at the other end of each edge.
+     * @param node_count The number of nodes.
+     * @return True if the offsets start at 0, never decrease and end at the number of edges, and every head is a node.
+     */
+    bool is_valid_csr(ArrayRef<uint32_t> offsets, ArrayRef<uint32_t> heads, uint32_t node_count);
+}
+
+#endif // GRAPH_HPP
@@ -0,0 +1,373 @@
+#include "HubLabels.hpp"
+#include "PriorityQueues.hpp"
+#include "QueryContext.hpp"
+#include "Snapshot.hpp"
+
+#include <algorithm>
+#include <numeric>
+#include <stdexcept>
+
+namespace travel {
+
+namespace {
+
+/**
+ * @brief A label entry while the labels are being built.
+ */
+struct LabelEntry {
+    uint32_t hub;      /**< Rank of the hub. */
+    uint32_t duration; /**< Duration between the node and the hub. */
+    uint32_t parent;   /**< Neighbour on the route to or from the hub, Graph::npos at the hub. */
+};
+
+/**
+ * @brief The arrays of an index built in memory.
+ */
+struct LabelArrays {
+    std::vector<uint32_t> out_offsets, out_hubs, out_durations, out_parents;
+    std::vector<uint32_t> in_offsets, in_hubs, in_durations, in_parents;
+};
+
+/**
+ * @brief Pruned Dijkstra searches and the scratch state they share across hubs.
+ */
+class Labeler {
+public:
+    /**
+     * @brief Prepares the scratch state.
+     * @param graph The graph to label.
+     */
+    explicit Labeler(const Graph& graph)
+    : out(graph.node_count()), in(graph.node_count()), graph(graph),
+      distance(graph.node_count(), QueryContext::infinity), parent(graph.node_count(), Graph::npos),
+      hub_duration(graph.node_count(), QueryContext::infinity) {}
+
+    /**
+     * @brief Adds a hub to the labels of every node whose distance to or from it is not covered yet.
+     * @param hub The dense index of the hub.
+     * @param rank The rank of the hub, larger than every rank added before.
+     */
+    void add(uint32_t hub, uint32_t rank) {
+        search(hub, rank, false);
+        search(hub, rank, true);
+    }
+
+    std::vector<std::vector<LabelEntry>> out; /**< Forward label of each node. */
+    std::vector<std::vector<LabelEntry>> in; /**< Backward label of each node. */
+
+private:
+    /**
+     * @brief Runs one pruned search from a hub.
+     *
+     * Forward, it labels the backward labels of the nodes reached with d(hub, v); backward, on the
+     * reverse adjacency, it labels the forward labels with d(v, hub). A node whose distance the
+     * current labels already match is neither labelled nor expanded. The hub's own opposite label
+     * is scattered into hub_duration first, so each pruning test is one pass over a single label.
+     */
+    void search(uint32_t hub, uint32_t rank, bool backward) {
+        std::vector<std::vector<LabelEntry>>& labels = backward ? out : in;
+        for (const LabelEntry& entry : backward ? in[hub] : out[hub]) {
+            hub_duration[entry.hub] = entry.duration;
+        }
+        distance[hub] = 0;
+        parent[hub] = Graph::npos;
+        reached.push_back(hub);
+        queue.clear();
+        queue.push(0, hub);
+        while (!queue.empty()) {
+            const QueueEntry top = queue.top();
+            queue.pop();
+            const uint32_t v = top.second;
+            if (top.first > distance[v]) {
+                continue;
+            }
+            bool covered = false;
+            for (const LabelEntry& entry : labels[v]) {
+                if (hub_duration[entry.hub] != QueryContext::infinity && hub_duration[entry.hub] + entry.duration <= top.first) {
+                    covered = true;
+                    break;
+                }
+            }
+            if (covered) {
+                continue;
+            }
+            labels[v].push_back(LabelEntry{rank, static_cast<uint32_t>(top.first), parent[v]});
+
+            const uint32_t begin = backward ? graph.reverse_edges_begin(v) : graph.edges_begin(v);
+            const uint32_t end = backward ? graph.reverse_edges_end(v) : graph.edges_end(v);
+            for (uint32_t e = begin; e < end; ++e) {
+                const uint32_t u = backward ? graph.reverse_source(e) : graph.target(e);
+                const uint64_t candidate = top.first + (backward ? graph.reverse_weight(e) : graph.weight(e));
+                if (candidate < distance[u]) {
+                    if (distance[u] == QueryContext::infinity) {
+                        reached.push_back(u);
+                    }
+                    distance[u] = candidate;
+                    parent[u] = v;
+                    queue.push(candidate, u);
+                }
+            }
+        }
+
+        for (uint32_t v : reached) {
+            distance[v] = QueryContext::infinity;
+        }
+        reached.clear();
+        for (const LabelEntry& entry : backward ? in[hub] : out[hub]) {
+            hub_duration[entry.hub] = QueryContext::infinity;
+        }
+    }
+
+    const Graph& graph;
+    std::vector<uint64_t> distance; /**< Tentative distance of each node in the current search. */
+    std::vector<uint32_t> parent; /**< Neighbour each node was reached from in the current search. */
+    std::vector<uint32_t> reached; /**< Nodes whose distance must be reset after the current search. */
+    std::vector<uint64_t> hub_duration; /**< Duration between the current hub and each earlier hub, by rank. */
+    RadixQueue queue;
+};
+
+/**
+ * @brief Packs per-node labels into CSR arrays.
+ */
+void toCsr(const std::vector<std::vector<LabelEntry>>& labels, std::vector<uint32_t>& offsets,
+           std::vector<uint32_t>& hubs, std::vector<uint32_t>& durations, std::vector<uint32_t>& parents) {
+    offsets.assign(labels.size() + 1, 0);
+    for (size_t v = 0; v < labels.size(); ++v) {
+        offsets[v] = static_cast<uint32_t>(hubs.size());
+        for (const LabelEntry& entry : labels[v]) {
+            hubs.push_back(entry.hub);
+            durations.push_back(entry.duration);
+            parents.push_back(entry.parent);
+        }
+    }
+    offsets[labels.size()] = static_cast<uint32_t>(hubs.size());
+}
+
+/**
+ * @brief Finds the entry of a hub in the label of a node.
+ * @return The entry index, or Graph::npos if the hub is not in the label.
+ */
+uint32_t findEntry(ArrayRef<uint32_t> offsets, ArrayRef<uint32_t> hubs, uint32_t node, uint32_t hub) {
+    const uint32_t* first = hubs.data() + offsets[node];
+    const uint32_t* last = hubs.data() + offsets[node + 1];
+    const uint32_t* it = std::lower_bound(first, last, hub);
+    return it != last && *it == hub ? static_cast<uint32_t>(it - hubs.data()) : Graph::npos;
+}
+
+/**
+ * @brief Checks that labels read from a snapshot can be merged and walked without leaving the arrays.
+ *
+ * Hubs must be nodes, increasing within each label, and every parent must be a node whose own
+ * label holds the same hub at a duration no larger, so that path walks only follow entries that exist.
+ *
+ * @return True if the labels are consistent.
+ */
+bool valid_labels(ArrayRef<uint32_t> offsets, ArrayRef<uint32_t> hubs, ArrayRef<uint32_t> durations, ArrayRef<uint32_t> parents) {
+    const uint32_t node_count = static_cast<uint32_t>(offsets.size() - 1);
+    if (!is_valid_csr(offsets, hubs, node_count)) {
+        return false;
+    }
+    for (uint32_t u = 0; u < node_count; ++u) {
+        for (uint32_t entry = offsets[u]; entry < offsets[u + 1]; ++entry) {
+            if (entry > offsets[u] && hubs[entry - 1] >= hubs[entry]) {
+                return false;
+            }
+            const uint32_t parent = parents[entry];
+            if (parent == Graph::npos) {
+                continue;
+            }
+            if (parent >= node_count) {
+                return false;
+            }
+            const uint32_t next = findEntry(offsets, hubs, parent, hubs[entry]);
+            if (next == Graph::npos || durations[next] > durations[entry]) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+/**
+ * @brief Computes the labels of a graph by pruned landmark labeling.
+ *
+ * Hubs are taken by decreasing number of connections: interchange stations cover the most routes,
+ * which keeps the labels of the stations labelled later short.
+ *
+ * @param graph The graph to preprocess.
+ */
+HubLabels::HubLabels(const Graph& graph) {
+    const uint32_t n = graph.node_count();
+    std::vector<uint32_t> order(n);
+    std::iota(order.begin(), order.end(), 0);
+    auto degree = [&graph](uint32_t v) {
+        return (graph.edges_end(v) - graph.edges_begin(v)) + (graph.reverse_edges_end(v) - graph.reverse_edges_begin(v));
+    };
+    std::stable_sort(order.begin(), order.end(), [&degree](uint32_t a, uint32_t b) { return degree(a) > degree(b); });
+
+    Labeler labeler(graph);
+    for (uint32_t rank = 0; rank < n; ++rank) {
+        labeler.add(order[rank], rank);
+    }
+
+    std::shared_ptr<LabelArrays> arrays = std::make_shared<LabelArrays>();
+    toCsr(labeler.out, arrays->out_offsets, arrays->out_hubs, arrays->out_durations, arrays->out_parents);
+    toCsr(labeler.in, arrays->in_offsets, arrays->in_hubs, arrays->in_durations, arrays->in_parents);
+    out_offsets = arrays->out_offsets;
+    out_hubs = arrays->out_hubs;
+    out_durations = arrays->out_durations;
+    out_parents = arrays->out_parents;
+    in_offsets = arrays->in_offsets;
+    in_hubs = arrays->in_hubs;
+    in_durations = arrays->in_durations;
+    in_parents = arrays->in_parents;
+    storage = arrays;
+}
+
+/**
+ * @brief Uses the labels stored in a snapshot in place, without copying them.
+ *
+ * The labels are checked entry by entry, since the checksum only catches corruption.
+ *
+ * @param snapshot The mapped snapshot, kept alive by the index.
+ * @throws std::runtime_error if a label section is missing or inconsistent.
+ */
+HubLabels::HubLabels(const Snapshot& snapshot)
+: storage(snapshot.file()),
+  out_offsets(snapshot.array<uint32_t>(SnapshotSection::HubLabelOutOffsets)),
+  out_hubs(snapshot.array<uint32_t>(SnapshotSection::HubLabelOutHubs)),
+  out_durations(snapshot.array<uint32_t>(SnapshotSection::HubLabelOutDurations)),
+  out_parents(snapshot.array<uint32_t>(SnapshotSection::HubLabelOutParents)),
+  in_offsets(snapshot.array<uint32_t>(SnapshotSection::HubLabelInOffsets)),
+  in_hubs(snapshot.array<uint32_t>(SnapshotSection::HubLabelInHubs)),
+  in_durations(snapshot.array<uint32_t>(SnapshotSection::HubLabelInDurations)),
+  in_parents(snapshot.array<uint32_t>(SnapshotSection::HubLabelInParents)) {
+    if (out_offsets.empty() || in_offsets.size() != out_offsets.size() ||
+        out_durations.size() != out_hubs.size() || out_parents.size() != out_hubs.size() ||
+        in_durations.size() != in_hubs.size() || in_parents.size() != in_hubs.size() ||
+        out_offsets[node_count()] != out_hubs.size() || in_offsets[node_count()] != in_hubs.size() ||
+        !valid_labels(out_offsets, out_hubs, out_durations, out_parents) || !valid_labels(in_offsets, in_hubs, in_durations, in_parents)) {
+        throw std::runtime_error("Inconsistent hub label sections in snapshot (HubLabels)");
+    }
+}
+
+/**
+ * @brief Registers the label arrays as snapshot sections.
+ *
+ * @param writer The snapshot being written; the index must outlive the write.
+ */
+void HubLabels::save(SnapshotWriter& writer) const {
+    writer.add(SnapshotSection::HubLabelOutOffsets, out_offsets);
+    writer.add(SnapshotSection::HubLabelOutHubs, out_hubs);
+    writer.add(SnapshotSection::HubLabelOutDurations, out_durations);
+    writer.add(SnapshotSection::HubLabelOutParents, out_parents);
+    writer.add(SnapshotSection::HubLabelInOffsets, in_offsets);
+    writer.add(SnapshotSection::HubLabelInHubs, in_hubs);
+    writer.add(SnapshotSection::HubLabelInDurations, in_durations);
+    writer.add(SnapshotSection::HubLabelInParents, in_parents);
+}
+
+/**
+ * @brief Walks both labels in hub order and keeps the best common hub.
+ *
+ * @param source The dense index of the starting node.
+ * @param target The dense index of the destination node.
+ * @param out_entry Receives the entry of the hub in the forward label of source.
+ * @param in_entry Receives the entry of the hub in the backward label of target.
+ * @return The total distance, QueryContext::infinity if the labels have no hub in common.
+ */
+uint64_t HubLabels::merge(uint32_t source, uint32_t target, uint32_t& out_entry, uint32_t& in_entry) const {
+    uint64_t best = QueryContext::infinity;
+    uint32_t i = out_offsets[source], i_end = out_offsets[source + 1];
+    uint32_t j = in_offsets[target], j_end = in_offsets[target + 1];
+    while (i < i_end && j < j_end) {
+        if (out_hubs[i] < in_hubs[j]) {
+            ++i;
+        } else if (out_hubs[i] > in_hubs[j]) {
+            ++j;
+        } else {
+            const uint64_t total = uint64_t(out_durations[i]) + in_durations[j];
+            if (total < best) {
+                best = total;
+                out_entry = i;
+                in_entry = j;
+            }
+            ++i;
+            ++j;
+        }
+    }
+    return best;
+}
+
+/**
+ * @brief Computes the shortest distance between two nodes by merging their labels.
+ *
+ * @param source The dense index of the starting node.
+ * @param target The dense index of the destination node.
+ * @return The shortest distance, QueryContext::infinity if the target is unreachable.
+ */
+uint64_t HubLabels::distance(uint32_t source, uint32_t target) const {
+    uint32_t out_entry = 0, in_entry = 0;
+    return merge(source, target, out_entry, in_entry);
+}
+
+/**
+ * @brief Rebuilds a shortest route between two nodes from the label entries of its best hub.
+ *
+ * A node is only expanded by the search of a hub, and so becomes a parent, once it has an entry
+ * for that hub: the parents of the hub's entries form its search tree, and following them always
+ * ends at the hub.
+ *
+ * @param source The dense index of the starting node.
+ * @param target The dense index of the destination node.
+ * @return The dense indices of the nodes on the route, empty if the target is unreachable.
+ */
+std::vector<uint32_t> HubLabels::path(uint32_t source, uint32_t target) const {
+    std::vector<uint32_t> route;
+    path(source, target, route);
+    return route;
+}
+
+/**
+ * @brief Rebuilds a shortest route between two nodes into a vector whose capacity is reused.
+ *
+ * The half from the hub to the target is walked backwards, so it is counted first and then stored
+ * straight at its position.
+ *
+ * @param source The dense index of the starting node.
+ * @param target The dense index of the destination node.
+ * @param route Receives the dense indices of the nodes on the route, none if the target is unreachable.
+ */
+void HubLabels::path(uint32_t source, uint32_t target, std::vector<uint32_t>& route) const {
+    route.clear();
+    uint32_t out_entry = 0, in_entry = 0;
+    if (source == target) {
+        route.push_back(source);
+        return;
+    }
+    if (merge(source, target, out_entry, in_entry) == QueryContext::infinity) {
+        return;
+    }
+    const uint32_t hub = out_hubs[out_entry];
+    route.push_back(source);
+    for (uint32_t entry = out_entry; out_parents[entry] != Graph::npos;) {
+        route.push_back(out_parents[entry]);
+        entry = findEntry(out_offsets, out_hubs, out_parents[entry], hub);
+    }
+    size_t end = route.size();
+    for (uint32_t entry = in_entry, at = target; in_parents[entry] != Graph::npos;) {
+        ++end;
+        at = in_parents[entry];
+        entry = findEntry(in_offsets, in_hubs, at, hub);
+    }
+    route.resize(end);
+    for (uint32_t entry = in_entry, at = target; in_parents[entry] != Graph::npos;) {
+        route[--end] = at;
+        at = in_parents[entry];
+        entry = findEntry(in_offsets, in_hubs, at, hub);
+    }
+}
+
+} // namespace travel
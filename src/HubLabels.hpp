@@ -0,0 +1,136 @@
+/**
+ * @file HubLabels.hpp
+ * @brief Contains the declaration of the HubLabels class.
+ */
+
+#pragma once
+#ifndef HUB_LABELS_HPP
+#define HUB_LABELS_HPP
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "ArrayRef.hpp"
+#include "Graph.hpp"
+
+namespace travel {
+    class Snapshot;  // Forward declaration
+    class SnapshotWriter;  // Forward declaration
+
+    /**
+     * @class HubLabels
+     * @brief Hub labeling index answering distance queries without any search.
+     *
+     * Every node v keeps a forward label, (hub, d(v, hub)) pairs, and a backward label,
+     * (hub, d(hub, v)) pairs, such that some hub on a shortest route from s to t appears in both
+     * the forward label of s and the backward label of t. A query is then a linear merge of two
+     * short sorted arrays: d(s, t) = min over common hubs of d(s, hub) + d(hub, t).
+     *
+     * The labels are built by pruned landmark labeling: hubs are processed from the most to the least
+     * connected station, each with a forward and a backward Dijkstra search that stops at every node
+     * whose distance the labels of the previous hubs already cover. Hubs are numbered in that order,
+     * so each label is sorted by construction.
+     *
+     * Each entry also keeps the next node on its route to or from the hub, so the route through the
+     * best hub can be rebuilt by walking entries of that same hub.
+     *
+     * The index is immutable once built and safe to share between threads. Node indices are the
+     * dense indices of the source Graph.
+     */
+    class HubLabels {
+    public:
+        /**
+         * @brief Constructs an empty index.
+         */
+        HubLabels() = default;
+
+        /**
+         * @brief Computes the labels of a graph by pruned landmark labeling.
+         * @param graph The graph to preprocess.
+         */
+        explicit HubLabels(const Graph& graph);
+
+        /**
+         * @brief Uses the labels stored in a snapshot in place, without copying them.
+         * @param snapshot The mapped snapshot, kept alive by the index.
+         * @throws std::runtime_error if a label section is missing or inconsistent.
+         */
+        explicit HubLabels(const Snapshot& snapshot);
+
+        /**
+         * @brief Registers the label arrays as snapshot sections.
+         * @param writer The snapshot being written; the index must outlive the write.
+         */
+        void save(SnapshotWriter& writer) const;
+
+        /**
+         * @brief Computes the shortest distance between two nodes by merging their labels.
+         * @param source The dense index of the starting node.
+         * @param target The dense index of the destination node.
+         * @return The shortest distance, QueryContext::infinity if the target is unreachable.
+         */
+        uint64_t distance(uint32_t source, uint32_t target) const;
+
+        /**
+         * @brief Rebuilds a shortest route between two nodes from the label entries of its best hub.
+         * @param source The dense index of the starting node.
+         * @param target The dense index of the destination node.
+         * @return The dense indices of the nodes on the route, empty if the target is unreachable.
+         */
+        std::vector<uint32_t> path(uint32_t source, uint32_t target) const;
+
+        /**
+         * @brief Rebuilds a shortest route between two nodes into a vector whose capacity is reused.
+         * @param source The dense index of the starting node.
+         * @param target The dense index of the destination node.
+         * @param route Receives the dense indices of the nodes on the route, none if the target is unreachable.
+         */
+        void path(uint32_t source, uint32_t target, std::vector<uint32_t>& route) const;
+
+        /**
+         * @brief Gets the number of nodes.
+         * @return The number of nodes.
+         */
+        uint32_t node_count() const { return out_offsets.empty() ? 0 : static_cast<uint32_t>(out_offsets.size() - 1); }
+
+        /**
+         * @brief Gets the average number of entries per label.
+         * @return The mean size of the forward and backward labels.
+         */
+        double average_label_size() const {
+            return node_count() == 0 ? 0.0 : double(out_hubs.size() + in_hubs.size()) / (2.0 * node_count());
+        }
+
+        /**
+         * @brief Gets the memory used by the labels.
+         * @return The size of every array in bytes.
+         */
+        size_t memory_usage() const {
+            return (out_offsets.size() + in_offsets.size() + 3 * (out_hubs.size() + in_hubs.size())) * sizeof(uint32_t);
+        }
+
+    private:
+        /**
+         * @brief Finds the hub common to two labels with the smallest total distance.
+         * @param source The dense index of the starting node.
+         * @param target The dense index of the destination node.
+         * @param out_entry Receives the entry of the hub in the forward label of source.
+         * @param in_entry Receives the entry of the hub in the backward label of target.
+         * @return The total distance, QueryContext::infinity if the labels have no hub in common.
+         */
+        uint64_t merge(uint32_t source, uint32_t target, uint32_t& out_entry, uint32_t& in_entry) const;
+
+        std::shared_ptr<const void> storage; /**< Owner of the arrays below: the index's own vectors or a mapped snapshot. */
+        ArrayRef<uint32_t> out_offsets; /**< Forward label range of each node, node_count() + 1 entries. */
+        ArrayRef<uint32_t> out_hubs; /**< Hub rank of each forward entry, increasing within a label. */
+        ArrayRef<uint32_t> out_durations; /**< Duration from the node to the hub. */
+        ArrayRef<uint32_t> out_parents; /**< Next node on the route to the hub, Graph::npos at the hub itself. */
+        ArrayRef<uint32_t> in_offsets; /**< Backward label range of each node, node_count() + 1 entries. */
+        ArrayRef<uint32_t> in_hubs; /**< Hub rank of each backward entry, increasing within a label. */
+        ArrayRef<uint32_t> in_durations; /**< Duration from the hub to the node. */
+        ArrayRef<uint32_t> in_parents; /**< Previous node on the route from the hub, Graph::npos at the hub itself. */
+    };
+}
+
+#endif // HUB_LABELS_HPP
@@ -0,0 +1,192 @@
+#include "Landmarks.hpp"
+
+#include <algorithm>
+
+namespace travel {
+
+const uint32_t Landmarks::unreachable;
+const uint32_t Landmarks::default_count;
+
+namespace {
+
+/**
+ * @brief Computes the durations from the closest of several sources to every node.
+ * @param graph The graph.
+ * @param sources The dense indices of the sources.
+ * @param backward True to follow the connections in reverse, giving durations to the sources.
+ * @param distance Receives the duration of each node, QueryContext::infinity if unreached.
+ */
+void searchFrom(const Graph& graph, const std::vector<uint32_t>& sources, bool backward, std::vector<uint64_t>& distance) {
+    RadixQueue queue;
+    distance.assign(graph.node_count(), QueryContext::infinity);
+    for (uint32_t source : sources) {
+        distance[source] = 0;
+        queue.push(0, source);
+    }
+    while (!queue.empty()) {
+        const QueueEntry top = queue.top();
+        queue.pop();
+        const uint32_t u = top.second;
+        if (top.first > distance[u]) {
+            continue;
+        }
+        const uint32_t begin = backward ? graph.reverse_edges_begin(u) : graph.edges_begin(u);
+        const uint32_t end = backward ? graph.reverse_edges_end(u) : graph.edges_end(u);
+        for (uint32_t e = begin; e < end; ++e) {
+            const uint32_t v = backward ? graph.reverse_source(e) : graph.target(e);
+            const uint64_t candidate = top.first + (backward ? graph.reverse_weight(e) : graph.weight(e));
+            if (candidate < distance[v]) {
+                distance[v] = candidate;
+                queue.push(candidate, v);
+            }
+        }
+    }
+}
+
+/**
+ * @brief Finds the node farthest from the sources of the last search, unreached nodes first.
+ * @param distance The durations computed by searchFrom.
+ * @return The dense index of the node.
+ */
+uint32_t farthest(const std::vector<uint64_t>& distance) {
+    return static_cast<uint32_t>(std::max_element(distance.begin(), distance.end()) - distance.begin());
+}
+
+} // namespace
+
+/**
+ * @brief Picks the landmarks by farthest-point selection and computes their distances.
+ *
+ * @param graph The graph to preprocess.
+ * @param count The number of landmarks, at most the number of nodes.
+ */
+Landmarks::Landmarks(const Graph& graph, uint32_t count) : count(std::min(count, graph.node_count())) {
+    const uint32_t n = graph.node_count();
+    if (this->count == 0) {
+        return;
+    }
+
+    std::vector<uint64_t> distance;
+    searchFrom(graph, std::vector<uint32_t>(1, 0), false, distance);
+    landmarks.push_back(farthest(distance));
+    while (landmarks.size() < this->count) {
+        searchFrom(graph, landmarks, false, distance);
+        landmarks.push_back(farthest(distance));
+    }
+
+    from_landmark.resize(size_t(n) * this->count);
+    to_landmark.resize(size_t(n) * this->count);
+    for (uint32_t l = 0; l < this->count; ++l) {
+        const std::vector<uint32_t> source(1, landmarks[l]);
+        for (int direction = 0; direction < 2; ++direction) {
+            searchFrom(graph, source, direction == 1, distance);
+            std::vector<uint32_t>& out = direction == 1 ? to_landmark : from_landmark;
+            for (uint32_t v = 0; v < n; ++v) {
+                out[size_t(v) * this->count + l] = distance[v] < unreachable ? static_cast<uint32_t>(distance[v]) : unreachable;
+            }
+        }
+    }
+}
+
+/**
+ * @brief Gets the best triangle inequality bound over the landmarks.
+ *
+ * Landmarks that cannot reach, or be reached from, either node give no bound.
+ *
+ * @param v The dense index of the origin.
+ * @param target The dense index of the destination.
+ * @return A duration no longer than the shortest route from v to target.
+ */
+uint64_t Landmarks::lower_bound(uint32_t v, uint32_t target) const {
+    const uint32_t* from_v = from_landmark.data() + size_t(v) * count;
+    const uint32_t* from_t = from_landmark.data() + size_t(target) * count;
+    const uint32_t* to_v = to_landmark.data() + size_t(v) * count;
+    const uint32_t* to_t = to_landmark.data() + size_t(target) * count;
+    uint32_t bound = 0;
+    for (uint32_t l = 0; l < count; ++l) {
+        if (from_v[l] != unreachable && from_t[l] != unreachable && from_t[l] > from_v[l]) {
+            bound = std::max(bound, from_t[l] - from_v[l]);
+        }
+        if (to_v[l] != unreachable && to_t[l] != unreachable && to_v[l] > to_t[l]) {
+            bound = std::max(bound, to_v[l] - to_t[l]);
+        }
+    }
+    return bound;
+}
+
+/**
+ * @brief Computes the shortest distance between two nodes with an A* search.
+ *
+ * @param context The scratch state of the calling thread.
+ * @param graph The graph to search.
+ * @param source The dense index of the starting node.
+ * @param target The dense index of the destination node.
+ * @return The shortest distance, QueryContext::infinity if the target is unreachable.
+ */
+uint64_t Landmarks::query(QueryContext& context, const Graph& graph, uint32_t source, uint32_t target) const {
+    context.prepare(graph.node_count());
+    context.setForward(source, 0, QueryContext::none);
+    switch (context.queue_strategy) {
+    case QueueStrategy::RadixHeap:
+        run(context, context.radixQueue, graph, source, target);
+        break;
+    case QueueStrategy::IndexedDaryHeap:
+        run(context, context.daryQueue, graph, source, target);
+        break;
+    default:
+        run(context, context.queue, graph, source, target);
+        break;
+    }
+    return context.distance(target);
+}
+
+/**
+ * @brief Runs the A* search on a given kind of priority queue.
+ *
+ * Nodes are queued by distance plus lower bound. The bounds are consistent (a connection never
+ * lowers the bound by more than its duration), so keys come out in increasing order, which the
+ * radix heap requires, and a node is final once settled. The bound of each node is computed once
+ * and memoized in its backward label, which this search does not otherwise use.
+ *
+ * @param context The scratch state of the calling thread, prepared.
+ * @param pq The queue of the search, empty.
+ * @param graph The graph to search.
+ * @param source The dense index of the starting node.
+ * @param target The dense index of the destination node.
+ */
+template <typename Queue>
+void Landmarks::run(QueryContext& context, Queue& pq, const Graph& graph, uint32_t source, uint32_t target) const {
+    context.setBackward(source, lower_bound(source, target), QueryContext::none);
+    pq.push(context.distanceBackward(source), source);
+    while (!pq.empty()) {
+        const uint64_t key = pq.top().first;
+        const uint32_t u = pq.top().second;
+        pq.pop();
+        const uint64_t d = context.distance(u);
+        if (key > d + context.distanceBackward(u)) {
+            TRAVEL_COUNT(context.counters.stale);
+            continue; // Stale entry
+        }
+        ++context.settled;
+        if (u == target) {
+            break;
+        }
+        for (uint32_t e = graph.edges_begin(u); e < graph.edges_end(u); ++e) {
+            TRAVEL_COUNT(context.counters.relaxed);
+            const uint32_t v = graph.target(e);
+            const uint64_t candidate = d + graph.weight(e);
+            if (candidate < context.distance(v)) {
+                uint64_t bound = context.distanceBackward(v);
+                if (bound == QueryContext::infinity) {
+                    bound = lower_bound(v, target);
+                    context.setBackward(v, bound, QueryContext::none);
+                }
+                context.setForward(v, candidate, u);
+                pq.push(candidate + bound, v);
+                TRAVEL_COUNT(context.counters.pushes);
+            }
+        }
+    }
+}
+
+} // namespace travel
@@ -0,0 +1,108 @@
+/**
+ * @file Landmarks.hpp
+ * @brief Contains the declaration of the Landmarks class.
+ */
+
+#pragma once
+#ifndef LANDMARKS_HPP
+#define LANDMARKS_HPP
+
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "Graph.hpp"
+#include "QueryContext.hpp"
+
+namespace travel {
+
+    /**
+     * @class Landmarks
+     * @brief Landmark distances for goal-directed A* queries (ALT: A*, landmarks, triangle inequality).
+     *
+     * A few landmarks are picked far apart on the graph, and the durations from every node to each
+     * landmark and back are precomputed with two searches per landmark. For any landmark L, the
+     * triangle inequality gives d(v, t) >= d(L, t) - d(L, v) and d(v, t) >= d(v, L) - d(t, L); the
+     * best of these bounds steers the search towards the target, which then settles a corridor
+     * instead of a disc around the start.
+     *
+     * The bounds stay valid when connections are closed or get slower, since no duration can get
+     * shorter: a query on a disrupted copy of the preprocessed graph is still exact. Only faster
+     * connections require new landmark distances.
+     *
+     * The index is immutable once built and is queried with a caller-owned QueryContext, so it is
+     * safe to share between threads. Node indices are the dense indices of the source Graph.
+     */
+    class Landmarks {
+    public:
+        static const uint32_t unreachable = std::numeric_limits<uint32_t>::max(); /**< Stored duration of unreachable pairs. */
+        static const uint32_t default_count = 16; /**< Number of landmarks picked by default. */
+
+        /**
+         * @brief Constructs an empty index, whose bounds are all zero.
+         */
+        Landmarks() = default;
+
+        /**
+         * @brief Picks the landmarks by farthest-point selection and computes their distances.
+         *
+         * The first landmark is the node farthest from node 0, each next one the node farthest
+         * from all landmarks picked so far; nodes no landmark reaches yet are picked first.
+         * @param graph The graph to preprocess.
+         * @param count The number of landmarks, at most the number of nodes.
+         */
+        explicit Landmarks(const Graph& graph, uint32_t count = default_count);
+
+        /**
+         * @brief Computes the shortest distance between two nodes with an A* search.
+         *
+         * Afterwards context.previous() leads from the target back to the source.
+         * @param context The scratch state of the calling thread; its queue_strategy is honoured.
+         * @param graph The graph to search: the preprocessed one, or a copy with the same dense
+         *        indices where connections are only closed or slower.
+         * @param source The dense index of the starting node.
+         * @param target The dense index of the destination node.
+         * @return The shortest distance, QueryContext::infinity if the target is unreachable.
+         */
+        uint64_t query(QueryContext& context, const Graph& graph, uint32_t source, uint32_t target) const;
+
+        /**
+         * @brief Gets the landmark lower bound of the distance between two nodes.
+         * @param v The dense index of the origin.
+         * @param target The dense index of the destination.
+         * @return A duration no longer than the shortest route from v to target.
+         */
+        uint64_t lower_bound(uint32_t v, uint32_t target) const;
+
+        /**
+         * @brief Gets the landmarks.
+         * @return The dense indices of the landmarks, in selection order.
+         */
+        const std::vector<uint32_t>& get_landmarks() const { return landmarks; }
+
+        /**
+         * @brief Gets the memory used by the distance arrays.
+         * @return The size in bytes.
+         */
+        size_t memory_usage() const { return (from_landmark.size() + to_landmark.size()) * sizeof(uint32_t); }
+
+    private:
+        /**
+         * @brief Runs the A* search on a given kind of priority queue.
+         * @param context The scratch state of the calling thread, prepared.
+         * @param pq The queue of the search, empty.
+         * @param graph The graph to search.
+         * @param source The dense index of the starting node.
+         * @param target The dense index of the destination node.
+         */
+        template <typename Queue>
+        void run(QueryContext& context, Queue& pq, const Graph& graph, uint32_t source, uint32_t target) const;
+
+        std::vector<uint32_t> landmarks; /**< Dense index of each landmark. */
+        std::vector<uint32_t> from_landmark; /**< d(L, v) at [v * count + L], node-major so a bound reads one cache line. */
+        std::vector<uint32_t> to_landmark; /**< d(v, L) at [v * count + L]. */
+        uint32_t count = 0; /**< Number of landmarks. */
+    };
+}
+
+#endif // LANDMARKS_HPP
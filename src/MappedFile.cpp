@@ -0,0 +1,80 @@
+#include "MappedFile.hpp"
+
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+namespace travel {
+
+/**
+ * @brief Maps a file into memory.
+ *
+ * @param filename The path of the file.
+ * @throws std::runtime_error if the file cannot be opened or mapped.
+ */
+MappedFile::MappedFile(const std::string& filename) {
+    std::string error;
+    if (!open(filename, &error)) {
+        throw std::runtime_error(error + " (MappedFile)");
+    }
+}
+
+/**
+ * @brief Unmaps the file.
+ */
+MappedFile::~MappedFile() {
+    close();
+}
+
+/**
+ * @brief Maps a file into memory without throwing, replacing any previous mapping.
+ *
+ * @param filename The path of the file.
+ * @param error Receives a description of the failure, if not null.
+ * @return True if the file is mapped.
+ */
+bool MappedFile::open(const std::string& filename, std::string* error) noexcept {
+    close();
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+        if (error != nullptr) *error = "Error opening file: " + filename + ": " + std::strerror(errno);
+        return false;
+    }
+    struct stat info;
+    if (::fstat(fd, &info) != 0) {
+        if (error != nullptr) *error = "Error reading file size: " + filename + ": " + std::strerror(errno);
+        ::close(fd);
+        return false;
+    }
+    size_t size = static_cast<size_t>(info.st_size);
+    if (size > 0) {
+        void* mapping = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapping == MAP_FAILED) {
+            if (error != nullptr) *error = "Error mapping file: " + filename + ": " + std::strerror(errno);
+            ::close(fd);
+            return false;
+        }
+        bytes = static_cast<const char*>(mapping);
+    }
+    length = size;
+    ::close(fd); // The mapping stays valid after the descriptor is closed
+    return true;
+}
+
+/**
+ * @brief Unmaps the file, if any.
+ */
+void MappedFile::close() noexcept {
+    if (bytes != nullptr) {
+        ::munmap(const_cast<char*>(bytes), length);
+    }
+    bytes = nullptr;
+    length = 0;
+}
+
+} // namespace travel
@@ -0,0 +1,75 @@
+/**
+ * @file MappedFile.hpp
+ * @brief Contains the declaration of the MappedFile class.
+ */
+
+#pragma once
+#ifndef MAPPED_FILE_HPP
+#define MAPPED_FILE_HPP
+
+#include <cstddef>
+#include <string>
+
+namespace travel {
+
+    /**
+     * @class MappedFile
+     * @brief Read-only memory mapping of a whole file.
+     *
+     * The pages are loaded by the kernel on first access and shared between processes mapping the
+     * same file, so several workers restarting on the same data pay neither a copy nor a parse.
+     */
+    class MappedFile {
+    public:
+        /**
+         * @brief Constructs an object with no file mapped; see open().
+         */
+        MappedFile() = default;
+
+        /**
+         * @brief Maps a file into memory.
+         * @param filename The path of the file.
+         * @throws std::runtime_error if the file cannot be opened or mapped.
+         */
+        explicit MappedFile(const std::string& filename);
+
+        /**
+         * @brief Unmaps the file.
+         */
+        ~MappedFile();
+
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        /**
+         * @brief Maps a file into memory without throwing, replacing any previous mapping.
+         * @param filename The path of the file.
+         * @param error Receives a description of the failure, if not null.
+         * @return True if the file is mapped.
+         */
+        bool open(const std::string& filename, std::string* error = nullptr) noexcept;
+
+        /**
+         * @brief Unmaps the file, if any.
+         */
+        void close() noexcept;
+
+        /**
+         * @brief Gets the mapped bytes.
+         * @return A pointer to the first byte, nullptr for an empty file.
+         */
+        const char* data() const { return bytes; }
+
+        /**
+         * @brief Gets the size of the file.
+         * @return The number of mapped bytes.
+         */
+        size_t size() const { return length; }
+
+    private:
+        const char* bytes = nullptr; /**< The mapping. */
+        size_t length = 0; /**< The size of the mapping. */
+    };
+}
+
+#endif // MAPPED_FILE_HPP
@@ -0,0 +1,315 @@
+#include "Metrics.hpp"
+#include "QueryContext.hpp"
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <vector>
+
+namespace travel {
+
+constexpr bool Metrics::enabled;
+
+namespace {
+
+const size_t histogram_count = static_cast<size_t>(Metrics::Histogram::Count);
+const size_t phase_count = static_cast<size_t>(Metrics::Phase::Count);
+const uint32_t bucket_count = 65; // Up to 2^64, the last bucket only ever shows as +Inf
+
+/**
+ * @brief Adds to a counter only ever written by the calling thread; readers may see it at any time.
+ * @param counter The counter.
+ * @param value The amount to add.
+ */
+void add(std::atomic<uint64_t>& counter, uint64_t value) {
+    counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+}
+
+/**
+ * @brief Gets the power-of-two bucket of a value.
+ * @param value The value.
+ * @return The smallest k such that value <= 2^k.
+ */
+uint32_t bucketOf(uint64_t value) {
+    return value <= 1 ? 0 : 64 - static_cast<uint32_t>(__builtin_clzll(value - 1));
+}
+
+/**
+ * @brief Bucket counts, sum and count of one histogram of one thread.
+ */
+struct HistogramData {
+    std::atomic<uint64_t> buckets[bucket_count];
+    std::atomic<uint64_t> sum;
+    std::atomic<uint64_t> count;
+
+    void record(uint64_t value) {
+        add(buckets[bucketOf(value)], 1);
+        add(sum, value);
+        add(count, 1);
+    }
+};
+
+/**
+ * @brief The histograms of one thread. Value-initialized, so every counter starts at 0.
+ */
+struct ThreadHistograms {
+    HistogramData histograms[histogram_count];
+};
+
+/**
+ * @brief Totals of one load phase. Phases run rarely, so they are shared by all threads.
+ */
+struct PhaseData {
+    std::atomic<uint64_t> runs;
+    std::atomic<uint64_t> nanos;
+    std::atomic<uint64_t> last_nanos;
+    std::atomic<uint64_t> rows;
+};
+
+/**
+ * @brief Owner of the histograms of every thread that recorded a query, and of the phase totals.
+ */
+struct Registry {
+    std::mutex mutex;
+    std::vector<std::unique_ptr<ThreadHistograms>> threads;
+    PhaseData phases[phase_count];
+};
+
+Registry& registry() {
+    static Registry instance;
+    return instance;
+}
+
+/**
+ * @brief Gets the histograms of the calling thread, registering them on first use.
+ * @return The histograms, owned by the registry so that they outlive the thread.
+ */
+ThreadHistograms& localHistograms() {
+    static thread_local ThreadHistograms* histograms = [] {
+        Registry& instance = registry();
+        std::lock_guard<std::mutex> lock(instance.mutex);
+        instance.threads.push_back(std::unique_ptr<ThreadHistograms>(new ThreadHistograms()));
+        return instance.threads.back().get();
+    }();
+    return *histograms;
+}
+
+/**
+ * @brief Totals of one histogram over every thread.
+ */
+struct HistogramTotals {
+    uint64_t buckets[bucket_count] = {};
+    uint64_t sum = 0;
+    uint64_t count = 0;
+};
+
+/**
+ * @brief Sums the histograms of every thread.
+ * @return The totals, indexed by Metrics::Histogram.
+ */
+std::vector<HistogramTotals> collect() {
+    std::vector<HistogramTotals> totals(histogram_count);
+    Registry& instance = registry();
+    std::lock_guard<std::mutex> lock(instance.mutex);
+    for (const std::unique_ptr<ThreadHistograms>& thread : instance.threads) {
+        for (size_t h = 0; h < histogram_count; ++h) {
+            const HistogramData& data = thread->histograms[h];
+            for (uint32_t b = 0; b < bucket_count; ++b) {
+                totals[h].buckets[b] += data.buckets[b].load(std::memory_order_relaxed);
+            }
+            totals[h].sum += data.sum.load(std::memory_order_relaxed);
+            totals[h].count += data.count.load(std::memory_order_relaxed);
+        }
+    }
+    return totals;
+}
+
+/**
+ * @brief Export names of the histograms and phases.
+ */
+const char* const histogram_names[histogram_count] = {
+    "settled_nodes", "relaxed_edges", "heap_pushes", "stale_pops", "path_length", "wall_time_ns"
+};
+const char* const histogram_help[histogram_count] = {
+    "Nodes settled per query.", "Edges relaxed per query.", "Priority queue insertions per query.",
+    "Outdated priority queue entries skipped per query.", "Connections on the route of each query.",
+    "Wall time of each query."
+};
+const char* const phase_names[phase_count] = {"read_stations", "read_connections"};
+
+} // namespace
+
+/**
+ * @brief Adds one query to the histograms of the calling thread.
+ *
+ * @param settled The nodes settled by the search, 0 if none ran.
+ * @param counters The rest of the work done by the search.
+ * @param path_length The number of connections on the route.
+ * @param nanos The wall time of the query.
+ */
+void Metrics::record_query(uint32_t settled, const SearchCounters& counters, uint32_t path_length, uint64_t nanos) {
+    HistogramData* histograms = localHistograms().histograms;
+    histograms[static_cast<size_t>(Histogram::SettledNodes)].record(settled);
+    histograms[static_cast<size_t>(Histogram::RelaxedEdges)].record(counters.relaxed);
+    histograms[static_cast<size_t>(Histogram::HeapPushes)].record(counters.pushes);
+    histograms[static_cast<size_t>(Histogram::StalePops)].record(counters.stale);
+    histograms[static_cast<size_t>(Histogram::PathLength)].record(path_length);
+    histograms[static_cast<size_t>(Histogram::WallTime)].record(nanos);
+}
+
+/**
+ * @brief Adds one run of a load phase.
+ *
+ * @param phase The phase.
+ * @param nanos The wall time of the run.
+ * @param rows The number of rows read.
+ */
+void Metrics::record_phase(Phase phase, uint64_t nanos, uint64_t rows) {
+    PhaseData& data = registry().phases[static_cast<size_t>(phase)];
+    data.runs.fetch_add(1, std::memory_order_relaxed);
+    data.nanos.fetch_add(nanos, std::memory_order_relaxed);
+    data.last_nanos.store(nanos, std::memory_order_relaxed);
+    data.rows.fetch_add(rows, std::memory_order_relaxed);
+}
+
+/**
+ * @brief Exports every metric in the Prometheus text exposition format.
+ *
+ * Histograms become cumulative _bucket series up to the highest non-empty bucket, then +Inf; the
+ * wall time is converted to seconds as Prometheus expects.
+ *
+ * @return The exposition.
+ */
+std::string Metrics::prometheus() {
+    std::ostringstream out;
+    out.precision(10);
+    std::vector<HistogramTotals> totals = collect();
+    for (size_t h = 0; h < histogram_count; ++h) {
+        const bool seconds = h == static_cast<size_t>(Histogram::WallTime);
+        const std::string name = std::string("travel_query_") + (seconds ? "duration_seconds" : histogram_names[h]);
+        const double scale = seconds ? 1e-9 : 1.0;
+        out << "# HELP " << name << ' ' << histogram_help[h] << "\n# TYPE " << name << " histogram\n";
+        uint32_t last = 0;
+        for (uint32_t b = 0; b + 1 < bucket_count; ++b) {
+            if (totals[h].buckets[b] != 0) {
+                last = b;
+            }
+        }
+        uint64_t cumulative = 0;
+        for (uint32_t b = 0; b <= last; ++b) {
+            cumulative += totals[h].buckets[b];
+            out << name << "_bucket{le=\"" << double(uint64_t(1) << b) * scale << "\"} " << cumulative << '\n';
+        }
+        out << name << "_bucket{le=\"+Inf\"} " << totals[h].count << '\n'
+            << name << "_sum " << double(totals[h].sum) * scale << '\n'
+            << name << "_count " << totals[h].count << '\n';
+    }
+
+    PhaseData* phases = registry().phases;
+    out << "# HELP travel_load_phase_runs_total Runs of each load phase.\n# TYPE travel_load_phase_runs_total counter\n";
+    for (size_t p = 0; p < phase_count; ++p) {
+        out << "travel_load_phase_runs_total{phase=\"" << phase_names[p] << "\"} " << phases[p].runs.load() << '\n';
+    }
+    out << "# HELP travel_load_phase_seconds_total Wall time spent in each load phase.\n# TYPE travel_load_phase_seconds_total counter\n";
+    for (size_t p = 0; p < phase_count; ++p) {
+        out << "travel_load_phase_seconds_total{phase=\"" << phase_names[p] << "\"} " << double(phases[p].nanos.load()) * 1e-9 << '\n';
+    }
+    out << "# HELP travel_load_phase_last_seconds Wall time of the last run of each load phase.\n# TYPE travel_load_phase_last_seconds gauge\n";
+    for (size_t p = 0; p < phase_count; ++p) {
+        out << "travel_load_phase_last_seconds{phase=\"" << phase_names[p] << "\"} " << double(phases[p].last_nanos.load()) * 1e-9 << '\n';
+    }
+    out << "# HELP travel_load_phase_rows_total Rows read by each load phase.\n# TYPE travel_load_phase_rows_total counter\n";
+    for (size_t p = 0; p < phase_count; ++p) {
+        out << "travel_load_phase_rows_total{phase=\"" << phase_names[p] << "\"} " << phases[p].rows.load() << '\n';
+    }
+    return out.str();
+}
+
+/**
+ * @brief Exports every metric as a JSON object.
+ *
+ * Each histogram lists its non-empty buckets as [upper bound, count] pairs, not cumulated; times
+ * are in nanoseconds.
+ *
+ * @return The object.
+ */
+std::string Metrics::json() {
+    std::ostringstream out;
+    std::vector<HistogramTotals> totals = collect();
+    out << "{\"enabled\":" << (enabled ? "true" : "false") << ",\"queries\":{";
+    for (size_t h = 0; h < histogram_count; ++h) {
+        out << (h ? "," : "") << '"' << histogram_names[h] << "\":{\"count\":" << totals[h].count
+            << ",\"sum\":" << totals[h].sum << ",\"buckets\":[";
+        bool first = true;
+        for (uint32_t b = 0; b < bucket_count; ++b) {
+            if (totals[h].buckets[b] != 0) {
+                out << (first ? "" : ",") << '[';
+                if (b < 64) {
+                    out << (uint64_t(1) << b);
+                } else {
+                    out << "null";
+                }
+                out << ',' << totals[h].buckets[b] << ']';
+                first = false;
+            }
+        }
+        out << "]}";
+    }
+    out << "},\"phases\":{";
+    PhaseData* phases = registry().phases;
+    for (size_t p = 0; p < phase_count; ++p) {
+        out << (p ? "," : "") << '"' << phase_names[p] << "\":{\"runs\":" << phases[p].runs.load()
+            << ",\"nanos\":" << phases[p].nanos.load() << ",\"last_nanos\":" << phases[p].last_nanos.load()
+            << ",\"rows\":" << phases[p].rows.load() << '}';
+    }
+    out << "}}";
+    return out.str();
+}
+
+/**
+ * @brief Clears every histogram and phase counter.
+ *
+ * Meant for quiet periods: a query recorded concurrently may be partly lost.
+ */
+void Metrics::reset() {
+    Registry& instance = registry();
+    std::lock_guard<std::mutex> lock(instance.mutex);
+    for (const std::unique_ptr<ThreadHistograms>& thread : instance.threads) {
+        for (HistogramData& data : thread->histograms) {
+            for (std::atomic<uint64_t>& bucket : data.buckets) {
+                bucket.store(0, std::memory_order_relaxed);
+            }
+            data.sum.store(0, std::memory_order_relaxed);
+            data.count.store(0, std::memory_order_relaxed);
+        }
+    }
+    for (PhaseData& data : instance.phases) {
+        data.runs.store(0);
+        data.nanos.store(0);
+        data.last_nanos.store(0);
+        data.rows.store(0);
+    }
+}
+
+#if TRAVEL_METRICS
+/**
+ * @brief Starts the clock and clears the counters of the context.
+ *
+ * @param context The scratch state of the calling thread.
+ */
+QueryProbe::QueryProbe(QueryContext& context) : context(context), begin(std::chrono::steady_clock::now()) {
+    context.settled = 0;
+    context.counters = SearchCounters();
+}
+
+/**
+ * @brief Records the query with the counters left in the context by its search, if any ran.
+ */
+QueryProbe::~QueryProbe() {
+    Metrics::record_query(context.settled, context.counters, path_length, static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - begin).count()));
+}
+#endif
+
+} // namespace travel
@@ -0,0 +1,195 @@
+/**
+ * @file Metrics.hpp
+ * @brief Contains the declaration of the Metrics class and of the query and load probes.
+ */
+
+#pragma once
+#ifndef METRICS_HPP
+#define METRICS_HPP
+
+#include <cstdint>
+#include <string>
+#include <chrono>
+
+/**
+ * Instrumentation is compiled in with -DTRAVEL_METRICS=1. Without it, the counters below are never
+ * touched, the probes are empty inline classes and the export functions report an empty registry.
+ */
+#ifndef TRAVEL_METRICS
+#define TRAVEL_METRICS 0
+#endif
+
+#if TRAVEL_METRICS
+#define TRAVEL_COUNT(counter) (++(counter))
+#else
+#define TRAVEL_COUNT(counter) ((void)0)
+#endif
+
+namespace travel {
+    class QueryContext;  // Forward declaration
+
+    /**
+     * @struct SearchCounters
+     * @brief Work done by the last search of a QueryContext, filled only when TRAVEL_METRICS is set.
+     */
+    struct SearchCounters {
+        uint32_t relaxed = 0; /**< Edges scanned from settled nodes. */
+        uint32_t pushes = 0; /**< Queue insertions made by those edges. */
+        uint32_t stale = 0; /**< Queue entries popped after their node was settled with a shorter distance. */
+    };
+
+    /**
+     * @class Metrics
+     * @brief Process-wide registry of query histograms and load-phase timings.
+     *
+     * Each thread records into its own histograms, registered on first use and kept after the thread
+     * exits, so recording takes no lock and no atomic read-modify-write. Exports sum the histograms
+     * of every thread. Buckets are powers of two: bucket k counts the values in (2^(k-1), 2^k].
+     */
+    class Metrics {
+    public:
+        static constexpr bool enabled = TRAVEL_METRICS != 0; /**< Whether the probes record anything. */
+
+        /**
+         * @brief The per-query histograms.
+         */
+        enum class Histogram {
+            SettledNodes,  /**< Nodes settled, both directions included. */
+            RelaxedEdges,  /**< Edges scanned. */
+            HeapPushes,    /**< Priority queue insertions. */
+            StalePops,     /**< Outdated priority queue entries skipped. */
+            PathLength,    /**< Connections on the route, 0 if unreachable. */
+            WallTime,      /**< Nanoseconds spent in plan_journey, cache hits included. */
+            Count
+        };
+
+        /**
+         * @brief The timed load phases.
+         */
+        enum class Phase {
+            ReadStations,     /**< MetroNetworkParser::read_stations. */
+            ReadConnections,  /**< MetroNetworkParser::read_connections. */
+            Count
+        };
+
+        /**
+         * @brief Adds one query to the histograms of the calling thread.
+         * @param settled The nodes settled by the search, 0 if none ran.
+         * @param counters The rest of the work done by the search.
+         * @param path_length The number of connections on the route.
+         * @param nanos The wall time of the query.
+         */
+        static void record_query(uint32_t settled, const SearchCounters& counters, uint32_t path_length, uint64_t nanos);
+
+        /**
+         * @brief Adds one run of a load phase.
+         * @param phase The phase.
+         * @param nanos The wall time of the run.
+         * @param rows The number of rows read.
+         */
+        static void record_phase(Phase phase, uint64_t nanos, uint64_t rows);
+
+        /**
+         * @brief Exports every metric in the Prometheus text exposition format.
+         * @return The exposition, one family per histogram and per phase counter.
+         */
+        static std::string prometheus();
+
+        /**
+         * @brief Exports every metric as a JSON object.
+         * @return The object, with the non-cumulative bucket counts of each histogram.
+         */
+        static std::string json();
+
+        /**
+         * @brief Clears every histogram and phase counter, e.g. between benchmark runs.
+         */
+        static void reset();
+    };
+
+#if TRAVEL_METRICS
+    /**
+     * @class QueryProbe
+     * @brief Measures one query for the Metrics histograms, from construction to destruction.
+     */
+    class QueryProbe {
+    public:
+        /**
+         * @brief Starts the clock and clears the counters of the context the query will search with.
+         * @param context The scratch state of the calling thread.
+         */
+        explicit QueryProbe(QueryContext& context);
+
+        /**
+         * @brief Records the query.
+         */
+        ~QueryProbe();
+
+        QueryProbe(const QueryProbe&) = delete;
+        QueryProbe& operator=(const QueryProbe&) = delete;
+
+        /**
+         * @brief Sets the number of connections on the route found.
+         * @param length The length of the route.
+         */
+        void set_path_length(size_t length) { path_length = static_cast<uint32_t>(length); }
+
+    private:
+        QueryContext& context; /**< The context the counters are read from. */
+        std::chrono::steady_clock::time_point begin; /**< Start of the query. */
+        uint32_t path_length = 0; /**< Connections on the route. */
+    };
+
+    /**
+     * @class PhaseProbe
+     * @brief Measures one run of a load phase, from construction to destruction.
+     */
+    class PhaseProbe {
+    public:
+        /**
+         * @brief Starts the clock.
+         * @param phase The phase being run.
+         */
+        explicit PhaseProbe(Metrics::Phase phase) : phase(phase), begin(std::chrono::steady_clock::now()) {}
+
+        /**
+         * @brief Records the run.
+         */
+        ~PhaseProbe() {
+            Metrics::record_phase(phase, static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - begin).count()), rows);
+        }
+
+        PhaseProbe(const PhaseProbe&) = delete;
+        PhaseProbe& operator=(const PhaseProbe&) = delete;
+
+        /**
+         * @brief Counts one row read.
+         */
+        void add_row() { ++rows; }
+
+    private:
+        Metrics::Phase phase; /**< The phase being run. */
+        std::chrono::steady_clock::time_point begin; /**< Start of the run. */
+        uint64_t rows = 0; /**< Rows read so far. */
+    };
+#else
+    class QueryProbe {
+    public:
+        explicit QueryProbe(QueryContext&) {}
+        QueryProbe(const QueryProbe&) = delete;
+        QueryProbe& operator=(const QueryProbe&) = delete;
+        void set_path_length(size_t) {}
+    };
+
+    class PhaseProbe {
+    public:
+        explicit PhaseProbe(Metrics::Phase) {}
+        PhaseProbe(const PhaseProbe&) = delete;
+        PhaseProbe& operator=(const PhaseProbe&) = delete;
+        void add_row() {}
+    };
+#endif
+}
+
+#endif // METRICS_HPP
@@ -1,115 +1,491 @@
 
 #include "MetroNetworkParser.hpp"
 #include "Navigation.hpp"
+#include "ThreadPool.hpp"
+#include "ContractionHierarchy.hpp"
+#include "HubLabels.hpp"
+#include "Snapshot.hpp"
+#include "MappedFile.hpp"
+#include "Metrics.hpp"
 
 namespace travel {
 
+/**
+ * Returns the ParetoContext of the calling thread, shared by every multi-criteria query it runs.
+ */
+static ParetoContext& thread_pareto_context() {
+    static thread_local ParetoContext context;
+    return context;
+}
+
+/**
+ * Returns the QueryContext of the calling thread, shared by every query it runs.
+ */
+static QueryContext& thread_context() {
+    static thread_local QueryContext context;
+    return context;
+}
+
 /**
  * Constructor for the MetroNetworkParser class.
  * Initializes the MetroNetworkParser object and calls the initializeData() function.
  */
 MetroNetworkParser::MetroNetworkParser(){
-    std::cout << "MetroNetworkParser constructor called" << std::endl;
     initializeData();
 }
 
+/**
+ * Constructor loading the network from a binary snapshot.
+ * @param snapshot_filename The path of the snapshot.
+ */
+MetroNetworkParser::MetroNetworkParser(const std::string& snapshot_filename){
+    load_snapshot(snapshot_filename);
+}
+
+/**
+ * Constructor loading the network from the given CSV files.
+ * @param stations_filename The path of the stations CSV file.
+ * @param connections_filename The path of the connections CSV file.
+ */
+MetroNetworkParser::MetroNetworkParser(const std::string& stations_filename, const std::string& connections_filename){
+    initializeData(stations_filename, connections_filename);
+}
+
 /**
  * Destructor for the MetroNetworkParser class.
- * Deletes the navigation object to properly free memory.
+ * The graph and navigation objects are released with the last query still holding them.
  */
 MetroNetworkParser::~MetroNetworkParser() {
-    delete navigation;  // Properly delete navigation
 }
 
 /**
  * Initializes the data for the MetroNetworkParser object.
  * Reads station and connection data from files and populates the corresponding hashmaps.
- * Initializes the navigation object after all data is loaded.
+ * Builds the CSR graph and initializes the navigation object after all data is loaded.
  */
 void MetroNetworkParser::initializeData() {
-    read_stations("src/data/s.csv");
-    read_connections("src/data/c.csv");
-    navigation = new Navigation(*this);  // Properly initialize navigation after all data is loaded
+    initializeData("src/data/s.csv", "src/data/c.csv");
+}
+
+/**
+ * Initializes the data for the MetroNetworkParser object from the given CSV files.
+ * @param stations_filename The path of the stations CSV file.
+ * @param connections_filename The path of the connections CSV file.
+ */
+void MetroNetworkParser::initializeData(const std::string& stations_filename, const std::string& connections_filename) {
+    read_stations(stations_filename);
+    read_connections(connections_filename);
+    connections_loaded = true;
+
+    std::vector<uint64_t> station_ids;
+    station_ids.reserve(stations.size());
+    for (uint32_t row = 0; row < stations.size(); ++row) {
+        station_ids.push_back(stations.id(row));
+    }
+    graph = std::make_shared<const Graph>(connections_hashmap, station_ids);
+    distance_table.reset();
+    landmarks.reset();
+    hub_labels.reset();
+    timetable.reset();
+    finalize_network();
+}
+
+/**
+ * Creates the navigation object once the graph is in place, drops the disruptions of the previous
+ * network and publishes the new one.
+ */
+void MetroNetworkParser::finalize_network() {
+    navigation = std::make_shared<const Navigation>(graph);  // Properly initialize navigation after all data is loaded
+    std::vector<uint32_t> lines(graph->node_count(), StationTable::npos);
+    for (uint32_t u = 0; u < graph->node_count(); ++u) {
+        const uint32_t row = stations.find(graph->id_of(u));
+        if (row != StationTable::npos) {
+            lines[u] = stations.line_handle(row);
+        }
+    }
+    node_lines = std::make_shared<const std::vector<uint32_t>>(std::move(lines));
+    pareto = std::make_shared<const ParetoSearch>(graph, node_lines);
+    station_index = std::make_shared<const StationIndex>(stations);
+
+    std::lock_guard<std::mutex> lock(update_mutex);
+    closed_stations.clear();
+    connection_overrides.clear();
+    published_overrides.clear();
+    publish_network(true);
+}
+
+/**
+ * Returns whether a route found on the loaded network uses a connection that is closed or has
+ * another duration in a disrupted version.
+ * @param network The disrupted version.
+ * @param path The dense indices of the route.
+ * @return True if the route is not valid as is in the version.
+ */
+static bool crosses_disruption(const NetworkVersion& network, const std::vector<uint32_t>& path) {
+    for (size_t i = 0; i + 1 < path.size(); ++i) {
+        uint32_t e = network.graph->find_edge(path[i], path[i + 1]);
+        if (e == Graph::npos || network.graph->weight(e) != network.base->weight(network.base->find_edge(path[i], path[i + 1]))) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * Builds the graph of the new version from the loaded graph and the disruptions, repairs the
+ * caches and publishes the version. Readers are never blocked: they keep the version they loaded.
+ * @param reload Whether the loaded network itself changed, which empties the caches.
+ */
+void MetroNetworkParser::publish_network(bool reload) {
+    std::shared_ptr<NetworkVersion> version = std::make_shared<NetworkVersion>();
+    version->base = graph;
+    version->contraction_hierarchy = contraction_hierarchy;
+    version->distance_table = distance_table;
+    version->landmarks = landmarks;
+    version->hub_labels = hub_labels;
+    version->timetable = timetable;
+
+    // Expand the closed stations into closed connections, both ways.
+    std::map<uint64_t, uint32_t> overrides = connection_overrides;
+    for (uint32_t station : closed_stations) {
+        for (uint32_t e = graph->edges_begin(station); e < graph->edges_end(station); ++e) {
+            overrides[uint64_t(station) << 32 | graph->target(e)] = Graph::closed;
+        }
+        for (uint32_t e = graph->reverse_edges_begin(station); e < graph->reverse_edges_end(station); ++e) {
+            overrides[uint64_t(graph->reverse_source(e)) << 32 | station] = Graph::closed;
+        }
+    }
+
+    // The keys sort like the edges of the CSR arrays: by tail, then by head.
+    std::vector<std::pair<uint32_t, uint32_t>> edges;
+    edges.reserve(overrides.size());
+    for (const auto& entry : overrides) {
+        uint32_t e = graph->find_edge(static_cast<uint32_t>(entry.first >> 32), static_cast<uint32_t>(entry.first));
+        edges.emplace_back(e, entry.second);
+        version->slower_only = version->slower_only && entry.second >= graph->weight(e);
+    }
+    version->disrupted = !edges.empty();
+    if (version->disrupted) {
+        version->graph = std::make_shared<const Graph>(*graph, edges);
+        version->navigation = std::make_shared<const Navigation>(version->graph);
+        version->pareto = std::make_shared<const ParetoSearch>(version->graph, node_lines);
+    } else {
+        version->graph = graph;
+        version->navigation = navigation;
+        version->pareto = pareto;
+    }
+
+    // Connections whose duration differs from the previous version, and whether any got faster.
+    std::vector<uint64_t> changed;
+    bool faster = false;
+    auto effective = [this](const std::map<uint64_t, uint32_t>& map, uint64_t key) {
+        auto it = map.find(key);
+        return it != map.end() ? it->second : graph->weight(graph->find_edge(static_cast<uint32_t>(key >> 32), static_cast<uint32_t>(key)));
+    };
+    std::set<uint64_t> keys;
+    for (const auto& entry : overrides) {
+        keys.insert(entry.first);
+    }
+    for (const auto& entry : published_overrides) {
+        keys.insert(entry.first);
+    }
+    for (uint64_t key : keys) {
+        uint32_t before = effective(published_overrides, key), after = effective(overrides, key);
+        if (before != after) {
+            changed.push_back(key);
+            faster = faster || after < before;
+        }
+    }
+    published_overrides = overrides;
+
+    version->epoch = network_epoch.fetch_add(1, std::memory_order_acq_rel) + 1;
+    if (reload || faster) {
+        // Any route may now be beaten by a shorter one.
+        route_cache.advance_epoch(version->epoch);
+        tree_cache.advance_epoch(version->epoch);
+    } else {
+        // Closures and slowdowns only invalidate the results that use a changed connection.
+        route_cache.advance_epoch(version->epoch, [&changed](uint64_t, const std::shared_ptr<const CachedRoute>& route) {
+            for (size_t i = 0; i + 1 < route->path.size(); ++i) {
+                if (std::binary_search(changed.begin(), changed.end(), uint64_t(route->path[i]) << 32 | route->path[i + 1])) {
+                    return false;
+                }
+            }
+            return true;
+        });
+        tree_cache.advance_epoch(version->epoch, [&changed](uint32_t, const std::shared_ptr<const ShortestPathTree>& tree) {
+            for (uint64_t key : changed) {
+                if (tree->parent[static_cast<uint32_t>(key)] == static_cast<uint32_t>(key >> 32)) {
+                    return false;
+                }
+            }
+            return true;
+        });
+    }
+
+    std::atomic_store(&current_network, std::shared_ptr<const NetworkVersion>(version));
+    for (const auto& listener : network_listeners) {
+        listener(version->epoch);
+    }
+}
+
+/**
+ * Applies a batch of disruptions and publishes the resulting network version.
+ * @param changes The changes, applied in order.
+ * @throws std::runtime_error if a station or connection is unknown; nothing is applied then.
+ */
+void MetroNetworkParser::apply_disruptions(const std::vector<Disruption>& changes) {
+    std::lock_guard<std::mutex> lock(update_mutex);
+    std::set<uint32_t> stations_after = closed_stations;
+    std::map<uint64_t, uint32_t> overrides_after = connection_overrides;
+    for (const Disruption& change : changes) {
+        uint32_t from = graph->index_of(change.from);
+        if (from == Graph::npos) {
+            throw std::runtime_error("Station not found in connections: " + std::to_string(change.from) + " (apply_disruptions)");
+        }
+        if (change.kind == Disruption::Kind::CloseStation) {
+            stations_after.insert(from);
+            continue;
+        }
+        if (change.kind == Disruption::Kind::ReopenStation) {
+            stations_after.erase(from);
+            continue;
+        }
+        uint32_t to = graph->index_of(change.to);
+        if (to == Graph::npos || graph->find_edge(from, to) == Graph::npos) {
+            throw std::runtime_error("Connection not found: " + std::to_string(change.from) + " -> " + std::to_string(change.to) + " (apply_disruptions)");
+        }
+        const uint64_t key = uint64_t(from) << 32 | to;
+        if (change.kind == Disruption::Kind::CloseConnection) {
+            overrides_after[key] = Graph::closed;
+        } else if (change.kind == Disruption::Kind::ReopenConnection) {
+            overrides_after.erase(key);
+        } else if (change.duration == Graph::closed) {
+            throw std::runtime_error("Duration out of range (apply_disruptions)");
+        } else {
+            overrides_after[key] = change.duration;
+        }
+    }
+    closed_stations.swap(stations_after);
+    connection_overrides.swap(overrides_after);
+    publish_network(false);
+}
+
+/**
+ * Removes every disruption and publishes the network as loaded.
+ */
+void MetroNetworkParser::clear_disruptions() {
+    std::lock_guard<std::mutex> lock(update_mutex);
+    closed_stations.clear();
+    connection_overrides.clear();
+    publish_network(false);
+}
+
+/**
+ * Writes the stations, the graph, the Contraction Hierarchies index, the distance table and the
+ * hub labels (if built) to a snapshot.
+ * @param filename The path of the snapshot to write.
+ */
+void MetroNetworkParser::save_snapshot(const std::string& filename) const {
+    SnapshotWriter writer;
+    stations.save(writer);
+    graph->save(writer);
+    if (contraction_hierarchy) {
+        contraction_hierarchy->save(writer);
+    }
+    if (distance_table) {
+        distance_table->save(writer);
+    }
+    if (hub_labels) {
+        hub_labels->save(writer);
+    }
+    writer.write(filename);
+}
+
+/**
+ * Loads the network from a snapshot. The graph, hierarchy, table and label arrays stay in the mapping; the
+ * station table is copied out as a few flat arrays. Every part is read and checked against the graph
+ * before any of them replaces the loaded network, so a rejected snapshot leaves the parser as it was.
+ * @param filename The path of the snapshot to load.
+ */
+void MetroNetworkParser::load_snapshot(const std::string& filename) {
+    Snapshot snapshot(filename);
+
+    StationTable loaded_stations(snapshot);
+    auto loaded_graph = std::make_shared<const Graph>(snapshot);
+    std::shared_ptr<const travel::ContractionHierarchy> loaded_hierarchy;
+    if (snapshot.has(SnapshotSection::HierarchyRank)) {
+        loaded_hierarchy = std::make_shared<const travel::ContractionHierarchy>(snapshot);
+        if (loaded_hierarchy->node_count() != loaded_graph->node_count()) {
+            throw std::runtime_error("Contraction hierarchy does not match the graph in snapshot: " + filename + " (load_snapshot)");
+        }
+    }
+    std::shared_ptr<const DistanceTable> loaded_table;
+    if (snapshot.has(SnapshotSection::DistanceTableDurations)) {
+        loaded_table = std::make_shared<const DistanceTable>(snapshot);
+        if (loaded_table->node_count() != loaded_graph->node_count()) {
+            throw std::runtime_error("Distance table does not match the graph in snapshot: " + filename + " (load_snapshot)");
+        }
+    }
+    std::shared_ptr<const travel::HubLabels> loaded_labels;
+    if (snapshot.has(SnapshotSection::HubLabelOutOffsets)) {
+        loaded_labels = std::make_shared<const travel::HubLabels>(snapshot);
+        if (loaded_labels->node_count() != loaded_graph->node_count()) {
+            throw std::runtime_error("Hub labels do not match the graph in snapshot: " + filename + " (load_snapshot)");
+        }
+    }
+
+    stations = std::move(loaded_stations);
+    {
+        std::lock_guard<std::mutex> lock(stations_mutex);
+        stations_hashmap.clear();
+        stations_loaded = false;
+    }
+    connections_hashmap.clear();
+    graph = std::move(loaded_graph);
+    contraction_hierarchy = std::move(loaded_hierarchy);
+    landmarks.reset();
+    distance_table = std::move(loaded_table);
+    hub_labels = std::move(loaded_labels);
+    timetable.reset();
+    connections_loaded = false;
+    finalize_network();
+}
+
+/**
+ * Rebuilds connections_hashmap from the graph, once, when the network came from a snapshot.
+ */
+void MetroNetworkParser::materialize_connections() const {
+    std::lock_guard<std::mutex> lock(connections_mutex);
+    if (connections_loaded) {
+        return;
+    }
+    for (uint32_t u = 0; u < graph->node_count(); ++u) {
+        if (graph->edges_begin(u) == graph->edges_end(u)) {
+            continue;
+        }
+        auto& row = connections_hashmap[graph->id_of(u)];
+        for (uint32_t e = graph->edges_begin(u); e < graph->edges_end(u); ++e) {
+            row[graph->id_of(graph->target(e))] = graph->weight(e);
+        }
+    }
+    connections_loaded = true;
 }
 
 /**
- * Reads station data from a file and populates the stations_hashmap.
+ * Fills stations_hashmap from the station table, once, for callers of get_stations_hashmap().
+ */
+void MetroNetworkParser::materialize_stations() const {
+    std::lock_guard<std::mutex> lock(stations_mutex);
+    if (stations_loaded) {
+        return;
+    }
+    stations_hashmap.clear();
+    stations_hashmap.reserve(stations.size());
+    for (uint32_t row = 0; row < stations.size(); ++row) {
+        StationView view = stations.view(row);
+        Station& station = stations_hashmap[view.id];
+        station.name.assign(view.name);
+        station.line_id.assign(view.line_id);
+        station.address.assign(view.address);
+        station.line_name.assign(view.line_name);
+    }
+    stations_loaded = true;
+}
+
+/**
+ * Reads station data from a file and populates the station table.
+ * Malformed rows are reported on std::cerr with their line number and skipped.
  * @param filename The name of the file to read the station data from.
  */
 void MetroNetworkParser::read_stations(const std::string& filename) {
- std::ifstream file(filename);
-    if (!file.is_open()) {
-        std::cerr << "Error opening file: " << filename << std::endl;
+    PhaseProbe probe(Metrics::Phase::ReadStations);
+    MappedFile file;
+    std::string open_error;
+    if (!file.open(filename, &open_error)) {
+        std::cerr << open_error << std::endl;
         return;
     }
-    std::string line;
-    std::getline(file, line); // Skip the header
-    while (std::getline(file, line)) {
-        std::istringstream iss(line);
-        Station station;
-        std::string id_str;
-        std::getline(iss, station.name, ',');
-        std::getline(iss, id_str, ',');
-        std::getline(iss, station.line_id, ',');
-        std::getline(iss, station.address, ',');
-        std::getline(iss, station.line_name, ',');
-
-        try {
-            uint64_t id = std::stoull(id_str);
-            stations_hashmap[id] = station;
-            name_to_id_map[station.name + "|" + station.line_id] = id;
-            // std::cout << "Loaded station: " << station.name << " ID: " << id << std::endl;
-        } catch (const std::exception& e) {
-            std::cerr << "Error parsing line: " << line << " - Exception: " << e.what() << std::endl;
-        }
-    }
-    file.close();
-    
+    CsvReader reader(std::string_view(file.data(), file.size()));
+    std::vector<std::string_view> fields;
+    CsvError error;
+    bool header = true;
+    CsvReader::Status status;
+    while ((status = reader.next(fields, error)) != CsvReader::Status::End) {
+        if (status == CsvReader::Status::Record) {
+            uint64_t id = 0;
+            if (header) {
+                header = false; // Skip the header
+                continue;
+            } else if (fields.size() < 5) {
+                error = CsvError{reader.line(), "expected 5 fields, got " + std::to_string(fields.size())};
+            } else if (!CsvReader::parse_unsigned(fields[1], id)) {
+                error = CsvError{reader.line(), "invalid station ID '" + std::string(fields[1]) + "'"};
+            } else {
+                stations.add(id, fields[0], fields[2], fields[3], fields[4]);
+                probe.add_row();
+                continue;
+            }
+        }
+        report_load_error(filename, error);
+    }
+    stations.seal();
+    std::lock_guard<std::mutex> lock(stations_mutex);
+    stations_loaded = false;
 }
 
 /**
  * Reads connection data from a file and populates the connections_hashmap.
+ * Malformed rows are reported on std::cerr with their line number and skipped.
  * @param filename The name of the file to read the connection data from.
  */
 void MetroNetworkParser::read_connections(const std::string& filename) {
-    std::ifstream file(filename);
-    if (!file.is_open()) {
-        std::cerr << "Error opening file: " << filename << std::endl;
+    PhaseProbe probe(Metrics::Phase::ReadConnections);
+    MappedFile file;
+    std::string open_error;
+    if (!file.open(filename, &open_error)) {
+        std::cerr << open_error << std::endl;
         return;
     }
-    std::string line;
-    std::getline(file, line); // Skip the header
-    while (std::getline(file, line)) {
-        std::istringstream iss(line);
-        std::string start_id_str, end_id_str, duration_str;
-        std::getline(iss, start_id_str, ',');
-        std::getline(iss, end_id_str, ',');
-        std::getline(iss, duration_str, ',');
-
-        try {
-            uint64_t start_id = std::stoull(start_id_str);
-            uint64_t end_id = std::stoull(end_id_str);
-            uint64_t duration = std::stoull(duration_str);
-
-            connections_hashmap[start_id][end_id] = duration;
-
-            // Debug output
-            // std::cout << "Connection from " << start_id << " to " << end_id << " with duration " << duration << " loaded." << std::endl;
-        } catch (const std::exception& e) {
-            std::cerr << "Error parsing line: " << line << " - Exception: " << e.what() << std::endl;
+    CsvReader reader(std::string_view(file.data(), file.size()));
+    std::vector<std::string_view> fields;
+    CsvError error;
+    bool header = true;
+    CsvReader::Status status;
+    while ((status = reader.next(fields, error)) != CsvReader::Status::End) {
+        if (status == CsvReader::Status::Record) {
+            uint64_t start_id = 0;
+            uint64_t end_id = 0;
+            uint64_t duration = 0;
+            if (header) {
+                header = false; // Skip the header
+                continue;
+            } else if (fields.size() < 3) {
+                error = CsvError{reader.line(), "expected 3 fields, got " + std::to_string(fields.size())};
+            } else if (!CsvReader::parse_unsigned(fields[0], start_id) || !CsvReader::parse_unsigned(fields[1], end_id)) {
+                error = CsvError{reader.line(), "invalid station ID"};
+            } else if (!CsvReader::parse_unsigned(fields[2], duration)) {
+                error = CsvError{reader.line(), "invalid duration '" + std::string(fields[2]) + "'"};
+            } else if (duration >= Graph::closed) {
+                error = CsvError{reader.line(), "duration " + std::to_string(duration) + " is too large"};
+            } else {
+                connections_hashmap[start_id][end_id] = duration;
+                probe.add_row();
+                continue;
+            }
         }
-
+        report_load_error(filename, error);
     }
-    file.close();
+}
 
-    // Print the entire connections hashmap for verification
-    // for (const auto& conn : connections_hashmap) {
-    //     // std::cout << "Station " << conn.first << " connects to: ";
-    //     for (const auto& dest : conn.second) {
-    //         // std::cout << dest.first << " (duration " << dest.second << "), ";
-    //     }
-    //     std::cout << std::endl;
-    // }
+/**
+ * Records a malformed CSV row and prints it on std::cerr.
+ * @param filename The file the row belongs to.
+ * @param error The line and reason.
+ */
+void MetroNetworkParser::report_load_error(const std::string& filename, const CsvError& error) {
+    std::cerr << "Error parsing " << filename << " line " << error.line << ": " << error.message << std::endl;
+    load_errors.push_back(error);
 }
 
 /**
@@ -119,18 +495,9 @@ void MetroNetworkParser::read_connections(const std::string& filename) {
  * @return A vector of ID pairs representing the shortest path between the two stations.
  */
 std::vector<std::pair<uint64_t, uint64_t>> MetroNetworkParser::compute_travel(uint64_t start, uint64_t end) {
-   Station startStation = get_station_by_id(start);
-    // std::cout << "Start station inside compute_travel: " << startStation.name << std::endl;
     try
     {
-        navigation->computeShortestPath(startStation.name, startStation.line_id);
-        auto path_ids = navigation->getShortestPath(end); // ensure this returns a vector of IDs
-
-        std::vector<std::pair<uint64_t, uint64_t>> paths;
-        for (size_t i = 0; i < path_ids.size()  ; i++) {
-            paths.emplace_back(path_ids[i], path_ids[i + 1]);
-        }
-        return paths;
+        return plan_journey(start, end).segments;
     }
     catch(const std::exception& e)
     {   
@@ -140,6 +507,378 @@ std::vector<std::pair<uint64_t, uint64_t>> MetroNetworkParser::compute_travel(ui
     
 }
 
+/**
+ * Computes the shortest path between two station IDs together with its total duration.
+ * The search state lives in a thread_local QueryContext, so concurrent calls never share scratch buffers.
+ * Routes already asked for in the current epoch come from the route cache; origins that keep missing
+ * it get their whole shortest path tree computed once and cached, and answer every destination.
+ * @param start The ID of the starting station.
+ * @param end The ID of the destination station.
+ * @return The route segments and the total duration.
+ * @throws std::runtime_error if either station is not part of the network.
+ */
+Journey MetroNetworkParser::plan_journey(uint64_t start, uint64_t end) const {
+    // Pin the current version: results computed on it carry its epoch, and the caches refuse them
+    // once a newer version has been published.
+    const std::shared_ptr<const NetworkVersion> network = get_network();
+    QueryContext& context = thread_context();
+    QueryProbe probe(context);
+    const uint32_t from = to_graph_index(start), to = to_graph_index(end);
+    std::shared_ptr<const CachedRoute> cached;
+    uint64_t duration = QueryContext::infinity;
+    const ArrayRef<uint32_t> path = find_route(context, *network, from, to, cached, duration);
+
+    Journey journey;
+    journey.duration = duration;
+    journey.segments.reserve(path.empty() ? 0 : path.size() - 1);
+    for (size_t i = 0; i + 1 < path.size(); i++) {
+        journey.segments.emplace_back(network->graph->id_of(path[i]), network->graph->id_of(path[i + 1]));
+    }
+    probe.set_path_length(journey.segments.size());
+    return journey;
+}
+
+/**
+ * Computes the shortest path between two station IDs into storage supplied by the caller.
+ * Same route and caches as plan_journey; the stations are written front to back straight from the
+ * cached route or from the scratch route of the calling thread's QueryContext, so no Journey is built.
+ * Nothing is allocated once the thread has answered a route of this length, except to fill the caches.
+ * @param start The ID of the starting station.
+ * @param end The ID of the destination station.
+ * @param stations Receives the IDs of the stations of the route, start and destination included.
+ * @param capacity The number of IDs that fit in stations.
+ * @return The duration and the number of stations of the route; if that is more than capacity, nothing was written.
+ * @throws std::runtime_error if either station is not part of the network.
+ */
+JourneyResult MetroNetworkParser::plan_journey(uint64_t start, uint64_t end, uint64_t* stations, size_t capacity) const {
+    const std::shared_ptr<const NetworkVersion> network = get_network();
+    QueryContext& context = thread_context();
+    QueryProbe probe(context);
+    const uint32_t from = to_graph_index(start), to = to_graph_index(end);
+    std::shared_ptr<const CachedRoute> cached;
+    JourneyResult result;
+    const ArrayRef<uint32_t> path = find_route(context, *network, from, to, cached, result.duration);
+
+    result.stations = path.size();
+    if (path.size() <= capacity) {
+        for (size_t i = 0; i < path.size(); ++i) {
+            stations[i] = network->graph->id_of(path[i]);
+        }
+    }
+    probe.set_path_length(path.empty() ? 0 : path.size() - 1);
+    return result;
+}
+
+/**
+ * Finds the route between two dense indices: from the route cache, from the cached shortest path tree
+ * of the start, or with the search selected by search_mode. A route not cached yet is cached, and the
+ * whole tree of an origin that keeps missing the cache is computed and cached too, if a tree of the
+ * network fits in a shard of the tree cache.
+ * @param context The scratch state of the calling thread; its path holds a route that was not cached.
+ * @param network The network version to search, pinned by the caller.
+ * @param start The dense index of the starting station.
+ * @param end The dense index of the destination station.
+ * @param cached Receives the cached route the result points into, if any, which keeps it alive.
+ * @param duration Receives the duration in seconds, infinity if unreachable.
+ * @return The dense indices of the stations of the route, empty if unreachable.
+ */
+ArrayRef<uint32_t> MetroNetworkParser::find_route(QueryContext& context, const NetworkVersion& network, uint32_t start, uint32_t end,
+                                                  std::shared_ptr<const CachedRoute>& cached, uint64_t& duration) const {
+    const uint64_t key = uint64_t(start) << 32 | end;
+    if (route_cache.budget() != 0 && route_cache.find(key, cached, network.epoch)) {
+        duration = cached->duration;
+        return ArrayRef<uint32_t>(cached->path);
+    }
+    // A tree larger than a shard's budget would be dropped by insert, so hot origins of large
+    // networks search like any other instead of paying a one-to-all search on every query.
+    std::shared_ptr<const ShortestPathTree> tree;
+    if (ShortestPathTree::memory_usage(network.graph->node_count()) <= tree_cache.max_cost()
+        && !tree_cache.find(start, tree, network.epoch) && tree_cache.frequency(start) >= hot_source_threshold) {
+        context.queue_strategy = queue_strategy;
+        network.navigation->computeShortestPath(context, network.graph->id_of(start));
+        tree = std::make_shared<const ShortestPathTree>(context, network.graph->node_count());
+        tree_cache.insert(start, tree, tree->memory_usage(), network.epoch);
+    }
+    duration = tree ? tree->route_to(end, context.path) : search_route(context, network, start, end, context.path);
+    if (route_cache.budget() != 0) {
+        cached = std::make_shared<const CachedRoute>(CachedRoute{context.path, duration});
+        route_cache.insert(key, cached, cached->memory_usage(), network.epoch);
+    }
+    return ArrayRef<uint32_t>(context.path);
+}
+
+/**
+ * Returns the duration between two station IDs from the distance table, or from plan_journey when
+ * there is no table or the network is disrupted.
+ * @param start The ID of the starting station.
+ * @param end The ID of the destination station.
+ * @return The duration in seconds, max() if unreachable.
+ * @throws std::runtime_error if either station is not part of the network.
+ */
+uint64_t MetroNetworkParser::lookup_duration(uint64_t start, uint64_t end) const {
+    const std::shared_ptr<const NetworkVersion> network = get_network();
+    if ((!network->distance_table && !network->hub_labels) || network->disrupted) {
+        return plan_journey(start, end).duration;
+    }
+    const uint32_t from = to_graph_index(start), to = to_graph_index(end);
+    if (!network->distance_table) {
+        return network->hub_labels->distance(from, to);
+    }
+    const uint32_t duration = network->distance_table->duration(from, to);
+    return duration == DistanceTable::unreachable ? std::numeric_limits<uint64_t>::max() : duration;
+}
+
+/**
+ * Returns the duration between two station IDs, and the route if asked for, from the hub labels
+ * when they are built and no disruption is active.
+ * @param start The ID of the starting station.
+ * @param end The ID of the destination station.
+ * @param path Receives the route segments if not null.
+ * @return The duration in seconds, max() if unreachable.
+ * @throws std::runtime_error if either station is not part of the network.
+ */
+uint64_t MetroNetworkParser::compute_duration(uint64_t start, uint64_t end, std::vector<std::pair<uint64_t, uint64_t>>* path) {
+    const std::shared_ptr<const NetworkVersion> network = get_network();
+    if (!network->hub_labels || network->disrupted) {
+        if (!path) {
+            return lookup_duration(start, end);
+        }
+        Journey journey = plan_journey(start, end);
+        *path = journey.segments;
+        return journey.duration;
+    }
+    const uint32_t from = to_graph_index(start), to = to_graph_index(end);
+    if (path) {
+        std::vector<uint32_t>& route = thread_context().path;
+        network->hub_labels->path(from, to, route);
+        path->clear();
+        for (size_t i = 0; i + 1 < route.size(); ++i) {
+            path->emplace_back(network->graph->id_of(route[i]), network->graph->id_of(route[i + 1]));
+        }
+    }
+    return network->hub_labels->distance(from, to);
+}
+
+/**
+ * Computes the fastest route between two sets of stations with one multi-source search.
+ * @param starts The IDs of the possible starting stations.
+ * @param ends The IDs of the possible destination stations.
+ * @return The route between the closest start and destination.
+ * @throws std::runtime_error if a list is empty or a station is not part of the network.
+ */
+Journey MetroNetworkParser::plan_journey(const std::vector<uint64_t>& starts, const std::vector<uint64_t>& ends) const {
+    if (starts.empty() || ends.empty()) {
+        throw std::runtime_error("No starting or destination station (plan_journey)");
+    }
+    const std::shared_ptr<const NetworkVersion> network = get_network();
+    const Navigation& nav = *network->navigation;
+    QueryContext& context = thread_context();
+    QueryProbe probe(context);
+    context.queue_strategy = queue_strategy;
+    nav.computeShortestPath(context, starts, ends);
+
+    // The destination settled first has the smallest distance; the others are at least as far.
+    uint64_t end = ends.front();
+    for (uint64_t candidate : ends) {
+        if (nav.getShortestDistance(context, candidate) < nav.getShortestDistance(context, end)) {
+            end = candidate;
+        }
+    }
+    Journey journey;
+    journey.duration = nav.getShortestDistance(context, end);
+    nav.writeShortestPath(context, network->graph->index_of(end), context.path);
+    journey.segments.reserve(context.path.empty() ? 0 : context.path.size() - 1);
+    for (size_t i = 0; i + 1 < context.path.size(); i++) {
+        journey.segments.emplace_back(network->graph->id_of(context.path[i]), network->graph->id_of(context.path[i + 1]));
+    }
+    probe.set_path_length(journey.segments.size());
+    return journey;
+}
+
+/**
+ * Computes the Pareto set of (duration, line changes) routes between two sets of stations.
+ * @param starts The IDs of the possible starting stations.
+ * @param ends The IDs of the possible destination stations.
+ * @param max_changes The largest number of changes of a route, at most the number of stations minus one.
+ * @return The routes by increasing number of changes and decreasing duration.
+ * @throws std::runtime_error if a list is empty, a station is not part of the network, or the
+ *                            network is too large to consider that many changes.
+ */
+std::vector<ParetoJourney> MetroNetworkParser::plan_pareto_journeys(const std::vector<uint64_t>& starts, const std::vector<uint64_t>& ends,
+                                                                    uint32_t max_changes) const {
+    if (starts.empty() || ends.empty()) {
+        throw std::runtime_error("No starting or destination station (plan_pareto_journeys)");
+    }
+    const std::shared_ptr<const NetworkVersion> network = get_network();
+    std::vector<ParetoRoute> routes = network->pareto->search(thread_pareto_context(), to_graph_indices(starts), to_graph_indices(ends), max_changes);
+    std::vector<ParetoJourney> journeys(routes.size());
+    for (size_t r = 0; r < routes.size(); ++r) {
+        journeys[r].duration = routes[r].duration;
+        journeys[r].changes = routes[r].changes;
+        for (size_t i = 0; i + 1 < routes[r].path.size(); ++i) {
+            journeys[r].segments.emplace_back(network->graph->id_of(routes[r].path[i]), network->graph->id_of(routes[r].path[i + 1]));
+        }
+    }
+    return journeys;
+}
+
+/**
+ * Computes the fastest route between every platform of one station name and every platform of another.
+ * @param origin The name of the starting station.
+ * @param destination The name of the destination station.
+ * @return The route between the closest platforms.
+ * @throws std::runtime_error if a name is unknown.
+ */
+Journey MetroNetworkParser::plan_stop_area_journey(std::string_view origin, std::string_view destination) const {
+    return plan_journey(get_stop_area(origin), get_stop_area(destination));
+}
+
+/**
+ * Computes the earliest arrival between two station IDs on the timetable, leaving at a given time.
+ * @param start The ID of the starting station.
+ * @param end The ID of the destination station.
+ * @param departure The earliest departure, in seconds after midnight.
+ * @return The route segments with their times, no segments if the destination is unreachable.
+ * @throws std::runtime_error if no timetable is loaded or a station is not part of it.
+ */
+TimedJourney MetroNetworkParser::plan_timed_journey(uint64_t start, uint64_t end, uint32_t departure) const {
+    const std::shared_ptr<const NetworkVersion> network = get_network();
+    if (!network->timetable) {
+        throw std::runtime_error("No timetable loaded (plan_timed_journey)");
+    }
+    return network->timetable->earliest_arrival(start, end, departure);
+}
+
+/**
+ * Computes the earliest arrival between two sets of stations on the timetable with one connection scan.
+ * @param starts The IDs of the possible starting stations.
+ * @param ends The IDs of the possible destination stations.
+ * @param departure The earliest departure, in seconds after midnight.
+ * @return The route to the destination reached first, no segments if none is reachable.
+ * @throws std::runtime_error if no timetable is loaded, a list is empty or a station is not part of it.
+ */
+TimedJourney MetroNetworkParser::plan_timed_journey(const std::vector<uint64_t>& starts, const std::vector<uint64_t>& ends, uint32_t departure) const {
+    const std::shared_ptr<const NetworkVersion> network = get_network();
+    if (!network->timetable) {
+        throw std::runtime_error("No timetable loaded (plan_timed_journey)");
+    }
+    return network->timetable->earliest_arrival(starts, ends, departure);
+}
+
+/**
+ * Computes the useful departures between two station IDs over a time window with one profile scan,
+ * then rebuilds the route of each departure.
+ * @param start The ID of the starting station.
+ * @param end The ID of the destination station.
+ * @param earliest The start of the window, in seconds after midnight.
+ * @param latest The end of the window, included.
+ * @return The journeys by increasing departure, each with its route.
+ * @throws std::runtime_error if no timetable is loaded or a station is not part of it.
+ */
+std::vector<TimedJourney> MetroNetworkParser::plan_departure_window(uint64_t start, uint64_t end, uint32_t earliest, uint32_t latest) const {
+    const std::shared_ptr<const NetworkVersion> network = get_network();
+    if (!network->timetable) {
+        throw std::runtime_error("No timetable loaded (plan_departure_window)");
+    }
+    std::vector<TimedJourney> journeys = network->timetable->profile(start, end, earliest, latest);
+    for (TimedJourney& journey : journeys) {
+        journey = network->timetable->earliest_arrival(start, end, journey.departure);
+    }
+    return journeys;
+}
+
+/**
+ * Returns the earliest arrival time between two station IDs on the timetable, and the route if asked for.
+ * @param start The ID of the starting station.
+ * @param end The ID of the destination station.
+ * @param departure The earliest departure, in seconds after midnight.
+ * @param path Receives the route segments if not null.
+ * @return The arrival time in seconds after midnight, max() if unreachable.
+ * @throws std::runtime_error if no timetable is loaded or a station is not part of it.
+ */
+uint64_t MetroNetworkParser::compute_arrival(uint64_t start, uint64_t end, uint64_t departure, std::vector<std::pair<uint64_t, uint64_t>>* path) {
+    TimedJourney journey = plan_timed_journey(start, end, static_cast<uint32_t>(std::min<uint64_t>(departure, Timetable::unreachable - 1)));
+    if (path) {
+        *path = std::move(journey.segments);
+    }
+    return journey.arrival == Timetable::unreachable ? std::numeric_limits<uint64_t>::max() : journey.arrival;
+}
+
+/**
+ * Runs the search selected by search_mode and writes the route as dense indices.
+ * On a disrupted version, a Contraction Hierarchies, distance table or hub label route is only kept if the
+ * disruptions are closures or slowdowns and it avoids all of them: it then exists unchanged in the
+ * disrupted graph, where nothing can be shorter than on the loaded one. Landmark bounds stay valid
+ * on such a version, so ALT searches it directly. Otherwise the query runs bidirectionally.
+ * @param context The scratch state of the calling thread.
+ * @param network The network version to search.
+ * @param start The dense index of the starting station.
+ * @param end The dense index of the destination station.
+ * @param path Receives the dense indices of the stations of the route, none if unreachable; its capacity is reused.
+ * @return The duration of the route, infinity if unreachable.
+ */
+uint64_t MetroNetworkParser::search_route(QueryContext& context, const NetworkVersion& network, uint32_t start, uint32_t end,
+                                          std::vector<uint32_t>& path) const {
+    context.queue_strategy = queue_strategy;
+    uint64_t duration = QueryContext::infinity;
+    const Navigation& nav = *network.navigation;
+    const uint64_t start_id = network.graph->id_of(start), end_id = network.graph->id_of(end);
+
+    switch (search_mode) {
+    case SearchMode::Full:
+        nav.computeShortestPath(context, start_id);
+        break;
+    case SearchMode::PointToPoint:
+        nav.computeShortestPath(context, start_id, end_id);
+        break;
+    case SearchMode::Bidirectional:
+        nav.computeBidirectionalPath(context, start_id, end_id);
+        break;
+    case SearchMode::ContractionHierarchy:
+        if (!network.disrupted || network.slower_only) {
+            duration = network.contraction_hierarchy->query(context, start, end);
+            network.contraction_hierarchy->unpackPath(context, path);
+            if (!network.disrupted || !crosses_disruption(network, path)) {
+                return duration;
+            }
+        }
+        nav.computeBidirectionalPath(context, start_id, end_id);
+        break;
+    case SearchMode::AllPairs:
+        if (!network.disrupted || network.slower_only) {
+            const uint32_t table_duration = network.distance_table->duration(start, end);
+            duration = table_duration == DistanceTable::unreachable ? QueryContext::infinity : table_duration;
+            network.distance_table->path(start, end, path);
+            if (!network.disrupted || !crosses_disruption(network, path)) {
+                return duration;
+            }
+        }
+        nav.computeBidirectionalPath(context, start_id, end_id);
+        break;
+    case SearchMode::HubLabels:
+        if (!network.disrupted || network.slower_only) {
+            duration = network.hub_labels->distance(start, end);
+            network.hub_labels->path(start, end, path);
+            if (!network.disrupted || !crosses_disruption(network, path)) {
+                return duration;
+            }
+        }
+        nav.computeBidirectionalPath(context, start_id, end_id);
+        break;
+    case SearchMode::Landmarks:
+        if (!network.disrupted || network.slower_only) {
+            duration = network.landmarks->query(context, *network.graph, start, end);
+            nav.writeShortestPath(context, end, path);
+            return duration;
+        }
+        nav.computeBidirectionalPath(context, start_id, end_id);
+        break;
+    }
+
+    nav.writeShortestPath(context, end, path);
+    return nav.getShortestDistance(context, end_id);
+}
+
 /**
  * Computes and displays the shortest path between two station IDs.
  * @param start The ID of the starting station.
@@ -147,16 +886,327 @@ std::vector<std::pair<uint64_t, uint64_t>> MetroNetworkParser::compute_travel(ui
  * @return A vector of ID pairs representing the shortest path between the two stations.
  */
 std::vector<std::pair<uint64_t, uint64_t>> MetroNetworkParser::compute_and_display_travel(uint64_t start, uint64_t end) {
-    auto path = compute_travel(start, end);
-    for (auto& segment : path) {
-        if (segment.first == end) {
-            std::cout << get_station_by_id(segment.first).name << ", Line :  "<< get_station_by_id(segment.first).line_id << std::endl;
-            break;
-        }else{
-            std::cout << get_station_by_id(segment.first).name << ", Line :  "<< get_station_by_id(segment.first).line_id << " -> ";
+    Journey journey;
+    try
+    {
+        journey = plan_journey(start, end);
+    }
+    catch(const std::exception& e)
+    {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return {};
+    }
+    display_journey(journey, start, end);
+    return journey.segments;
+}
+
+/**
+ * Displays a journey as the list of stations it goes through.
+ * @param journey The journey returned by plan_journey.
+ * @param start The ID of the starting station.
+ * @param end The ID of the destination station.
+ */
+void MetroNetworkParser::display_journey(const Journey& journey, uint64_t start, uint64_t end) const {
+    for (auto& segment : journey.segments) {
+        const StationView station = get_station_by_id(segment.first);
+        std::cout << station.name << ", Line :  "<< station.line_id << " -> ";
+    }
+    if (!journey.segments.empty() || start == end) {
+        const StationView station = get_station_by_id(end);
+        std::cout << station.name << ", Line :  "<< station.line_id << std::endl;
+    }
+}
+
+/**
+ * Displays a timed route, one segment per line with its departure and arrival times.
+ * @param journey The journey returned by plan_timed_journey.
+ */
+void MetroNetworkParser::display_timed_journey(const TimedJourney& journey) const {
+    if (journey.arrival == Timetable::unreachable) {
+        std::cout << "No trip reaches the destination after this time." << std::endl;
+        return;
+    }
+    for (size_t i = 0; i < journey.segments.size(); ++i) {
+        const StationView from = get_station_by_id(journey.segments[i].first);
+        const StationView to = get_station_by_id(journey.segments[i].second);
+        std::cout << Timetable::format_time(journey.times[i].first) << " " << from.name << ", Line :  " << from.line_id << " -> "
+                  << Timetable::format_time(journey.times[i].second) << " " << to.name << ", Line :  " << to.line_id << std::endl;
+    }
+    std::cout << "Departure: " << Timetable::format_time(journey.departure) << ", arrival: " << Timetable::format_time(journey.arrival) << std::endl;
+}
+
+/**
+ * Selects the search strategy used by compute_travel, building the index it needs if any.
+ * @param mode The search strategy.
+ */
+void MetroNetworkParser::set_search_mode(SearchMode mode) {
+    if (mode == SearchMode::ContractionHierarchy && !contraction_hierarchy) {
+        build_contraction_hierarchy();
+    }
+    if (mode == SearchMode::AllPairs && !distance_table) {
+        build_distance_table();
+    }
+    if (mode == SearchMode::Landmarks && !landmarks) {
+        build_landmarks();
+    }
+    if (mode == SearchMode::HubLabels && !hub_labels) {
+        build_hub_labels();
+    }
+    search_mode = mode;
+}
+
+/**
+ * Sets the memory budgets of the route and tree caches.
+ * @param route_bytes The budget of the origin-destination cache, 0 to disable it.
+ * @param tree_bytes The budget of the shortest path tree cache, 0 to disable it.
+ */
+void MetroNetworkParser::set_cache_budget(size_t route_bytes, size_t tree_bytes) {
+    route_cache.set_budget(route_bytes);
+    tree_cache.set_budget(tree_bytes);
+}
+
+/**
+ * Returns the counters of the route and tree caches.
+ * @return The statistics of both caches.
+ */
+RouteCacheStats MetroNetworkParser::get_cache_stats() const {
+    RouteCacheStats stats;
+    stats.routes = route_cache.stats();
+    stats.trees = tree_cache.stats();
+    return stats;
+}
+
+/**
+ * Runs the Contraction Hierarchies preprocessing on the loaded graph and publishes it.
+ */
+void MetroNetworkParser::build_contraction_hierarchy() {
+    std::lock_guard<std::mutex> lock(update_mutex);
+    contraction_hierarchy = std::make_shared<const travel::ContractionHierarchy>(*graph);
+    publish_network(false);
+}
+
+/**
+ * Computes the all-pairs distance table of the loaded graph on the thread pool and publishes it.
+ * @param method The algorithm.
+ */
+void MetroNetworkParser::build_distance_table(DistanceTable::Method method) {
+    std::lock_guard<std::mutex> lock(update_mutex);
+    distance_table = std::make_shared<const DistanceTable>(*graph, get_thread_pool(), method);
+    publish_network(false);
+}
+
+/**
+ * Picks the landmarks of the loaded graph, computes their distances and publishes them.
+ * @param count The number of landmarks.
+ */
+void MetroNetworkParser::build_landmarks(uint32_t count) {
+    std::lock_guard<std::mutex> lock(update_mutex);
+    landmarks = std::make_shared<const travel::Landmarks>(*graph, count);
+    publish_network(false);
+}
+
+/**
+ * Computes the hub labels of the loaded graph and publishes them.
+ */
+void MetroNetworkParser::build_hub_labels() {
+    std::lock_guard<std::mutex> lock(update_mutex);
+    hub_labels = std::make_shared<const travel::HubLabels>(*graph);
+    publish_network(false);
+}
+
+/**
+ * Renumbers the loaded graph, rebuilds the indexes that existed on the new numbering and publishes
+ * it as a newly loaded network.
+ * @param order The numbering.
+ * @param stops_filename A GTFS stops file with the coordinates of the stations, read by NodeOrder::Hilbert only.
+ * @throws std::runtime_error if the stops file cannot be read or lacks a required column.
+ */
+void MetroNetworkParser::reorder_nodes(NodeOrder order, const std::string& stops_filename) {
+    std::vector<GeoPoint> coordinates;
+    if (order == NodeOrder::Hilbert) {
+        std::vector<CsvError> errors;
+        coordinates = read_stop_coordinates(stops_filename, *graph, &errors);
+        for (const CsvError& error : errors) {
+            report_load_error(stops_filename, error);
         }
     }
-    return path;}
+    graph = std::make_shared<const Graph>(*graph, compute_node_order(*graph, order, coordinates));
+    if (contraction_hierarchy) {
+        contraction_hierarchy = std::make_shared<const travel::ContractionHierarchy>(*graph);
+    }
+    if (distance_table) {
+        distance_table = std::make_shared<const DistanceTable>(*graph, get_thread_pool(), distance_table->get_method());
+    }
+    if (landmarks) {
+        landmarks = std::make_shared<const travel::Landmarks>(*graph, static_cast<uint32_t>(landmarks->get_landmarks().size()));
+    }
+    if (hub_labels) {
+        hub_labels = std::make_shared<const travel::HubLabels>(*graph);
+    }
+    finalize_network();
+}
+
+/**
+ * Loads the trips of a stop_times file, with the connections between platforms of the same station
+ * name as transfers, and publishes them.
+ * @param stop_times_filename The stop_times CSV file.
+ * @throws std::runtime_error if the file cannot be read or lacks a required column.
+ */
+void MetroNetworkParser::load_timetable(const std::string& stop_times_filename) {
+    std::vector<Timetable::Footpath> footpaths;
+    for (uint32_t u = 0; u < graph->node_count(); ++u) {
+        const uint32_t row = stations.find(graph->id_of(u));
+        for (uint32_t e = graph->edges_begin(u); e < graph->edges_end(u); ++e) {
+            const uint32_t next = stations.find(graph->id_of(graph->target(e)));
+            if (row != StationTable::npos && next != StationTable::npos && stations.name_handle(row) == stations.name_handle(next)) {
+                footpaths.push_back(Timetable::Footpath{graph->id_of(u), graph->id_of(graph->target(e)), graph->weight(e)});
+            }
+        }
+    }
+    std::vector<CsvError> errors;
+    std::shared_ptr<const Timetable> loaded = std::make_shared<const Timetable>(stop_times_filename, footpaths, &errors);
+    for (const CsvError& error : errors) {
+        report_load_error(stop_times_filename, error);
+    }
+    std::lock_guard<std::mutex> lock(update_mutex);
+    timetable = loaded;
+    publish_network(false);
+}
+
+/**
+ * Computes the duration matrix between the given sources and targets on the thread pool.
+ * @param sources The IDs of the origin stations.
+ * @param targets The IDs of the destination stations.
+ * @return The row-major duration matrix.
+ * @throws std::runtime_error if a station is not part of the network.
+ */
+TravelMatrix MetroNetworkParser::compute_matrix(const std::vector<uint64_t>& sources, const std::vector<uint64_t>& targets) {
+    std::vector<uint32_t> source_indices = to_graph_indices(sources);
+    std::vector<uint32_t> target_indices = to_graph_indices(targets);
+
+    TravelMatrix matrix;
+    matrix.sources = sources;
+    matrix.targets = targets;
+    matrix.durations.resize(sources.size() * targets.size());
+    compute_matrix_rows(source_indices, target_indices, 0, sources.size(), matrix.durations.data());
+    return matrix;
+}
+
+/**
+ * Computes the duration matrix block by block and appends each block to a binary file.
+ * @param sources The IDs of the origin stations.
+ * @param targets The IDs of the destination stations.
+ * @param filename The path of the file to write.
+ * @throws std::runtime_error if a station is not part of the network or the file cannot be written.
+ */
+void MetroNetworkParser::compute_matrix_to_file(const std::vector<uint64_t>& sources, const std::vector<uint64_t>& targets, const std::string& filename) {
+    std::vector<uint32_t> source_indices = to_graph_indices(sources);
+    std::vector<uint32_t> target_indices = to_graph_indices(targets);
+
+    std::ofstream file(filename, std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) {
+        throw std::runtime_error("Error opening file: " + filename + " (compute_matrix_to_file)");
+    }
+    const char magic[8] = {'M', 'E', 'T', 'R', 'O', 'M', 'T', 'X'};
+    const uint32_t version = 1, reserved = 0;
+    const uint64_t rows = sources.size(), cols = targets.size();
+    file.write(magic, sizeof(magic));
+    file.write(reinterpret_cast<const char*>(&version), sizeof(version));
+    file.write(reinterpret_cast<const char*>(&reserved), sizeof(reserved));
+    file.write(reinterpret_cast<const char*>(&rows), sizeof(rows));
+    file.write(reinterpret_cast<const char*>(&cols), sizeof(cols));
+    file.write(reinterpret_cast<const char*>(sources.data()), sources.size() * sizeof(uint64_t));
+    file.write(reinterpret_cast<const char*>(targets.data()), targets.size() * sizeof(uint64_t));
+
+    // Bound the buffer to about 64 MiB, but keep at least a few rows per worker to stay parallel.
+    const size_t buffer_bytes = size_t(64) << 20;
+    size_t block_rows = std::max<size_t>(get_thread_pool().size() * 4, buffer_bytes / std::max<size_t>(1, cols * sizeof(uint32_t)));
+    block_rows = std::min<size_t>(std::max<size_t>(block_rows, 1), std::max<size_t>(rows, 1));
+
+    std::vector<uint32_t> block(block_rows * cols);
+    for (size_t first = 0; first < rows; first += block_rows) {
+        size_t count = std::min(block_rows, rows - first);
+        compute_matrix_rows(source_indices, target_indices, first, count, block.data());
+        file.write(reinterpret_cast<const char*>(block.data()), count * cols * sizeof(uint32_t));
+        if (!file) {
+            throw std::runtime_error("Error writing file: " + filename + " (compute_matrix_to_file)");
+        }
+    }
+}
+
+/**
+ * Returns the worker thread pool, starting it on first use.
+ * @return The thread pool shared by batch computations.
+ */
+ThreadPool& MetroNetworkParser::get_thread_pool() const {
+    std::call_once(thread_pool_once, [this] { thread_pool.reset(new ThreadPool(worker_threads)); });
+    return *thread_pool;
+}
+
+/**
+ * Translates station IDs to dense graph indices.
+ * @param ids The station IDs.
+ * @return The dense indices, in the same order.
+ * @throws std::runtime_error if a station is not part of the network.
+ */
+std::vector<uint32_t> MetroNetworkParser::to_graph_indices(const std::vector<uint64_t>& ids) const {
+    std::vector<uint32_t> indices;
+    indices.reserve(ids.size());
+    for (uint64_t id : ids) {
+        indices.push_back(to_graph_index(id));
+    }
+    return indices;
+}
+
+/**
+ * Translates a station ID to its dense graph index.
+ * @param id The station ID.
+ * @return The dense index.
+ * @throws std::runtime_error if the station is not part of the network.
+ */
+uint32_t MetroNetworkParser::to_graph_index(uint64_t id) const {
+    uint32_t index = graph->index_of(id);
+    if (index == Graph::npos) {
+        throw std::runtime_error("Station not found in connections: " + std::to_string(id) + " (to_graph_index)");
+    }
+    return index;
+}
+
+/**
+ * Computes a block of consecutive matrix rows, one one-to-all search per row on the thread pool.
+ * Each worker searches with its own thread_local QueryContext and writes only its own rows.
+ * Rows are copied from the distance table instead when it is built and no disruption is active.
+ * @param sources The dense indices of the origin stations.
+ * @param targets The dense indices of the destination stations.
+ * @param first_row The first row of the block.
+ * @param row_count The number of rows in the block.
+ * @param out The buffer receiving row_count * targets.size() durations.
+ */
+void MetroNetworkParser::compute_matrix_rows(const std::vector<uint32_t>& sources, const std::vector<uint32_t>& targets, size_t first_row, size_t row_count, uint32_t* out) const {
+    const std::shared_ptr<const NetworkVersion> network = get_network();
+    if (network->distance_table && !network->disrupted) {
+        const DistanceTable& table = *network->distance_table;
+        for (size_t i = 0; i < row_count; ++i) {
+            const uint32_t source = sources[first_row + i];
+            uint32_t* row = out + i * targets.size();
+            for (size_t c = 0; c < targets.size(); ++c) {
+                row[c] = table.duration(source, targets[c]); // DistanceTable::unreachable == TravelMatrix::unreachable
+            }
+        }
+        return;
+    }
+    const Navigation& nav = *network->navigation;
+    get_thread_pool().parallel_for(row_count, [&](size_t i) {
+        QueryContext& context = thread_context();
+        context.queue_strategy = queue_strategy;
+        nav.computeShortestPath(context, network->graph->id_of(sources[first_row + i]));
+        uint32_t* row = out + i * targets.size();
+        for (size_t c = 0; c < targets.size(); ++c) {
+            uint64_t d = context.distance(targets[c]);
+            row[c] = d < TravelMatrix::unreachable ? static_cast<uint32_t>(d) : uint32_t(TravelMatrix::unreachable);
+        }
+    }, 1);
+}
 
 /**
  * Returns the station ID given a station name and line.
@@ -165,40 +1215,52 @@ std::vector<std::pair<uint64_t, uint64_t>> MetroNetworkParser::compute_and_displ
  * @return The ID of the station.
  * @throws std::runtime_error if the station ID is not found.
  */
-uint64_t MetroNetworkParser::get_station_id_by_name_and_line(const std::string& name, const std::string& line) const {
-    std::string key = name + "|" + line;
-    auto it = name_to_id_map.find(key);
-    if (it != name_to_id_map.end()) {
-        // std::cout << "Station ID found: " << it->second << std::endl;
-        return it->second;
+uint64_t MetroNetworkParser::get_station_id_by_name_and_line(std::string_view name, std::string_view line) const {
+    uint64_t id;
+    if (stations.find_id(name, line, id)) {
+        return id;
     }
     throw std::runtime_error("Station ID not found (get_station_id_by_name_and_line)");
 }
 
+/**
+ * Returns the IDs of every platform sharing a station name.
+ * @param name The name of the station.
+ * @return The IDs of the platforms.
+ * @throws std::runtime_error if the name is unknown.
+ */
+std::vector<uint64_t> MetroNetworkParser::get_stop_area(std::string_view name) const {
+    ArrayRef<uint64_t> platforms = station_index ? station_index->find(name) : ArrayRef<uint64_t>();
+    if (platforms.empty()) {
+        throw std::runtime_error("Stop area not found: " + std::string(name) + " (get_stop_area)");
+    }
+    return std::vector<uint64_t>(platforms.begin(), platforms.end());
+}
+
 /**
  * Returns the station name given an ID.
  * @param id The ID of the station.
- * @return The name of the station.
+ * @return A view of the name of the station.
  * @throws std::runtime_error if the station name is not found.
  */
-std::string MetroNetworkParser::get_station_name_by_id(uint64_t id) const {
-    auto it = stations_hashmap.find(id);
-    if (it != stations_hashmap.end()) {
-        return it->second.name;
+std::string_view MetroNetworkParser::get_station_name_by_id(uint64_t id) const {
+    uint32_t row = stations.find(id);
+    if (row != StationTable::npos) {
+        return stations.view(row).name;
     }
     throw std::runtime_error("Station name not found (get_station_name_by_id)");
 }
 
 /**
- * Returns a Station object given an ID.
+ * Returns a view of a station given an ID.
  * @param id The ID of the station.
- * @return The Station object.
+ * @return A view of the station.
  * @throws std::runtime_error if the station ID is not found.
  */
-Station MetroNetworkParser::get_station_by_id(uint64_t id) const {
-    auto it = stations_hashmap.find(id);
-    if (it != stations_hashmap.end()) {
-        return it->second;
+StationView MetroNetworkParser::get_station_by_id(uint64_t id) const {
+    uint32_t row = stations.find(id);
+    if (row != StationTable::npos) {
+        return stations.view(row);
     }
     throw std::runtime_error("Station ID not found (get_station_by_id)");
 }
@@ -207,9 +1269,9 @@ Station MetroNetworkParser::get_station_by_id(uint64_t id) const {
  * Prints all stations stored in the parser.
  */
 void MetroNetworkParser::print_all_stations() const {
-    for (const auto& pair : stations_hashmap) {
-        const Station& station = pair.second;
-        std::cout << "Station ID: " << pair.first
+    for (uint32_t row = 0; row < stations.size(); ++row) {
+        StationView station = stations.view(row);
+        std::cout << "Station ID: " << station.id
                   << ", Name: " << station.name
                   << ", Line ID: " << station.line_id
                   << ", Address: " << station.address
@@ -224,17 +1286,34 @@ void MetroNetworkParser::print_all_stations() const {
  */
 std::vector<std::pair<std::string, std::string>> MetroNetworkParser::searchStations(const std::string &input) const {
     std::vector<std::pair<std::string, std::string>> matches;
-    std::string lowerInput = input;
-    std::transform(lowerInput.begin(), lowerInput.end(), lowerInput.begin(), ::tolower); // Convert input to lowercase
-
-    for (const auto &pair : stations_hashmap) {
-        std::string lowerName = pair.second.name;
-        std::transform(lowerName.begin(), lowerName.end(), lowerName.begin(), ::tolower); // Convert station name to lowercase
-
-        if (lowerName.find(lowerInput) != std::string::npos) {
-            matches.emplace_back(pair.second.name, pair.second.line_id); // Add matching station name and line
+    for (const StationMatch& match : search_stations(input)) {
+        size_t first = matches.size();
+        for (uint64_t id : match.station_ids) {
+            std::string_view line = get_station_by_id(id).line_id;
+            // Both directions of a line are separate platforms; list the line once
+            bool listed = false;
+            for (size_t i = first; i < matches.size(); ++i) {
+                listed = listed || matches[i].second == line;
+            }
+            if (!listed) {
+                matches.emplace_back(match.name, line);
+            }
         }
     }
-    return matches;}
+    return matches;
+}
+
+/**
+ * Autocompletes a station name, tolerating case, accents and typos.
+ * @param query The text typed so far.
+ * @param limit The maximum number of names to return.
+ * @return The best matching names, best first.
+ */
+std::vector<StationMatch> MetroNetworkParser::search_stations(std::string_view query, size_t limit) const {
+    if (!station_index) {
+        return std::vector<StationMatch>();
+    }
+    return station_index->search(query, limit);
+}
 
 } // namespace travel
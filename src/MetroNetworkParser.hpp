@@ -4,7 +4,25 @@
 #define METRO_NETWORK_PARSER_HPP
 
 #include "Generic_mapper.hpp"
+#include "Graph.hpp"
+#include "CsvReader.hpp"
+#include "StationTable.hpp"
+#include "StationIndex.hpp"
+#include "PriorityQueues.hpp"
+#include "RouteCache.hpp"
+#include "DistanceTable.hpp"
+#include "Landmarks.hpp"
+#include "HubLabels.hpp"
+#include "Timetable.hpp"
+#include "ParetoSearch.hpp"
+#include "NodeOrder.hpp"
 #include <string>
+#include <memory>
+#include <map>
+#include <set>
+#include <mutex>
+#include <atomic>
+#include <functional>
 #include <unordered_map>
 #include <iostream>
 #include <fstream>
@@ -14,12 +32,106 @@
 
 namespace travel {
     class Navigation;  // Forward declaration
+    class ThreadPool;  // Forward declaration
+    class ContractionHierarchy;  // Forward declaration
+
+    /**
+     * @brief The search strategy used by compute_travel.
+     */
+    enum class SearchMode {
+        Full,           /**< Settle the whole network, then read the destination. */
+        PointToPoint,   /**< Stop as soon as the destination is settled. */
+        Bidirectional,  /**< Search from both ends on the forward and reverse adjacency until they meet. */
+        ContractionHierarchy,  /**< Upward bidirectional search on the Contraction Hierarchies index. */
+        AllPairs,       /**< Read the precomputed all-pairs distance table, no search at all. */
+        Landmarks,      /**< A* search guided by landmark lower bounds (ALT). */
+        HubLabels       /**< Merge of the hub labels of both stations, route rebuilt from the labels. */
+    };
+
+    /**
+     * @brief The result of a single journey query.
+     */
+    struct Journey {
+        std::vector<std::pair<uint64_t, uint64_t>> segments;  /**< The (station, station) segments of the route, in travel order. */
+        uint64_t duration = std::numeric_limits<uint64_t>::max();  /**< The total duration in seconds, max() if unreachable. */
+    };
+
+    /**
+     * @brief The result of a journey query whose stations are written into storage of the caller.
+     */
+    struct JourneyResult {
+        uint64_t duration = std::numeric_limits<uint64_t>::max();  /**< The total duration in seconds, max() if unreachable. */
+        size_t stations = 0;  /**< The number of stations of the route, start and destination included; 0 if unreachable. */
+    };
+
+    /**
+     * @brief One route of a multi-criteria query.
+     */
+    struct ParetoJourney {
+        std::vector<std::pair<uint64_t, uint64_t>> segments;  /**< The (station, station) segments of the route, in travel order. */
+        uint64_t duration = 0;  /**< The total duration in seconds. */
+        uint32_t changes = 0;  /**< The number of line changes. */
+    };
+
+    /**
+     * @brief One change of a live disruption update.
+     */
+    struct Disruption {
+        /**
+         * @brief What the change does.
+         */
+        enum class Kind {
+            CloseStation,      /**< Removes every connection from and to the station. */
+            ReopenStation,     /**< Undoes CloseStation. */
+            CloseConnection,   /**< Removes the connection from `from` to `to`. */
+            ReopenConnection,  /**< Restores the connection from `from` to `to` with its loaded duration. */
+            SetDuration        /**< Overrides the duration of the connection from `from` to `to`. */
+        };
+
+        Kind kind = Kind::CloseStation;  /**< What the change does. */
+        uint64_t from = 0;  /**< The station, or the first station of the connection. */
+        uint64_t to = 0;  /**< The second station of the connection, unused for stations. */
+        uint32_t duration = 0;  /**< The new duration in seconds, for SetDuration only. */
+    };
+
+    /**
+     * @brief One published version of the network: the loaded graph with the active disruptions applied.
+     *
+     * Versions are immutable. A query pins the current version for its whole run, so publishing a
+     * new one never waits for queries in flight and a query never sees half an update.
+     */
+    struct NetworkVersion {
+        std::shared_ptr<const Graph> graph;  /**< The graph searched, with the same dense indices as base. */
+        std::shared_ptr<const Navigation> navigation;  /**< Dijkstra searches on graph. */
+        std::shared_ptr<const ParetoSearch> pareto;  /**< Duration and line change searches on graph. */
+        std::shared_ptr<const Graph> base;  /**< The graph as loaded, without disruptions. */
+        std::shared_ptr<const ContractionHierarchy> contraction_hierarchy;  /**< Built on base, if built at all. */
+        std::shared_ptr<const DistanceTable> distance_table;  /**< Built on base, if built at all. */
+        std::shared_ptr<const travel::Landmarks> landmarks;  /**< Built on base, if built at all. */
+        std::shared_ptr<const travel::HubLabels> hub_labels;  /**< Built on base, if built at all. */
+        std::shared_ptr<const Timetable> timetable;  /**< Loaded on base, if loaded at all; disruptions do not apply to it. */
+        bool disrupted = false;  /**< Whether any disruption is active. */
+        bool slower_only = true;  /**< Whether the active disruptions only close connections or lengthen them. */
+        uint64_t epoch = 0;  /**< The cache epoch of the version. */
+    };
     
     /**
      * @brief The MetroNetworkParser class is responsible for parsing and managing the metro network data.
      * 
      * It inherits from the Generic_mapper class and provides methods for reading station and connection data,
      * computing and displaying travel routes, searching for stations, and accessing station information.
+     * 
+     * Once initializeData() has returned the network is immutable: compute_travel, plan_journey and the
+     * lookup methods may be called from any number of threads at the same time, each thread searching
+     * with its own QueryContext.
+     * 
+     * plan_journey answers repeated origin-destination pairs from a sharded LRU cache, and serves
+     * origins that keep missing it from a cache of whole shortest path trees. Each network loaded by
+     * initializeData or load_snapshot starts a new epoch, which empties both caches.
+     * 
+     * Disruptions (closed stations or connections, changed durations) are applied while serving with
+     * apply_disruptions: each update publishes a new NetworkVersion, RCU-style, without blocking the
+     * queries still running on the previous one.
      */
     class MetroNetworkParser : public Generic_mapper {
        
@@ -29,6 +141,22 @@ namespace travel {
          */
         MetroNetworkParser();
 
+        /**
+         * @brief Constructs a MetroNetworkParser object from a binary snapshot instead of the CSV files.
+         * 
+         * @param snapshot_filename The path of a snapshot written by save_snapshot.
+         * @throws std::runtime_error if the snapshot is missing, corrupted or of another version.
+         */
+        explicit MetroNetworkParser(const std::string& snapshot_filename);
+
+        /**
+         * @brief Constructs a MetroNetworkParser object from the given CSV files.
+         * 
+         * @param stations_filename The path of the stations CSV file.
+         * @param connections_filename The path of the connections CSV file.
+         */
+        MetroNetworkParser(const std::string& stations_filename, const std::string& connections_filename);
+
         /**
          * @brief Destroys the MetroNetworkParser object.
          */
@@ -39,6 +167,66 @@ namespace travel {
          */
         void initializeData();
 
+        /**
+         * @brief Initializes the metro network from the given CSV files.
+         * 
+         * @param stations_filename The path of the stations CSV file.
+         * @param connections_filename The path of the connections CSV file.
+         */
+        void initializeData(const std::string& stations_filename, const std::string& connections_filename);
+
+        /**
+         * @brief Writes the loaded network to a binary snapshot.
+         * 
+         * The snapshot holds the station table and its string pool, the CSR graph and, if built,
+         * the Contraction Hierarchies index, the distance table and the hub labels, so that
+         * load_snapshot can start without parsing or precomputing anything.
+         * 
+         * @param filename The path of the snapshot to write.
+         * @throws std::runtime_error if the file cannot be written.
+         */
+        void save_snapshot(const std::string& filename) const;
+
+        /**
+         * @brief Loads the network from a binary snapshot.
+         * 
+         * The graph, the Contraction Hierarchies index, the distance table and the hub labels are used
+         * in place from the memory mapping.
+         * connections_hashmap is only rebuilt if get_connections_hashmap() is called.
+         * 
+         * @param filename The path of the snapshot to load.
+         * @throws std::runtime_error if the snapshot is missing, corrupted or of another version, or if one
+         * of its indexes does not match its graph; the loaded network is then left unchanged.
+         */
+        void load_snapshot(const std::string& filename);
+
+        /**
+         * @brief Closes or reopens stations and connections, or changes durations, while serving queries.
+         * 
+         * The changes are an overlay on the loaded network, which stays untouched: the searched graph
+         * is rebuilt from it in linear time and published atomically, and queries already running
+         * finish on the version they started with. Cached journeys and trees that use none of the
+         * changed connections survive an update that only closes or slows connections. Contraction
+         * Hierarchies queries keep using the index built on the loaded network when their route
+         * avoids the changes, and fall back to a bidirectional search otherwise. Thread-safe.
+         * 
+         * @param changes The changes, applied in order and published together.
+         * @throws std::runtime_error if a station or connection is not part of the network; nothing is applied then.
+         */
+        void apply_disruptions(const std::vector<Disruption>& changes);
+
+        /**
+         * @brief Removes every disruption, restoring the network as loaded. Thread-safe.
+         */
+        void clear_disruptions();
+
+        /**
+         * @brief Retrieves the current version of the network.
+         * 
+         * @return The version searched by queries starting now, valid as long as it is held.
+         */
+        std::shared_ptr<const NetworkVersion> get_network() const { return std::atomic_load(&current_network); }
+
         /**
          * @brief Computes the travel route between two stations.
          * 
@@ -48,6 +236,213 @@ namespace travel {
          */
         std::vector<std::pair<uint64_t, uint64_t>> compute_travel(uint64_t _start, uint64_t _end) override;
 
+        /**
+         * @brief Computes the travel route and its total duration between two stations.
+         * 
+         * Thread-safe: the search runs on a QueryContext owned by the calling thread.
+         * 
+         * @param _start The ID of the starting station.
+         * @param _end The ID of the destination station.
+         * @return The route segments and the total duration, no segments if the destination is unreachable.
+         * @throws std::runtime_error if either station is not part of the network.
+         */
+        Journey plan_journey(uint64_t _start, uint64_t _end) const;
+
+        /**
+         * @brief Computes the travel route between two stations into storage supplied by the caller.
+         * 
+         * The same route as plan_journey, from the same caches, written front to back as station IDs.
+         * Once the calling thread has answered a route of this length, nothing is allocated besides
+         * the copy kept by the route cache, none with the cache disabled. Thread-safe.
+         * 
+         * @param _start The ID of the starting station.
+         * @param _end The ID of the destination station.
+         * @param stations Receives the IDs of the stations of the route, start and destination included.
+         * @param capacity The number of IDs that fit in stations.
+         * @return The duration and the number of stations; if there are more stations than capacity, none was written.
+         * @throws std::runtime_error if either station is not part of the network.
+         */
+        JourneyResult plan_journey(uint64_t _start, uint64_t _end, uint64_t* stations, size_t capacity) const;
+
+        /**
+         * @brief Retrieves the duration of the fastest route between two stations, without the route.
+         * 
+         * A single load from the distance table when it is built and no disruption is active, a
+         * merge of the hub labels when only those are built, plan_journey otherwise. Thread-safe.
+         * 
+         * @param _start The ID of the starting station.
+         * @param _end The ID of the destination station.
+         * @return The duration in seconds, max() if the destination is unreachable.
+         * @throws std::runtime_error if either station is not part of the network.
+         */
+        uint64_t lookup_duration(uint64_t _start, uint64_t _end) const;
+
+        /**
+         * @brief Computes the duration between two stations, and the route only if asked for.
+         * 
+         * Answered from the hub labels when they are built and no disruption is active, the route
+         * included; otherwise like lookup_duration, or plan_journey when the route is wanted.
+         * Thread-safe.
+         * 
+         * @param _start The ID of the starting station.
+         * @param _end The ID of the destination station.
+         * @param _path Receives the route segments if not null, none if the destination is unreachable.
+         * @return The duration in seconds, max() if the destination is unreachable.
+         * @throws std::runtime_error if either station is not part of the network.
+         */
+        uint64_t compute_duration(uint64_t _start, uint64_t _end, std::vector<std::pair<uint64_t, uint64_t>>* _path = nullptr) override;
+
+        /**
+         * @brief Computes the fastest route from any of several stations to any of several others.
+         * 
+         * One multi-source search seeded with every start, stopped at the first destination settled.
+         * Thread-safe; not cached.
+         * 
+         * @param starts The IDs of the possible starting stations.
+         * @param ends The IDs of the possible destination stations.
+         * @return The route from the start to the destination that are closest to each other.
+         * @throws std::runtime_error if a list is empty or a station is not part of the network.
+         */
+        Journey plan_journey(const std::vector<uint64_t>& starts, const std::vector<uint64_t>& ends) const;
+
+        /**
+         * @brief Computes the fastest route for each number of line changes.
+         * 
+         * One multi-criteria search from every start: a route is kept only if every route with
+         * fewer changes is slower, so the result trades minutes against changes. A change is any
+         * connection between platforms of different lines. Thread-safe; not cached.
+         * 
+         * @param starts The IDs of the possible starting stations.
+         * @param ends The IDs of the possible destination stations.
+         * @param max_changes The largest number of changes of a route, at most the number of stations minus one.
+         * @return The routes by increasing number of changes and decreasing duration, empty if unreachable.
+         * @throws std::runtime_error if a list is empty, a station is not part of the network, or the
+         *                            network is too large to consider that many changes.
+         */
+        std::vector<ParetoJourney> plan_pareto_journeys(const std::vector<uint64_t>& starts, const std::vector<uint64_t>& ends,
+                                                        uint32_t max_changes = ParetoSearch::default_max_changes) const;
+
+        /**
+         * @brief Computes the fastest route between two stop areas, whatever the lines.
+         * 
+         * A stop area is every platform of a station name, e.g. all the lines at Châtelet.
+         * 
+         * @param origin The name of the starting station, in any case and with or without accents.
+         * @param destination The name of the destination station.
+         * @return The route between the closest platforms of the two areas.
+         * @throws std::runtime_error if a name is unknown.
+         */
+        Journey plan_stop_area_journey(std::string_view origin, std::string_view destination) const;
+
+        /**
+         * @brief Computes the earliest arrival between two stations on the timetable, leaving at a given time.
+         * 
+         * Connection scan over the trips of load_timetable; transfers between the platforms of a
+         * station take the durations of the loaded network. Disruptions do not apply. Thread-safe.
+         * 
+         * @param _start The ID of the starting station.
+         * @param _end The ID of the destination station.
+         * @param departure The earliest departure, in seconds after midnight.
+         * @return The route segments with their times, no segments if the destination is unreachable.
+         * @throws std::runtime_error if no timetable is loaded or a station is not part of it.
+         */
+        TimedJourney plan_timed_journey(uint64_t _start, uint64_t _end, uint32_t departure) const;
+
+        /**
+         * @brief Computes the earliest arrival from any of several stations to any of several others, leaving at a given time.
+         * 
+         * One connection scan seeded with every start at the departure time, stopped at the first
+         * destination reached. Thread-safe.
+         * 
+         * @param starts The IDs of the possible starting stations.
+         * @param ends The IDs of the possible destination stations.
+         * @param departure The earliest departure, in seconds after midnight.
+         * @return The route to the destination reached first, no segments if none is reachable.
+         * @throws std::runtime_error if no timetable is loaded, a list is empty or a station is not part of it.
+         */
+        TimedJourney plan_timed_journey(const std::vector<uint64_t>& starts, const std::vector<uint64_t>& ends, uint32_t departure) const;
+
+        /**
+         * @brief Computes every useful departure between two stations over a time window.
+         * 
+         * One backward connection scan gives the departures of the window that no later departure
+         * beats; the route of each is then rebuilt by a forward scan. Thread-safe.
+         * 
+         * @param _start The ID of the starting station.
+         * @param _end The ID of the destination station.
+         * @param earliest The start of the window, in seconds after midnight.
+         * @param latest The end of the window, included.
+         * @return The journeys by increasing departure, each with its route.
+         * @throws std::runtime_error if no timetable is loaded or a station is not part of it.
+         */
+        std::vector<TimedJourney> plan_departure_window(uint64_t _start, uint64_t _end, uint32_t earliest, uint32_t latest) const;
+
+        /**
+         * @brief Computes the earliest arrival time on the timetable, and the route only if asked for.
+         * 
+         * @param _start The ID of the starting station.
+         * @param _end The ID of the destination station.
+         * @param _departure The earliest departure, in seconds after midnight.
+         * @param _path Receives the route segments if not null, none if the destination is unreachable.
+         * @return The arrival time in seconds after midnight, max() if the destination is unreachable.
+         * @throws std::runtime_error if no timetable is loaded or a station is not part of it.
+         */
+        uint64_t compute_arrival(uint64_t _start, uint64_t _end, uint64_t _departure, std::vector<std::pair<uint64_t, uint64_t>>* _path = nullptr) override;
+
+        /**
+         * @brief Displays a travel route, one station per hop.
+         * 
+         * @param journey The journey returned by plan_journey.
+         * @param _start The ID of the starting station.
+         * @param _end The ID of the destination station.
+         */
+        void display_journey(const Journey& journey, uint64_t _start, uint64_t _end) const;
+
+        /**
+         * @brief Displays a timed route, one segment per line with its departure and arrival times.
+         * 
+         * @param journey The journey returned by plan_timed_journey.
+         */
+        void display_timed_journey(const TimedJourney& journey) const;
+
+        /**
+         * @brief Computes the travel durations from every source to every target.
+         * 
+         * Runs one one-to-all search per source on the worker thread pool and writes each row
+         * straight into a preallocated row-major matrix. Nothing is printed.
+         * 
+         * @param sources The IDs of the origin stations, one row each.
+         * @param targets The IDs of the destination stations, one column each.
+         * @return The matrix of durations in seconds, TravelMatrix::unreachable where there is no route.
+         * @throws std::runtime_error if a station is not part of the network.
+         */
+        TravelMatrix compute_matrix(const std::vector<uint64_t>& sources, const std::vector<uint64_t>& targets) override;
+
+        /**
+         * @brief Computes the travel duration matrix and streams it to a binary file.
+         * 
+         * Rows are computed in blocks that fit in a bounded buffer and appended in source order,
+         * so the matrix never has to fit in memory. The file layout is, in native byte order:
+         * the 8-byte magic "METROMTX", uint32 version (1), uint32 reserved, uint64 row count,
+         * uint64 column count, the uint64 source IDs, the uint64 target IDs, then the uint32
+         * durations row by row.
+         * 
+         * @param sources The IDs of the origin stations, one row each.
+         * @param targets The IDs of the destination stations, one column each.
+         * @param filename The path of the file to write.
+         * @throws std::runtime_error if a station is not part of the network or the file cannot be written.
+         */
+        void compute_matrix_to_file(const std::vector<uint64_t>& sources, const std::vector<uint64_t>& targets, const std::string& filename) override;
+
+        /**
+         * @brief Sets the number of worker threads used by batch computations.
+         * 
+         * Only effective before the first batch computation starts the pool.
+         * 
+         * @param threads The number of workers, 0 for one per hardware thread.
+         */
+        void set_worker_threads(size_t threads) { worker_threads = threads; }
+
         /**
          * @brief Computes and displays the travel route between two stations.
          * 
@@ -77,24 +472,43 @@ namespace travel {
          * @param name The name of the station.
          * @param line The line the station belongs to.
          * @return The ID of the station.
+         * @throws std::runtime_error if no station has this name on this line.
+         */
+        uint64_t get_station_id_by_name_and_line(std::string_view name, std::string_view line) const;
+
+        /**
+         * @brief Retrieves every platform of a stop area: the stations sharing a name, on any line.
+         * 
+         * @param name The name of the station, in any case and with or without accents.
+         * @return The IDs of the platforms, one per line and direction.
+         * @throws std::runtime_error if no station has this name.
          */
-        uint64_t get_station_id_by_name_and_line(const std::string& name, const std::string& line) const;
+        std::vector<uint64_t> get_stop_area(std::string_view name) const;
 
         /**
          * @brief Retrieves the name of a station based on its ID.
          * 
          * @param id The ID of the station.
-         * @return The name of the station.
+         * @return A view of the name, valid as long as the network is loaded.
+         * @throws std::runtime_error if the station is unknown.
          */
-        std::string get_station_name_by_id(uint64_t id) const;
+        std::string_view get_station_name_by_id(uint64_t id) const;
 
         /**
-         * @brief Retrieves the station object based on its ID.
+         * @brief Retrieves a station based on its ID.
          * 
          * @param id The ID of the station.
-         * @return The station object.
+         * @return A view of the station, valid as long as the network is loaded.
+         * @throws std::runtime_error if the station is unknown.
+         */
+        StationView get_station_by_id(uint64_t id) const;
+
+        /**
+         * @brief Retrieves the station catalogue.
+         * 
+         * @return The table of every station, sorted by ID.
          */
-        Station get_station_by_id(uint64_t id) const;
+        const StationTable& get_station_table() const { return stations; }
 
         /**
          * @brief Prints the information of all stations.
@@ -104,22 +518,318 @@ namespace travel {
         /**
          * @brief Searches for stations based on a given input.
          * 
+         * Runs search_stations and lists every line of the matching stations.
+         * 
          * @param input The input to search for.
          * @return A vector of pairs representing the search results, where each pair contains the name of a station and the line it belongs to.
          */
         std::vector<std::pair<std::string, std::string>> searchStations(const std::string &input) const;
 
+        /**
+         * @brief Autocompletes a station name, tolerating case, accents and typos.
+         * 
+         * Thread-safe. Each name is returned once with the IDs of all its platforms.
+         * 
+         * @param query The text typed so far.
+         * @param limit The maximum number of names to return.
+         * @return The best matching names, best first.
+         */
+        std::vector<StationMatch> search_stations(std::string_view query, size_t limit = 10) const;
+
         /**
          * @brief Retrieves the navigation object.
          * 
-         * @return A pointer to the navigation object.
+         * @return A shared pointer to the navigation object, which can be queried concurrently.
+         */
+        std::shared_ptr<const Navigation> getNavigation() const { return navigation; }
+
+        /**
+         * @brief Retrieves the CSR graph built from the connections.
+         * 
+         * @return A reference to the immutable graph used by the navigation.
+         */
+        const Graph& get_graph() const { return *graph; }
+
+        /**
+         * @brief Selects the search strategy used by compute_travel.
+         * 
+         * Selecting SearchMode::ContractionHierarchy, SearchMode::AllPairs, SearchMode::Landmarks or
+         * SearchMode::HubLabels builds the structure it reads first if it does not exist yet.
+         * Not thread-safe: configure the parser before serving queries.
+         * 
+         * @param mode The search strategy.
+         */
+        void set_search_mode(SearchMode mode);
+
+        /**
+         * @brief Runs the Contraction Hierarchies preprocessing on the loaded network.
+         * 
+         * Orders and contracts every station of the graph built from connections_hashmap. Queries in
+         * SearchMode::ContractionHierarchy then return the same durations as Dijkstra.
+         */
+        void build_contraction_hierarchy();
+
+        /**
+         * @brief Precomputes the durations and next hops between every pair of stations.
+         * 
+         * Runs on the worker thread pool. The table takes 6 bytes per pair and is stored in
+         * snapshots, so compile it once with tools/compile_snapshot rather than at every start.
+         * 
+         * @param method The algorithm, Floyd-Warshall for small networks by default.
+         * @throws std::runtime_error if the network has more than DistanceTable::max_nodes stations.
+         */
+        void build_distance_table(DistanceTable::Method method = DistanceTable::Method::Auto);
+
+        /**
+         * @brief Picks landmarks on the loaded network and precomputes their distances for ALT queries.
+         * 
+         * Two one-to-all searches per landmark, plus one per landmark to pick them. Landmark queries
+         * stay exact while disruptions only close connections or slow them down, and fall back to a
+         * bidirectional search otherwise.
+         * 
+         * @param count The number of landmarks; more landmarks give tighter bounds and larger labels.
+         */
+        void build_landmarks(uint32_t count = travel::Landmarks::default_count);
+
+        /**
+         * @brief Computes the hub labels of the loaded network by pruned landmark labeling.
+         * 
+         * Distance queries then merge two short sorted arrays instead of searching. The labels are
+         * stored in snapshots, so compile them once with tools/compile_snapshot.
+         */
+        void build_hub_labels();
+
+        /**
+         * @brief Renumbers the stations of the loaded network so that connected stations sit close in memory.
+         * 
+         * Station IDs are unchanged: they are translated to the new dense indices at the boundary, like
+         * before. The Contraction Hierarchies index, the distance table, the landmarks and the hub labels
+         * are built again on the new numbering if they existed, with the same distance table method and number
+         * of landmarks, and the numbering is kept by save_snapshot.
+         * Like loading a network, this drops the disruptions and empties the journey caches.
+         * Not thread-safe: renumber before serving queries.
+         * 
+         * @param order The numbering.
+         * @param stops_filename A GTFS stops file with the coordinates of the stations, read by NodeOrder::Hilbert only.
+         * @throws std::runtime_error if the stops file cannot be read or lacks a required column.
+         */
+        void reorder_nodes(NodeOrder order, const std::string& stops_filename = "");
+
+        /**
+         * @brief Loads the trips of a GTFS stop_times file for the timed queries.
+         * 
+         * Stop IDs are station IDs of the loaded network; the connections between platforms of the
+         * same station name become the transfers. Malformed rows are reported like CSV load errors
+         * and skipped. Loading another network drops the timetable.
+         * 
+         * @param stop_times_filename The stop_times CSV file.
+         * @throws std::runtime_error if the file cannot be read or lacks a required column.
+         */
+        void load_timetable(const std::string& stop_times_filename);
+
+        /**
+         * @brief Retrieves the search strategy used by compute_travel.
+         * 
+         * @return The search strategy.
+         */
+        SearchMode get_search_mode() const { return search_mode; }
+
+        /**
+         * @brief Selects the priority queue of the Dijkstra searches (all modes but ContractionHierarchy).
+         * 
+         * Not thread-safe: configure the parser before serving queries.
+         * 
+         * @param strategy The priority queue.
+         */
+        void set_queue_strategy(QueueStrategy strategy) { queue_strategy = strategy; }
+
+        /**
+         * @brief Retrieves the priority queue of the Dijkstra searches.
+         * 
+         * @return The priority queue.
+         */
+        QueueStrategy get_queue_strategy() const { return queue_strategy; }
+
+        /**
+         * @brief Sets the memory budgets of the journey caches, evicting entries if needed.
+         * 
+         * Safe to call while queries run: each shard is resized under its lock.
+         * 
+         * @param route_bytes The budget of the origin-destination cache, 0 to disable it.
+         * @param tree_bytes The budget of the shortest path tree cache, 0 to disable it. Each of its 16 shards
+         *                   holds a sixteenth, and trees are only built when one fits: about 12 bytes per station.
+         */
+        void set_cache_budget(size_t route_bytes, size_t tree_bytes);
+
+        /**
+         * @brief Sets how many recent cache misses from an origin make it worth a whole shortest path tree.
+         * 
+         * Not thread-safe: configure the parser before serving queries.
+         * 
+         * @param misses The number of recent misses, at least 1.
+         */
+        void set_hot_source_threshold(uint32_t misses) { hot_source_threshold = std::max<uint32_t>(misses, 1); }
+
+        /**
+         * @brief Retrieves the counters of the journey caches.
+         * 
+         * @return The hits, misses, evictions and memory of both caches.
+         */
+        RouteCacheStats get_cache_stats() const;
+
+        /**
+         * @brief Retrieves the epoch of the current network version.
+         * 
+         * @return A counter incremented every time a network is loaded or disrupted.
+         */
+        uint64_t get_network_epoch() const { return network_epoch.load(std::memory_order_acquire); }
+
+        /**
+         * @brief Registers a function called with the new epoch every time a network is loaded or disrupted.
+         * 
+         * Lets results derived from the network elsewhere be dropped with the journey caches.
+         * Not thread-safe: register listeners before serving queries.
+         * 
+         * @param listener The function to call, on the thread loading the network.
+         */
+        void on_network_change(std::function<void(uint64_t)> listener) { network_listeners.push_back(std::move(listener)); }
+
+        /**
+         * @brief Retrieves the malformed CSV rows skipped while loading.
+         * 
+         * @return The line number and reason of each skipped row, in reading order.
+         */
+        const std::vector<CsvError>& get_load_errors() const { return load_errors; }
+
+        std::shared_ptr<const Graph> graph;  // CSR graph built from connections_hashmap once all data is loaded, without disruptions
+        std::shared_ptr<const Navigation> navigation;  // Shared, stateless Navigation on graph
+        std::shared_ptr<const std::vector<uint32_t>> node_lines;  // Interned line of each dense index of graph
+        std::shared_ptr<const ParetoSearch> pareto;  // Shared, stateless ParetoSearch on graph
+        std::shared_ptr<const StationIndex> station_index;  // Autocomplete index over the station names
+        std::shared_ptr<const travel::ContractionHierarchy> contraction_hierarchy;  // Built on demand by build_contraction_hierarchy
+        std::shared_ptr<const DistanceTable> distance_table;  // Built on demand by build_distance_table
+        std::shared_ptr<const travel::Landmarks> landmarks;  // Built on demand by build_landmarks
+        std::shared_ptr<const travel::HubLabels> hub_labels;  // Built on demand by build_hub_labels
+        std::shared_ptr<const Timetable> timetable;  // Loaded on demand by load_timetable
+        SearchMode search_mode = SearchMode::PointToPoint;  // Strategy used by compute_travel
+        QueueStrategy queue_strategy = QueueStrategy::RadixHeap;  // Priority queue of the Dijkstra searches
+
+    protected:
+        /**
+         * @brief Rebuilds connections_hashmap from the graph when the network came from a snapshot.
+         */
+        void materialize_connections() const override;
+
+        /**
+         * @brief Fills stations_hashmap from the station table on first use.
+         */
+        void materialize_stations() const override;
+
+    private:
+        /**
+         * @brief Creates the navigation object and the station index once the graph and stations are in place.
+         */
+        void finalize_network();
+
+        /**
+         * @brief Builds and publishes a new network version from the loaded network and the disruptions.
+         * 
+         * Must be called with update_mutex held.
+         * 
+         * @param reload Whether the loaded network itself changed, which empties the caches.
+         */
+        void publish_network(bool reload);
+
+        /**
+         * @brief Finds the route between two dense indices in the caches, or searches and caches it.
+         * 
+         * @param context The scratch state of the calling thread; its path holds a route that was not cached.
+         * @param network The network version to search, pinned by the caller.
+         * @param start The dense index of the starting station.
+         * @param end The dense index of the destination station.
+         * @param cached Receives the cached route the result points into, if any, which keeps it alive.
+         * @param duration Receives the duration in seconds, infinity if unreachable.
+         * @return The dense indices of the stations of the route, empty if unreachable.
+         */
+        ArrayRef<uint32_t> find_route(QueryContext& context, const NetworkVersion& network, uint32_t start, uint32_t end,
+                                      std::shared_ptr<const CachedRoute>& cached, uint64_t& duration) const;
+
+        /**
+         * @brief Runs the search selected by search_mode between two dense indices.
+         * 
+         * @param context The scratch state of the calling thread.
+         * @param network The network version to search.
+         * @param start The dense index of the starting station.
+         * @param end The dense index of the destination station.
+         * @param path Receives the dense indices of the stations of the route, none if unreachable; its capacity is reused.
+         * @return The duration of the route, infinity if unreachable.
+         */
+        uint64_t search_route(QueryContext& context, const NetworkVersion& network, uint32_t start, uint32_t end,
+                              std::vector<uint32_t>& path) const;
+
+        /**
+         * @brief Records a malformed CSV row and prints it on std::cerr.
+         * 
+         * @param filename The file the row belongs to.
+         * @param error The line and reason.
+         */
+        void report_load_error(const std::string& filename, const CsvError& error);
+
+        /**
+         * @brief Retrieves the worker thread pool, starting it on first use.
+         * 
+         * @return The thread pool shared by batch computations.
+         */
+        ThreadPool& get_thread_pool() const;
+
+        /**
+         * @brief Translates station IDs to dense graph indices.
+         * 
+         * @param ids The station IDs.
+         * @return The dense indices, in the same order.
+         * @throws std::runtime_error if a station is not part of the network.
+         */
+        std::vector<uint32_t> to_graph_indices(const std::vector<uint64_t>& ids) const;
+
+        /**
+         * @brief Translates a station ID to its dense graph index.
+         * 
+         * @param id The station ID.
+         * @return The dense index.
+         * @throws std::runtime_error if the station is not part of the network.
+         */
+        uint32_t to_graph_index(uint64_t id) const;
+
+        /**
+         * @brief Computes a block of consecutive matrix rows in parallel.
+         * 
+         * @param sources The dense indices of the origin stations.
+         * @param targets The dense indices of the destination stations.
+         * @param first_row The first row of the block.
+         * @param row_count The number of rows in the block.
+         * @param out The buffer receiving row_count * targets.size() durations.
          */
-        Navigation* getNavigation() const { return navigation; }
+        void compute_matrix_rows(const std::vector<uint32_t>& sources, const std::vector<uint32_t>& targets, size_t first_row, size_t row_count, uint32_t* out) const;
 
-        std::unordered_map<uint64_t, Station> stations_hashmap;  // Hashmap to store station information
-        std::unordered_map<std::string, uint64_t> name_to_id_map;  // Hashmap to map station names to IDs
-        std::unordered_map<uint64_t, std::unordered_map<uint64_t, uint64_t>> connections_hashmap;  // Hashmap to store connection information
-        Navigation* navigation;  // Pointer to Navigation
+        StationTable stations;  // Station catalogue with interned strings
+        mutable bool stations_loaded = false;  // Whether stations_hashmap mirrors the station table
+        mutable std::mutex stations_mutex;  // Guards the lazy fill of stations_hashmap
+        std::vector<CsvError> load_errors;  // Rows skipped by read_stations and read_connections
+        size_t worker_threads = 0;  // Requested size of the thread pool, 0 for hardware concurrency
+        mutable std::unique_ptr<ThreadPool> thread_pool;  // Started lazily by the first batch computation
+        mutable std::once_flag thread_pool_once;  // Guards the lazy start of thread_pool
+        mutable bool connections_loaded = false;  // False when the graph came from a snapshot and connections_hashmap is still empty
+        mutable std::mutex connections_mutex;  // Guards the lazy rebuild of connections_hashmap
+        std::atomic<uint64_t> network_epoch{0};  // Incremented by publish_network for every network version
+        std::vector<std::function<void(uint64_t)>> network_listeners;  // Called by publish_network with the new epoch
+        std::shared_ptr<const NetworkVersion> current_network;  // Read and replaced with std::atomic_load / std::atomic_store only
+        std::mutex update_mutex;  // Serializes the writers of current_network and of the disruption state below
+        std::set<uint32_t> closed_stations;  // Dense indices of the closed stations
+        std::map<uint64_t, uint32_t> connection_overrides;  // (from << 32 | to) dense indices -> duration, or Graph::closed
+        std::map<uint64_t, uint32_t> published_overrides;  // Every overridden connection of current_network, closed stations included
+        mutable RouteCache route_cache{size_t(16) << 20};  // Routes by (start, end), 16 MiB by default
+        mutable TreeCache tree_cache{size_t(32) << 20};  // Shortest path trees of hot origins, 32 MiB by default
+        uint32_t hot_source_threshold = 4;  // Recent misses from an origin before its whole tree is cached
 
     };
 
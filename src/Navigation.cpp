@@ -1,117 +1,385 @@
 #include "Navigation.hpp"
-#include "MetroNetworkParser.hpp"
 
 namespace travel {
 
+namespace {
+
 /**
- * @brief Constructs a Navigation object.
- * 
- * @param parser The MetroNetworkParser object used for parsing the metro network.
+ * @brief Walks the path of the last search to a node in travel order, without building it backwards.
+ *
+ * The parents lead from the end back to the start, so the nodes are counted first and then stored
+ * straight at their position. After a bidirectional search, the path to its target is the forward
+ * tree up to the meeting node followed by the backward tree.
+ *
+ * @param context The scratch state of the last search.
+ * @param end The dense index of the end node.
+ * @param resize Called once with the number of nodes on the path, 0 if the node is unreachable.
+ * @param store Called with (position, dense index) for each node on the path.
  */
-Navigation::Navigation(MetroNetworkParser& parser)
-: connections_hashmap(parser.connections_hashmap), metroNetworkParser(parser) {
-    std::cout << "Navigation constructor called" << std::endl;
-    uint64_t max_node_id = 0;
-    for (const auto &entry : connections_hashmap) {
-        max_node_id = std::max(max_node_id, entry.first);
-        for (const auto &neighbor : entry.second) {
-            max_node_id = std::max(max_node_id, neighbor.first);
-        }
+template <typename Resize, typename Store>
+void walkPath(const QueryContext& context, uint32_t end, Resize resize, Store store) {
+    const bool bidirectional = end == context.target;
+    uint32_t last = bidirectional ? context.meeting : end;
+    if (!bidirectional && context.distance(end) == QueryContext::infinity) {
+        last = QueryContext::none;
+    }
+    size_t forward = 0, backward = 0;
+    for (uint32_t at = last; at != QueryContext::none; at = context.previous(at)) {
+        ++forward;
+    }
+    for (uint32_t at = bidirectional && forward ? context.next(last) : QueryContext::none; at != QueryContext::none; at = context.next(at)) {
+        ++backward;
+    }
+    resize(forward + backward);
+    size_t position = forward;
+    for (uint32_t at = last; at != QueryContext::none; at = context.previous(at)) {
+        store(--position, at);
     }
-    distance.resize(max_node_id + 1, std::numeric_limits<uint64_t>::max());
-    previous.resize(max_node_id + 1, std::numeric_limits<uint64_t>::max());
+    position = forward;
+    for (uint32_t at = bidirectional && forward ? context.next(last) : QueryContext::none; at != QueryContext::none; at = context.next(at)) {
+        store(position++, at);
+    }
+}
+
+} // namespace
+
+/**
+ * @brief Constructs a Navigation object.
+ *
+ * @param graph The CSR graph of the metro network.
+ */
+Navigation::Navigation(std::shared_ptr<const Graph> graph)
+: graph(std::move(graph)) {
 }
 
 /**
  * @brief Computes the shortest path from a given start station to all other stations in the metro network.
- * 
- * @param startName The name of the start station.
- * @param startLine The line of the start station.
+ *
+ * @param context The scratch state of the calling thread.
+ * @param startId The ID of the start station.
+ * @throws std::runtime_error if the station is not part of the network.
  */
-void Navigation::computeShortestPath(const std::string& startName, const std::string& startLine) 
+void Navigation::computeShortestPath(QueryContext& context, uint64_t startId) const
 {
-    std::fill(distance.begin(), distance.end(), std::numeric_limits<uint64_t>::max());
-    std::fill(previous.begin(), previous.end(), std::numeric_limits<uint64_t>::max());
-    while (!pq.empty())
-        pq.pop(); // Clear the priority queue
-    uint64_t startId = metroNetworkParser.get_station_id_by_name_and_line(startName, startLine);
+    uint32_t start = resetSearch(context, startId);
+    searchForward(context, ArrayRef<uint32_t>(&start, 1), ArrayRef<uint32_t>());
+}
 
-    distance[startId] = 0;
-    pq.push(std::make_pair(0, startId));
+/**
+ * @brief Computes the shortest path between two stations, stopping as soon as the destination is settled.
+ *
+ * Once a node is settled its distance and predecessor never change again, so stopping there
+ * yields exactly the path a full search would.
+ *
+ * @param context The scratch state of the calling thread.
+ * @param startId The ID of the start station.
+ * @param endId The ID of the end station.
+ * @throws std::runtime_error if either station is not part of the network.
+ */
+void Navigation::computeShortestPath(QueryContext& context, uint64_t startId, uint64_t endId) const
+{
+    uint32_t end = graph->index_of(endId);
+    if (end == Graph::npos) {
+        throw std::runtime_error("Station not found in connections (computeShortestPath)");
+    }
+    uint32_t start = resetSearch(context, startId);
+    searchForward(context, ArrayRef<uint32_t>(&start, 1), ArrayRef<uint32_t>(&end, 1));
+}
 
-    while (!pq.empty())
+/**
+ * @brief Computes the shortest path from any of several stations to the closest of several others.
+ *
+ * A multi-source search: the starts all enter the queue at distance 0, so every station ends up
+ * labelled with its distance from the closest start, and the first destination settled is the
+ * closest one overall.
+ *
+ * @param context The scratch state of the calling thread.
+ * @param startIds The IDs of the start stations.
+ * @param endIds The IDs of the end stations.
+ * @throws std::runtime_error if a station is not part of the network.
+ */
+void Navigation::computeShortestPath(QueryContext& context, const std::vector<uint64_t>& startIds, const std::vector<uint64_t>& endIds) const
+{
+    std::vector<uint32_t> starts, ends;
+    for (uint64_t endId : endIds) {
+        uint32_t end = graph->index_of(endId);
+        if (end == Graph::npos) {
+            throw std::runtime_error("Station not found in connections (computeShortestPath)");
+        }
+        ends.push_back(end);
+    }
+    for (uint64_t startId : startIds) {
+        uint32_t start = graph->index_of(startId);
+        if (start == Graph::npos) {
+            throw std::runtime_error("Station not found in connections (computeShortestPath)");
+        }
+        starts.push_back(start);
+    }
+    context.prepare(graph->node_count());
+    for (uint32_t start : starts) {
+        context.setForward(start, 0, QueryContext::none);
+    }
+    searchForward(context, starts, ends);
+}
+
+/**
+ * @brief Computes the shortest path between two stations with a bidirectional search.
+ *
+ * @param context The scratch state of the calling thread.
+ * @param startId The ID of the start station.
+ * @param endId The ID of the end station.
+ * @throws std::runtime_error if either station is not part of the network.
+ */
+void Navigation::computeBidirectionalPath(QueryContext& context, uint64_t startId, uint64_t endId) const
+{
+    uint32_t end = graph->index_of(endId);
+    if (end == Graph::npos) {
+        throw std::runtime_error("Station not found in connections (computeBidirectionalPath)");
+    }
+    uint32_t start = resetSearch(context, startId);
+    switch (context.queue_strategy) {
+    case QueueStrategy::RadixHeap:
+        runBidirectional(context, context.radixQueue, context.radixQueueBackward, start, end);
+        break;
+    case QueueStrategy::IndexedDaryHeap:
+        runBidirectional(context, context.daryQueue, context.daryQueueBackward, start, end);
+        break;
+    default:
+        runBidirectional(context, context.queue, context.queueBackward, start, end);
+        break;
+    }
+}
+
+/**
+ * @brief Runs the two searches of a bidirectional query on a given kind of priority queue.
+ *
+ * Both searches advance one node at a time, the one with the smaller queue head first. Each
+ * relaxed edge that reaches a node labelled by the other search is a candidate path; the search
+ * stops once the two queue heads together cannot beat the best candidate.
+ *
+ * @param context The scratch state of the calling thread, prepared by resetSearch.
+ * @param pq The queue of the forward search.
+ * @param pqBackward The queue of the backward search.
+ * @param start The dense index of the start station.
+ * @param end The dense index of the end station.
+ */
+template <typename Queue>
+void Navigation::runBidirectional(QueryContext& context, Queue& pq, Queue& pqBackward, uint32_t start, uint32_t end) const
+{
+    const uint64_t infinity = QueryContext::infinity;
+    pq.push(0, start);
+    context.target = end;
+    context.setBackward(end, 0, QueryContext::none);
+    pqBackward.push(0, end);
+    if (start == end) {
+        context.meeting = start;
+        context.bestDistance = 0;
+        return;
+    }
+    while (!pq.empty() && !pqBackward.empty())
     {
-        uint64_t u = pq.top().second;
-        pq.pop();
+        if (context.bestDistance != infinity && pq.top().first + pqBackward.top().first >= context.bestDistance)
+            break;
 
-        if (connections_hashmap.find(u) != connections_hashmap.end()) {
-            for (const auto &pair : connections_hashmap.at(u))
+        if (pq.top().first <= pqBackward.top().first)
+        {
+            uint64_t d = pq.top().first;
+            uint32_t u = pq.top().second;
+            pq.pop();
+            if (d > context.distance(u))
             {
-                uint64_t v = pair.first;
-                uint64_t w = pair.second;
+                TRAVEL_COUNT(context.counters.stale);
+                continue; // Stale entry
+            }
+            ++context.settled;
 
-                if (distance[v] > distance[u] + w)
+            for (uint32_t e = graph->edges_begin(u); e < graph->edges_end(u); ++e)
+            {
+                TRAVEL_COUNT(context.counters.relaxed);
+                uint32_t v = graph->target(e);
+                uint64_t candidate = d + graph->weight(e);
+                if (context.distance(v) > candidate)
                 {
-                    distance[v] = distance[u] + w;
-                    previous[v] = u;
-                    pq.push(std::make_pair(distance[v], v));
+                    context.setForward(v, candidate, u);
+                    pq.push(candidate, v);
+                    TRAVEL_COUNT(context.counters.pushes);
+                }
+                uint64_t remaining = context.distanceBackward(v);
+                if (remaining != infinity && candidate + remaining < context.bestDistance)
+                {
+                    context.bestDistance = candidate + remaining;
+                    context.meeting = v;
                 }
             }
         }
-        else{
-            std::cerr << "Error: Node not found in connections." << std::endl;
+        else
+        {
+            uint64_t d = pqBackward.top().first;
+            uint32_t v = pqBackward.top().second;
+            pqBackward.pop();
+            if (d > context.distanceBackward(v))
+            {
+                TRAVEL_COUNT(context.counters.stale);
+                continue; // Stale entry
+            }
+            ++context.settled;
+
+            for (uint32_t e = graph->reverse_edges_begin(v); e < graph->reverse_edges_end(v); ++e)
+            {
+                TRAVEL_COUNT(context.counters.relaxed);
+                uint32_t u = graph->reverse_source(e);
+                uint64_t candidate = d + graph->reverse_weight(e);
+                if (context.distanceBackward(u) > candidate)
+                {
+                    context.setBackward(u, candidate, v);
+                    pqBackward.push(candidate, u);
+                    TRAVEL_COUNT(context.counters.pushes);
+                }
+                uint64_t reached = context.distance(u);
+                if (reached != infinity && candidate + reached < context.bestDistance)
+                {
+                    context.bestDistance = candidate + reached;
+                    context.meeting = u;
+                }
+            }
         }
     }
 }
 
 /**
- * @brief Prints the shortest path from a given end station to the start station.
- * 
- * @param endName The name of the end station.
- * @param endLine The line of the end station.
+ * @brief Starts a new query and resolves a station ID to its dense index.
+ *
+ * @param context The scratch state of the calling thread.
+ * @param startId The ID of the start station.
+ * @return The dense index of the start station, labelled but not queued yet.
+ * @throws std::runtime_error if the station is not part of the network.
  */
-void Navigation::printShortestPath(const std::string& endName, const std::string& endLine) const {
-    uint64_t endId = metroNetworkParser.get_station_id_by_name_and_line(endName, endLine);
-    if (previous[endId] == std::numeric_limits<uint64_t>::max()) {
-        std::cout << "No path from start to end" << std::endl;
-        return;
+uint32_t Navigation::resetSearch(QueryContext& context, uint64_t startId) const
+{
+    uint32_t start = graph->index_of(startId);
+    if (start == Graph::npos) {
+        throw std::runtime_error("Station not found in connections (computeShortestPath)");
     }
 
-    std::vector<uint64_t> path;
-    for (uint64_t at = endId; at != std::numeric_limits<uint64_t>::max(); at = previous[at]) {
-        path.push_back(at);
+    context.prepare(graph->node_count());
+    context.setForward(start, 0, QueryContext::none);
+    return start;
+}
+
+/**
+ * @brief Runs the forward search on the priority queue selected by the context.
+ *
+ * @param context The scratch state of the calling thread, with every start labelled at distance 0.
+ * @param starts The dense indices of the start stations.
+ * @param stops The dense indices to stop at, empty to settle the whole network.
+ */
+void Navigation::searchForward(QueryContext& context, ArrayRef<uint32_t> starts, ArrayRef<uint32_t> stops) const
+{
+    switch (context.queue_strategy) {
+    case QueueStrategy::RadixHeap:
+        runForward(context, context.radixQueue, starts, stops);
+        break;
+    case QueueStrategy::IndexedDaryHeap:
+        runForward(context, context.daryQueue, starts, stops);
+        break;
+    default:
+        runForward(context, context.queue, starts, stops);
+        break;
     }
-    std::reverse(path.begin(), path.end());
+}
 
-    for (const auto& id : path) {
-        std::cout << metroNetworkParser.get_station_name_by_id(id) << " ";
+/**
+ * @brief Settles nodes of the forward search until the priority queue is empty or a target is settled.
+ *
+ * @param context The scratch state of the calling thread, with every start labelled at distance 0.
+ * @param pq The queue of the search, empty.
+ * @param starts The dense indices of the start stations.
+ * @param stops The dense indices to stop at, empty to settle the whole network.
+ */
+template <typename Queue>
+void Navigation::runForward(QueryContext& context, Queue& pq, ArrayRef<uint32_t> starts, ArrayRef<uint32_t> stops) const
+{
+    for (uint32_t start : starts) {
+        pq.push(0, start);
+    }
+    while (!pq.empty())
+    {
+        uint64_t d = pq.top().first;
+        uint32_t u = pq.top().second;
+        pq.pop();
+
+        if (d > context.distance(u))
+        {
+            TRAVEL_COUNT(context.counters.stale);
+            continue; // Stale entry, u was already settled with a shorter distance
+        }
+        ++context.settled;
+        if (std::find(stops.begin(), stops.end(), u) != stops.end())
+            break;
+
+        for (uint32_t e = graph->edges_begin(u); e < graph->edges_end(u); ++e)
+        {
+            TRAVEL_COUNT(context.counters.relaxed);
+            uint32_t v = graph->target(e);
+            uint64_t w = graph->weight(e);
+
+            if (context.distance(v) > d + w)
+            {
+                context.setForward(v, d + w, u);
+                pq.push(d + w, v);
+                TRAVEL_COUNT(context.counters.pushes);
+            }
+        }
     }
-    std::cout << std::endl;
 }
 
 /**
  * @brief Gets the shortest distance from the start station to a given end station.
- * 
+ *
+ * @param context The scratch state of the last search.
  * @param end The ID of the end station.
  * @return The shortest distance from the start station to the end station.
  */
-uint64_t Navigation::getShortestDistance(uint64_t end) const {
-    return distance[end];
+uint64_t Navigation::getShortestDistance(const QueryContext& context, uint64_t end) const {
+    uint32_t index = graph->index_of(end);
+    if (index == Graph::npos) {
+        return QueryContext::infinity;
+    }
+    if (index == context.target) {
+        return context.bestDistance;
+    }
+    return context.distance(index);
 }
 
 /**
  * @brief Gets the shortest path from the start station to a given end station.
- * 
+ *
+ * @param context The scratch state of the last search.
  * @param end The ID of the end station.
- * @return A vector containing the IDs of the stations in the shortest path.
+ * @return A vector containing the IDs of the stations in the shortest path, empty if the end station is unreachable.
  */
-std::vector<uint64_t> Navigation::getShortestPath(uint64_t end) const {
+std::vector<uint64_t> Navigation::getShortestPath(const QueryContext& context, uint64_t end) const {
     std::vector<uint64_t> path;
-    for (uint64_t at = end; at != std::numeric_limits<uint64_t>::max(); at = previous[at]) {
-        path.push_back(at);
+    uint32_t index = graph->index_of(end);
+    if (index != Graph::npos) {
+        walkPath(context, index, [&](size_t length) { path.resize(length); },
+                 [&](size_t position, uint32_t at) { path[position] = graph->id_of(at); });
     }
-    std::reverse(path.begin(), path.end());
     return path;
 }
 
+/**
+ * @brief Writes the shortest path to a given station as dense indices, front to back.
+ *
+ * Allocates only when the path is longer than any the vector held before.
+ *
+ * @param context The scratch state of the last search.
+ * @param end The dense index of the destination station.
+ * @param path Receives the dense indices of the stations on the path, none if unreachable; its capacity is reused.
+ */
+void Navigation::writeShortestPath(const QueryContext& context, uint32_t end, std::vector<uint32_t>& path) const {
+    walkPath(context, end, [&](size_t length) { path.resize(length); },
+             [&](size_t position, uint32_t at) { path[position] = at; });
+}
+
 } // namespace travel
@@ -8,61 +8,153 @@
 #define NAVIGATION_HPP
 
 #include <vector>
-#include <queue>
+#include <memory>
 #include <limits>
 #include <iostream>
 #include <algorithm>
-#include <unordered_map>
+#include <stdexcept>
+
+#include "Graph.hpp"
+#include "QueryContext.hpp"
 
 namespace travel {
-    class MetroNetworkParser;  // Forward declaration
 
     /**
      * @class Navigation
-     * @brief Represents a navigation system for a metro network.
+     * @brief Shortest path searches on a metro network.
+     *
+     * A Navigation object only holds a shared, immutable graph; all per-query state lives in the
+     * QueryContext passed to each call. Any number of threads can therefore query the same
+     * Navigation concurrently, each with its own context.
+     *
+     * The priority queue of the Dijkstra kernels is chosen per query by QueryContext::queue_strategy.
+     * All strategies return the same distances; among several shortest paths of equal duration they
+     * may return different ones.
      */
     class Navigation {
     public:
         /**
          * @brief Constructs a Navigation object.
-         * @param parser The MetroNetworkParser object used to parse the metro network data.
+         * @param graph The CSR graph of the metro network.
+         */
+        explicit Navigation(std::shared_ptr<const Graph> graph);
+
+        /**
+         * @brief Computes the shortest paths from a station to every other station.
+         * @param context The scratch state of the calling thread.
+         * @param startId The ID of the starting station.
+         * @throws std::runtime_error if the station is not part of the network.
+         */
+        void computeShortestPath(QueryContext& context, uint64_t startId) const;
+
+        /**
+         * @brief Computes the shortest path between two stations, stopping as soon as the destination is settled.
+         *
+         * The resulting path and distance are identical to a full computeShortestPath(context, startId) run.
+         * @param context The scratch state of the calling thread.
+         * @param startId The ID of the starting station.
+         * @param endId The ID of the destination station.
+         * @throws std::runtime_error if either station is not part of the network.
          */
-        explicit Navigation(MetroNetworkParser &parser);
+        void computeShortestPath(QueryContext& context, uint64_t startId, uint64_t endId) const;
 
         /**
-         * @brief Computes the shortest path between two metro stations.
-         * @param startName The name of the starting station.
-         * @param startLine The line of the starting station.
+         * @brief Computes the shortest path from any of several stations to the closest of several others.
+         *
+         * Every start is seeded at distance 0 and the search stops as soon as one destination is
+         * settled, so a stop area served by several lines costs one search instead of one per pair
+         * of platforms. The destination reached is the one with the smallest getShortestDistance, and
+         * getShortestPath leads to it from the start it is closest to.
+         * @param context The scratch state of the calling thread.
+         * @param startIds The IDs of the starting stations.
+         * @param endIds The IDs of the destination stations, a handful at most: each is checked when a station is settled.
+         * @throws std::runtime_error if a station is not part of the network.
          */
-        void computeShortestPath(const std::string& startName, const std::string& startLine);
+        void computeShortestPath(QueryContext& context, const std::vector<uint64_t>& startIds, const std::vector<uint64_t>& endIds) const;
 
         /**
-         * @brief Prints the shortest path between two metro stations.
-         * @param endName The name of the destination station.
-         * @param endLine The line of the destination station.
+         * @brief Computes the shortest path between two stations with a bidirectional search.
+         *
+         * A forward search from the start and a backward search on the reverse adjacency from the
+         * destination run alternately until they meet. The distance is the same as a unidirectional
+         * search; among several shortest paths of equal duration another one may be returned.
+         * @param context The scratch state of the calling thread.
+         * @param startId The ID of the starting station.
+         * @param endId The ID of the destination station.
+         * @throws std::runtime_error if either station is not part of the network.
          */
-        void printShortestPath(const std::string& endName, const std::string& endLine) const;
+        void computeBidirectionalPath(QueryContext& context, uint64_t startId, uint64_t endId) const;
 
         /**
          * @brief Gets the shortest distance between the starting station and a given station.
+         * @param context The scratch state of the last search.
          * @param end The ID of the destination station.
          * @return The shortest distance between the starting station and the destination station.
          */
-        uint64_t getShortestDistance(uint64_t end) const;
+        uint64_t getShortestDistance(const QueryContext& context, uint64_t end) const;
 
         /**
          * @brief Gets the shortest path between the starting station and a given station.
+         * @param context The scratch state of the last search.
          * @param end The ID of the destination station.
          * @return A vector containing the IDs of the stations in the shortest path.
          */
-        std::vector<uint64_t> getShortestPath(uint64_t end) const;
+        std::vector<uint64_t> getShortestPath(const QueryContext& context, uint64_t end) const;
+
+        /**
+         * @brief Writes the shortest path to a given station as dense indices, front to back.
+         * @param context The scratch state of the last search.
+         * @param end The dense index of the destination station.
+         * @param path Receives the dense indices of the stations on the path, none if unreachable; its capacity is reused.
+         */
+        void writeShortestPath(const QueryContext& context, uint32_t end, std::vector<uint32_t>& path) const;
+
+        /**
+         * @brief Gets the graph the searches run on.
+         * @return A reference to the immutable graph.
+         */
+        const Graph& get_graph() const { return *graph; }
 
     private:
-        const std::unordered_map<uint64_t, std::unordered_map<uint64_t, uint64_t>>& connections_hashmap; /**< The hashmap representing the connections between metro stations. */
-        std::vector<uint64_t> distance; /**< The vector storing the shortest distances from the starting station. */
-        std::vector<uint64_t> previous; /**< The vector storing the previous station in the shortest path from the starting station. */
-        std::priority_queue<std::pair<uint64_t, uint64_t>, std::vector<std::pair<uint64_t, uint64_t>>, std::greater<std::pair<uint64_t, uint64_t>>> pq; /**< The priority queue used for Dijkstra's algorithm. */
-        MetroNetworkParser &metroNetworkParser; /**< The MetroNetworkParser object used to parse the metro network data. */
+        /**
+         * @brief Starts a new query and resolves a station ID to its dense index.
+         * @param context The scratch state of the calling thread.
+         * @param startId The ID of the starting station.
+         * @return The dense index of the starting station, labelled but not queued yet.
+         * @throws std::runtime_error if the station is not part of the network.
+         */
+        uint32_t resetSearch(QueryContext& context, uint64_t startId) const;
+
+        /**
+         * @brief Runs the forward search on the priority queue selected by the context.
+         * @param context The scratch state of the calling thread, with every start labelled at distance 0.
+         * @param starts The dense indices of the starting stations.
+         * @param stops The dense indices to stop at, empty to settle the whole network.
+         */
+        void searchForward(QueryContext& context, ArrayRef<uint32_t> starts, ArrayRef<uint32_t> stops) const;
+
+        /**
+         * @brief Settles nodes of the forward search until the priority queue is empty or a target is settled.
+         * @param context The scratch state of the calling thread, with every start labelled at distance 0.
+         * @param pq The queue of the search, empty.
+         * @param starts The dense indices of the starting stations.
+         * @param stops The dense indices to stop at, empty to settle the whole network.
+         */
+        template <typename Queue>
+        void runForward(QueryContext& context, Queue& pq, ArrayRef<uint32_t> starts, ArrayRef<uint32_t> stops) const;
+
+        /**
+         * @brief Runs the two searches of a bidirectional query on a given kind of priority queue.
+         * @param context The scratch state of the calling thread, prepared by resetSearch.
+         * @param pq The queue of the forward search, empty.
+         * @param pqBackward The queue of the backward search, empty.
+         * @param start The dense index of the starting station.
+         * @param end The dense index of the destination station.
+         */
+        template <typename Queue>
+        void runBidirectional(QueryContext& context, Queue& pq, Queue& pqBackward, uint32_t start, uint32_t end) const;
+
+        std::shared_ptr<const Graph> graph; /**< The CSR graph of the connections between metro stations. */
     };
 }
 
@@ -0,0 +1,370 @@
+#include "NodeOrder.hpp"
+#include "MappedFile.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <numeric>
+#include <stdexcept>
+
+namespace travel {
+
+namespace {
+
+const uint32_t npos = std::numeric_limits<uint32_t>::max();
+
+/**
+ * @brief The neighbours of every node, edges followed both ways, as sorted CSR rows without duplicates.
+ */
+struct Neighbours {
+    std::vector<uint32_t> offsets;
+    std::vector<uint32_t> nodes;
+
+    explicit Neighbours(const Graph& graph) : offsets(graph.node_count() + 1, 0) {
+        nodes.reserve(2 * size_t(graph.edge_count()));
+        for (uint32_t u = 0; u < graph.node_count(); ++u) {
+            const size_t begin = nodes.size();
+            for (uint32_t e = graph.edges_begin(u); e < graph.edges_end(u); ++e) {
+                nodes.push_back(graph.target(e));
+            }
+            for (uint32_t e = graph.reverse_edges_begin(u); e < graph.reverse_edges_end(u); ++e) {
+                nodes.push_back(graph.reverse_source(e));
+            }
+            std::sort(nodes.begin() + begin, nodes.end());
+            nodes.erase(std::unique(nodes.begin() + begin, nodes.end()), nodes.end());
+            nodes.erase(std::remove(nodes.begin() + begin, nodes.end(), u), nodes.end());
+            offsets[u + 1] = static_cast<uint32_t>(nodes.size());
+        }
+    }
+
+    uint32_t degree(uint32_t u) const { return offsets[u + 1] - offsets[u]; }
+};
+
+/**
+ * @brief Breadth-first search over the nodes not numbered yet.
+ *
+ * @param neighbours The adjacency.
+ * @param root The first node.
+ * @param numbered Whether each node already has its new index; those are not entered.
+ * @param level Depth of each node reached, npos for the others; reset by the caller.
+ * @param queue Receives the nodes reached, in visiting order.
+ * @param by_degree Whether the neighbours of a node are visited from the least connected (Cuthill-McKee) instead of by index.
+ */
+void breadth_first(const Neighbours& neighbours, uint32_t root, const std::vector<bool>& numbered,
+                   std::vector<uint32_t>& level, std::vector<uint32_t>& queue, bool by_degree) {
+    queue.clear();
+    queue.push_back(root);
+    level[root] = 0;
+    for (size_t head = 0; head < queue.size(); ++head) {
+        const uint32_t u = queue[head];
+        const size_t first = queue.size();
+        for (uint32_t i = neighbours.offsets[u]; i < neighbours.offsets[u + 1]; ++i) {
+            const uint32_t v = neighbours.nodes[i];
+            if (!numbered[v] && level[v] == npos) {
+                level[v] = level[u] + 1;
+                queue.push_back(v);
+            }
+        }
+        if (by_degree) {
+            std::stable_sort(queue.begin() + first, queue.end(), [&](uint32_t a, uint32_t b) {
+                return neighbours.degree(a) < neighbours.degree(b);
+            });
+        }
+    }
+}
+
+/**
+ * @brief Finds a pseudo-peripheral node of the component of a node (George and Liu).
+ *
+ * Starts from the node, then from a least connected node of the deepest level, as long as the
+ * depth keeps growing.
+ *
+ * @param neighbours The adjacency.
+ * @param start A node of the component.
+ * @param numbered Whether each node already has its new index.
+ * @param level Scratch depths, all npos; left so.
+ * @param queue Scratch.
+ * @return A node of the component at the end of a long shortest path.
+ */
+uint32_t peripheral_node(const Neighbours& neighbours, uint32_t start, const std::vector<bool>& numbered,
+                         std::vector<uint32_t>& level, std::vector<uint32_t>& queue) {
+    uint32_t root = start, depth = 0;
+    for (int round = 0; round < 8; ++round) {
+        breadth_first(neighbours, root, numbered, level, queue, false);
+        const uint32_t reached = level[queue.back()];
+        uint32_t candidate = queue.back();
+        for (uint32_t u : queue) {
+            if (level[u] == reached && neighbours.degree(u) < neighbours.degree(candidate)) {
+                candidate = u;
+            }
+        }
+        for (uint32_t u : queue) {
+            level[u] = npos;
+        }
+        if (round > 0 && reached <= depth) {
+            break;
+        }
+        depth = reached;
+        root = candidate;
+    }
+    return root;
+}
+
+/**
+ * @brief Numbers every component breadth-first from a peripheral node.
+ *
+ * @param graph The graph.
+ * @param by_degree Whether to visit the least connected neighbours first and reverse the result (reverse Cuthill-McKee).
+ * @return The current dense index of each new one.
+ */
+std::vector<uint32_t> breadth_first_order(const Graph& graph, bool by_degree) {
+    const uint32_t nodes = graph.node_count();
+    const Neighbours neighbours(graph);
+    std::vector<bool> numbered(nodes, false);
+    std::vector<uint32_t> level(nodes, npos), queue, order;
+    order.reserve(nodes);
+    for (uint32_t start = 0; start < nodes; ++start) {
+        if (numbered[start]) {
+            continue;
+        }
+        const uint32_t root = peripheral_node(neighbours, start, numbered, level, queue);
+        breadth_first(neighbours, root, numbered, level, queue, by_degree);
+        for (uint32_t u : queue) {
+            numbered[u] = true;
+            level[u] = npos;
+            order.push_back(u);
+        }
+    }
+    if (by_degree) {
+        std::reverse(order.begin(), order.end());
+    }
+    return order;
+}
+
+/**
+ * @brief Gets the position of a cell along the Hilbert curve filling a 2^16 x 2^16 grid.
+ * @param x The column of the cell.
+ * @param y The row of the cell.
+ * @return The number of cells visited before it.
+ */
+uint64_t hilbert_index(uint32_t x, uint32_t y) {
+    const uint32_t side = 1u << 16;
+    uint64_t index = 0;
+    for (uint32_t s = side / 2; s > 0; s /= 2) {
+        const uint32_t rx = (x & s) ? 1 : 0;
+        const uint32_t ry = (y & s) ? 1 : 0;
+        index += uint64_t(s) * s * ((3 * rx) ^ ry);
+        if (ry == 0) {
+            if (rx == 1) {
+                x = side - 1 - x;
+                y = side - 1 - y;
+            }
+            std::swap(x, y);
+        }
+    }
+    return index;
+}
+
+/**
+ * @brief Numbers the nodes along a Hilbert curve over their coordinates.
+ *
+ * Longitudes are scaled by the cosine of the mean latitude so that both axes measure about the
+ * same distance, then the bounding square of the stations is cut into 2^16 x 2^16 cells.
+ *
+ * @param graph The graph.
+ * @param coordinates The position of each dense index.
+ * @return The current dense index of each new one.
+ * @throws std::runtime_error if coordinates does not have one entry per node.
+ */
+std::vector<uint32_t> hilbert_order(const Graph& graph, std::vector<GeoPoint> coordinates) {
+    const uint32_t nodes = graph.node_count();
+    if (coordinates.size() != nodes) {
+        throw std::runtime_error("The Hilbert order needs one position per station (compute_node_order)");
+    }
+
+    // Place the stations without coordinates on their nearest placed neighbour, breadth-first.
+    const Neighbours neighbours(graph);
+    std::vector<uint32_t> queue;
+    for (uint32_t u = 0; u < nodes; ++u) {
+        if (!std::isnan(coordinates[u].latitude)) {
+            queue.push_back(u);
+        }
+    }
+    for (size_t head = 0; head < queue.size(); ++head) {
+        const uint32_t u = queue[head];
+        for (uint32_t i = neighbours.offsets[u]; i < neighbours.offsets[u + 1]; ++i) {
+            const uint32_t v = neighbours.nodes[i];
+            if (std::isnan(coordinates[v].latitude)) {
+                coordinates[v] = coordinates[u];
+                queue.push_back(v);
+            }
+        }
+    }
+
+    double latitude_sum = 0;
+    for (uint32_t u : queue) {
+        latitude_sum += coordinates[u].latitude;
+    }
+    const double radians = 3.14159265358979323846 / 180;
+    const double scale = queue.empty() ? 1 : std::cos(latitude_sum / queue.size() * radians);
+    double min_x = HUGE_VAL, min_y = HUGE_VAL, max_x = -HUGE_VAL, max_y = -HUGE_VAL;
+    for (uint32_t u : queue) {
+        min_x = std::min(min_x, coordinates[u].longitude * scale);
+        max_x = std::max(max_x, coordinates[u].longitude * scale);
+        min_y = std::min(min_y, coordinates[u].latitude);
+        max_y = std::max(max_y, coordinates[u].latitude);
+    }
+    const double extent = std::max(max_x - min_x, max_y - min_y);
+    const double cells = extent > 0 ? 65535 / extent : 0;
+
+    // Sort by curve position; the stations of components without any coordinates come last.
+    std::vector<std::pair<uint64_t, uint32_t>> keys(nodes);
+    for (uint32_t u = 0; u < nodes; ++u) {
+        uint64_t key = std::numeric_limits<uint64_t>::max();
+        if (!std::isnan(coordinates[u].latitude)) {
+            key = hilbert_index(static_cast<uint32_t>((coordinates[u].longitude * scale - min_x) * cells),
+                                static_cast<uint32_t>((coordinates[u].latitude - min_y) * cells));
+        }
+        keys[u] = std::make_pair(key, u);
+    }
+    std::sort(keys.begin(), keys.end());
+    std::vector<uint32_t> order(nodes);
+    for (uint32_t i = 0; i < nodes; ++i) {
+        order[i] = keys[i].second;
+    }
+    return order;
+}
+
+/**
+ * @brief Parses a decimal coordinate.
+ * @param field The text of the field.
+ * @param value Receives the number.
+ * @return False if the field is not a finite number.
+ */
+bool parse_coordinate(std::string_view field, double& value) {
+    const std::string text(field);
+    char* end = nullptr;
+    value = std::strtod(text.c_str(), &end);
+    return !text.empty() && end == text.c_str() + text.size() && std::isfinite(value);
+}
+
+} // namespace
+
+/**
+ * @brief Computes a numbering of the nodes of a graph.
+ *
+ * @param graph The graph to renumber.
+ * @param order The numbering.
+ * @param coordinates The position of each dense index, only read by NodeOrder::Hilbert.
+ * @return The current dense index of each new one, as taken by the renumbering Graph constructor.
+ * @throws std::runtime_error if NodeOrder::Hilbert is asked without a position for every node.
+ */
+std::vector<uint32_t> compute_node_order(const Graph& graph, NodeOrder order, const std::vector<GeoPoint>& coordinates) {
+    switch (order) {
+    case NodeOrder::BreadthFirst:
+        return breadth_first_order(graph, false);
+    case NodeOrder::CuthillMcKee:
+        return breadth_first_order(graph, true);
+    case NodeOrder::Hilbert:
+        return hilbert_order(graph, coordinates);
+    case NodeOrder::StationId:
+        break;
+    }
+    // Ascending station IDs, whatever the current numbering.
+    std::vector<uint32_t> sorted(graph.node_count());
+    std::iota(sorted.begin(), sorted.end(), 0);
+    std::sort(sorted.begin(), sorted.end(), [&](uint32_t a, uint32_t b) { return graph.id_of(a) < graph.id_of(b); });
+    return sorted;
+}
+
+/**
+ * @brief Reads the positions of the stations from a GTFS stops file.
+ *
+ * @param stops_filename The stops CSV file, with stop_id, stop_lat and stop_lon columns.
+ * @param graph The graph whose dense indices the positions are returned by.
+ * @param errors Receives the malformed rows, which are skipped, if not null.
+ * @return The position of each dense index, NaN for the stations the file does not place.
+ * @throws std::runtime_error if the file cannot be read or lacks a required column.
+ */
+std::vector<GeoPoint> read_stop_coordinates(const std::string& stops_filename, const Graph& graph, std::vector<CsvError>* errors) {
+    MappedFile file;
+    std::string open_error;
+    if (!file.open(stops_filename, &open_error)) {
+        throw std::runtime_error(open_error + " (read_stop_coordinates)");
+    }
+    CsvReader reader(std::string_view(file.data(), file.size()));
+    std::vector<std::string_view> fields;
+    CsvError error;
+    auto report = [&](const CsvError& row_error) {
+        if (errors) {
+            errors->push_back(row_error);
+        }
+    };
+
+    // Find the columns in the header.
+    static const char* const names[] = {"stop_id", "stop_lat", "stop_lon"};
+    size_t columns[3] = {npos, npos, npos};
+    CsvReader::Status status;
+    while ((status = reader.next(fields, error)) == CsvReader::Status::Error) {
+        report(error);
+    }
+    if (status == CsvReader::Status::End) {
+        throw std::runtime_error("Empty stops file: " + stops_filename + " (read_stop_coordinates)");
+    }
+    for (size_t i = 0; i < fields.size(); ++i) {
+        for (size_t column = 0; column < 3; ++column) {
+            if (fields[i] == names[column]) {
+                columns[column] = i;
+            }
+        }
+    }
+    for (size_t column = 0; column < 3; ++column) {
+        if (columns[column] == npos) {
+            throw std::runtime_error("Missing column " + std::string(names[column]) + " in " + stops_filename + " (read_stop_coordinates)");
+        }
+    }
+    const size_t width = *std::max_element(columns, columns + 3) + 1;
+
+    std::vector<GeoPoint> coordinates(graph.node_count());
+    while ((status = reader.next(fields, error)) != CsvReader::Status::End) {
+        if (status == CsvReader::Status::Record) {
+            uint64_t id = 0;
+            GeoPoint point;
+            if (fields.size() < width) {
+                error = CsvError{reader.line(), "expected " + std::to_string(width) + " fields, got " + std::to_string(fields.size())};
+            } else if (!CsvReader::parse_unsigned(fields[columns[0]], id)) {
+                error = CsvError{reader.line(), "invalid stop ID '" + std::string(fields[columns[0]]) + "'"};
+            } else if (!parse_coordinate(fields[columns[1]], point.latitude) || !parse_coordinate(fields[columns[2]], point.longitude)) {
+                error = CsvError{reader.line(), "invalid coordinates"};
+            } else {
+                const uint32_t u = graph.index_of(id);
+                if (u != Graph::npos) {
+                    coordinates[u] = point;
+                }
+                continue;
+            }
+        }
+        report(error);
+    }
+    return coordinates;
+}
+
+/**
+ * @brief Parses the name of a numbering, as given on command lines.
+ * @param name One of "id", "bfs", "rcm" or "hilbert".
+ * @param order Receives the numbering.
+ * @return False if the name is unknown.
+ */
+bool parse_node_order(const std::string& name, NodeOrder& order) {
+    static const std::pair<const char*, NodeOrder> names[] = {
+        {"id", NodeOrder::StationId}, {"bfs", NodeOrder::BreadthFirst}, {"rcm", NodeOrder::CuthillMcKee}, {"hilbert", NodeOrder::Hilbert}};
+    for (const auto& entry : names) {
+        if (name == entry.first) {
+            order = entry.second;
+            return true;
+        }
+    }
+    return false;
+}
+
+} // namespace travel
@@ -0,0 +1,78 @@
+/**
+ * @file NodeOrder.hpp
+ * @brief Contains the locality-improving orderings of the graph nodes.
+ */
+
+#pragma once
+#ifndef NODE_ORDER_HPP
+#define NODE_ORDER_HPP
+
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include "CsvReader.hpp"
+#include "Graph.hpp"
+
+namespace travel {
+
+    /**
+     * @brief The numberings of the dense node indices.
+     *
+     * Every search keeps per-node arrays (distances, parents, queue positions) indexed by dense
+     * index, and walks the CSR rows of the nodes it settles. Numbering connected stations close to
+     * each other keeps those accesses on the cache lines and pages already loaded.
+     */
+    enum class NodeOrder {
+        StationId,      /**< Ascending station IDs: the numbering of a freshly loaded network. */
+        BreadthFirst,   /**< Breadth-first from a peripheral station, one connected component after the other. */
+        CuthillMcKee,   /**< Reverse Cuthill-McKee: breadth-first visiting the least connected neighbours first, reversed; keeps the bandwidth small. */
+        Hilbert         /**< Along a Hilbert curve over the coordinates of the stations. */
+    };
+
+    /**
+     * @brief The position of a station, NaN when unknown.
+     */
+    struct GeoPoint {
+        double latitude = std::numeric_limits<double>::quiet_NaN(); /**< Degrees north. */
+        double longitude = std::numeric_limits<double>::quiet_NaN(); /**< Degrees east. */
+    };
+
+    /**
+     * @brief Computes a numbering of the nodes of a graph.
+     *
+     * Edges are followed in both directions. A station without coordinates takes those of the
+     * nearest station, in connections, that has some; a component without any comes last.
+     *
+     * @param graph The graph to renumber.
+     * @param order The numbering.
+     * @param coordinates The position of each dense index, only read by NodeOrder::Hilbert.
+     * @return The current dense index of each new one, as taken by the renumbering Graph constructor.
+     * @throws std::runtime_error if NodeOrder::Hilbert is asked with coordinates that are not one per node.
+     */
+    std::vector<uint32_t> compute_node_order(const Graph& graph, NodeOrder order, const std::vector<GeoPoint>& coordinates = std::vector<GeoPoint>());
+
+    /**
+     * @brief Reads the positions of the stations from a GTFS stops file.
+     *
+     * Stop IDs are station IDs; stops that are not part of the graph are ignored.
+     *
+     * @param stops_filename The stops CSV file, with stop_id, stop_lat and stop_lon columns.
+     * @param graph The graph whose dense indices the positions are returned by.
+     * @param errors Receives the malformed rows, which are skipped, if not null.
+     * @return The position of each dense index, NaN for the stations the file does not place.
+     * @throws std::runtime_error if the file cannot be read or lacks a required column.
+     */
+    std::vector<GeoPoint> read_stop_coordinates(const std::string& stops_filename, const Graph& graph, std::vector<CsvError>* errors = nullptr);
+
+    /**
+     * @brief Parses the name of a numbering, as given on command lines.
+     * @param name One of "id", "bfs", "rcm" or "hilbert".
+     * @param order Receives the numbering.
+     * @return False if the name is unknown.
+     */
+    bool parse_node_order(const std::string& name, NodeOrder& order);
+}
+
+#endif // NODE_ORDER_HPP
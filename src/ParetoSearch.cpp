@@ -0,0 +1,139 @@
+#include "ParetoSearch.hpp"
+#include "QueryContext.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace travel {
+
+/**
+ * @brief Starts a new query.
+ * @param node_count The number of dense node indices of the graph.
+ * @param width The size of a bag, max_changes + 1.
+ */
+void ParetoContext::prepare(uint32_t node_count, uint32_t width) {
+    if (++generation == 0 || stamps.size() < node_count) {
+        // Stamps of 0 are never current, so a wrapped counter or new nodes start from clean bags.
+        stamps.assign(std::max<size_t>(stamps.size(), node_count), 0);
+        generation = 1;
+    }
+    if (pool.size() < size_t(node_count) * width) {
+        pool.resize(size_t(node_count) * width);
+    }
+    this->width = width;
+    queue.clear();
+    target_duration.assign(width, QueryContext::infinity);
+    target_state.assign(width, QueryContext::none);
+    settled = 0;
+}
+
+/**
+ * @brief Constructs a search on a graph.
+ * @param graph The CSR graph of the metro network.
+ * @param lines The line of each dense node index; an edge between different lines is a change.
+ * @throws std::runtime_error if there is not one line per node.
+ */
+ParetoSearch::ParetoSearch(std::shared_ptr<const Graph> graph, std::shared_ptr<const std::vector<uint32_t>> lines)
+    : graph(std::move(graph)), lines(std::move(lines)) {
+    if (this->lines->size() != this->graph->node_count()) {
+        throw std::runtime_error("Expected one line per station (ParetoSearch::ParetoSearch)");
+    }
+}
+
+/**
+ * @brief Computes the Pareto set of (duration, changes) routes from several starts to several destinations.
+ *
+ * A label (u, k, d) is reached in d seconds with k changes and is identified by the state
+ * u * width + k. Pushing it writes d into entries k and above of the bag of u while they are
+ * slower, so the entry k of a bag always holds the best duration with at most k changes, and
+ * likewise for the destinations. The search stops when the queue reaches the fastest route with
+ * no change, which every remaining label is slower than.
+ *
+ * A route without cycles changes lines at most once per connection, so max_changes is first
+ * clamped to node_count() - 1.
+ *
+ * @param context The scratch state of the calling thread.
+ * @param starts The dense indices of the starting stations, all at 0 changes.
+ * @param ends The dense indices of the destination stations, a handful at most.
+ * @param max_changes The largest number of changes of a route; no route has more than node_count() - 1.
+ * @return The routes by increasing number of changes and decreasing duration, empty if unreachable.
+ * @throws std::runtime_error if the labels of every node would not fit 32-bit states.
+ */
+std::vector<ParetoRoute> ParetoSearch::search(ParetoContext& context, const std::vector<uint32_t>& starts, const std::vector<uint32_t>& ends,
+                                              uint32_t max_changes) const {
+    const uint64_t nodes = std::max<uint32_t>(graph->node_count(), 1);
+    const uint64_t bag_size = std::min<uint64_t>(max_changes, nodes - 1) + 1;
+    if (nodes * bag_size > QueryContext::none) {
+        throw std::runtime_error("Too many changes for the size of the network (ParetoSearch::search)");
+    }
+    const uint32_t width = static_cast<uint32_t>(bag_size);
+    const std::vector<uint32_t>& line = *lines;
+    context.prepare(graph->node_count(), width);
+    std::vector<uint64_t>& target = context.target_duration;
+
+    auto relax = [&](uint32_t v, uint32_t k, uint64_t d, uint32_t parent) {
+        if (d >= target[k]) {
+            return;  // A destination is already as fast with as few changes
+        }
+        ParetoContext::Entry* bag = context.bag(v);
+        if (d >= bag[k].duration) {
+            return;
+        }
+        for (uint32_t j = k; j < width && d < bag[j].duration; ++j) {
+            bag[j] = ParetoContext::Entry{d, parent};
+        }
+        const uint32_t state = v * width + k;
+        context.queue.push(d, state);
+        if (std::find(ends.begin(), ends.end(), v) != ends.end()) {
+            for (uint32_t j = k; j < width && d < target[j]; ++j) {
+                target[j] = d;
+                context.target_state[j] = state;
+            }
+        }
+    };
+
+    for (uint32_t start : starts) {
+        relax(start, 0, 0, QueryContext::none);
+    }
+    while (!context.queue.empty()) {
+        const uint64_t d = context.queue.top().first;
+        const uint32_t state = context.queue.top().second;
+        context.queue.pop();
+        if (d >= target[0]) {
+            break;  // Every label left is slower than a route with no change
+        }
+        const uint32_t u = state / width, k = state % width;
+        const ParetoContext::Entry* bag = context.bag(u);
+        if (d != bag[k].duration || d >= target[k] || (k > 0 && bag[k - 1].duration <= d)) {
+            continue;  // Stale, or caught up with by a label with fewer changes
+        }
+        ++context.settled;
+        for (uint32_t e = graph->edges_begin(u); e < graph->edges_end(u); ++e) {
+            const uint32_t v = graph->target(e);
+            const uint32_t changes = k + (line[v] != line[u]);
+            if (changes < width) {
+                relax(v, changes, d + graph->weight(e), state);
+            }
+        }
+    }
+
+    std::vector<ParetoRoute> routes;
+    for (uint32_t k = 0; k < width; ++k) {
+        if (target[k] == QueryContext::infinity || (k > 0 && target[k] >= target[k - 1])) {
+            continue;
+        }
+        ParetoRoute route;
+        route.duration = target[k];
+        route.changes = context.target_state[k] % width;
+        for (uint32_t state = context.target_state[k]; state != QueryContext::none;) {
+            const uint32_t u = state / width;
+            route.path.push_back(u);
+            state = context.bag(u)[state % width].parent;
+        }
+        std::reverse(route.path.begin(), route.path.end());
+        routes.push_back(std::move(route));
+    }
+    return routes;
+}
+
+} // namespace travel
@@ -0,0 +1,127 @@
+/**
+ * @file ParetoSearch.hpp
+ * @brief Contains the declaration of the ParetoSearch class.
+ */
+
+#pragma once
+#ifndef PARETO_SEARCH_HPP
+#define PARETO_SEARCH_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <vector>
+
+#include "Graph.hpp"
+#include "PriorityQueues.hpp"
+
+namespace travel {
+
+    /**
+     * @brief One route of a Pareto set, as dense node indices.
+     */
+    struct ParetoRoute {
+        uint64_t duration = 0;  /**< The total duration in seconds. */
+        uint32_t changes = 0;  /**< The number of line changes. */
+        std::vector<uint32_t> path;  /**< The dense indices of the stations, in travel order. */
+    };
+
+    /**
+     * @class ParetoContext
+     * @brief Per-thread scratch state of a ParetoSearch.
+     *
+     * The label bags of all nodes live in one pooled array: node u owns the max_changes + 1
+     * consecutive entries starting at u * width, entry k holding the best duration reaching u with at
+     * most k line changes. A bag is reset the first time a query touches its node, so starting a
+     * query only bumps a counter. A context must not be shared by two threads at the same time.
+     */
+    class ParetoContext {
+    public:
+        /**
+         * @brief A label of a bag.
+         */
+        struct Entry {
+            uint64_t duration;  /**< Best duration with at most this many changes, infinity if none. */
+            uint32_t parent;  /**< The (node * width + changes) state the label was reached from. */
+        };
+
+        /**
+         * @brief Starts a new query.
+         * @param node_count The number of dense node indices of the graph.
+         * @param width The size of a bag, max_changes + 1.
+         */
+        void prepare(uint32_t node_count, uint32_t width);
+
+        /**
+         * @brief Gets the bag of a node, resetting it on first use in the query.
+         * @param u The dense node index.
+         * @return The width entries of the bag.
+         */
+        Entry* bag(uint32_t u) {
+            Entry* entries = &pool[size_t(u) * width];
+            if (stamps[u] != generation) {
+                stamps[u] = generation;
+                std::fill(entries, entries + width, Entry{std::numeric_limits<uint64_t>::max(), std::numeric_limits<uint32_t>::max()});
+            }
+            return entries;
+        }
+
+        RadixQueue queue; /**< Monotone queue of (duration, state) pairs. */
+        std::vector<uint64_t> target_duration; /**< Best duration reaching a destination with at most k changes. */
+        std::vector<uint32_t> target_state; /**< The state of that label. */
+        uint32_t settled = 0; /**< Labels settled by the last search. */
+
+    private:
+        std::vector<Entry> pool; /**< The bags, width entries per node. */
+        std::vector<uint32_t> stamps; /**< Generation that last reset each bag. */
+        uint32_t width = 0; /**< The size of a bag in the current query. */
+        uint32_t generation = 0; /**< Stamp of the current query. */
+    };
+
+    /**
+     * @class ParetoSearch
+     * @brief Multi-criteria search for the fastest route for each number of line changes.
+     *
+     * A label-setting Dijkstra search on (station, changes) states: leaving a platform for a
+     * platform of another line costs one change. A label is pushed only if it beats the bag entry of
+     * its node for the same or fewer changes, and only if no destination label with the same or
+     * fewer changes is already as fast; a popped label that a label with fewer changes caught up with
+     * is skipped. Since a bag entry holds the best duration with at most k changes, both checks are
+     * a single comparison.
+     *
+     * The result is the Pareto set: routes with strictly decreasing durations as the number of
+     * changes grows. Like Navigation, the object only holds the immutable graph and line of each
+     * node, and any number of threads can search it concurrently with their own contexts.
+     */
+    class ParetoSearch {
+    public:
+        static const uint32_t default_max_changes = 6; /**< Changes considered when the caller does not say. */
+
+        /**
+         * @brief Constructs a search on a graph.
+         * @param graph The CSR graph of the metro network.
+         * @param lines The line of each dense node index; an edge between different lines is a change.
+         * @throws std::runtime_error if there is not one line per node.
+         */
+        ParetoSearch(std::shared_ptr<const Graph> graph, std::shared_ptr<const std::vector<uint32_t>> lines);
+
+        /**
+         * @brief Computes the Pareto set of (duration, changes) routes from several starts to several destinations.
+         * @param context The scratch state of the calling thread.
+         * @param starts The dense indices of the starting stations, all at 0 changes.
+         * @param ends The dense indices of the destination stations, a handful at most.
+         * @param max_changes The largest number of changes of a route; no route has more than node_count() - 1.
+         * @return The routes by increasing number of changes and decreasing duration, empty if unreachable.
+         * @throws std::runtime_error if the labels of every node would not fit 32-bit states.
+         */
+        std::vector<ParetoRoute> search(ParetoContext& context, const std::vector<uint32_t>& starts, const std::vector<uint32_t>& ends,
+                                        uint32_t max_changes = default_max_changes) const;
+
+    private:
+        std::shared_ptr<const Graph> graph; /**< The CSR graph of the connections between metro stations. */
+        std::shared_ptr<const std::vector<uint32_t>> lines; /**< The line of each dense node index. */
+    };
+}
+
+#endif // PARETO_SEARCH_HPP
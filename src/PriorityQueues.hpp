@@ -0,0 +1,230 @@
+/**
+ * @file PriorityQueues.hpp
+ * @brief Contains the RadixQueue and IndexedDaryHeap priority queues used by the Dijkstra kernels.
+ */
+
+#pragma once
+#ifndef PRIORITY_QUEUES_HPP
+#define PRIORITY_QUEUES_HPP
+
+#include <cstdint>
+#include <limits>
+#include <vector>
+#include <utility>
+#include <algorithm>
+
+namespace travel {
+
+    typedef std::pair<uint64_t, uint32_t> QueueEntry; /**< A (distance, dense node index) pair. */
+
+    /**
+     * @brief The priority queue used by the Dijkstra searches of Navigation.
+     */
+    enum class QueueStrategy {
+        BinaryHeap,       /**< Binary heap with lazy duplicates (QueryContext::MinQueue). */
+        RadixHeap,        /**< Monotone radix heap over integer distances (RadixQueue). */
+        IndexedDaryHeap   /**< 4-ary heap with decrease-key, one entry per node (IndexedDaryHeap). */
+    };
+
+    /**
+     * @class RadixQueue
+     * @brief Monotone radix heap for integer distances.
+     *
+     * Entry distances are bucketed by the highest bit in which they differ from the last extracted
+     * minimum, so bucket i holds distances in [last + 2^(i-1), last + 2^i). Extracting from an empty
+     * bucket 0 redistributes the first non-empty bucket into lower ones; every entry moves down at
+     * most 64 times over its lifetime, and in practice once or twice since transfer times are small.
+     * Pushes are O(1) appends with no comparison at all.
+     *
+     * Only valid for monotone use, which Dijkstra guarantees: a pushed distance is never smaller than
+     * the last extracted one. Like MinQueue it keeps duplicates, which the search skips as stale.
+     */
+    class RadixQueue {
+    public:
+        /** @brief Checks whether the queue is empty. */
+        bool empty() const { return count == 0; }
+
+        /** @brief Gets the number of entries, stale ones included. */
+        size_t size() const { return count; }
+
+        /** @brief Gets the entry with the smallest distance; the queue must not be empty. */
+        const QueueEntry& top() {
+            if (buckets[0].empty()) {
+                refill();
+            }
+            return buckets[0].back();
+        }
+
+        /** @brief Inserts a node with its tentative distance, at least the last extracted one. */
+        void push(uint64_t distance, uint32_t node) {
+            buckets[bucket(distance)].emplace_back(distance, node);
+            ++count;
+        }
+
+        /** @brief Removes the entry with the smallest distance; the queue must not be empty. */
+        void pop() {
+            if (buckets[0].empty()) {
+                refill();
+            }
+            buckets[0].pop_back();
+            --count;
+        }
+
+        /** @brief Removes every entry, keeping the allocated storage. */
+        void clear() {
+            for (std::vector<QueueEntry>& entries : buckets) {
+                entries.clear();
+            }
+            count = 0;
+            last = 0;
+        }
+
+    private:
+        /** @brief Gets the bucket of a distance relative to the last extracted minimum. */
+        size_t bucket(uint64_t distance) const {
+            return distance == last ? 0 : 64 - static_cast<size_t>(__builtin_clzll(distance ^ last));
+        }
+
+        /** @brief Moves the smallest non-empty bucket down so that bucket 0 holds the minimum. */
+        void refill() {
+            size_t i = 1;
+            while (buckets[i].empty()) {
+                ++i;
+            }
+            uint64_t minimum = std::numeric_limits<uint64_t>::max();
+            for (const QueueEntry& entry : buckets[i]) {
+                minimum = std::min(minimum, entry.first);
+            }
+            last = minimum;
+            for (const QueueEntry& entry : buckets[i]) {
+                buckets[bucket(entry.first)].push_back(entry); // Always to a bucket below i
+            }
+            buckets[i].clear();
+        }
+
+        std::vector<QueueEntry> buckets[65]; /**< Entries by highest differing bit from last. */
+        uint64_t last = 0; /**< The last extracted minimum. */
+        size_t count = 0; /**< The number of entries. */
+    };
+
+    /**
+     * @class IndexedDaryHeap
+     * @brief D-ary min-heap with decrease-key, holding at most one entry per node.
+     *
+     * A position array indexed by node lets push() lower the key of a node already queued instead
+     * of adding a duplicate, so the heap never holds more than the frontier and never yields stale
+     * entries. A fan-out of 4 halves the depth of a binary heap and keeps a node's children on one
+     * cache line.
+     */
+    template <unsigned Arity>
+    class IndexedDaryHeap {
+    public:
+        /** @brief Checks whether the queue is empty. */
+        bool empty() const { return heap.empty(); }
+
+        /** @brief Gets the number of queued nodes. */
+        size_t size() const { return heap.size(); }
+
+        /** @brief Gets the entry with the smallest distance; the queue must not be empty. */
+        const QueueEntry& top() const { return heap.front(); }
+
+        /**
+         * @brief Inserts a node, or lowers its distance if it is queued with a larger one.
+         * @param distance The tentative distance.
+         * @param node A dense node index below the count passed to resize().
+         */
+        void push(uint64_t distance, uint32_t node) {
+            uint32_t at = position[node];
+            if (at == absent) {
+                at = static_cast<uint32_t>(heap.size());
+                heap.emplace_back(distance, node);
+            } else if (distance < heap[at].first) {
+                heap[at].first = distance;
+            } else {
+                return;
+            }
+            sift_up(at);
+        }
+
+        /** @brief Removes the entry with the smallest distance; the queue must not be empty. */
+        void pop() {
+            position[heap.front().second] = absent;
+            QueueEntry moved = heap.back();
+            heap.pop_back();
+            if (!heap.empty()) {
+                heap[0] = moved;
+                position[moved.second] = 0;
+                sift_down(0);
+            }
+        }
+
+        /** @brief Removes every entry, keeping the allocated storage. */
+        void clear() {
+            for (const QueueEntry& entry : heap) {
+                position[entry.second] = absent;
+            }
+            heap.clear();
+        }
+
+        /**
+         * @brief Makes room for the node indices of a graph.
+         * @param node_count The number of dense node indices.
+         */
+        void resize(uint32_t node_count) {
+            if (position.size() < node_count) {
+                position.resize(node_count, absent);
+            }
+        }
+
+    private:
+        static constexpr uint32_t absent = std::numeric_limits<uint32_t>::max(); /**< Position of nodes not queued. */
+
+        /** @brief Moves an entry up until its parent is not larger. */
+        void sift_up(uint32_t at) {
+            QueueEntry entry = heap[at];
+            while (at > 0) {
+                uint32_t parent = (at - 1) / Arity;
+                if (heap[parent].first <= entry.first) {
+                    break;
+                }
+                heap[at] = heap[parent];
+                position[heap[at].second] = at;
+                at = parent;
+            }
+            heap[at] = entry;
+            position[entry.second] = at;
+        }
+
+        /** @brief Moves an entry down until none of its children is smaller. */
+        void sift_down(uint32_t at) {
+            QueueEntry entry = heap[at];
+            const uint32_t size = static_cast<uint32_t>(heap.size());
+            while (true) {
+                uint32_t first = at * Arity + 1;
+                if (first >= size) {
+                    break;
+                }
+                uint32_t best = first;
+                uint32_t end = first + Arity < size ? first + Arity : size;
+                for (uint32_t child = first + 1; child < end; ++child) {
+                    if (heap[child].first < heap[best].first) {
+                        best = child;
+                    }
+                }
+                if (entry.first <= heap[best].first) {
+                    break;
+                }
+                heap[at] = heap[best];
+                position[heap[at].second] = at;
+                at = best;
+            }
+            heap[at] = entry;
+            position[entry.second] = at;
+        }
+
+        std::vector<QueueEntry> heap; /**< Heap-ordered entries. */
+        std::vector<uint32_t> position; /**< Index of each node in heap, absent if not queued. */
+    };
+}
+
+#endif // PRIORITY_QUEUES_HPP
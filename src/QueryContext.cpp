@@ -0,0 +1,44 @@
+#include "QueryContext.hpp"
+
+namespace travel {
+
+const uint64_t QueryContext::infinity;
+const uint32_t QueryContext::none;
+
+/**
+ * @brief Starts a new query on a graph with the given number of nodes.
+ *
+ * Only grows the label arrays when the graph is larger than any graph seen before; otherwise
+ * the previous labels are invalidated by moving to the next generation. The arrays are only
+ * cleared when the generation counter wraps around.
+ *
+ * @param node_count The number of dense node indices of the graph.
+ */
+void QueryContext::prepare(uint32_t node_count) {
+    if (forward.size() < node_count) {
+        forward.resize(node_count, Label{infinity, none, 0});
+        backward.resize(node_count, Label{infinity, none, 0});
+    }
+    if (++generation == 0) {
+        std::fill(forward.begin(), forward.end(), Label{infinity, none, 0});
+        std::fill(backward.begin(), backward.end(), Label{infinity, none, 0});
+        generation = 1;
+    }
+    queue.clear();
+    queueBackward.clear();
+    radixQueue.clear();
+    radixQueueBackward.clear();
+    daryQueue.clear();
+    daryQueueBackward.clear();
+    daryQueue.resize(node_count);
+    daryQueueBackward.resize(node_count);
+    target = none;
+    meeting = none;
+    bestDistance = infinity;
+    settled = 0;
+#if TRAVEL_METRICS
+    counters = SearchCounters();
+#endif
+}
+
+} // namespace travel
@@ -0,0 +1,151 @@
+/**
+ * @file QueryContext.hpp
+ * @brief Contains the declaration of the QueryContext class.
+ */
+
+#pragma once
+#ifndef QUERY_CONTEXT_HPP
+#define QUERY_CONTEXT_HPP
+
+#include <cstdint>
+#include <limits>
+#include <vector>
+#include <utility>
+#include <algorithm>
+#include <functional>
+
+#include "PriorityQueues.hpp"
+#include "Metrics.hpp"
+
+namespace travel {
+
+    /**
+     * @class QueryContext
+     * @brief Per-thread scratch state of a shortest path search.
+     *
+     * Labels carry the generation of the query that wrote them, so starting a new query only
+     * bumps a counter instead of clearing every node. A context can be reused for any number of
+     * queries (on any graph) but must not be shared by two threads at the same time.
+     */
+    class QueryContext {
+    public:
+        static const uint64_t infinity = std::numeric_limits<uint64_t>::max(); /**< Distance of unreached nodes. */
+        static const uint32_t none = std::numeric_limits<uint32_t>::max(); /**< Parent of the search roots. */
+
+        typedef travel::QueueEntry QueueEntry; /**< A (distance, dense node index) pair. */
+
+        /**
+         * @class MinQueue
+         * @brief Binary min-heap over a vector whose capacity survives clear().
+         */
+        class MinQueue {
+        public:
+            /** @brief Checks whether the queue is empty. */
+            bool empty() const { return heap.empty(); }
+
+            /** @brief Gets the number of entries, stale ones included. */
+            size_t size() const { return heap.size(); }
+
+            /** @brief Gets the entry with the smallest distance. */
+            const QueueEntry& top() const { return heap.front(); }
+
+            /** @brief Inserts a node with its tentative distance. */
+            void push(uint64_t distance, uint32_t node) {
+                heap.emplace_back(distance, node);
+                std::push_heap(heap.begin(), heap.end(), std::greater<QueueEntry>());
+            }
+
+            /** @brief Removes the entry with the smallest distance. */
+            void pop() {
+                std::pop_heap(heap.begin(), heap.end(), std::greater<QueueEntry>());
+                heap.pop_back();
+            }
+
+            /** @brief Removes every entry, keeping the allocated storage. */
+            void clear() { heap.clear(); }
+
+        private:
+            std::vector<QueueEntry> heap; /**< Heap-ordered entries. */
+        };
+
+        /**
+         * @brief Starts a new query on a graph with the given number of nodes.
+         * @param node_count The number of dense node indices of the graph.
+         */
+        void prepare(uint32_t node_count);
+
+        /**
+         * @brief Gets the forward distance of a node in the current query.
+         * @param u The dense node index.
+         * @return The tentative distance from the source, or infinity if unreached.
+         */
+        uint64_t distance(uint32_t u) const { return forward[u].stamp == generation ? forward[u].distance : infinity; }
+
+        /**
+         * @brief Gets the forward parent of a node in the current query.
+         * @param u The dense node index.
+         * @return The previous node on the path from the source, or none.
+         */
+        uint32_t previous(uint32_t u) const { return forward[u].stamp == generation ? forward[u].parent : none; }
+
+        /**
+         * @brief Labels a node of the forward search.
+         * @param u The dense node index.
+         * @param d The new distance from the source.
+         * @param parent The previous node on the path from the source.
+         */
+        void setForward(uint32_t u, uint64_t d, uint32_t parent) { forward[u] = Label{d, parent, generation}; }
+
+        /**
+         * @brief Gets the backward distance of a node in the current query.
+         * @param u The dense node index.
+         * @return The tentative distance to the target, or infinity if unreached.
+         */
+        uint64_t distanceBackward(uint32_t u) const { return backward[u].stamp == generation ? backward[u].distance : infinity; }
+
+        /**
+         * @brief Gets the backward parent of a node in the current query.
+         * @param u The dense node index.
+         * @return The next node on the path to the target, or none.
+         */
+        uint32_t next(uint32_t u) const { return backward[u].stamp == generation ? backward[u].parent : none; }
+
+        /**
+         * @brief Labels a node of the backward search.
+         * @param u The dense node index.
+         * @param d The new distance to the target.
+         * @param parent The next node on the path to the target.
+         */
+        void setBackward(uint32_t u, uint64_t d, uint32_t parent) { backward[u] = Label{d, parent, generation}; }
+
+        QueueStrategy queue_strategy = QueueStrategy::RadixHeap; /**< The priority queue used by Navigation searches. */
+        MinQueue queue; /**< Binary heap of the forward search. */
+        MinQueue queueBackward; /**< Binary heap of the backward search. */
+        RadixQueue radixQueue; /**< Radix heap of the forward search. */
+        RadixQueue radixQueueBackward; /**< Radix heap of the backward search. */
+        IndexedDaryHeap<4> daryQueue; /**< Indexed 4-ary heap of the forward search. */
+        IndexedDaryHeap<4> daryQueueBackward; /**< Indexed 4-ary heap of the backward search. */
+        uint32_t target = none; /**< Destination of the last bidirectional query, none otherwise. */
+        uint32_t meeting = none; /**< Node where the two searches of the last bidirectional query met. */
+        uint64_t bestDistance = infinity; /**< Length of the path through the meeting node. */
+        uint32_t settled = 0; /**< Nodes settled by the last search, both directions included. */
+        SearchCounters counters; /**< Rest of the work of the last search, only counted when TRAVEL_METRICS is set. */
+        std::vector<uint32_t> path; /**< Route of the last query as dense indices, for callers that copy it out; keeps its capacity. */
+
+    private:
+        /**
+         * @brief Distance and parent of a node, valid only if stamp equals the current generation.
+         */
+        struct Label {
+            uint64_t distance;
+            uint32_t parent;
+            uint32_t stamp;
+        };
+
+        std::vector<Label> forward; /**< Labels of the forward search, indexed by dense node index. */
+        std::vector<Label> backward; /**< Labels of the backward search, indexed by dense node index. */
+        uint32_t generation = 0; /**< Stamp of the current query. */
+    };
+}
+
+#endif // QUERY_CONTEXT_HPP
@@ -0,0 +1,104 @@
+/**
+ * @file RouteCache.hpp
+ * @brief Contains the values stored by the journey caches of MetroNetworkParser.
+ */
+
+#pragma once
+#ifndef ROUTE_CACHE_HPP
+#define ROUTE_CACHE_HPP
+
+#include <memory>
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+
+#include "QueryContext.hpp"
+#include "ShardedCache.hpp"
+
+namespace travel {
+
+    /**
+     * @brief A computed route, as stored by the origin-destination cache.
+     */
+    struct CachedRoute {
+        std::vector<uint32_t> path; /**< Dense indices of the stations of the route, empty if unreachable. */
+        uint64_t duration = QueryContext::infinity; /**< The total duration in seconds, infinity if unreachable. */
+
+        /** @brief Estimates the memory held by the route, shared pointer control block included. */
+        size_t memory_usage() const { return sizeof(CachedRoute) + 2 * sizeof(void*) + path.capacity() * sizeof(uint32_t); }
+    };
+
+    /**
+     * @brief The shortest paths from one source to every station, as stored by the tree cache.
+     */
+    struct ShortestPathTree {
+        std::vector<uint64_t> distance; /**< Distance of each dense index from the source, infinity if unreachable. */
+        std::vector<uint32_t> parent; /**< Previous station of each dense index, QueryContext::none for the source. */
+
+        /**
+         * @brief Copies the labels of a finished one-to-all search.
+         * @param context The context of the search.
+         * @param node_count The number of dense indices of the graph searched.
+         */
+        ShortestPathTree(const QueryContext& context, uint32_t node_count) : distance(node_count), parent(node_count) {
+            for (uint32_t u = 0; u < node_count; ++u) {
+                distance[u] = context.distance(u);
+                parent[u] = context.previous(u);
+            }
+        }
+
+        /**
+         * @brief Extracts the route to a station.
+         * @param target The dense index of the destination.
+         * @return The route from the source.
+         */
+        CachedRoute route_to(uint32_t target) const {
+            CachedRoute route;
+            route.duration = route_to(target, route.path);
+            return route;
+        }
+
+        /**
+         * @brief Writes the route to a station front to back into a vector whose capacity is reused.
+         * @param target The dense index of the destination.
+         * @param path Receives the dense indices of the stations of the route, none if unreachable.
+         * @return The duration of the route, infinity if unreachable.
+         */
+        uint64_t route_to(uint32_t target, std::vector<uint32_t>& path) const {
+            size_t length = 0;
+            if (distance[target] != QueryContext::infinity) {
+                for (uint32_t at = target; at != QueryContext::none; at = parent[at]) {
+                    ++length;
+                }
+            }
+            path.resize(length);
+            for (uint32_t at = target; length > 0; at = parent[at]) {
+                path[--length] = at;
+            }
+            return distance[target];
+        }
+
+        /** @brief Estimates the memory held by the tree, shared pointer control block included. */
+        size_t memory_usage() const {
+            return sizeof(ShortestPathTree) + 2 * sizeof(void*) + distance.capacity() * sizeof(uint64_t) + parent.capacity() * sizeof(uint32_t);
+        }
+
+        /** @brief Estimates the memory a tree of a graph would hold, before searching it. */
+        static size_t memory_usage(uint32_t node_count) {
+            return sizeof(ShortestPathTree) + 2 * sizeof(void*) + size_t(node_count) * (sizeof(uint64_t) + sizeof(uint32_t));
+        }
+    };
+
+    /**
+     * @brief The counters of both journey caches.
+     */
+    struct RouteCacheStats {
+        CacheStats routes; /**< The origin-destination cache. */
+        CacheStats trees; /**< The per-source shortest path tree cache. */
+    };
+
+    typedef ShardedCache<uint64_t, std::shared_ptr<const CachedRoute>> RouteCache; /**< Routes keyed by (start << 32 | end) dense indices. */
+    typedef ShardedCache<uint32_t, std::shared_ptr<const ShortestPathTree>> TreeCache; /**< Trees keyed by source dense index. */
+}
+
+#endif // ROUTE_CACHE_HPP
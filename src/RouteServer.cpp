@@ -0,0 +1,680 @@
+#include "RouteServer.hpp"
+#include "CsvReader.hpp"
+#include "MetroNetworkParser.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <cstring>
+#include <exception>
+#include <limits>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#ifdef __linux__
+#include <sys/epoll.h>
+#else
+#include <poll.h>
+#endif
+
+namespace travel {
+
+namespace {
+
+const uint64_t listener_id = 0; /**< Poller ID of the listening socket. */
+const uint64_t wake_id = 1; /**< Poller ID of the wake pipe. */
+
+#ifdef MSG_NOSIGNAL
+const int send_flags = MSG_NOSIGNAL;  // A client leaving early must not kill the daemon with SIGPIPE
+#else
+const int send_flags = 0;  // SO_NOSIGPIPE is set on the sockets instead
+#endif
+
+/**
+ * @brief Describes the failure of the last system call.
+ */
+std::string system_error(const std::string& what) {
+    return what + ": " + std::strerror(errno) + " (RouteServer)";
+}
+
+/**
+ * @brief Makes a descriptor non-blocking and closed on exec.
+ */
+bool set_nonblocking(int fd) {
+    const int flags = fcntl(fd, F_GETFL, 0);
+    return flags >= 0 && fcntl(fd, F_SETFL, flags | O_NONBLOCK) == 0 && fcntl(fd, F_SETFD, FD_CLOEXEC) == 0;
+}
+
+void appendNumber(std::string& buffer, uint64_t value) {
+    char digits[20];
+    buffer.append(digits, std::to_chars(digits, digits + sizeof(digits), value).ptr);
+}
+
+/**
+ * @brief Appends text as a single field, turning tabs and line breaks into spaces.
+ */
+void appendField(std::string& buffer, std::string_view text) {
+    for (char c : text) {
+        buffer.push_back(c == '\t' || c == '\r' || c == '\n' ? ' ' : c);
+    }
+}
+
+/**
+ * @brief Removes surrounding spaces, tabs and carriage returns.
+ */
+std::string_view trim(std::string_view field) {
+    const size_t begin = field.find_first_not_of(" \t\r");
+    if (begin == std::string_view::npos) {
+        return std::string_view();
+    }
+    return field.substr(begin, field.find_last_not_of(" \t\r") - begin + 1);
+}
+
+/**
+ * @brief Resolves a route field to station IDs: the ID itself, or every platform of the named station.
+ */
+std::vector<uint64_t> resolve(const MetroNetworkParser& parser, std::string_view field) {
+    uint64_t id = 0;
+    if (CsvReader::parse_unsigned(field, id)) {
+        return {id};
+    }
+    return parser.get_stop_area(field);
+}
+
+} // namespace
+
+/**
+ * @brief Readiness notifications of the sockets: epoll on Linux, poll elsewhere. Level-triggered.
+ */
+class RouteServer::Poller {
+public:
+    /**
+     * @brief What a socket is ready for.
+     */
+    struct Event {
+        uint64_t id;  /**< The ID the socket was registered with. */
+        bool readable;  /**< Data or end of file can be read. */
+        bool writable;  /**< Data can be written. */
+        bool hangup;  /**< The client is gone in both directions, or the socket failed. */
+    };
+
+#ifdef __linux__
+    Poller() : fd(epoll_create1(EPOLL_CLOEXEC)) {
+        if (fd < 0) {
+            throw std::runtime_error(system_error("Cannot create the epoll instance"));
+        }
+    }
+
+    ~Poller() {
+        ::close(fd);
+    }
+
+    void watch(int socket, uint64_t id, bool read, bool write, bool registered) {
+        epoll_event event{};
+        event.events = (read ? uint32_t(EPOLLIN) : 0u) | (write ? uint32_t(EPOLLOUT) : 0u);
+        event.data.u64 = id;
+        if (epoll_ctl(fd, registered ? EPOLL_CTL_MOD : EPOLL_CTL_ADD, socket, &event) != 0) {
+            throw std::runtime_error(system_error("Cannot watch a socket"));
+        }
+    }
+
+    void remove(int socket) {
+        epoll_ctl(fd, EPOLL_CTL_DEL, socket, nullptr);
+    }
+
+    void wait(std::vector<Event>& events) {
+        epoll_event ready[256];
+        const int count = epoll_wait(fd, ready, 256, -1);
+        events.clear();
+        if (count < 0 && errno != EINTR) {
+            throw std::runtime_error(system_error("Cannot wait for the sockets"));
+        }
+        for (int i = 0; i < count; ++i) {
+            const uint32_t flags = ready[i].events;
+            events.push_back(Event{ready[i].data.u64, (flags & EPOLLIN) != 0, (flags & EPOLLOUT) != 0, (flags & (EPOLLHUP | EPOLLERR)) != 0});
+        }
+    }
+
+private:
+    int fd; /**< The epoll instance. */
+#else
+    void watch(int socket, uint64_t id, bool read, bool write, bool registered) {
+        size_t i = registered ? index_of(socket) : fds.size();
+        if (i == fds.size()) {
+            fds.push_back(pollfd{socket, 0, 0});
+            ids.push_back(id);
+        }
+        fds[i].events = static_cast<short>((read ? POLLIN : 0) | (write ? POLLOUT : 0));
+    }
+
+    void remove(int socket) {
+        size_t i = index_of(socket);
+        if (i < fds.size()) {
+            fds[i] = fds.back();
+            ids[i] = ids.back();
+            fds.pop_back();
+            ids.pop_back();
+        }
+    }
+
+    void wait(std::vector<Event>& events) {
+        const int count = ::poll(fds.data(), fds.size(), -1);
+        events.clear();
+        if (count < 0 && errno != EINTR) {
+            throw std::runtime_error(system_error("Cannot wait for the sockets"));
+        }
+        for (size_t i = 0; count > 0 && i < fds.size(); ++i) {
+            const short flags = fds[i].revents;
+            if (flags) {
+                events.push_back(Event{ids[i], (flags & POLLIN) != 0, (flags & POLLOUT) != 0, (flags & (POLLHUP | POLLERR | POLLNVAL)) != 0});
+            }
+        }
+    }
+
+private:
+    size_t index_of(int socket) const {
+        size_t i = 0;
+        while (i < fds.size() && fds[i].fd != socket) {
+            ++i;
+        }
+        return i;
+    }
+
+    std::vector<pollfd> fds; /**< The watched sockets. */
+    std::vector<uint64_t> ids; /**< The ID of each watched socket. */
+#endif
+};
+
+/**
+ * @brief Binds the listening socket.
+ *
+ * A port number listens on 127.0.0.1 only. A Unix socket file left by a previous run is replaced.
+ *
+ * @param parser The network, queried concurrently by the workers; it must outlive the server.
+ * @param options The address and the limits of the server.
+ * @throws std::runtime_error if the address is invalid or cannot be bound.
+ */
+RouteServer::RouteServer(const MetroNetworkParser& parser, const ServerOptions& options)
+    : parser(parser), options(options), poller(new Poller()) {
+    if (this->options.batch_size == 0) {
+        this->options.batch_size = 1;
+    }
+    auto fail = [this](const std::string& what) {
+        std::string error = system_error(what);
+        for (int fd : {listener, wake_read, wake_write}) {
+            if (fd >= 0) {
+                ::close(fd);
+            }
+        }
+        if (!socket_path.empty()) {
+            ::unlink(socket_path.c_str());
+        }
+        throw std::runtime_error(error);
+    };
+
+    uint64_t port = 0;
+    if (CsvReader::parse_unsigned(options.address, port)) {
+        if (port == 0 || port > 65535) {
+            throw std::runtime_error("Invalid port: " + options.address + " (RouteServer)");
+        }
+        sockaddr_in address{};
+        address.sin_family = AF_INET;
+        address.sin_port = htons(static_cast<uint16_t>(port));
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        listener = ::socket(AF_INET, SOCK_STREAM, 0);
+        const int one = 1;
+        if (listener < 0 || setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one)) != 0 ||
+            ::bind(listener, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0) {
+            fail("Cannot bind 127.0.0.1:" + options.address);
+        }
+    } else {
+        sockaddr_un address{};
+        if (options.address.empty() || options.address.size() >= sizeof(address.sun_path)) {
+            throw std::runtime_error("Invalid socket path: " + options.address + " (RouteServer)");
+        }
+        address.sun_family = AF_UNIX;
+        std::memcpy(address.sun_path, options.address.c_str(), options.address.size() + 1);
+        struct stat info;
+        if (::stat(options.address.c_str(), &info) == 0 && S_ISSOCK(info.st_mode)) {
+            ::unlink(options.address.c_str());
+        }
+        listener = ::socket(AF_UNIX, SOCK_STREAM, 0);
+        if (listener < 0 || ::bind(listener, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0) {
+            fail("Cannot bind " + options.address);
+        }
+        socket_path = options.address;
+    }
+    int pipe_fds[2];
+    if (::listen(listener, SOMAXCONN) != 0 || !set_nonblocking(listener)) {
+        fail("Cannot listen on " + options.address);
+    }
+    if (::pipe(pipe_fds) != 0) {
+        fail("Cannot create the wake pipe");
+    }
+    wake_read = pipe_fds[0];
+    wake_write = pipe_fds[1];
+    if (!set_nonblocking(wake_read) || !set_nonblocking(wake_write)) {
+        fail("Cannot create the wake pipe");
+    }
+    poller->watch(listener, listener_id, true, false, false);
+    poller->watch(wake_read, wake_id, true, false, false);
+}
+
+/**
+ * @brief Closes the sockets and removes the Unix socket file.
+ */
+RouteServer::~RouteServer() {
+    for (auto& connection : connections) {
+        ::close(connection.second.fd);
+    }
+    ::close(listener);
+    ::close(wake_read);
+    ::close(wake_write);
+    if (!socket_path.empty()) {
+        ::unlink(socket_path.c_str());
+    }
+}
+
+/**
+ * @brief Serves requests until stop is called.
+ *
+ * Starts the workers, then loops on the poller. Readable and writable sockets are read and written
+ * until they would block; a byte on the wake pipe means tasks came back from the workers, whose
+ * responses are written at once. After every event the connection queues its next task if it is idle.
+ *
+ * @return The counts of the run.
+ * @throws std::runtime_error if the event loop fails.
+ */
+ServerStats RouteServer::run() {
+    ServerStats stats;
+    worker_count = options.threads ? options.threads : std::max(1u, std::thread::hardware_concurrency());
+    workers_stopping = false;
+    for (size_t i = 0; i < worker_count; ++i) {
+        workers.emplace_back(&RouteServer::work, this);
+    }
+
+    std::exception_ptr failure;
+    try {
+        std::vector<Poller::Event> events;
+        std::vector<Task> done;
+        while (!stopping.load()) {
+            poller->wait(events);
+            for (const Poller::Event& event : events) {
+                if (event.id == listener_id) {
+                    accept_connections(stats);
+                    continue;
+                }
+                if (event.id == wake_id) {
+                    // Drain the pipe before taking the tasks, so that a task finished meanwhile wakes the loop again
+                    char bytes[64];
+                    while (::read(wake_read, bytes, sizeof(bytes)) > 0) {
+                    }
+                    {
+                        std::lock_guard<std::mutex> lock(queue_mutex);
+                        done.swap(finished);
+                    }
+                    for (Task& task : done) {
+                        ++stats.batches;
+                        stats.requests += task.requests;
+                        stats.errors += task.errors;
+                        auto it = connections.find(task.connection);
+                        if (it == connections.end()) {
+                            continue;  // The client left before its responses were ready
+                        }
+                        it->second.busy = false;
+                        it->second.output.append(task.output);
+                        if (write_output(it->second)) {
+                            dispatch(task.connection, it->second);
+                        } else {
+                            close_connection(task.connection);
+                        }
+                    }
+                    done.clear();
+                    continue;
+                }
+                auto it = connections.find(event.id);
+                if (it == connections.end()) {
+                    continue;
+                }
+                Connection& connection = it->second;
+                if (event.hangup || (event.readable && !read_input(connection)) || (event.writable && !write_output(connection))) {
+                    close_connection(event.id);
+                } else {
+                    dispatch(event.id, connection);
+                }
+            }
+        }
+    } catch (...) {
+        failure = std::current_exception();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(queue_mutex);
+        workers_stopping = true;
+    }
+    queue_ready.notify_all();
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+    workers.clear();
+    queue.clear();
+    finished.clear();
+    while (!connections.empty()) {
+        close_connection(connections.begin()->first);
+    }
+    if (failure) {
+        std::rethrow_exception(failure);
+    }
+    return stats;
+}
+
+/**
+ * @brief Makes run return, closing every connection. Safe to call from a signal handler.
+ */
+void RouteServer::stop() {
+    stopping.store(true);
+    const char byte = 0;
+    ssize_t written = ::write(wake_write, &byte, 1);
+    (void)written;  // A full pipe already wakes the loop
+}
+
+/**
+ * @brief Answers one request line.
+ *
+ * @param parser The network queried.
+ * @param request The request, without its line break.
+ * @param response Receives the response line, line break included.
+ * @return False if the response is an error.
+ */
+bool RouteServer::respond(const MetroNetworkParser& parser, std::string_view request, std::string& response) {
+    const size_t mark = response.size();
+    request = trim(request);
+    const size_t space = request.find(' ');
+    const std::string_view command = request.substr(0, space);
+    const std::string_view argument = space == std::string_view::npos ? std::string_view() : trim(request.substr(space + 1));
+    try {
+        if (command == "route") {
+            const size_t comma = argument.find(',');
+            const std::string_view start = trim(argument.substr(0, comma));
+            const std::string_view end = comma == std::string_view::npos ? std::string_view() : trim(argument.substr(comma + 1));
+            if (start.empty() || end.empty()) {
+                throw std::runtime_error("expected route <start>,<end>");
+            }
+            // The route is written into a buffer of the worker, which stops growing after the longest one.
+            static thread_local std::vector<uint64_t> stations;
+            uint64_t start_id = 0, end_id = 0, duration = 0;
+            size_t count = 0;
+            if (CsvReader::parse_unsigned(start, start_id) && CsvReader::parse_unsigned(end, end_id)) {
+                JourneyResult result = parser.plan_journey(start_id, end_id, stations.data(), stations.size());
+                if (result.stations > stations.size()) {
+                    stations.resize(result.stations);
+                    result = parser.plan_journey(start_id, end_id, stations.data(), stations.size());
+                }
+                duration = result.duration;
+                count = result.stations;
+            } else {
+                const std::vector<uint64_t> starts = resolve(parser, start);
+                const std::vector<uint64_t> ends = resolve(parser, end);
+                const Journey journey = parser.plan_journey(starts, ends);
+                // A route of no connection starts on a platform shared by both stations.
+                start_id = starts.front();
+                for (uint64_t id : starts) {
+                    if (std::find(ends.begin(), ends.end(), id) != ends.end()) {
+                        start_id = id;
+                        break;
+                    }
+                }
+                duration = journey.duration;
+                count = journey.segments.size() + 1;
+                stations.resize(std::max(stations.size(), count));
+                stations[0] = journey.segments.empty() ? start_id : journey.segments.front().first;
+                for (size_t i = 0; i < journey.segments.size(); ++i) {
+                    stations[i + 1] = journey.segments[i].second;
+                }
+            }
+            if (duration == std::numeric_limits<uint64_t>::max()) {
+                response.append("unreachable");
+            } else {
+                response.append("ok ");
+                appendNumber(response, duration);
+                for (size_t i = 0; i < count; ++i) {
+                    response.push_back(' ');
+                    appendNumber(response, stations[i]);
+                }
+            }
+        } else if (command == "area" && !argument.empty()) {
+            response.append("ok");
+            for (uint64_t id : parser.get_stop_area(argument)) {
+                response.push_back(' ');
+                appendNumber(response, id);
+            }
+        } else if (command == "search" && !argument.empty()) {
+            response.append("ok");
+            for (const auto& match : parser.searchStations(std::string(argument))) {
+                response.push_back('\t');
+                appendField(response, match.first);
+                response.push_back('\t');
+                appendField(response, match.second);
+            }
+        } else if (command == "ping" && argument.empty()) {
+            response.append("ok");
+        } else {
+            throw std::runtime_error("unknown request, expected route, area, search or ping");
+        }
+    } catch (const std::exception& e) {
+        response.resize(mark);
+        response.append("error ");
+        appendField(response, e.what());
+        response.push_back('\n');
+        return false;
+    }
+    response.push_back('\n');
+    return true;
+}
+
+/**
+ * @brief Main loop of a worker thread.
+ *
+ * Takes its share of the queued tasks, answers every line of them and hands them back to the event
+ * loop. The pipe is only written when the loop has nothing to pick up yet: otherwise a wake-up is
+ * already on its way and will find these tasks too.
+ */
+void RouteServer::work() {
+    std::vector<Task> tasks;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(queue_mutex);
+            queue_ready.wait(lock, [&] { return workers_stopping || !queue.empty(); });
+            if (workers_stopping) {
+                return;
+            }
+            for (size_t share = std::max<size_t>(1, queue.size() / worker_count); share > 0; --share) {
+                tasks.push_back(std::move(queue.front()));
+                queue.pop_front();
+            }
+        }
+        for (Task& task : tasks) {
+            for (size_t begin = 0; begin < task.input.size();) {
+                const size_t end = task.input.find('\n', begin);
+                ++task.requests;
+                if (!respond(parser, std::string_view(task.input).substr(begin, end - begin), task.output)) {
+                    ++task.errors;
+                }
+                begin = end + 1;
+            }
+        }
+        bool wake = false;
+        {
+            std::lock_guard<std::mutex> lock(queue_mutex);
+            wake = finished.empty();
+            for (Task& task : tasks) {
+                finished.push_back(std::move(task));
+            }
+        }
+        tasks.clear();
+        if (wake) {
+            const char byte = 0;
+            ssize_t written = ::write(wake_write, &byte, 1);
+            (void)written;  // A full pipe already wakes the loop
+        }
+    }
+}
+
+/**
+ * @brief Accepts every pending connection.
+ *
+ * @param stats The counts of the run.
+ */
+void RouteServer::accept_connections(ServerStats& stats) {
+    while (true) {
+        const int fd = ::accept(listener, nullptr, nullptr);
+        if (fd < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return;  // Nothing left, or out of descriptors until a connection closes
+        }
+        const int one = 1;
+        if (!set_nonblocking(fd)) {
+            ::close(fd);
+            continue;
+        }
+#ifdef SO_NOSIGPIPE
+        setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &one, sizeof(one));
+#endif
+        if (socket_path.empty()) {
+            // Responses are small and pipelined clients wait for them; do not hold them back
+            setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        }
+        const uint64_t id = next_connection++;
+        connections[id].fd = fd;
+        poller->watch(fd, id, true, false, false);
+        ++stats.connections;
+    }
+}
+
+/**
+ * @brief Reads what a connection sent, until the socket would block.
+ *
+ * Stops early once max_pending bytes wait, so that a client sending faster than it is answered
+ * is read no further than that.
+ *
+ * @param connection The connection.
+ * @return False if the socket failed.
+ */
+bool RouteServer::read_input(Connection& connection) {
+    char chunk[16384];
+    while (!connection.eof && connection.input.size() < options.max_pending) {
+        const ssize_t count = ::read(connection.fd, chunk, sizeof(chunk));
+        if (count > 0) {
+            connection.input.append(chunk, static_cast<size_t>(count));
+        } else if (count == 0) {
+            connection.eof = true;
+        } else if (errno != EINTR) {
+            return errno == EAGAIN || errno == EWOULDBLOCK;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Writes the pending responses of a connection, until the socket would block.
+ *
+ * @param connection The connection.
+ * @return False if the socket failed.
+ */
+bool RouteServer::write_output(Connection& connection) {
+    while (connection.sent < connection.output.size()) {
+        const ssize_t count = ::send(connection.fd, connection.output.data() + connection.sent,
+                                     connection.output.size() - connection.sent, send_flags);
+        if (count > 0) {
+            connection.sent += static_cast<size_t>(count);
+        } else if (count < 0 && errno == EINTR) {
+            continue;
+        } else if (count < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            break;
+        } else {
+            return false;
+        }
+    }
+    if (connection.sent == connection.output.size()) {
+        connection.output.clear();
+        connection.sent = 0;
+    } else if (connection.sent > connection.output.size() / 2) {
+        connection.output.erase(0, connection.sent);
+        connection.sent = 0;
+    }
+    return true;
+}
+
+/**
+ * @brief Queues the complete lines of an idle connection, then closes it or updates what the poller watches.
+ *
+ * A connection is closed once its client closed its side and every request is answered and written,
+ * or when it sends a line longer than max_line. A last line without a line break is a request too.
+ *
+ * @param id The ID of the connection.
+ * @param connection The connection.
+ * @return False if the connection was closed.
+ */
+bool RouteServer::dispatch(uint64_t id, Connection& connection) {
+    if (!connection.busy) {
+        if (connection.eof && !connection.input.empty() && connection.input.back() != '\n') {
+            connection.input.push_back('\n');
+        }
+        size_t end = 0, lines = 0;
+        for (size_t found; lines < options.batch_size && (found = connection.input.find('\n', end)) != std::string::npos; end = found + 1) {
+            ++lines;
+        }
+        if (lines > 0) {
+            Task task;
+            task.connection = id;
+            task.input.assign(connection.input, 0, end);
+            connection.input.erase(0, end);
+            connection.busy = true;
+            {
+                std::lock_guard<std::mutex> lock(queue_mutex);
+                queue.push_back(std::move(task));
+            }
+            queue_ready.notify_one();
+        }
+    }
+
+    const size_t pending = connection.output.size() - connection.sent;
+    if ((connection.input.size() > options.max_line && connection.input.find('\n') == std::string::npos) ||
+        (connection.eof && !connection.busy && pending == 0 && connection.input.empty())) {
+        close_connection(id);
+        return false;
+    }
+    const bool reading = !connection.eof && pending < options.max_pending && connection.input.size() < options.max_pending;
+    const bool writing = pending > 0;
+    if (reading != connection.reading || writing != connection.writing) {
+        connection.reading = reading;
+        connection.writing = writing;
+        poller->watch(connection.fd, id, reading, writing, true);
+    }
+    return true;
+}
+
+/**
+ * @brief Closes a connection and forgets it.
+ *
+ * @param id The ID of the connection.
+ */
+void RouteServer::close_connection(uint64_t id) {
+    auto it = connections.find(id);
+    if (it != connections.end()) {
+        poller->remove(it->second.fd);
+        ::close(it->second.fd);
+        connections.erase(it);
+    }
+}
+
+} // namespace travel
@@ -0,0 +1,197 @@
+/**
+ * @file RouteServer.hpp
+ * @brief Contains the declaration of the RouteServer class.
+ */
+
+#pragma once
+#ifndef ROUTE_SERVER_HPP
+#define ROUTE_SERVER_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace travel {
+    class MetroNetworkParser;  // Forward declaration
+
+    /**
+     * @brief Settings of a routing daemon.
+     */
+    struct ServerOptions {
+        std::string address; /**< A Unix socket path, or a TCP port number to listen on 127.0.0.1. */
+        size_t threads = 0; /**< Query workers, 0 for one per hardware thread. */
+        size_t batch_size = 64; /**< Pipelined requests of a connection handed to a worker at once. */
+        size_t max_pending = 1 << 20; /**< Unsent response bytes after which a connection is not read any more. */
+        size_t max_line = 1 << 16; /**< Longest request line; a connection sending a longer one is closed. */
+    };
+
+    /**
+     * @brief Counts of a daemon run.
+     */
+    struct ServerStats {
+        uint64_t connections = 0; /**< Connections accepted. */
+        uint64_t requests = 0; /**< Request lines answered. */
+        uint64_t errors = 0; /**< Requests answered with an error. */
+        uint64_t batches = 0; /**< Worker tasks, each holding the pipelined requests of one connection. */
+    };
+
+    /**
+     * @class RouteServer
+     * @brief Long-lived routing daemon answering a line protocol over a Unix or loopback socket.
+     *
+     * Each request is one line and gets exactly one response line, in order, so a client can
+     * pipeline as many requests as it likes before reading:
+     *
+     *     route <start>,<end>   ok <duration> <station ID>...   |   unreachable
+     *     area <name>           ok <station ID>...
+     *     search <text>         ok<TAB><name><TAB><line>...
+     *     ping                  ok
+     *
+     * Anything that fails is answered with "error <message>". Like in batch mode, a route field made of
+     * digits is a station ID and anything else a station name standing for all its platforms.
+     *
+     * One thread runs the event loop (epoll on Linux, poll elsewhere) on non-blocking sockets: it reads
+     * whatever has arrived, cuts the complete lines of a connection into a task of up to batch_size
+     * requests and queues it for the workers. A connection has at most one task in flight, which keeps
+     * its responses in order without sequence numbers; the lines arriving meanwhile wait in its buffer
+     * and make the next, larger task. Workers take their share of the queued tasks under one lock,
+     * answer them with the thread-safe queries of the parser and hand them back together through a pipe
+     * that wakes the event loop, which appends the responses to the output buffers and writes them with
+     * as few calls as possible. A connection whose client does not read its responses stops being read.
+     */
+    class RouteServer {
+    public:
+        /**
+         * @brief Binds the listening socket.
+         * @param parser The network, queried concurrently by the workers; it must outlive the server.
+         * @param options The address and the limits of the server.
+         * @throws std::runtime_error if the address is invalid or cannot be bound.
+         */
+        RouteServer(const MetroNetworkParser& parser, const ServerOptions& options);
+
+        /**
+         * @brief Closes the sockets and removes the Unix socket file.
+         */
+        ~RouteServer();
+
+        RouteServer(const RouteServer&) = delete;
+        RouteServer& operator=(const RouteServer&) = delete;
+
+        /**
+         * @brief Serves requests until stop is called.
+         * @return The counts of the run.
+         * @throws std::runtime_error if the event loop fails.
+         */
+        ServerStats run();
+
+        /**
+         * @brief Makes run return, closing every connection. Safe to call from a signal handler.
+         */
+        void stop();
+
+        /**
+         * @brief Answers one request line.
+         * @param parser The network queried.
+         * @param request The request, without its line break.
+         * @param response Receives the response line, line break included.
+         * @return False if the response is an error.
+         */
+        static bool respond(const MetroNetworkParser& parser, std::string_view request, std::string& response);
+
+    private:
+        class Poller;  // Defined in RouteServer.cpp
+
+        /**
+         * @brief A client socket and its buffers.
+         */
+        struct Connection {
+            int fd = -1; /**< The socket. */
+            std::string input; /**< Bytes read and not handed to a worker yet. */
+            std::string output; /**< Response bytes not written yet, from `sent` on. */
+            size_t sent = 0; /**< Bytes of output already written. */
+            bool busy = false; /**< Whether a task of the connection is in flight. */
+            bool eof = false; /**< Whether the client closed its side. */
+            bool reading = true; /**< Whether the poller watches the socket for reads. */
+            bool writing = false; /**< Whether the poller watches the socket for writes. */
+        };
+
+        /**
+         * @brief The pipelined requests of a connection, as solved by a worker.
+         */
+        struct Task {
+            uint64_t connection = 0; /**< The ID of the connection. */
+            std::string input; /**< Complete request lines. */
+            std::string output; /**< Their response lines. */
+            uint32_t requests = 0; /**< Requests answered. */
+            uint32_t errors = 0; /**< Requests answered with an error. */
+        };
+
+        /**
+         * @brief Main loop of a worker thread.
+         */
+        void work();
+
+        /**
+         * @brief Accepts every pending connection.
+         * @param stats The counts of the run.
+         */
+        void accept_connections(ServerStats& stats);
+
+        /**
+         * @brief Reads what a connection sent, until the socket would block.
+         * @param connection The connection.
+         * @return False if the socket failed.
+         */
+        bool read_input(Connection& connection);
+
+        /**
+         * @brief Writes the pending responses of a connection, until the socket would block.
+         * @param connection The connection.
+         * @return False if the socket failed.
+         */
+        bool write_output(Connection& connection);
+
+        /**
+         * @brief Queues the complete lines of an idle connection, then closes it or updates what the poller watches.
+         * @param id The ID of the connection.
+         * @param connection The connection.
+         * @return False if the connection was closed.
+         */
+        bool dispatch(uint64_t id, Connection& connection);
+
+        /**
+         * @brief Closes a connection and forgets it.
+         * @param id The ID of the connection.
+         */
+        void close_connection(uint64_t id);
+
+        const MetroNetworkParser& parser; /**< The network queried. */
+        ServerOptions options; /**< The settings of the server. */
+        std::string socket_path; /**< The Unix socket file to remove, empty for TCP. */
+        int listener = -1; /**< The listening socket. */
+        int wake_read = -1; /**< Read end of the pipe waking the event loop. */
+        int wake_write = -1; /**< Write end of the pipe waking the event loop. */
+        std::unique_ptr<Poller> poller; /**< Readiness notifications of the sockets. */
+        std::unordered_map<uint64_t, Connection> connections; /**< The open connections, by ID. */
+        uint64_t next_connection = 2; /**< ID of the next connection; 0 and 1 are the listener and the pipe. */
+        std::atomic<bool> stopping{false}; /**< Set by stop. */
+
+        std::vector<std::thread> workers; /**< The query workers. */
+        std::mutex queue_mutex; /**< Protects the fields below. */
+        std::condition_variable queue_ready; /**< Signals workers that tasks were queued or the server stops. */
+        std::deque<Task> queue; /**< Tasks waiting for a worker. */
+        std::vector<Task> finished; /**< Tasks answered and not picked up by the event loop yet. */
+        size_t worker_count = 1; /**< The number of workers, fixed before they start. */
+        bool workers_stopping = false; /**< Tells the workers to exit. */
+    };
+}
+
+#endif // ROUTE_SERVER_HPP
@@ -0,0 +1,303 @@
+/**
+ * @file ShardedCache.hpp
+ * @brief Contains the ShardedCache class template and its statistics.
+ */
+
+#pragma once
+#ifndef SHARDED_CACHE_HPP
+#define SHARDED_CACHE_HPP
+
+#include <list>
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <cstdint>
+#include <utility>
+#include <algorithm>
+#include <functional>
+#include <unordered_map>
+
+namespace travel {
+
+    /**
+     * @brief Counters of a ShardedCache, summed over its shards.
+     */
+    struct CacheStats {
+        uint64_t hits = 0;        /**< Lookups that found a value. */
+        uint64_t misses = 0;      /**< Lookups that found nothing. */
+        uint64_t insertions = 0;  /**< Values stored. */
+        uint64_t evictions = 0;   /**< Values dropped to stay within the budget. */
+        uint64_t rejections = 0;  /**< Values not admitted because they were less popular than the eviction victim. */
+        size_t entries = 0;       /**< Values currently stored. */
+        size_t bytes = 0;         /**< Estimated memory of the stored values. */
+        size_t budget = 0;        /**< Memory budget, 0 when the cache is disabled. */
+        uint64_t epoch = 0;       /**< The current epoch. */
+    };
+
+    /**
+     * @class ShardedCache
+     * @brief Concurrent LRU cache with TinyLFU admission, a memory budget and epoch invalidation.
+     *
+     * Keys are spread over independently locked shards, so threads hitting different keys rarely
+     * contend. Each shard keeps its entries in LRU order and a count-min sketch of how often each key
+     * was looked up, halved periodically so popularity fades. When storing a value would exceed the
+     * shard's share of the budget, it is only admitted if its key was requested more often than the
+     * least recently used entry it would evict; one-off queries therefore cannot flush hot entries.
+     *
+     * Every value belongs to an epoch. advance_epoch() drops everything, or only the values a predicate
+     * rejects, and values computed in an older epoch are neither returned nor stored, so a result
+     * computed on a network that was swapped out meanwhile never reaches the cache. Each shard moves
+     * to the new epoch once it has been filtered, so a caller already on the new epoch never sees a
+     * value the predicate has not checked yet.
+     *
+     * Values are copied in and out under the shard lock: use shared pointers for large values.
+     */
+    template <typename Key, typename Value, typename Hash = std::hash<Key>>
+    class ShardedCache {
+    public:
+        /**
+         * @brief Constructs a cache.
+         * @param budget The memory budget in bytes, 0 to disable the cache.
+         * @param shard_count The number of independently locked shards, rounded up to a power of two.
+         */
+        explicit ShardedCache(size_t budget = 0, size_t shard_count = 16) {
+            size_t count = 1;
+            while (count < shard_count) {
+                count *= 2;
+            }
+            shards.reserve(count);
+            for (size_t i = 0; i < count; ++i) {
+                shards.emplace_back(new Shard());
+            }
+            set_budget(budget);
+        }
+
+        /**
+         * @brief Changes the memory budget, evicting entries if needed.
+         * @param budget The memory budget in bytes, 0 to disable the cache.
+         */
+        void set_budget(size_t budget) {
+            total_budget.store(budget, std::memory_order_relaxed);
+            for (auto& shard : shards) {
+                std::lock_guard<std::mutex> lock(shard->mutex);
+                shard->budget = budget / shards.size();
+                shard->shrink();
+            }
+        }
+
+        /**
+         * @brief Gets the memory budget.
+         * @return The budget in bytes, 0 when the cache is disabled.
+         */
+        size_t budget() const { return total_budget.load(std::memory_order_relaxed); }
+
+        /**
+         * @brief Gets the largest cost a value can have and still be stored: the budget of one shard.
+         * @return The cost in bytes.
+         */
+        size_t max_cost() const { return total_budget.load(std::memory_order_relaxed) / shards.size(); }
+
+        /**
+         * @brief Looks a key up and records the request in the popularity sketch.
+         * @param key The key.
+         * @param value Receives the value if found.
+         * @param epoch The epoch of the caller's network; nothing is found for an old epoch.
+         * @return True on a hit.
+         */
+        bool find(const Key& key, Value& value, uint64_t epoch) {
+            size_t hash = Hash()(key);
+            Shard& shard = shard_of(hash);
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            shard.record(hash);
+            auto it = shard.index.find(key);
+            if (it == shard.index.end() || epoch != shard.epoch) {
+                ++shard.misses;
+                return false;
+            }
+            shard.entries.splice(shard.entries.begin(), shard.entries, it->second);
+            value = it->second->value;
+            ++shard.hits;
+            return true;
+        }
+
+        /**
+         * @brief Estimates how often a key was requested recently, without recording a request.
+         * @param key The key.
+         * @return The estimated number of recent find() calls for the key, at most 255.
+         */
+        uint32_t frequency(const Key& key) {
+            size_t hash = Hash()(key);
+            Shard& shard = shard_of(hash);
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            return shard.frequency(hash);
+        }
+
+        /**
+         * @brief Stores a value, if admitted, as the most recently used entry.
+         * @param key The key.
+         * @param value The value.
+         * @param cost The estimated memory of the value in bytes.
+         * @param epoch The epoch of the network the value was computed on; ignored if not current.
+         */
+        void insert(const Key& key, const Value& value, size_t cost, uint64_t epoch) {
+            size_t hash = Hash()(key);
+            Shard& shard = shard_of(hash);
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            cost += sizeof(Entry) + 4 * sizeof(void*); // List node and hash map node
+            if (epoch != shard.epoch || cost > shard.budget) {
+                return;
+            }
+            auto it = shard.index.find(key);
+            if (it != shard.index.end()) {
+                shard.bytes -= it->second->cost;
+                shard.entries.erase(it->second);
+                shard.index.erase(it);
+            } else if (shard.bytes + cost > shard.budget && !shard.entries.empty() &&
+                       shard.frequency(hash) <= shard.frequency(Hash()(shard.entries.back().key))) {
+                ++shard.rejections;
+                return;
+            }
+            shard.entries.push_front(Entry{key, value, cost});
+            shard.index[key] = shard.entries.begin();
+            shard.bytes += cost;
+            ++shard.insertions;
+            shard.shrink();
+        }
+
+        /**
+         * @brief Moves to a new epoch and drops every entry.
+         * @param epoch The new epoch.
+         */
+        void advance_epoch(uint64_t epoch) {
+            advance_epoch(epoch, [](const Key&, const Value&) { return false; });
+        }
+
+        /**
+         * @brief Moves to a new epoch, keeping only the entries still valid in it.
+         * @param epoch The new epoch.
+         * @param keep Called as keep(key, value) on every entry, under the shard lock; false drops it.
+         */
+        template <typename Keep>
+        void advance_epoch(uint64_t epoch, Keep keep) {
+            current_epoch.store(epoch, std::memory_order_release);
+            for (auto& shard : shards) {
+                std::lock_guard<std::mutex> lock(shard->mutex);
+                for (auto it = shard->entries.begin(); it != shard->entries.end();) {
+                    if (keep(it->key, it->value)) {
+                        ++it;
+                        continue;
+                    }
+                    shard->bytes -= it->cost;
+                    shard->index.erase(it->key);
+                    it = shard->entries.erase(it);
+                }
+                shard->epoch = epoch;
+            }
+        }
+
+        /**
+         * @brief Gets the counters summed over the shards.
+         * @return The statistics.
+         */
+        CacheStats stats() const {
+            CacheStats total;
+            for (const auto& shard : shards) {
+                std::lock_guard<std::mutex> lock(shard->mutex);
+                total.hits += shard->hits;
+                total.misses += shard->misses;
+                total.insertions += shard->insertions;
+                total.evictions += shard->evictions;
+                total.rejections += shard->rejections;
+                total.entries += shard->entries.size();
+                total.bytes += shard->bytes;
+            }
+            total.budget = total_budget.load(std::memory_order_relaxed);
+            total.epoch = current_epoch.load(std::memory_order_acquire);
+            return total;
+        }
+
+    private:
+        /**
+         * @brief A stored value.
+         */
+        struct Entry {
+            Key key;
+            Value value;
+            size_t cost;
+        };
+
+        /**
+         * @brief An independently locked part of the cache.
+         */
+        struct Shard {
+            static constexpr size_t sketch_width = 1024; /**< Counters per sketch row, a power of two. */
+
+            std::mutex mutex;
+            std::list<Entry> entries; /**< Most recently used first. */
+            std::unordered_map<Key, typename std::list<Entry>::iterator, Hash> index;
+            std::vector<uint8_t> sketch = std::vector<uint8_t>(4 * sketch_width, 0); /**< Count-min sketch, 4 rows. */
+            size_t samples = 0; /**< Requests recorded since the sketch was last halved. */
+            uint64_t epoch = 0; /**< Epoch of the stored values. */
+            size_t budget = 0;
+            size_t bytes = 0;
+            uint64_t hits = 0;
+            uint64_t misses = 0;
+            uint64_t insertions = 0;
+            uint64_t evictions = 0;
+            uint64_t rejections = 0;
+
+            /** @brief Gets the sketch counter of a hash in a row. */
+            uint8_t& counter(size_t hash, size_t row) {
+                static const uint64_t seeds[4] = {0x9E3779B97F4A7C15ull, 0xC2B2AE3D27D4EB4Full, 0x165667B19E3779F9ull, 0xD6E8FEB86659FD93ull};
+                return sketch[row * sketch_width + ((uint64_t(hash) * seeds[row]) >> 52) % sketch_width];
+            }
+
+            /** @brief Counts a request, halving every counter once enough requests were seen. */
+            void record(size_t hash) {
+                for (size_t row = 0; row < 4; ++row) {
+                    uint8_t& count = counter(hash, row);
+                    if (count < 255) {
+                        ++count;
+                    }
+                }
+                if (++samples >= 10 * sketch_width) {
+                    for (uint8_t& count : sketch) {
+                        count /= 2;
+                    }
+                    samples /= 2;
+                }
+            }
+
+            /** @brief Estimates the recent requests of a hash. */
+            uint32_t frequency(size_t hash) {
+                uint32_t estimate = 255;
+                for (size_t row = 0; row < 4; ++row) {
+                    estimate = std::min<uint32_t>(estimate, counter(hash, row));
+                }
+                return estimate;
+            }
+
+            /** @brief Evicts least recently used entries until the rest fits in the budget. */
+            void shrink() {
+                while (!entries.empty() && bytes > budget) {
+                    bytes -= entries.back().cost;
+                    index.erase(entries.back().key);
+                    entries.pop_back();
+                    ++evictions;
+                }
+            }
+        };
+
+        /** @brief Gets the shard of a hash. */
+        Shard& shard_of(size_t hash) {
+            return *shards[(hash ^ (hash >> 29)) & (shards.size() - 1)];
+        }
+
+        std::vector<std::unique_ptr<Shard>> shards; /**< The shards, a power of two. */
+        std::atomic<size_t> total_budget{0}; /**< Memory budget of the whole cache, read by queries without a lock. */
+        std::atomic<uint64_t> current_epoch{0}; /**< The latest epoch, which the shards reach once filtered. */
+    };
+}
+
+#endif // SHARDED_CACHE_HPP
@@ -0,0 +1,184 @@
+#include "Snapshot.hpp"
+
+#include <cstring>
+#include <fstream>
+
+namespace travel {
+
+const uint32_t Snapshot::version;
+
+namespace {
+
+const char magic[8] = {'M', 'E', 'T', 'R', 'O', 'S', 'N', 'P'};
+const uint32_t byte_order_marker = 0x01020304;
+const uint64_t section_alignment = 64;
+
+/**
+ * @brief The fixed-size header at the start of every snapshot.
+ */
+struct Header {
+    char magic[8];
+    uint32_t version;
+    uint32_t byte_order;
+    uint32_t section_count;
+    uint32_t reserved;
+    uint64_t file_size;
+    uint64_t checksum;
+    uint64_t padding;
+};
+
+/**
+ * @brief Rounds an offset up to the section alignment.
+ */
+uint64_t align(uint64_t offset) {
+    return (offset + section_alignment - 1) / section_alignment * section_alignment;
+}
+
+} // namespace
+
+/**
+ * @brief Writes the header, the section table and every registered section.
+ *
+ * The file is assembled in memory first so the checksum can be stored in the header.
+ *
+ * @param filename The path of the file to write.
+ * @throws std::runtime_error if the file cannot be written.
+ */
+void SnapshotWriter::write(const std::string& filename) const {
+    struct TableEntry { uint32_t tag; uint32_t element_size; uint64_t offset; uint64_t size; };
+
+    uint64_t offset = align(sizeof(Header) + sections.size() * sizeof(TableEntry));
+    std::vector<TableEntry> table;
+    for (const Pending& section : sections) {
+        table.push_back(TableEntry{section.tag, section.element_size, offset, section.size});
+        offset = align(offset + section.size);
+    }
+
+    std::vector<char> buffer(offset, 0);
+    std::memcpy(buffer.data() + sizeof(Header), table.data(), table.size() * sizeof(TableEntry));
+    for (size_t i = 0; i < sections.size(); ++i) {
+        if (sections[i].size > 0) {
+            std::memcpy(buffer.data() + table[i].offset, sections[i].data, sections[i].size);
+        }
+    }
+
+    Header header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, magic, sizeof(magic));
+    header.version = Snapshot::version;
+    header.byte_order = byte_order_marker;
+    header.section_count = static_cast<uint32_t>(sections.size());
+    header.file_size = buffer.size();
+    header.checksum = Snapshot::checksum(buffer.data() + sizeof(Header), buffer.size() - sizeof(Header));
+    std::memcpy(buffer.data(), &header, sizeof(header));
+
+    std::ofstream file(filename, std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) {
+        throw std::runtime_error("Error opening file: " + filename + " (SnapshotWriter::write)");
+    }
+    file.write(buffer.data(), buffer.size());
+    if (!file) {
+        throw std::runtime_error("Error writing file: " + filename + " (SnapshotWriter::write)");
+    }
+}
+
+/**
+ * @brief Maps and validates a snapshot file.
+ *
+ * @param filename The path of the snapshot.
+ * @param verify Whether to check the payload checksum.
+ * @throws std::runtime_error if the file is not a valid snapshot of this version.
+ */
+Snapshot::Snapshot(const std::string& filename, bool verify)
+: mapping(std::make_shared<const MappedFile>(filename)) {
+    const char* data = mapping->data();
+    Header header;
+    if (mapping->size() < sizeof(Header)) {
+        throw std::runtime_error("File too small to be a snapshot: " + filename);
+    }
+    std::memcpy(&header, data, sizeof(header));
+    if (std::memcmp(header.magic, magic, sizeof(magic)) != 0) {
+        throw std::runtime_error("Not a network snapshot: " + filename);
+    }
+    if (header.version != version) {
+        throw std::runtime_error("Unsupported snapshot version " + std::to_string(header.version) + ": " + filename);
+    }
+    if (header.byte_order != byte_order_marker) {
+        throw std::runtime_error("Snapshot written with another byte order: " + filename);
+    }
+    if (header.file_size != mapping->size() ||
+        sizeof(Header) + uint64_t(header.section_count) * sizeof(Entry) > header.file_size) {
+        throw std::runtime_error("Truncated snapshot: " + filename);
+    }
+    if (verify && checksum(data + sizeof(Header), mapping->size() - sizeof(Header)) != header.checksum) {
+        throw std::runtime_error("Snapshot checksum mismatch: " + filename);
+    }
+
+    entries = ArrayRef<Entry>(reinterpret_cast<const Entry*>(data + sizeof(Header)), header.section_count);
+    for (const Entry& entry : entries) {
+        if (entry.offset + entry.size > header.file_size || entry.offset % section_alignment != 0 ||
+            entry.element_size == 0 || entry.size % entry.element_size != 0) {
+            throw std::runtime_error("Corrupted snapshot section table: " + filename);
+        }
+    }
+}
+
+/**
+ * @brief Checks whether a section is present.
+ *
+ * @param tag The section identifier.
+ * @return True if the snapshot contains the section.
+ */
+bool Snapshot::has(SnapshotSection tag) const {
+    for (const Entry& entry : entries) {
+        if (entry.tag == static_cast<uint32_t>(tag)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Finds a section in the table.
+ *
+ * @param tag The section identifier.
+ * @return The table entry.
+ * @throws std::runtime_error if the section is missing.
+ */
+const Snapshot::Entry& Snapshot::find(SnapshotSection tag) const {
+    for (const Entry& entry : entries) {
+        if (entry.tag == static_cast<uint32_t>(tag)) {
+            return entry;
+        }
+    }
+    throw std::runtime_error("Snapshot section " + std::to_string(static_cast<uint32_t>(tag)) + " not found (Snapshot::find)");
+}
+
+/**
+ * @brief Computes the checksum stored in the header.
+ *
+ * Mixes eight bytes at a time (multiply-rotate), which runs at memory speed instead of the byte
+ * at a time of FNV, so verifying a snapshot stays cheap compared to parsing CSV.
+ *
+ * @param data The first byte.
+ * @param size The number of bytes.
+ * @return A 64-bit checksum of the bytes.
+ */
+uint64_t Snapshot::checksum(const char* data, size_t size) {
+    const uint64_t prime = 0x9E3779B185EBCA87ULL;
+    uint64_t hash = 0xCBF29CE484222325ULL ^ size;
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8) {
+        uint64_t word;
+        std::memcpy(&word, data + i, sizeof(word));
+        hash ^= word * prime;
+        hash = ((hash << 31) | (hash >> 33)) * prime;
+    }
+    for (; i < size; ++i) {
+        hash ^= static_cast<unsigned char>(data[i]);
+        hash *= prime;
+    }
+    return hash ^ (hash >> 29);
+}
+
+} // namespace travel
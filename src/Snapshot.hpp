@@ -0,0 +1,182 @@
+/**
+ * @file Snapshot.hpp
+ * @brief Contains the declaration of the binary network snapshot format.
+ */
+
+#pragma once
+#ifndef SNAPSHOT_HPP
+#define SNAPSHOT_HPP
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include <stdexcept>
+
+#include "ArrayRef.hpp"
+#include "MappedFile.hpp"
+
+namespace travel {
+
+    /**
+     * @brief Identifies the arrays stored in a snapshot.
+     */
+    enum class SnapshotSection : uint32_t {
+        GraphIds = 1,               /**< uint64 station ID of each dense node. */
+        GraphOffsets = 2,           /**< uint32 CSR offsets. */
+        GraphTargets = 3,           /**< uint32 CSR edge heads. */
+        GraphWeights = 4,           /**< uint32 CSR edge durations. */
+        GraphReverseOffsets = 5,    /**< uint32 reverse CSR offsets. */
+        GraphReverseSources = 6,    /**< uint32 reverse CSR edge tails. */
+        GraphReverseWeights = 7,    /**< uint32 reverse CSR edge durations. */
+        GraphLookupIds = 8,         /**< uint64 station IDs sorted, only if the graph was renumbered. */
+        GraphLookupNodes = 9,       /**< uint32 dense index of each sorted station ID. */
+        StationIds = 16,            /**< uint64 ID of each station, sorted. */
+        StationNames = 17,          /**< uint32 string handle of each station name. */
+        StationLines = 18,          /**< uint32 string handle of each station line. */
+        StationAddresses = 19,      /**< uint32 string handle of each station address. */
+        StationLineNames = 20,      /**< uint32 string handle of each line description. */
+        StationIndexKeys = 21,      /**< uint64 (name handle, line handle) keys, sorted. */
+        StationIndexIds = 22,       /**< uint64 station ID of each key. */
+        StringBytes = 24,           /**< Bytes of every interned string, back to back. */
+        StringOffsets = 25,         /**< uint32 start of each interned string, followed by the total size. */
+        HierarchyRank = 32,         /**< uint32 Contraction Hierarchies rank of each node. */
+        HierarchyUpOffsets = 33,    /**< uint32 upward forward CSR offsets. */
+        HierarchyUpTargets = 34,    /**< uint32 upward forward edge heads. */
+        HierarchyUpWeights = 35,    /**< uint32 upward forward edge durations. */
+        HierarchyUpMiddles = 36,    /**< uint32 upward forward shortcut middles. */
+        HierarchyDownOffsets = 37,  /**< uint32 upward backward CSR offsets. */
+        HierarchyDownSources = 38,  /**< uint32 upward backward edge tails. */
+        HierarchyDownWeights = 39,  /**< uint32 upward backward edge durations. */
+        HierarchyDownMiddles = 40,  /**< uint32 upward backward shortcut middles. */
+        DistanceTableDurations = 48, /**< uint32 all-pairs durations, row-major. */
+        DistanceTableNextHops = 49, /**< uint16 all-pairs next hops, row-major. */
+        HubLabelOutOffsets = 56,    /**< uint32 forward label range of each node. */
+        HubLabelOutHubs = 57,       /**< uint32 hub rank of each forward label entry, sorted per node. */
+        HubLabelOutDurations = 58,  /**< uint32 duration from the node to the hub. */
+        HubLabelOutParents = 59,    /**< uint32 next node towards the hub, Graph::npos at the hub. */
+        HubLabelInOffsets = 60,     /**< uint32 backward label range of each node. */
+        HubLabelInHubs = 61,        /**< uint32 hub rank of each backward label entry, sorted per node. */
+        HubLabelInDurations = 62,   /**< uint32 duration from the hub to the node. */
+        HubLabelInParents = 63      /**< uint32 previous node from the hub, Graph::npos at the hub. */
+    };
+
+    /**
+     * @class SnapshotWriter
+     * @brief Collects arrays and writes them as a snapshot file.
+     *
+     * Layout, in native byte order: a 48-byte header (magic "METROSNP", format version, byte order
+     * marker, section count, file size, checksum of everything after the header), the section table
+     * (tag, element size, offset, byte size per section), then every section aligned on 64 bytes.
+     */
+    class SnapshotWriter {
+    public:
+        /**
+         * @brief Registers an array to write. The memory must stay valid until write() returns.
+         * @param tag The section identifier.
+         * @param array The elements.
+         */
+        template <typename T>
+        void add(SnapshotSection tag, ArrayRef<T> array) {
+            sections.push_back(Pending{static_cast<uint32_t>(tag), sizeof(T),
+                                       reinterpret_cast<const char*>(array.data()), array.size() * sizeof(T)});
+        }
+
+        /**
+         * @brief Writes the header, the section table and every registered section.
+         * @param filename The path of the file to write.
+         * @throws std::runtime_error if the file cannot be written.
+         */
+        void write(const std::string& filename) const;
+
+    private:
+        /**
+         * @brief A registered section.
+         */
+        struct Pending {
+            uint32_t tag;
+            uint32_t element_size;
+            const char* data;
+            uint64_t size;
+        };
+
+        std::vector<Pending> sections; /**< The registered sections, in writing order. */
+    };
+
+    /**
+     * @class Snapshot
+     * @brief A memory-mapped snapshot whose sections are accessed in place, without copying.
+     */
+    class Snapshot {
+    public:
+        static const uint32_t version = 3; /**< The format version written and accepted. */
+
+        /**
+         * @brief Maps and validates a snapshot file.
+         * @param filename The path of the snapshot.
+         * @param verify Whether to check the payload checksum (one pass over the file).
+         * @throws std::runtime_error if the file is not a valid snapshot of this version.
+         */
+        explicit Snapshot(const std::string& filename, bool verify = true);
+
+        /**
+         * @brief Checks whether a section is present.
+         * @param tag The section identifier.
+         * @return True if the snapshot contains the section.
+         */
+        bool has(SnapshotSection tag) const;
+
+        /**
+         * @brief Gets a section as a typed array pointing into the mapping.
+         * @param tag The section identifier.
+         * @return A view of the section, valid as long as file() is alive.
+         * @throws std::runtime_error if the section is missing or has another element size.
+         */
+        template <typename T>
+        ArrayRef<T> array(SnapshotSection tag) const {
+            const Entry& entry = find(tag);
+            if (entry.element_size != sizeof(T)) {
+                throw std::runtime_error("Snapshot section has an unexpected element size (Snapshot::array)");
+            }
+            return ArrayRef<T>(reinterpret_cast<const T*>(mapping->data() + entry.offset), entry.size / sizeof(T));
+        }
+
+        /**
+         * @brief Gets the mapping, to keep it alive as long as views into it are used.
+         * @return The shared mapping.
+         */
+        const std::shared_ptr<const MappedFile>& file() const { return mapping; }
+
+        /**
+         * @brief Computes the checksum stored in the header.
+         * @param data The first byte.
+         * @param size The number of bytes.
+         * @return A 64-bit checksum of the bytes.
+         */
+        static uint64_t checksum(const char* data, size_t size);
+
+    private:
+        /**
+         * @brief An entry of the section table.
+         */
+        struct Entry {
+            uint32_t tag;
+            uint32_t element_size;
+            uint64_t offset;
+            uint64_t size;
+        };
+
+        /**
+         * @brief Finds a section in the table.
+         * @param tag The section identifier.
+         * @return The table entry.
+         * @throws std::runtime_error if the section is missing.
+         */
+        const Entry& find(SnapshotSection tag) const;
+
+        std::shared_ptr<const MappedFile> mapping; /**< The mapped file. */
+        ArrayRef<Entry> entries; /**< The section table, inside the mapping. */
+    };
+}
+
+#endif // SNAPSHOT_HPP
@@ -0,0 +1,391 @@
+#include "StationIndex.hpp"
+
+#include <tuple>
+#include <algorithm>
+
+namespace travel {
+
+namespace {
+
+/**
+ * @brief ASCII spelling of U+00C0 to U+00FF, "" for the two mathematical signs.
+ */
+const char* const latin1_supplement[64] = {
+    "a", "a", "a", "a", "a", "a", "ae", "c", "e", "e", "e", "e", "i", "i", "i", "i",
+    "d", "n", "o", "o", "o", "o", "o", "", "o", "u", "u", "u", "u", "y", "th", "ss",
+    "a", "a", "a", "a", "a", "a", "ae", "c", "e", "e", "e", "e", "i", "i", "i", "i",
+    "d", "n", "o", "o", "o", "o", "o", "", "o", "u", "u", "u", "u", "y", "th", "y"
+};
+
+/**
+ * @brief ASCII spelling of the runs of U+0100 to U+017F, each run starting at first.
+ */
+const struct { uint32_t first; const char* ascii; } latin_extended_a[] = {
+    {0x100, "a"}, {0x106, "c"}, {0x10E, "d"}, {0x112, "e"}, {0x11C, "g"}, {0x124, "h"}, {0x128, "i"},
+    {0x132, "ij"}, {0x134, "j"}, {0x136, "k"}, {0x139, "l"}, {0x143, "n"}, {0x14C, "o"}, {0x152, "oe"},
+    {0x154, "r"}, {0x15A, "s"}, {0x162, "t"}, {0x168, "u"}, {0x174, "w"}, {0x176, "y"}, {0x179, "z"},
+    {0x17F, "s"}
+};
+
+/**
+ * @brief Decodes one UTF-8 sequence.
+ * @param text The text, advanced past the sequence.
+ * @return The code point, or 0xFFFD for a malformed sequence (one byte is consumed).
+ */
+uint32_t decode(std::string_view& text) {
+    unsigned char lead = static_cast<unsigned char>(text[0]);
+    size_t length = lead < 0x80 ? 1 : (lead >> 5) == 0x6 ? 2 : (lead >> 4) == 0xE ? 3 : (lead >> 3) == 0x1E ? 4 : 0;
+    if (length == 0 || length > text.size()) {
+        text.remove_prefix(1);
+        return 0xFFFD;
+    }
+    uint32_t code = length == 1 ? lead : lead & (0x7F >> length);
+    for (size_t i = 1; i < length; ++i) {
+        unsigned char next = static_cast<unsigned char>(text[i]);
+        if ((next >> 6) != 0x2) {
+            text.remove_prefix(1);
+            return 0xFFFD;
+        }
+        code = (code << 6) | (next & 0x3F);
+    }
+    text.remove_prefix(length);
+    return code;
+}
+
+/**
+ * @brief Packs the three bytes of a trigram into a key.
+ * @param text At least three bytes.
+ * @return The key.
+ */
+uint32_t trigram(const char* text) {
+    return (uint32_t(static_cast<unsigned char>(text[0])) << 16) | (uint32_t(static_cast<unsigned char>(text[1])) << 8) |
+           static_cast<unsigned char>(text[2]);
+}
+
+/**
+ * @brief Collects the distinct trigrams of a folded string, which is padded with a leading space
+ * so that word starts are represented.
+ * @param text The folded string.
+ * @param keys Receives the sorted, distinct keys.
+ */
+void trigrams(std::string_view text, std::vector<uint32_t>& keys) {
+    keys.clear();
+    std::string padded;
+    padded.reserve(text.size() + 1);
+    padded.push_back(' ');
+    padded.append(text);
+    for (size_t i = 0; i + 3 <= padded.size(); ++i) {
+        keys.push_back(trigram(padded.data() + i));
+    }
+    std::sort(keys.begin(), keys.end());
+    keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+}
+
+/**
+ * @brief Per-thread scratch state of StationIndex::search.
+ */
+struct SearchScratch {
+    std::vector<uint32_t> counts;    /**< Shared trigrams per entry, or a mark for entries already taken. */
+    std::vector<uint32_t> touched;   /**< Entries whose count is not zero. */
+    std::vector<uint32_t> keys;      /**< Trigrams of the query. */
+    std::vector<uint32_t> previous;  /**< Edit distance rows of StationIndex::prefix_distance. */
+    std::vector<uint32_t> current;
+};
+
+/**
+ * Returns the search scratch state of the calling thread.
+ */
+SearchScratch& thread_scratch() {
+    static thread_local SearchScratch scratch;
+    return scratch;
+}
+
+} // namespace
+
+/**
+ * @brief Indexes the names of every station of a table.
+ *
+ * @param stations The station catalogue.
+ */
+StationIndex::StationIndex(const StationTable& stations) {
+    // (folded name, station ID, row), sorted so that platforms of one name are adjacent and the
+    // lowest station ID provides the displayed spelling.
+    std::vector<std::tuple<std::string, uint64_t, uint32_t>> platforms;
+    platforms.reserve(stations.size());
+    for (uint32_t row = 0; row < stations.size(); ++row) {
+        StationView station = stations.view(row);
+        platforms.emplace_back(fold(station.name), station.id, row);
+    }
+    std::sort(platforms.begin(), platforms.end());
+
+    entry_offsets.push_back(0);
+    display_offsets.push_back(0);
+    station_offsets.push_back(0);
+    for (size_t i = 0; i < platforms.size(); ++i) {
+        const std::string& name = std::get<0>(platforms[i]);
+        if (name.empty()) {
+            continue;
+        }
+        if (size() == 0 || folded(size() - 1) != name) {
+            if (size() != 0) {
+                station_offsets.push_back(static_cast<uint32_t>(station_ids.size()));
+            }
+            folded_names += name;
+            entry_offsets.push_back(static_cast<uint32_t>(folded_names.size()));
+            display_names += stations.view(std::get<2>(platforms[i])).name;
+            display_offsets.push_back(static_cast<uint32_t>(display_names.size()));
+        }
+        station_ids.push_back(std::get<1>(platforms[i]));
+    }
+    if (size() != 0) {
+        station_offsets.push_back(static_cast<uint32_t>(station_ids.size()));
+    }
+
+    std::vector<std::pair<uint32_t, uint32_t>> postings;
+    std::vector<uint32_t> keys;
+    for (uint32_t entry = 0; entry < size(); ++entry) {
+        std::string_view name = folded(entry);
+        for (uint32_t offset = 0; offset < name.size(); ++offset) {
+            if (offset == 0 || name[offset - 1] == ' ') {
+                word_starts.emplace_back(entry, offset);
+            }
+        }
+        trigrams(name, keys);
+        for (uint32_t key : keys) {
+            postings.emplace_back(key, entry);
+        }
+    }
+    std::sort(word_starts.begin(), word_starts.end(), [this](const std::pair<uint32_t, uint32_t>& a, const std::pair<uint32_t, uint32_t>& b) {
+        return folded(a.first).substr(a.second) < folded(b.first).substr(b.second);
+    });
+
+    std::sort(postings.begin(), postings.end());
+    trigram_entries.reserve(postings.size());
+    for (const auto& posting : postings) {
+        if (trigram_keys.empty() || trigram_keys.back() != posting.first) {
+            trigram_keys.push_back(posting.first);
+            trigram_offsets.push_back(static_cast<uint32_t>(trigram_entries.size()));
+        }
+        trigram_entries.push_back(posting.second);
+    }
+    trigram_offsets.push_back(static_cast<uint32_t>(trigram_entries.size()));
+}
+
+/**
+ * @brief Finds every platform of a station name with a binary search over the sorted folded names.
+ *
+ * @param name The station name, in any case and with or without accents.
+ * @return The IDs of the platforms, or an empty view if the name is unknown.
+ */
+ArrayRef<uint64_t> StationIndex::find(std::string_view name) const {
+    const std::string key = fold(name);
+    uint32_t low = 0, high = size();
+    while (low < high) {
+        uint32_t middle = low + (high - low) / 2;
+        if (folded(middle) < key) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    if (key.empty() || low == size() || folded(low) != key) {
+        return ArrayRef<uint64_t>();
+    }
+    return ArrayRef<uint64_t>(station_ids.data() + station_offsets[low], station_offsets[low + 1] - station_offsets[low]);
+}
+
+/**
+ * @brief Finds the station names that best complete a query.
+ *
+ * Queries shorter than three characters only match exact word prefixes. Longer ones tolerate one
+ * typo, and two from six characters on, in names sharing at least one trigram with the query.
+ *
+ * @param query The text typed so far, in any case and with or without accents.
+ * @param limit The maximum number of results.
+ * @return Up to limit matches, best first. The views stay valid as long as the index.
+ */
+std::vector<StationMatch> StationIndex::search(std::string_view query, size_t limit) const {
+    std::vector<StationMatch> matches;
+    std::string folded_query = fold(query);
+    if (folded_query.empty() || limit == 0 || size() == 0) {
+        return matches;
+    }
+    const std::string_view q = folded_query;
+    const uint32_t bound = q.size() < 3 ? 0 : q.size() < 6 ? 1 : 2;
+    const uint32_t taken = 0xFFFFFFFFu;
+
+    SearchScratch& scratch = thread_scratch();
+    scratch.counts.resize(size(), 0);
+    // (edits, does not start the whole name, name length, entry)
+    std::vector<std::tuple<uint32_t, bool, uint32_t, uint32_t>> ranked;
+    auto take = [&](uint32_t entry, uint32_t edits) {
+        if (scratch.counts[entry] == 0) {
+            scratch.touched.push_back(entry);
+        }
+        scratch.counts[entry] = taken;
+        std::string_view name = folded(entry);
+        ranked.emplace_back(edits, name.compare(0, q.size(), q) != 0, static_cast<uint32_t>(name.size()), entry);
+    };
+
+    // Exact prefixes of a word: the word suffixes starting with the query are contiguous
+    auto word = std::lower_bound(word_starts.begin(), word_starts.end(), q, [this](const std::pair<uint32_t, uint32_t>& start, std::string_view text) {
+        return folded(start.first).substr(start.second) < text;
+    });
+    for (; word != word_starts.end() && folded(word->first).substr(word->second).compare(0, q.size(), q) == 0; ++word) {
+        if (scratch.counts[word->first] != taken) {
+            take(word->first, 0);
+        }
+    }
+
+    if (bound > 0) {
+        // Each edit destroys at most three trigrams of the query
+        trigrams(q, scratch.keys);
+        uint32_t needed = scratch.keys.size() > 3 * bound ? static_cast<uint32_t>(scratch.keys.size() - 3 * bound) : 1;
+        std::vector<uint32_t> candidates;
+        for (uint32_t key : scratch.keys) {
+            auto it = std::lower_bound(trigram_keys.begin(), trigram_keys.end(), key);
+            if (it == trigram_keys.end() || *it != key) {
+                continue;
+            }
+            size_t slot = static_cast<size_t>(it - trigram_keys.begin());
+            for (uint32_t i = trigram_offsets[slot]; i < trigram_offsets[slot + 1]; ++i) {
+                uint32_t entry = trigram_entries[i];
+                uint32_t& count = scratch.counts[entry];
+                if (count == taken) {
+                    continue;
+                }
+                if (count == 0) {
+                    scratch.touched.push_back(entry);
+                }
+                if (++count == needed) {
+                    candidates.push_back(entry);
+                }
+            }
+        }
+        for (uint32_t entry : candidates) {
+            uint32_t edits = prefix_distance(q, folded(entry), bound);
+            if (edits <= bound) {
+                take(entry, edits);
+            }
+        }
+    }
+
+    for (uint32_t entry : scratch.touched) {
+        scratch.counts[entry] = 0;
+    }
+    scratch.touched.clear();
+
+    size_t count = std::min(limit, ranked.size());
+    std::partial_sort(ranked.begin(), ranked.begin() + count, ranked.end());
+    matches.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        uint32_t entry = std::get<3>(ranked[i]);
+        StationMatch match;
+        match.name = std::string_view(display_names.data() + display_offsets[entry], display_offsets[entry + 1] - display_offsets[entry]);
+        match.station_ids = ArrayRef<uint64_t>(station_ids.data() + station_offsets[entry], station_offsets[entry + 1] - station_offsets[entry]);
+        match.edits = std::get<0>(ranked[i]);
+        matches.push_back(match);
+    }
+    return matches;
+}
+
+/**
+ * @brief Computes how many edits turn the query into a prefix of a word suffix of a name.
+ *
+ * Levenshtein distance where the match may begin at any word start of the name for free and the
+ * name may continue after it for free, computed one query character per row.
+ *
+ * @param query The folded query.
+ * @param name The folded name.
+ * @param bound The number of edits beyond which the exact count does not matter.
+ * @return The number of edits, at most bound + 1.
+ */
+uint32_t StationIndex::prefix_distance(std::string_view query, std::string_view name, uint32_t bound) {
+    SearchScratch& scratch = thread_scratch();
+    std::vector<uint32_t>& previous = scratch.previous;
+    std::vector<uint32_t>& current = scratch.current;
+    previous.resize(name.size() + 1);
+    current.resize(name.size() + 1);
+
+    previous[0] = 0;
+    for (size_t j = 1; j <= name.size(); ++j) {
+        previous[j] = name[j - 1] == ' ' ? 0 : previous[j - 1] + 1;
+    }
+    for (size_t i = 1; i <= query.size(); ++i) {
+        current[0] = static_cast<uint32_t>(i);
+        uint32_t row_min = current[0];
+        for (size_t j = 1; j <= name.size(); ++j) {
+            uint32_t substitute = previous[j - 1] + (query[i - 1] != name[j - 1]);
+            current[j] = std::min(substitute, std::min(previous[j], current[j - 1]) + 1);
+            row_min = std::min(row_min, current[j]);
+        }
+        if (row_min > bound) {
+            return bound + 1;
+        }
+        previous.swap(current);
+    }
+    return std::min(bound + 1, *std::min_element(previous.begin(), previous.end()));
+}
+
+/**
+ * @brief Lowercases a UTF-8 string, strips Latin accents and replaces punctuation with single spaces.
+ *
+ * Letters of Latin-1 and Latin Extended-A are spelled in ASCII, other non-ASCII characters are
+ * kept as they are.
+ *
+ * @param text The UTF-8 text.
+ * @return The folded text, without leading or trailing spaces.
+ */
+std::string StationIndex::fold(std::string_view text) {
+    std::string result;
+    result.reserve(text.size());
+    auto append = [&result](const char* ascii) {
+        for (; *ascii != '\0'; ++ascii) {
+            result.push_back(*ascii);
+        }
+    };
+    auto space = [&result]() {
+        if (!result.empty() && result.back() != ' ') {
+            result.push_back(' ');
+        }
+    };
+
+    while (!text.empty()) {
+        std::string_view sequence = text;
+        uint32_t code = decode(text);
+        if (code < 0x80) {
+            char c = static_cast<char>(code);
+            if (c >= 'A' && c <= 'Z') {
+                result.push_back(static_cast<char>(c - 'A' + 'a'));
+            } else if ((c >= 'a' && c <= 'z') || (c >= '0' && c <= '9')) {
+                result.push_back(c);
+            } else {
+                space();
+            }
+        } else if (code >= 0xC0 && code <= 0xFF) {
+            const char* ascii = latin1_supplement[code - 0xC0];
+            if (*ascii == '\0') {
+                space();
+            }
+            append(ascii);
+        } else if (code >= 0x100 && code <= 0x17F) {
+            const char* ascii = "";
+            for (const auto& run : latin_extended_a) {
+                if (run.first <= code) {
+                    ascii = run.ascii;
+                }
+            }
+            append(ascii);
+        } else if (code < 0xC0 || (code >= 0x2000 && code <= 0x206F)) {
+            space(); // Latin-1 symbols, General Punctuation (’ – …)
+        } else if (code != 0xFFFD) {
+            result.append(sequence.data(), sequence.size() - text.size());
+        }
+    }
+    if (!result.empty() && result.back() == ' ') {
+        result.pop_back();
+    }
+    return result;
+}
+
+} // namespace travel
@@ -0,0 +1,120 @@
+/**
+ * @file StationIndex.hpp
+ * @brief Contains the declaration of the StationIndex class.
+ */
+
+#pragma once
+#ifndef STATION_INDEX_HPP
+#define STATION_INDEX_HPP
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <utility>
+#include <string_view>
+
+#include "ArrayRef.hpp"
+#include "StationTable.hpp"
+
+namespace travel {
+
+    /**
+     * @brief One station name returned by StationIndex::search.
+     */
+    struct StationMatch {
+        std::string_view name;            /**< The station name as written in the data. */
+        ArrayRef<uint64_t> station_ids;   /**< The IDs of every platform with this name, one per line and direction. */
+        uint32_t edits = 0;               /**< The number of typos between the query and the best matching part of the name. */
+    };
+
+    /**
+     * @class StationIndex
+     * @brief Typo-tolerant autocomplete over station names.
+     *
+     * Names are folded once at build time: lowercased, accents stripped (Léon -> leon, œ -> oe) and
+     * punctuation turned into spaces. Platforms whose folded names are equal become one entry, so a
+     * stop served by four lines is suggested once.
+     *
+     * A query is folded the same way and matched against every word start of the names, as a prefix:
+     * "blum" and "leon bl" both find "Voltaire (Léon Blum)". Exact word prefixes come from binary
+     * searches in a sorted array of word suffixes. Misspelled queries of three characters or more are
+     * also matched through a trigram index, which narrows the names down to those sharing enough
+     * trigrams before the edit distance is computed. Results are ranked by edits, then by whether the
+     * whole name starts with the query, then by length.
+     *
+     * The index is immutable once built and search() is safe to call from several threads.
+     */
+    class StationIndex {
+    public:
+        /**
+         * @brief Constructs an empty index.
+         */
+        StationIndex() = default;
+
+        /**
+         * @brief Indexes the names of every station of a table.
+         * @param stations The station catalogue.
+         */
+        explicit StationIndex(const StationTable& stations);
+
+        /**
+         * @brief Finds the station names that best complete a query.
+         * @param query The text typed so far, in any case and with or without accents.
+         * @param limit The maximum number of results.
+         * @return Up to limit matches, best first. The views stay valid as long as the index.
+         */
+        std::vector<StationMatch> search(std::string_view query, size_t limit = 10) const;
+
+        /**
+         * @brief Finds every platform of a station name, whatever its case and accents.
+         * @param name The station name.
+         * @return The IDs of the platforms, one per line and direction, or an empty view if the name is unknown.
+         */
+        ArrayRef<uint64_t> find(std::string_view name) const;
+
+        /**
+         * @brief Gets the number of distinct names.
+         * @return The number of entries.
+         */
+        uint32_t size() const { return static_cast<uint32_t>(entry_offsets.empty() ? 0 : entry_offsets.size() - 1); }
+
+        /**
+         * @brief Lowercases a UTF-8 string, strips Latin accents and replaces punctuation with single spaces.
+         * @param text The UTF-8 text.
+         * @return The folded text, without leading or trailing spaces.
+         */
+        static std::string fold(std::string_view text);
+
+    private:
+        /**
+         * @brief Gets the folded name of an entry.
+         * @param entry An entry in [0, size()).
+         * @return The folded name.
+         */
+        std::string_view folded(uint32_t entry) const {
+            return std::string_view(folded_names.data() + entry_offsets[entry], entry_offsets[entry + 1] - entry_offsets[entry]);
+        }
+
+        /**
+         * @brief Computes how many edits turn the query into a prefix of a word suffix of a name.
+         * @param query The folded query.
+         * @param name The folded name.
+         * @param bound The number of edits beyond which the exact count does not matter.
+         * @return The number of edits, at most bound + 1.
+         */
+        static uint32_t prefix_distance(std::string_view query, std::string_view name, uint32_t bound);
+
+        std::string folded_names; /**< The folded name of every entry, back to back, sorted. */
+        std::vector<uint32_t> entry_offsets; /**< Start of each folded name, plus one final entry. */
+        std::string display_names; /**< The original name of every entry, back to back. */
+        std::vector<uint32_t> display_offsets; /**< Start of each original name, plus one final entry. */
+        std::vector<uint64_t> station_ids; /**< The platforms of each entry, grouped by entry. */
+        std::vector<uint32_t> station_offsets; /**< Start of each entry's platforms, plus one final entry. */
+        std::vector<std::pair<uint32_t, uint32_t>> word_starts; /**< (entry, offset) of every word start, sorted by the text that follows. */
+        std::vector<uint32_t> trigram_keys; /**< Every distinct trigram, sorted. */
+        std::vector<uint32_t> trigram_offsets; /**< Start of each trigram's entries, plus one final entry. */
+        std::vector<uint32_t> trigram_entries; /**< The entries containing each trigram, grouped by trigram. */
+    };
+}
+
+#endif // STATION_INDEX_HPP
@@ -0,0 +1,187 @@
+#include "StationTable.hpp"
+#include "Snapshot.hpp"
+
+#include <numeric>
+#include <type_traits>
+#include <algorithm>
+#include <stdexcept>
+
+namespace travel {
+
+const uint32_t StationTable::npos = 0xFFFFFFFFu;
+
+namespace {
+
+/**
+ * @brief Reorders an array by a permutation.
+ * @param values The array, replaced by values[order[0]], values[order[1]], ...
+ * @param order The indices to keep, in their new order.
+ */
+template <typename T>
+void permute(std::vector<T>& values, const std::vector<uint32_t>& order) {
+    std::vector<T> result;
+    result.reserve(order.size());
+    for (uint32_t i : order) {
+        result.push_back(values[i]);
+    }
+    values.swap(result);
+}
+
+/**
+ * @brief Sorts the rows described by parallel key arrays, keeping the last added row of each key.
+ * @param keys The key of each row, in insertion order.
+ * @return The indices of the rows to keep, sorted by key.
+ */
+std::vector<uint32_t> last_of_each_key(const std::vector<uint64_t>& keys) {
+    std::vector<uint32_t> order(keys.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) { return keys[a] < keys[b]; });
+    std::vector<uint32_t> kept;
+    kept.reserve(order.size());
+    for (size_t i = 0; i < order.size(); ++i) {
+        if (i + 1 == order.size() || keys[order[i + 1]] != keys[order[i]]) {
+            kept.push_back(order[i]);
+        }
+    }
+    return kept;
+}
+
+} // namespace
+
+/**
+ * @brief Loads the table stored in a snapshot.
+ *
+ * The rows are copied out of the mapping: a handful of flat arrays, with no per-station allocation.
+ *
+ * @param snapshot The mapped snapshot.
+ * @throws std::runtime_error if a station section is missing or inconsistent.
+ */
+StationTable::StationTable(const Snapshot& snapshot)
+: strings(snapshot.array<char>(SnapshotSection::StringBytes), snapshot.array<uint32_t>(SnapshotSection::StringOffsets)) {
+    auto copy = [&snapshot](SnapshotSection tag, auto& values) {
+        using T = typename std::decay<decltype(values)>::type::value_type;
+        ArrayRef<T> array = snapshot.array<T>(tag);
+        values.assign(array.begin(), array.end());
+    };
+    copy(SnapshotSection::StationIds, ids);
+    copy(SnapshotSection::StationNames, names);
+    copy(SnapshotSection::StationLines, line_ids);
+    copy(SnapshotSection::StationAddresses, addresses);
+    copy(SnapshotSection::StationLineNames, line_names);
+    copy(SnapshotSection::StationIndexKeys, index_keys);
+    copy(SnapshotSection::StationIndexIds, index_ids);
+
+    if (names.size() != ids.size() || line_ids.size() != ids.size() || addresses.size() != ids.size() ||
+        line_names.size() != ids.size() || index_ids.size() != index_keys.size() ||
+        !std::is_sorted(ids.begin(), ids.end()) || !std::is_sorted(index_keys.begin(), index_keys.end())) {
+        throw std::runtime_error("Inconsistent station sections in snapshot (StationTable)");
+    }
+    for (const std::vector<uint32_t>* handles : {&names, &line_ids, &addresses, &line_names}) {
+        for (uint32_t handle : *handles) {
+            if (handle >= strings.size()) {
+                throw std::runtime_error("Station string out of the string pool (StationTable)");
+            }
+        }
+    }
+}
+
+/**
+ * @brief Registers the table arrays as snapshot sections.
+ *
+ * @param writer The snapshot being written; the table must outlive the write.
+ */
+void StationTable::save(SnapshotWriter& writer) const {
+    writer.add(SnapshotSection::StationIds, ArrayRef<uint64_t>(ids));
+    writer.add(SnapshotSection::StationNames, ArrayRef<uint32_t>(names));
+    writer.add(SnapshotSection::StationLines, ArrayRef<uint32_t>(line_ids));
+    writer.add(SnapshotSection::StationAddresses, ArrayRef<uint32_t>(addresses));
+    writer.add(SnapshotSection::StationLineNames, ArrayRef<uint32_t>(line_names));
+    writer.add(SnapshotSection::StationIndexKeys, ArrayRef<uint64_t>(index_keys));
+    writer.add(SnapshotSection::StationIndexIds, ArrayRef<uint64_t>(index_ids));
+    writer.add(SnapshotSection::StringBytes, strings.get_bytes());
+    writer.add(SnapshotSection::StringOffsets, strings.get_offsets());
+}
+
+/**
+ * @brief Appends a station; lookups only see it after seal().
+ *
+ * @param id The station ID.
+ * @param name The station name.
+ * @param line_id The short name of the line.
+ * @param address The address of the station.
+ * @param line_name The description of the line.
+ */
+void StationTable::add(uint64_t id, std::string_view name, std::string_view line_id, std::string_view address, std::string_view line_name) {
+    ids.push_back(id);
+    names.push_back(strings.intern(name));
+    line_ids.push_back(strings.intern(line_id));
+    addresses.push_back(strings.intern(address));
+    line_names.push_back(strings.intern(line_name));
+    index_keys.push_back(key(names.back(), line_ids.back()));
+    index_ids.push_back(id);
+}
+
+/**
+ * @brief Sorts the rows by ID, drops superseded duplicates and rebuilds the (name, line) index.
+ *
+ * Rows already sealed precede the ones added since, so a stable sort keeps the most recent row
+ * last within each run of equal keys.
+ */
+void StationTable::seal() {
+    std::vector<uint32_t> rows = last_of_each_key(ids);
+    permute(ids, rows);
+    permute(names, rows);
+    permute(line_ids, rows);
+    permute(addresses, rows);
+    permute(line_names, rows);
+
+    std::vector<uint32_t> entries = last_of_each_key(index_keys);
+    permute(index_keys, entries);
+    permute(index_ids, entries);
+}
+
+/**
+ * @brief Finds the row of a station.
+ *
+ * @param id The station ID.
+ * @return The row, or npos if the station is unknown.
+ */
+uint32_t StationTable::find(uint64_t id) const {
+    auto it = std::lower_bound(ids.begin(), ids.end(), id);
+    return it != ids.end() && *it == id ? static_cast<uint32_t>(it - ids.begin()) : npos;
+}
+
+/**
+ * @brief Finds the station with a given name on a given line.
+ *
+ * @param name The station name.
+ * @param line_id The short name of the line.
+ * @param id Receives the station ID.
+ * @return False if there is no such station.
+ */
+bool StationTable::find_id(std::string_view name, std::string_view line_id, uint64_t& id) const {
+    uint32_t name_handle = strings.find(name);
+    uint32_t line_handle = strings.find(line_id);
+    if (name_handle == StringPool::npos || line_handle == StringPool::npos) {
+        return false;
+    }
+    uint64_t wanted = key(name_handle, line_handle);
+    auto it = std::lower_bound(index_keys.begin(), index_keys.end(), wanted);
+    if (it == index_keys.end() || *it != wanted) {
+        return false;
+    }
+    id = index_ids[it - index_keys.begin()];
+    return true;
+}
+
+/**
+ * @brief Gets the memory held by the table.
+ *
+ * @return The number of bytes allocated for the rows, the index and the string pool.
+ */
+size_t StationTable::memory_usage() const {
+    return strings.memory_usage() + (ids.capacity() + index_keys.capacity() + index_ids.capacity()) * sizeof(uint64_t) +
+           (names.capacity() + line_ids.capacity() + addresses.capacity() + line_names.capacity()) * sizeof(uint32_t);
+}
+
+} // namespace travel
@@ -0,0 +1,174 @@
+/**
+ * @file StationTable.hpp
+ * @brief Contains the declaration of the StationTable class.
+ */
+
+#pragma once
+#ifndef STATION_TABLE_HPP
+#define STATION_TABLE_HPP
+
+#include <cstdint>
+#include <vector>
+#include <ostream>
+#include <string_view>
+
+#include "StringPool.hpp"
+
+namespace travel {
+
+    class Snapshot;        // Forward declaration
+    class SnapshotWriter;  // Forward declaration
+
+    /**
+     * @brief Read-only view of one station of a StationTable.
+     *
+     * The strings point into the table's string pool and stay valid until the table is modified.
+     */
+    struct StationView {
+        uint64_t id = 0;              /**< The station ID. */
+        std::string_view name;        /**< The station name. */
+        std::string_view line_id;     /**< The short name of the line. */
+        std::string_view address;     /**< The address of the station. */
+        std::string_view line_name;   /**< The description of the line. */
+
+        friend std::ostream& operator<<(std::ostream& os, const StationView& station) {
+            os << "Station: " << station.name << " (line " << station.line_id << ")";
+            return os;
+        }
+    };
+
+    /**
+     * @class StationTable
+     * @brief Structure-of-arrays station catalogue with interned strings.
+     *
+     * A station is a row: its ID plus four 32-bit handles into a shared StringPool for the name,
+     * line, address and line description. Rows are kept sorted by ID and looked up by binary search,
+     * and a sorted (name, line) -> ID index replaces the concatenated "name|line" keys, so neither
+     * lookup allocates.
+     *
+     * Stations are appended with add() and become visible to lookups after seal(). When the same ID
+     * or the same (name, line) pair is added several times, the last one wins.
+     */
+    class StationTable {
+    public:
+        static const uint32_t npos; /**< Returned by lookups that find nothing. */
+
+        /**
+         * @brief Constructs an empty table.
+         */
+        StationTable() = default;
+
+        /**
+         * @brief Loads the table stored in a snapshot.
+         * @param snapshot The mapped snapshot.
+         * @throws std::runtime_error if a station section is missing or inconsistent.
+         */
+        explicit StationTable(const Snapshot& snapshot);
+
+        /**
+         * @brief Registers the table arrays as snapshot sections.
+         * @param writer The snapshot being written; the table must outlive the write.
+         */
+        void save(SnapshotWriter& writer) const;
+
+        /**
+         * @brief Appends a station; lookups only see it after seal().
+         * @param id The station ID.
+         * @param name The station name.
+         * @param line_id The short name of the line.
+         * @param address The address of the station.
+         * @param line_name The description of the line.
+         */
+        void add(uint64_t id, std::string_view name, std::string_view line_id, std::string_view address, std::string_view line_name);
+
+        /**
+         * @brief Sorts the rows by ID, drops superseded duplicates and rebuilds the (name, line) index.
+         */
+        void seal();
+
+        /**
+         * @brief Gets the number of stations.
+         * @return The number of rows.
+         */
+        uint32_t size() const { return static_cast<uint32_t>(ids.size()); }
+
+        /**
+         * @brief Finds the row of a station.
+         * @param id The station ID.
+         * @return The row, or npos if the station is unknown.
+         */
+        uint32_t find(uint64_t id) const;
+
+        /**
+         * @brief Finds the station with a given name on a given line.
+         * @param name The station name.
+         * @param line_id The short name of the line.
+         * @param id Receives the station ID.
+         * @return False if there is no such station.
+         */
+        bool find_id(std::string_view name, std::string_view line_id, uint64_t& id) const;
+
+        /**
+         * @brief Gets a station.
+         * @param row A row in [0, size()).
+         * @return A view of the station.
+         */
+        StationView view(uint32_t row) const {
+            return StationView{ids[row], strings.view(names[row]), strings.view(line_ids[row]),
+                               strings.view(addresses[row]), strings.view(line_names[row])};
+        }
+
+        /**
+         * @brief Gets the ID of a station.
+         * @param row A row in [0, size()).
+         * @return The station ID.
+         */
+        uint64_t id(uint32_t row) const { return ids[row]; }
+
+        /**
+         * @brief Gets the interned name of a station.
+         * @param row A row in [0, size()).
+         * @return The handle of the name in get_strings().
+         */
+        uint32_t name_handle(uint32_t row) const { return names[row]; }
+
+        /**
+         * @brief Gets the interned line of a station.
+         * @param row A row in [0, size()).
+         * @return The handle of the line in get_strings().
+         */
+        uint32_t line_handle(uint32_t row) const { return line_ids[row]; }
+
+        /**
+         * @brief Gets the string pool holding every station string.
+         * @return The pool.
+         */
+        const StringPool& get_strings() const { return strings; }
+
+        /**
+         * @brief Gets the memory held by the table.
+         * @return The number of bytes allocated for the rows, the index and the string pool.
+         */
+        size_t memory_usage() const;
+
+    private:
+        /**
+         * @brief Packs a (name, line) pair of handles into an index key.
+         * @param name The handle of the name.
+         * @param line_id The handle of the line.
+         * @return The key.
+         */
+        static uint64_t key(uint32_t name, uint32_t line_id) { return (uint64_t(name) << 32) | line_id; }
+
+        StringPool strings; /**< Every station string, interned. */
+        std::vector<uint64_t> ids; /**< ID of each row, sorted after seal(). */
+        std::vector<uint32_t> names; /**< Name handle of each row. */
+        std::vector<uint32_t> line_ids; /**< Line handle of each row. */
+        std::vector<uint32_t> addresses; /**< Address handle of each row. */
+        std::vector<uint32_t> line_names; /**< Line description handle of each row. */
+        std::vector<uint64_t> index_keys; /**< (name, line) keys, sorted after seal(). */
+        std::vector<uint64_t> index_ids; /**< Station ID of each key. */
+    };
+}
+
+#endif // STATION_TABLE_HPP
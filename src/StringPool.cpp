@@ -0,0 +1,108 @@
+#include "StringPool.hpp"
+
+#include <functional>
+#include <stdexcept>
+
+namespace travel {
+
+const uint32_t StringPool::npos = 0xFFFFFFFFu;
+
+/**
+ * @brief Constructs a pool holding only the empty string, as handle 0.
+ */
+StringPool::StringPool()
+: offsets(2, 0) {
+    rehash();
+}
+
+/**
+ * @brief Rebuilds a pool from the arrays written by a previous pool.
+ *
+ * @param bytes The characters of every string, back to back.
+ * @param offsets The start of each string in bytes, followed by bytes.size().
+ * @throws std::runtime_error if the offsets do not describe bytes.
+ */
+StringPool::StringPool(ArrayRef<char> bytes, ArrayRef<uint32_t> offsets)
+: bytes(bytes.begin(), bytes.end()), offsets(offsets.begin(), offsets.end()) {
+    if (this->offsets.size() < 2 || this->offsets.front() != 0 || this->offsets.back() != this->bytes.size()) {
+        throw std::runtime_error("Inconsistent string pool (StringPool)");
+    }
+    for (size_t i = 1; i < this->offsets.size(); ++i) {
+        if (this->offsets[i] < this->offsets[i - 1]) {
+            throw std::runtime_error("Inconsistent string pool (StringPool)");
+        }
+    }
+    rehash();
+}
+
+/**
+ * @brief Returns the handle of a string, adding it to the pool if needed.
+ *
+ * @param text The string.
+ * @return The handle of the string.
+ */
+uint32_t StringPool::intern(std::string_view text) {
+    size_t mask = slots.size() - 1;
+    size_t slot = std::hash<std::string_view>()(text) & mask;
+    while (slots[slot] != npos) {
+        if (view(slots[slot]) == text) {
+            return slots[slot];
+        }
+        slot = (slot + 1) & mask;
+    }
+
+    uint32_t handle = size();
+    bytes.insert(bytes.end(), text.begin(), text.end());
+    offsets.push_back(static_cast<uint32_t>(bytes.size()));
+    slots[slot] = handle;
+    if (size() * 2 > slots.size()) {
+        rehash();
+    }
+    return handle;
+}
+
+/**
+ * @brief Looks a string up without adding it.
+ *
+ * @param text The string.
+ * @return The handle of the string, or npos if it was never interned.
+ */
+uint32_t StringPool::find(std::string_view text) const {
+    size_t mask = slots.size() - 1;
+    for (size_t slot = std::hash<std::string_view>()(text) & mask; slots[slot] != npos; slot = (slot + 1) & mask) {
+        if (view(slots[slot]) == text) {
+            return slots[slot];
+        }
+    }
+    return npos;
+}
+
+/**
+ * @brief Gets the memory held by the pool.
+ *
+ * @return The number of bytes allocated for the arena, the offsets and the hash table.
+ */
+size_t StringPool::memory_usage() const {
+    return bytes.capacity() + offsets.capacity() * sizeof(uint32_t) + slots.capacity() * sizeof(uint32_t);
+}
+
+/**
+ * @brief Rebuilds the hash table with room for at least twice the current strings.
+ */
+void StringPool::rehash() {
+    size_t capacity = 16;
+    while (capacity < size() * 4) {
+        capacity *= 2;
+    }
+    slots.assign(capacity, npos);
+    size_t mask = capacity - 1;
+    for (uint32_t handle = 0; handle < size(); ++handle) {
+        size_t slot = std::hash<std::string_view>()(view(handle)) & mask;
+        while (slots[slot] != npos) {
+            slot = (slot + 1) & mask;
+        }
+        slots[slot] = handle;
+    }
+}
+
+} // namespace travel
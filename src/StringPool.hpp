@@ -0,0 +1,102 @@
+/**
+ * @file StringPool.hpp
+ * @brief Contains the declaration of the StringPool class.
+ */
+
+#pragma once
+#ifndef STRING_POOL_HPP
+#define STRING_POOL_HPP
+
+#include <cstdint>
+#include <vector>
+#include <string_view>
+
+#include "ArrayRef.hpp"
+
+namespace travel {
+
+    /**
+     * @class StringPool
+     * @brief Interned strings stored back to back in one arena and referred to by 32-bit handles.
+     *
+     * Each distinct string is stored once, so the line names and addresses shared by the platforms
+     * of a stop cost a handle each instead of a heap block each. Handles are dense and stable for the
+     * lifetime of the pool. Lookups hash the string_view directly and never allocate.
+     */
+    class StringPool {
+    public:
+        static const uint32_t npos; /**< Returned by find for strings that were never interned. */
+
+        /**
+         * @brief Constructs a pool holding only the empty string, as handle 0.
+         */
+        StringPool();
+
+        /**
+         * @brief Rebuilds a pool from the arrays written by a previous pool.
+         * @param bytes The characters of every string, back to back.
+         * @param offsets The start of each string in bytes, followed by bytes.size().
+         * @throws std::runtime_error if the offsets do not describe bytes.
+         */
+        StringPool(ArrayRef<char> bytes, ArrayRef<uint32_t> offsets);
+
+        /**
+         * @brief Returns the handle of a string, adding it to the pool if needed.
+         * @param text The string.
+         * @return The handle of the string.
+         */
+        uint32_t intern(std::string_view text);
+
+        /**
+         * @brief Looks a string up without adding it.
+         * @param text The string.
+         * @return The handle of the string, or npos if it was never interned.
+         */
+        uint32_t find(std::string_view text) const;
+
+        /**
+         * @brief Gets the string behind a handle.
+         * @param handle A handle returned by intern or find.
+         * @return A view valid until the next call to intern.
+         */
+        std::string_view view(uint32_t handle) const {
+            return std::string_view(bytes.data() + offsets[handle], offsets[handle + 1] - offsets[handle]);
+        }
+
+        /**
+         * @brief Gets the number of distinct strings.
+         * @return The number of handles.
+         */
+        uint32_t size() const { return static_cast<uint32_t>(offsets.size() - 1); }
+
+        /**
+         * @brief Gets the arena, for writing it to a snapshot.
+         * @return The characters of every string, back to back.
+         */
+        ArrayRef<char> get_bytes() const { return bytes; }
+
+        /**
+         * @brief Gets the string boundaries, for writing them to a snapshot.
+         * @return The start of each string, followed by the arena size.
+         */
+        ArrayRef<uint32_t> get_offsets() const { return offsets; }
+
+        /**
+         * @brief Gets the memory held by the pool.
+         * @return The number of bytes allocated for the arena, the offsets and the hash table.
+         */
+        size_t memory_usage() const;
+
+    private:
+        /**
+         * @brief Rebuilds the hash table with room for at least twice the current strings.
+         */
+        void rehash();
+
+        std::vector<char> bytes; /**< The characters of every string, back to back. */
+        std::vector<uint32_t> offsets; /**< Start of each string in bytes, plus one final entry. */
+        std::vector<uint32_t> slots; /**< Open-addressing table of handles, npos for empty slots; size is a power of two. */
+    };
+}
+
+#endif // STRING_POOL_HPP
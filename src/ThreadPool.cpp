@@ -0,0 +1,159 @@
+#include "ThreadPool.hpp"
+
+#include <algorithm>
+
+namespace travel {
+
+/**
+ * @brief Starts the worker threads.
+ *
+ * @param threads The number of workers, 0 for one per hardware thread.
+ */
+ThreadPool::ThreadPool(size_t threads) {
+    if (threads == 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    for (size_t i = 0; i < threads; ++i) {
+        workers.emplace_back(new Worker());
+    }
+    for (size_t i = 0; i < threads; ++i) {
+        workers[i]->thread = std::thread(&ThreadPool::run, this, i);
+    }
+}
+
+/**
+ * @brief Stops and joins the worker threads.
+ */
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(state_mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (auto& worker : workers) {
+        worker->thread.join();
+    }
+}
+
+/**
+ * @brief Runs body(i) for every i in [0, count) on the workers and waits for completion.
+ *
+ * @param count The number of indices.
+ * @param body The function to run for each index.
+ * @param grain The number of consecutive indices per chunk, 0 to pick one automatically.
+ */
+void ThreadPool::parallel_for(size_t count, const std::function<void(size_t)>& body, size_t grain) {
+    if (count == 0) {
+        return;
+    }
+    if (grain == 0) {
+        // About eight chunks per worker: enough to steal from, few enough to keep locking cheap.
+        grain = std::max<size_t>(1, count / (workers.size() * 8));
+    }
+
+    std::lock_guard<std::mutex> submit(submit_mutex);
+    size_t chunk_count = 0;
+    for (size_t begin = 0; begin < count; begin += grain, ++chunk_count) {
+        Worker& worker = *workers[chunk_count % workers.size()];
+        std::lock_guard<std::mutex> lock(worker.mutex);
+        worker.chunks.emplace_back(begin, std::min(count, begin + grain));
+    }
+
+    std::exception_ptr error;
+    {
+        std::unique_lock<std::mutex> lock(state_mutex);
+        current_body = &body;
+        pending_chunks = chunk_count;
+        failure = nullptr;
+        failed = false;
+        ++loop_generation;
+        wake.notify_all();
+        // Also wait for every worker to leave the loop so none can pick up the next loop's chunks with this body.
+        done.wait(lock, [this] { return pending_chunks == 0 && active_workers == 0; });
+        current_body = nullptr;
+        error = failure;
+    }
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
+
+/**
+ * @brief Main loop of a worker thread.
+ *
+ * @param self The index of the worker.
+ */
+void ThreadPool::run(size_t self) {
+    uint64_t seen_generation = 0;
+    while (true) {
+        const std::function<void(size_t)>* body;
+        {
+            std::unique_lock<std::mutex> lock(state_mutex);
+            wake.wait(lock, [&] { return stopping || loop_generation != seen_generation; });
+            if (stopping) {
+                return;
+            }
+            seen_generation = loop_generation;
+            body = current_body;
+            if (body == nullptr) {
+                continue; // Woke up after that loop already completed
+            }
+            ++active_workers;
+        }
+
+        std::pair<size_t, size_t> chunk;
+        while (take(self, chunk)) {
+            if (!failed) {
+                try {
+                    for (size_t i = chunk.first; i < chunk.second; ++i) {
+                        (*body)(i);
+                    }
+                } catch (...) {
+                    std::lock_guard<std::mutex> lock(state_mutex);
+                    if (!failure) {
+                        failure = std::current_exception();
+                    }
+                    failed = true;
+                }
+            }
+            std::lock_guard<std::mutex> lock(state_mutex);
+            --pending_chunks;
+        }
+
+        std::lock_guard<std::mutex> lock(state_mutex);
+        if (--active_workers == 0 && pending_chunks == 0) {
+            done.notify_one();
+        }
+    }
+}
+
+/**
+ * @brief Takes a chunk from the worker's own deque, or steals one from another worker.
+ *
+ * @param self The index of the worker.
+ * @param chunk Receives the chunk.
+ * @return True if a chunk was found.
+ */
+bool ThreadPool::take(size_t self, std::pair<size_t, size_t>& chunk) {
+    {
+        Worker& own = *workers[self];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.chunks.empty()) {
+            chunk = own.chunks.back();
+            own.chunks.pop_back();
+            return true;
+        }
+    }
+    for (size_t offset = 1; offset < workers.size(); ++offset) {
+        Worker& victim = *workers[(self + offset) % workers.size()];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.chunks.empty()) {
+            chunk = victim.chunks.front();
+            victim.chunks.pop_front();
+            return true;
+        }
+    }
+    return false;
+}
+
+} // namespace travel
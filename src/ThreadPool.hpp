@@ -0,0 +1,104 @@
+/**
+ * @file ThreadPool.hpp
+ * @brief Contains the declaration of the ThreadPool class.
+ */
+
+#pragma once
+#ifndef THREAD_POOL_HPP
+#define THREAD_POOL_HPP
+
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <vector>
+#include <memory>
+#include <utility>
+#include <exception>
+#include <functional>
+#include <condition_variable>
+
+namespace travel {
+
+    /**
+     * @class ThreadPool
+     * @brief Fixed set of worker threads running data-parallel loops with work stealing.
+     *
+     * parallel_for cuts the index range into chunks dealt round-robin to per-worker deques. A worker
+     * takes chunks from the back of its own deque and, once it runs dry, steals from the front of the
+     * others, so uneven chunks (e.g. searches from well and poorly connected stations) stay balanced.
+     * Worker threads are long-lived, which keeps their thread_local QueryContext warm between loops.
+     */
+    class ThreadPool {
+    public:
+        /**
+         * @brief Starts the worker threads.
+         * @param threads The number of workers, 0 for one per hardware thread.
+         */
+        explicit ThreadPool(size_t threads = 0);
+
+        /**
+         * @brief Stops and joins the worker threads.
+         */
+        ~ThreadPool();
+
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool& operator=(const ThreadPool&) = delete;
+
+        /**
+         * @brief Gets the number of worker threads.
+         * @return The number of workers.
+         */
+        size_t size() const { return workers.size(); }
+
+        /**
+         * @brief Runs body(i) for every i in [0, count) on the workers and waits for completion.
+         *
+         * Calls from several threads are serialized. If a body throws, the remaining chunks are
+         * skipped and the first exception is rethrown to the caller.
+         * @param count The number of indices.
+         * @param body The function to run for each index.
+         * @param grain The number of consecutive indices per chunk, 0 to pick one automatically.
+         */
+        void parallel_for(size_t count, const std::function<void(size_t)>& body, size_t grain = 0);
+
+    private:
+        /**
+         * @brief A worker thread and its deque of [begin, end) chunks.
+         */
+        struct Worker {
+            std::thread thread;
+            std::mutex mutex;
+            std::deque<std::pair<size_t, size_t>> chunks;
+        };
+
+        /**
+         * @brief Main loop of a worker thread.
+         * @param self The index of the worker.
+         */
+        void run(size_t self);
+
+        /**
+         * @brief Takes a chunk from the worker's own deque, or steals one from another worker.
+         * @param self The index of the worker.
+         * @param chunk Receives the chunk.
+         * @return True if a chunk was found.
+         */
+        bool take(size_t self, std::pair<size_t, size_t>& chunk);
+
+        std::vector<std::unique_ptr<Worker>> workers; /**< The workers and their deques. */
+        std::mutex submit_mutex; /**< Serializes parallel_for calls. */
+        std::mutex state_mutex; /**< Protects the fields below and the condition variables. */
+        std::condition_variable wake; /**< Signals workers that a loop started or the pool stops. */
+        std::condition_variable done; /**< Signals the caller that the last chunk finished. */
+        const std::function<void(size_t)>* current_body = nullptr; /**< Body of the running loop. */
+        uint64_t loop_generation = 0; /**< Incremented for every loop so workers notice new work. */
+        size_t pending_chunks = 0; /**< Chunks of the running loop not finished yet. */
+        size_t active_workers = 0; /**< Workers currently taking chunks of the running loop. */
+        std::exception_ptr failure; /**< First exception thrown by the running loop. */
+        std::atomic<bool> failed{false}; /**< Set once a body threw, so remaining chunks are skipped. */
+        bool stopping = false; /**< Set by the destructor. */
+    };
+}
+
+#endif // THREAD_POOL_HPP
@@ -0,0 +1,639 @@
+#include "Timetable.hpp"
+#include "MappedFile.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <functional>
+#include <numeric>
+#include <queue>
+#include <stdexcept>
+#include <unordered_map>
+
+namespace travel {
+
+const uint32_t Timetable::unreachable = std::numeric_limits<uint32_t>::max();
+
+namespace {
+
+const uint32_t npos = std::numeric_limits<uint32_t>::max();
+
+/**
+ * @brief One row of a stop_times file.
+ */
+struct StopTime {
+    uint32_t trip;      /**< Dense index of the trip. */
+    uint32_t sequence;  /**< Position of the stop in the trip. */
+    uint32_t arrival;   /**< Arrival time at the stop. */
+    uint32_t departure; /**< Departure time from the stop. */
+    uint64_t stop;      /**< Stop ID. */
+    size_t line;        /**< Line of the row, for error messages. */
+};
+
+/**
+ * @brief Scratch labels of the scans, reused by every query of a thread.
+ *
+ * A label is valid only if its stamp is the generation of the current query, so starting a query
+ * never clears the arrays.
+ */
+struct ScanContext {
+    uint32_t generation = 0;
+    std::vector<uint32_t> stop_stamp;  /**< Generation that last wrote each stop label. */
+    std::vector<uint32_t> arrival;  /**< Earliest arrival at each stop. */
+    std::vector<uint32_t> enter;  /**< First connection of the ride reaching each stop, npos after a footpath. */
+    std::vector<uint32_t> exit;  /**< Last connection of that ride, or the stop the footpath left from. */
+    std::vector<std::vector<std::pair<uint32_t, uint32_t>>> profiles;  /**< (departure, arrival) Pareto set of each stop, by decreasing departure. */
+    std::vector<uint32_t> trip_stamp;  /**< Generation that last wrote each trip label. */
+    std::vector<uint32_t> trip_value;  /**< Boarding connection of each trip, or arrival when staying on it. */
+
+    /**
+     * @brief Starts a query on a timetable.
+     * @param stops The number of stops.
+     * @param trips The number of trips.
+     */
+    void prepare(size_t stops, size_t trips) {
+        if (++generation == 0) {
+            std::fill(stop_stamp.begin(), stop_stamp.end(), 0);
+            std::fill(trip_stamp.begin(), trip_stamp.end(), 0);
+            generation = 1;
+        }
+        if (stop_stamp.size() < stops) {
+            stop_stamp.resize(stops, 0);
+            arrival.resize(stops);
+            enter.resize(stops);
+            exit.resize(stops);
+            profiles.resize(stops);
+        }
+        if (trip_stamp.size() < trips) {
+            trip_stamp.resize(trips, 0);
+            trip_value.resize(trips);
+        }
+    }
+};
+
+/**
+ * @brief Gets the scratch labels of the calling thread.
+ * @return The labels, shared by every timetable the thread queries.
+ */
+ScanContext& scan_context() {
+    thread_local ScanContext context;
+    return context;
+}
+
+} // namespace
+
+/**
+ * @brief Reads the trips of a GTFS stop_times file and indexes them with the footpaths.
+ *
+ * Rows are grouped by trip and ordered by stop_sequence; each pair of consecutive rows of a trip
+ * becomes a connection. The connections are then sorted by departure, then arrival, and trips and
+ * stop order break the remaining ties, so a ride of no duration is still scanned before the next
+ * ride of its trip.
+ *
+ * @param stop_times_filename The stop_times CSV file.
+ * @param footpaths The transfers between stops.
+ * @param errors Receives the malformed rows, which are skipped, if not null.
+ * @throws std::runtime_error if the file cannot be read or lacks a required column.
+ */
+Timetable::Timetable(const std::string& stop_times_filename, const std::vector<Footpath>& footpaths, std::vector<CsvError>* errors) {
+    MappedFile file;
+    std::string open_error;
+    if (!file.open(stop_times_filename, &open_error)) {
+        throw std::runtime_error(open_error + " (Timetable::Timetable)");
+    }
+    CsvReader reader(std::string_view(file.data(), file.size()));
+    std::vector<std::string_view> fields;
+    CsvError error;
+    auto report = [&](const CsvError& row_error) {
+        if (errors) {
+            errors->push_back(row_error);
+        }
+    };
+
+    // Find the columns in the header.
+    static const char* const names[] = {"trip_id", "arrival_time", "departure_time", "stop_id", "stop_sequence"};
+    size_t columns[5] = {npos, npos, npos, npos, npos};
+    CsvReader::Status status;
+    while ((status = reader.next(fields, error)) == CsvReader::Status::Error) {
+        report(error);
+    }
+    if (status == CsvReader::Status::End) {
+        throw std::runtime_error("Empty stop_times file: " + stop_times_filename + " (Timetable::Timetable)");
+    }
+    for (size_t i = 0; i < fields.size(); ++i) {
+        for (size_t column = 0; column < 5; ++column) {
+            if (fields[i] == names[column]) {
+                columns[column] = i;
+            }
+        }
+    }
+    for (size_t column = 0; column < 5; ++column) {
+        if (columns[column] == npos) {
+            throw std::runtime_error("Missing column " + std::string(names[column]) + " in " + stop_times_filename + " (Timetable::Timetable)");
+        }
+    }
+    const size_t width = *std::max_element(columns, columns + 5) + 1;
+
+    std::unordered_map<std::string, uint32_t> trip_index;
+    std::vector<StopTime> rows;
+    while ((status = reader.next(fields, error)) != CsvReader::Status::End) {
+        if (status == CsvReader::Status::Record) {
+            StopTime row{0, 0, 0, 0, 0, reader.line()};
+            uint64_t sequence = 0;
+            if (fields.size() < width) {
+                error = CsvError{reader.line(), "expected " + std::to_string(width) + " fields, got " + std::to_string(fields.size())};
+            } else if (!CsvReader::parse_unsigned(fields[columns[3]], row.stop)) {
+                error = CsvError{reader.line(), "invalid stop ID '" + std::string(fields[columns[3]]) + "'"};
+            } else if (!CsvReader::parse_unsigned(fields[columns[4]], sequence) || sequence > npos) {
+                error = CsvError{reader.line(), "invalid stop_sequence '" + std::string(fields[columns[4]]) + "'"};
+            } else if (!parse_time(fields[columns[1]], row.arrival) || !parse_time(fields[columns[2]], row.departure)) {
+                error = CsvError{reader.line(), "invalid time"};
+            } else if (row.departure < row.arrival) {
+                error = CsvError{reader.line(), "departure before arrival"};
+            } else {
+                row.sequence = static_cast<uint32_t>(sequence);
+                row.trip = trip_index.emplace(std::string(fields[columns[0]]), static_cast<uint32_t>(trip_index.size())).first->second;
+                rows.push_back(row);
+                continue;
+            }
+        }
+        report(error);
+    }
+    trips = static_cast<uint32_t>(trip_index.size());
+    std::sort(rows.begin(), rows.end(), [](const StopTime& a, const StopTime& b) {
+        return a.trip != b.trip ? a.trip < b.trip : a.sequence != b.sequence ? a.sequence < b.sequence : a.line < b.line;
+    });
+
+    // Dense stop indices: every stop of a trip or a footpath.
+    stop_ids.reserve(rows.size() + 2 * footpaths.size());
+    for (const StopTime& row : rows) {
+        stop_ids.push_back(row.stop);
+    }
+    for (const Footpath& footpath : footpaths) {
+        stop_ids.push_back(footpath.from);
+        stop_ids.push_back(footpath.to);
+    }
+    std::sort(stop_ids.begin(), stop_ids.end());
+    stop_ids.erase(std::unique(stop_ids.begin(), stop_ids.end()), stop_ids.end());
+    stop_ids.shrink_to_fit();
+    auto dense = [this](uint64_t id) {
+        return static_cast<uint32_t>(std::lower_bound(stop_ids.begin(), stop_ids.end(), id) - stop_ids.begin());
+    };
+
+    // Connections in trip order, each linked to the next one of its trip.
+    std::vector<Connection> by_trip;
+    std::vector<uint32_t> next_by_trip;
+    by_trip.reserve(rows.size());
+    next_by_trip.reserve(rows.size());
+    bool linked = false;  // Whether the previous pair of rows of the trip became the last connection
+    uint32_t trip = 0;
+    for (size_t i = 0; i + 1 < rows.size(); ++i) {
+        const StopTime& from = rows[i];
+        const StopTime& to = rows[i + 1];
+        const bool starts = i == 0 || rows[i - 1].trip != from.trip;
+        if (from.trip != to.trip) {
+            continue;
+        }
+        if (from.sequence == to.sequence) {
+            report(CsvError{to.line, "duplicate stop_sequence"});
+            linked = false;
+            continue;
+        }
+        if (to.arrival < from.departure) {
+            report(CsvError{to.line, "arrival before the departure from the previous stop"});
+            linked = false;
+            continue;
+        }
+        if (starts) {
+            trip = from.trip;
+        } else if (!linked) {
+            trip = trips++;  // The rest of a trip broken by a bad row runs as a trip of its own
+        } else {
+            next_by_trip.back() = static_cast<uint32_t>(by_trip.size());
+        }
+        by_trip.push_back(Connection{from.departure, to.arrival, dense(from.stop), dense(to.stop), trip});
+        next_by_trip.push_back(npos);
+        linked = true;
+    }
+
+    // Scan order: by departure, then arrival; the stable sort keeps trip order for the ties.
+    std::vector<uint32_t> order(by_trip.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&by_trip](uint32_t a, uint32_t b) {
+        return by_trip[a].departure != by_trip[b].departure ? by_trip[a].departure < by_trip[b].departure : by_trip[a].arrival < by_trip[b].arrival;
+    });
+    std::vector<uint32_t> position(order.size());
+    for (uint32_t i = 0; i < order.size(); ++i) {
+        position[order[i]] = i;
+    }
+    connections.resize(order.size());
+    next_in_trip.resize(order.size());
+    for (uint32_t i = 0; i < order.size(); ++i) {
+        connections[i] = by_trip[order[i]];
+        next_in_trip[i] = next_by_trip[order[i]] == npos ? npos : position[next_by_trip[order[i]]];
+    }
+
+    build_footpaths(footpaths);
+}
+
+/**
+ * @brief Indexes the footpaths by stop, closed transitively.
+ *
+ * Runs a Dijkstra search over the footpaths from every stop that has one; the search stays inside
+ * the group of platforms linked to the stop, so the closure costs little on transit networks.
+ *
+ * @param footpaths The transfers between stops, all of them part of stop_ids.
+ */
+void Timetable::build_footpaths(const std::vector<Footpath>& footpaths) {
+    const uint32_t stops = stop_count();
+    std::vector<std::vector<std::pair<uint32_t, uint32_t>>> direct(stops);
+    for (const Footpath& footpath : footpaths) {
+        const uint32_t from = index_of(footpath.from, "build_footpaths");
+        const uint32_t to = index_of(footpath.to, "build_footpaths");
+        if (from != to) {
+            direct[from].emplace_back(to, footpath.duration);
+        }
+    }
+
+    std::vector<uint32_t> distance(stops, unreachable);
+    std::vector<uint32_t> reached;
+    std::priority_queue<std::pair<uint32_t, uint32_t>, std::vector<std::pair<uint32_t, uint32_t>>, std::greater<>> queue;
+    footpath_offsets.assign(1, 0);
+    footpath_offsets.reserve(stops + 1);
+    for (uint32_t source = 0; source < stops; ++source) {
+        if (!direct[source].empty()) {
+            distance[source] = 0;
+            reached.push_back(source);
+            queue.emplace(0, source);
+            while (!queue.empty()) {
+                const auto [d, u] = queue.top();
+                queue.pop();
+                if (d != distance[u]) {
+                    continue;
+                }
+                for (const auto& [v, duration] : direct[u]) {
+                    if (d + duration < distance[v]) {
+                        if (distance[v] == unreachable) {
+                            reached.push_back(v);
+                        }
+                        distance[v] = d + duration;
+                        queue.emplace(distance[v], v);
+                    }
+                }
+            }
+            std::sort(reached.begin(), reached.end());
+            for (uint32_t v : reached) {
+                if (v != source) {
+                    footpath_targets.push_back(v);
+                    footpath_durations.push_back(distance[v]);
+                }
+                distance[v] = unreachable;
+            }
+            reached.clear();
+        }
+        footpath_offsets.push_back(static_cast<uint32_t>(footpath_targets.size()));
+    }
+}
+
+/**
+ * @brief Computes the earliest arrival at a stop, leaving another one at a given time.
+ *
+ * @param source The ID of the starting stop.
+ * @param target The ID of the destination stop.
+ * @param departure The earliest time the journey may leave.
+ * @return The journey arriving first, no segments and max() times if the destination cannot be reached.
+ * @throws std::runtime_error if either stop is not part of the timetable.
+ */
+TimedJourney Timetable::earliest_arrival(uint64_t source, uint64_t target, uint32_t departure) const {
+    const uint32_t s = index_of(source, "earliest_arrival");
+    const uint32_t t = index_of(target, "earliest_arrival");
+    return scan_earliest_arrival(ArrayRef<uint32_t>(&s, 1), ArrayRef<uint32_t>(&t, 1), departure);
+}
+
+/**
+ * @brief Computes the earliest arrival at any of several stops, leaving any of several others at a given time.
+ *
+ * @param sources The IDs of the possible starting stops.
+ * @param targets The IDs of the possible destination stops.
+ * @param departure The earliest time the journey may leave.
+ * @return The journey arriving first at a target, no segments and max() times if none can be reached.
+ * @throws std::runtime_error if a list is empty or a stop is not part of the timetable.
+ */
+TimedJourney Timetable::earliest_arrival(const std::vector<uint64_t>& sources, const std::vector<uint64_t>& targets, uint32_t departure) const {
+    if (sources.empty() || targets.empty()) {
+        throw std::runtime_error("No starting or destination stop (earliest_arrival)");
+    }
+    std::vector<uint32_t> s(sources.size()), t(targets.size());
+    for (size_t i = 0; i < sources.size(); ++i) {
+        s[i] = index_of(sources[i], "earliest_arrival");
+    }
+    for (size_t i = 0; i < targets.size(); ++i) {
+        t[i] = index_of(targets[i], "earliest_arrival");
+    }
+    return scan_earliest_arrival(s, t, departure);
+}
+
+/**
+ * @brief Runs the earliest arrival scan between sets of dense stop indices.
+ *
+ * Forward connection scan: a connection is usable if its trip was boarded earlier or its departure
+ * stop is reached in time; using it may improve the arrival at its arrival stop and, through the
+ * footpaths, at the neighbouring platforms. Each stop remembers the ride or the footpath that
+ * reached it last, from which the route is rebuilt backwards. Leading footpaths are then shifted
+ * to end when the first ride leaves, so the journey does not wait on a platform. The scan stops
+ * once connections leave after the earliest arrival at a target.
+ *
+ * @param sources The stops left at the departure time.
+ * @param targets The stops the scan stops at.
+ * @param departure The earliest time the journey may leave.
+ * @return The journey arriving first at a target.
+ */
+TimedJourney Timetable::scan_earliest_arrival(ArrayRef<uint32_t> sources, ArrayRef<uint32_t> targets, uint32_t departure) const {
+    ScanContext& context = scan_context();
+    context.prepare(stop_count(), trips);
+    const uint32_t generation = context.generation;
+    auto arrival_at = [&context, generation](uint32_t stop) {
+        return context.stop_stamp[stop] == generation ? context.arrival[stop] : unreachable;
+    };
+    // The target reached first so far, npos until one is.
+    uint32_t t = npos;
+    uint32_t best = unreachable;
+    auto reach = [&](uint32_t stop, uint32_t time, uint32_t enter, uint32_t exit) {
+        context.stop_stamp[stop] = generation;
+        context.arrival[stop] = time;
+        context.enter[stop] = enter;
+        context.exit[stop] = exit;
+        if (time < best && std::find(targets.begin(), targets.end(), stop) != targets.end()) {
+            t = stop;
+            best = time;
+        }
+    };
+    auto walk_from = [&](uint32_t stop, uint32_t time) {
+        for (uint32_t f = footpath_offsets[stop]; f < footpath_offsets[stop + 1]; ++f) {
+            if (time + footpath_durations[f] < arrival_at(footpath_targets[f])) {
+                reach(footpath_targets[f], time + footpath_durations[f], npos, stop);
+            }
+        }
+    };
+
+    for (uint32_t s : sources) {
+        reach(s, departure, npos, npos);
+    }
+    for (uint32_t s : sources) {
+        walk_from(s, departure);
+    }
+    const auto first = std::lower_bound(connections.begin(), connections.end(), departure,
+                                        [](const Connection& c, uint32_t time) { return c.departure < time; });
+    for (uint32_t i = static_cast<uint32_t>(first - connections.begin()); i < connections.size(); ++i) {
+        const Connection& c = connections[i];
+        if (c.departure >= best) {
+            break;
+        }
+        if (context.trip_stamp[c.trip] != generation) {
+            if (arrival_at(c.from) > c.departure) {
+                continue;
+            }
+            context.trip_stamp[c.trip] = generation;
+            context.trip_value[c.trip] = i;
+        }
+        if (c.arrival < arrival_at(c.to)) {
+            reach(c.to, c.arrival, context.trip_value[c.trip], i);
+            walk_from(c.to, c.arrival);
+        }
+    }
+
+    TimedJourney journey;
+    if (t == npos) {
+        return journey;
+    }
+    // The rides and footpaths from the destination back to the start.
+    struct Leg {
+        uint32_t enter, exit, to;
+    };
+    std::vector<Leg> legs;
+    for (uint32_t stop = t; context.enter[stop] != npos || context.exit[stop] != npos;) {
+        legs.push_back(Leg{context.enter[stop], context.exit[stop], stop});
+        stop = context.enter[stop] != npos ? connections[context.enter[stop]].from : context.exit[stop];
+    }
+
+    uint32_t time = departure;
+    size_t first_ride = legs.size() + 1;
+    for (auto leg = legs.rbegin(); leg != legs.rend(); ++leg) {
+        if (leg->enter == npos) {
+            const uint32_t duration = footpath_duration(leg->exit, leg->to);
+            journey.segments.emplace_back(stop_ids[leg->exit], stop_ids[leg->to]);
+            journey.times.emplace_back(time, time + duration);
+            time += duration;
+            continue;
+        }
+        if (first_ride > legs.size()) {
+            first_ride = journey.times.size();
+        }
+        for (uint32_t c = leg->enter;; c = next_in_trip[c]) {
+            journey.segments.emplace_back(stop_ids[connections[c].from], stop_ids[connections[c].to]);
+            journey.times.emplace_back(connections[c].departure, connections[c].arrival);
+            if (c == leg->exit) {
+                break;
+            }
+        }
+        time = connections[leg->exit].arrival;
+    }
+    if (first_ride <= legs.size()) {
+        // Walk to the first ride as late as possible.
+        uint32_t end = journey.times[first_ride].first;
+        for (size_t j = first_ride; j-- > 0;) {
+            const uint32_t duration = journey.times[j].second - journey.times[j].first;
+            journey.times[j] = {end - duration, end};
+            end -= duration;
+        }
+    }
+    journey.departure = journey.times.empty() ? departure : journey.times.front().first;
+    journey.arrival = best;
+    return journey;
+}
+
+/**
+ * @brief Computes every useful departure of a time window in one backward scan.
+ *
+ * A forward scan from the end of the window first bounds the arrivals; connections are then
+ * scanned from the last one leaving before that bound down to the first leaving at the start of
+ * the window.
+ * The arrival at the destination when taking a connection is the best of staying on its trip,
+ * which the later connections of the trip already know, and of getting off, possibly walking to
+ * another platform, and taking the best later departure there. Each stop keeps its (departure,
+ * arrival) pairs by decreasing departure and strictly decreasing arrival, so a new pair is only
+ * appended, and a lookup is a binary search.
+ *
+ * @param source The ID of the starting stop.
+ * @param target The ID of the destination stop.
+ * @param earliest The start of the window.
+ * @param latest The end of the window, included.
+ * @return The Pareto-optimal journeys, by increasing departure.
+ * @throws std::runtime_error if either stop is not part of the timetable.
+ */
+std::vector<TimedJourney> Timetable::profile(uint64_t source, uint64_t target, uint32_t earliest, uint32_t latest) const {
+    const uint32_t s = index_of(source, "profile");
+    const uint32_t t = index_of(target, "profile");
+    std::vector<TimedJourney> journeys;
+    if (earliest > latest) {
+        return journeys;
+    }
+    // Walking beats any ride from a platform of the destination station.
+    const uint32_t walk = s == t ? 0 : footpath_duration(s, t);
+    if (walk != unreachable) {
+        journeys.emplace_back();
+        journeys.back().departure = earliest;
+        journeys.back().arrival = earliest + walk;
+        return journeys;
+    }
+    // Leaving earlier never arrives later, so no journey of the window arrives after the earliest
+    // arrival leaving at its end, and no connection leaving after that can take part in one.
+    const uint32_t bound = earliest_arrival(source, target, latest).arrival;
+    ScanContext& context = scan_context();
+    context.prepare(stop_count(), trips);
+    const uint32_t generation = context.generation;
+    // The earliest arrival at the destination leaving a stop at or after a time.
+    auto arrival_from = [&context, generation, t](uint32_t stop, uint32_t time) {
+        if (stop == t) {
+            return time;
+        }
+        if (context.stop_stamp[stop] != generation) {
+            return unreachable;
+        }
+        const auto& pairs = context.profiles[stop];
+        const auto after = std::partition_point(pairs.begin(), pairs.end(), [time](const std::pair<uint32_t, uint32_t>& pair) {
+            return pair.first >= time;
+        });
+        return after == pairs.begin() ? unreachable : std::prev(after)->second;
+    };
+
+    const auto first = std::lower_bound(connections.begin(), connections.end(), earliest,
+                                        [](const Connection& c, uint32_t time) { return c.departure < time; });
+    const auto last = std::upper_bound(first, connections.end(), bound,
+                                       [](uint32_t time, const Connection& c) { return time < c.departure; });
+    const uint32_t end = static_cast<uint32_t>(first - connections.begin());
+    for (uint32_t i = static_cast<uint32_t>(last - connections.begin()); i-- > end;) {
+        const Connection& c = connections[i];
+        uint32_t arrival = arrival_from(c.to, c.arrival);
+        for (uint32_t f = footpath_offsets[c.to]; f < footpath_offsets[c.to + 1]; ++f) {
+            arrival = std::min(arrival, arrival_from(footpath_targets[f], c.arrival + footpath_durations[f]));
+        }
+        if (context.trip_stamp[c.trip] == generation) {
+            arrival = std::min(arrival, context.trip_value[c.trip]);
+        }
+        if (arrival == unreachable) {
+            continue;
+        }
+        context.trip_stamp[c.trip] = generation;
+        context.trip_value[c.trip] = arrival;
+
+        auto& pairs = context.profiles[c.from];
+        if (context.stop_stamp[c.from] != generation) {
+            context.stop_stamp[c.from] = generation;
+            pairs.clear();
+        }
+        if (pairs.empty() || arrival < pairs.back().second) {
+            if (!pairs.empty() && pairs.back().first == c.departure) {
+                pairs.back().second = arrival;
+            } else {
+                pairs.emplace_back(c.departure, arrival);
+            }
+        }
+    }
+
+    // Departures from the source itself, or walking to another platform first.
+    std::vector<std::pair<uint32_t, uint32_t>> candidates;
+    if (context.stop_stamp[s] == generation) {
+        candidates = context.profiles[s];
+    }
+    for (uint32_t f = footpath_offsets[s]; f < footpath_offsets[s + 1]; ++f) {
+        const uint32_t stop = footpath_targets[f];
+        if (context.stop_stamp[stop] == generation) {
+            for (const auto& pair : context.profiles[stop]) {
+                if (pair.first >= footpath_durations[f]) {
+                    candidates.emplace_back(pair.first - footpath_durations[f], pair.second);
+                }
+            }
+        }
+    }
+    std::sort(candidates.begin(), candidates.end(), [](const std::pair<uint32_t, uint32_t>& a, const std::pair<uint32_t, uint32_t>& b) {
+        return a.first != b.first ? a.first > b.first : a.second < b.second;
+    });
+    // A departure of the window is only useful if no later one arrives as early, even after the window.
+    uint32_t best = unreachable;
+    for (const auto& pair : candidates) {
+        if (pair.first < earliest || pair.second >= best) {
+            continue;
+        }
+        best = pair.second;
+        if (pair.first <= latest) {
+            journeys.emplace_back();
+            journeys.back().departure = pair.first;
+            journeys.back().arrival = pair.second;
+        }
+    }
+    std::reverse(journeys.begin(), journeys.end());
+    return journeys;
+}
+
+/**
+ * @brief Finds the dense index of a stop.
+ * @param id The stop ID.
+ * @param caller The name of the query, for the error message.
+ * @return The dense index.
+ * @throws std::runtime_error if the stop is not part of the timetable.
+ */
+uint32_t Timetable::index_of(uint64_t id, const char* caller) const {
+    const auto it = std::lower_bound(stop_ids.begin(), stop_ids.end(), id);
+    if (it == stop_ids.end() || *it != id) {
+        throw std::runtime_error("Stop not in the timetable: " + std::to_string(id) + " (Timetable::" + caller + ")");
+    }
+    return static_cast<uint32_t>(it - stop_ids.begin());
+}
+
+/**
+ * @brief Gets the duration of the footpath between two stops.
+ * @param from The dense index of the stop left.
+ * @param to The dense index of the stop reached.
+ * @return The walking time in seconds, unreachable if there is no footpath.
+ */
+uint32_t Timetable::footpath_duration(uint32_t from, uint32_t to) const {
+    const auto begin = footpath_targets.begin() + footpath_offsets[from];
+    const auto end = footpath_targets.begin() + footpath_offsets[from + 1];
+    const auto it = std::lower_bound(begin, end, to);
+    return it == end || *it != to ? unreachable : footpath_durations[it - footpath_targets.begin()];
+}
+
+/**
+ * @brief Parses a H:MM:SS time.
+ * @param text The time, hours possibly above 23.
+ * @param seconds Receives the seconds after midnight.
+ * @return False if the text is not a valid time.
+ */
+bool Timetable::parse_time(std::string_view text, uint32_t& seconds) {
+    const size_t first = text.find(':');
+    const size_t second = first == std::string_view::npos ? first : text.find(':', first + 1);
+    if (second == std::string_view::npos) {
+        return false;
+    }
+    uint64_t hours = 0, minutes = 0, rest = 0;
+    if (!CsvReader::parse_unsigned(text.substr(0, first), hours) || hours > 1000 ||
+        !CsvReader::parse_unsigned(text.substr(first + 1, second - first - 1), minutes) || minutes > 59 ||
+        !CsvReader::parse_unsigned(text.substr(second + 1), rest) || rest > 59) {
+        return false;
+    }
+    seconds = static_cast<uint32_t>(hours * 3600 + minutes * 60 + rest);
+    return true;
+}
+
+/**
+ * @brief Formats a time as HH:MM:SS.
+ * @param seconds The seconds after midnight.
+ * @return The formatted time.
+ */
+std::string Timetable::format_time(uint32_t seconds) {
+    char text[16];
+    std::snprintf(text, sizeof(text), "%02u:%02u:%02u", seconds / 3600, seconds / 60 % 60, seconds % 60);
+    return text;
+}
+
+} // namespace travel
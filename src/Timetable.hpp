@@ -0,0 +1,214 @@
+/**
+ * @file Timetable.hpp
+ * @brief Contains the declaration of the Timetable class.
+ */
+
+#pragma once
+#ifndef TIMETABLE_HPP
+#define TIMETABLE_HPP
+
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "ArrayRef.hpp"
+#include "CsvReader.hpp"
+
+namespace travel {
+
+    /**
+     * @brief The result of a timed journey query.
+     *
+     * Times are seconds after midnight of the service day; they may exceed 24 hours for trips
+     * running past midnight, like in GTFS.
+     */
+    struct TimedJourney {
+        std::vector<std::pair<uint64_t, uint64_t>> segments;  /**< The (station, station) segments of the route, in travel order. */
+        std::vector<std::pair<uint32_t, uint32_t>> times;  /**< The (departure, arrival) times of each segment. */
+        uint32_t departure = std::numeric_limits<uint32_t>::max();  /**< The time the journey leaves the start, max() if unreachable. */
+        uint32_t arrival = std::numeric_limits<uint32_t>::max();  /**< The time the journey reaches the destination, max() if unreachable. */
+    };
+
+    /**
+     * @class Timetable
+     * @brief Time-dependent routing on scheduled trips with the Connection Scan Algorithm.
+     *
+     * A connection is one vehicle ride between two consecutive stops of a trip, with its departure
+     * and arrival times. All connections live in one contiguous array sorted by departure time, the
+     * order both queries scan it in; each connection also links to the next connection of its trip,
+     * so the rides of a trip can be walked in stop order when a journey is rebuilt.
+     *
+     * Footpaths are the transfers between platforms, with fixed durations. They are closed
+     * transitively when the timetable is built, so a scan only ever relaxes a single footpath.
+     *
+     * An earliest arrival query scans forward from the first connection leaving after the departure
+     * time and stops as soon as the next connection leaves after the best known arrival. A profile
+     * query scans backward once and keeps, for every stop, the Pareto set of (departure, arrival)
+     * pairs to the destination, which gives every useful departure of a whole time window.
+     *
+     * Stop IDs are the station IDs of the static network. The timetable is immutable once built and
+     * safe to share between threads; each thread keeps its own scratch labels.
+     */
+    class Timetable {
+    public:
+        static const uint32_t unreachable; /**< The arrival time of a stop that cannot be reached. */
+
+        /**
+         * @brief A transfer between two stops, taken at any time.
+         */
+        struct Footpath {
+            uint64_t from = 0;  /**< The ID of the stop the footpath leaves from. */
+            uint64_t to = 0;  /**< The ID of the stop the footpath leads to. */
+            uint32_t duration = 0;  /**< The walking time in seconds. */
+        };
+
+        /**
+         * @brief Constructs an empty timetable.
+         */
+        Timetable() = default;
+
+        /**
+         * @brief Reads the trips of a GTFS stop_times file and indexes them with the footpaths.
+         *
+         * The file needs the trip_id, arrival_time, departure_time, stop_id and stop_sequence
+         * columns, in any order; other columns are ignored. Times are H:MM:SS and may exceed 24 hours.
+         *
+         * @param stop_times_filename The stop_times CSV file.
+         * @param footpaths The transfers between stops.
+         * @param errors Receives the malformed rows, which are skipped, if not null.
+         * @throws std::runtime_error if the file cannot be read or lacks a required column.
+         */
+        Timetable(const std::string& stop_times_filename, const std::vector<Footpath>& footpaths, std::vector<CsvError>* errors = nullptr);
+
+        /**
+         * @brief Computes the earliest arrival at a stop, leaving another one at a given time.
+         * @param source The ID of the starting stop.
+         * @param target The ID of the destination stop.
+         * @param departure The earliest time the journey may leave.
+         * @return The journey arriving first, no segments and max() times if the destination cannot be reached.
+         * @throws std::runtime_error if either stop is not part of the timetable.
+         */
+        TimedJourney earliest_arrival(uint64_t source, uint64_t target, uint32_t departure) const;
+
+        /**
+         * @brief Computes the earliest arrival at any of several stops, leaving any of several others at a given time.
+         *
+         * One scan seeded with every source, stopped once no connection can improve on the first
+         * target reached, like the platforms of two stop areas.
+         *
+         * @param sources The IDs of the possible starting stops.
+         * @param targets The IDs of the possible destination stops.
+         * @param departure The earliest time the journey may leave.
+         * @return The journey arriving first at a target, no segments and max() times if none can be reached.
+         * @throws std::runtime_error if a list is empty or a stop is not part of the timetable.
+         */
+        TimedJourney earliest_arrival(const std::vector<uint64_t>& sources, const std::vector<uint64_t>& targets, uint32_t departure) const;
+
+        /**
+         * @brief Computes every useful departure of a time window in one backward scan.
+         *
+         * A departure is useful when no later departure, even after the window, arrives as early. The
+         * journeys only carry their departure and arrival times; earliest_arrival at a departure
+         * rebuilds its route. When the destination is a footpath away, the walk is the only journey,
+         * leaving at the start of the window.
+         *
+         * @param source The ID of the starting stop.
+         * @param target The ID of the destination stop.
+         * @param earliest The start of the window.
+         * @param latest The end of the window, included.
+         * @return The Pareto-optimal journeys, by increasing departure.
+         * @throws std::runtime_error if either stop is not part of the timetable.
+         */
+        std::vector<TimedJourney> profile(uint64_t source, uint64_t target, uint32_t earliest, uint32_t latest) const;
+
+        /**
+         * @brief Gets the number of stops served by a trip or a footpath.
+         * @return The number of stops.
+         */
+        uint32_t stop_count() const { return static_cast<uint32_t>(stop_ids.size()); }
+
+        /**
+         * @brief Gets the number of trips.
+         * @return The number of trips; a trip broken by a malformed row counts once per part.
+         */
+        uint32_t trip_count() const { return trips; }
+
+        /**
+         * @brief Gets the number of connections.
+         * @return The number of rides between consecutive stops.
+         */
+        uint32_t connection_count() const { return static_cast<uint32_t>(connections.size()); }
+
+        /**
+         * @brief Parses a H:MM:SS time.
+         * @param text The time, hours possibly above 23.
+         * @param seconds Receives the seconds after midnight.
+         * @return False if the text is not a valid time.
+         */
+        static bool parse_time(std::string_view text, uint32_t& seconds);
+
+        /**
+         * @brief Formats a time as HH:MM:SS.
+         * @param seconds The seconds after midnight.
+         * @return The formatted time.
+         */
+        static std::string format_time(uint32_t seconds);
+
+    private:
+        /**
+         * @brief One ride of a trip, as scanned by the queries.
+         */
+        struct Connection {
+            uint32_t departure;  /**< The departure time from `from`. */
+            uint32_t arrival;  /**< The arrival time at `to`. */
+            uint32_t from;  /**< The dense index of the stop left. */
+            uint32_t to;  /**< The dense index of the stop reached. */
+            uint32_t trip;  /**< The dense index of the trip. */
+        };
+
+        /**
+         * @brief Finds the dense index of a stop.
+         * @param id The stop ID.
+         * @param caller The name of the query, for the error message.
+         * @return The dense index.
+         * @throws std::runtime_error if the stop is not part of the timetable.
+         */
+        uint32_t index_of(uint64_t id, const char* caller) const;
+
+        /**
+         * @brief Runs the earliest arrival scan between sets of dense stop indices.
+         * @param sources The stops left at the departure time.
+         * @param targets The stops the scan stops at.
+         * @param departure The earliest time the journey may leave.
+         * @return The journey arriving first at a target.
+         */
+        TimedJourney scan_earliest_arrival(ArrayRef<uint32_t> sources, ArrayRef<uint32_t> targets, uint32_t departure) const;
+
+        /**
+         * @brief Indexes the footpaths by stop, closed transitively.
+         * @param footpaths The transfers between stops, all of them part of stop_ids.
+         */
+        void build_footpaths(const std::vector<Footpath>& footpaths);
+
+        /**
+         * @brief Gets the duration of the footpath between two stops.
+         * @param from The dense index of the stop left.
+         * @param to The dense index of the stop reached.
+         * @return The walking time in seconds, unreachable if there is no footpath.
+         */
+        uint32_t footpath_duration(uint32_t from, uint32_t to) const;
+
+        std::vector<uint64_t> stop_ids; /**< The ID of each dense stop index, sorted. */
+        std::vector<Connection> connections; /**< Every ride, by departure time. */
+        std::vector<uint32_t> next_in_trip; /**< The next connection of the same trip, npos after the last stop. */
+        uint32_t trips = 0; /**< The number of trips. */
+        std::vector<uint32_t> footpath_offsets; /**< Footpath range of each stop, stop_count() + 1 entries. */
+        std::vector<uint32_t> footpath_targets; /**< Stop reached by each footpath. */
+        std::vector<uint32_t> footpath_durations; /**< Walking time of each footpath. */
+    };
+}
+
+#endif // TIMETABLE_HPP
@@ -0,0 +1,103 @@
+/**
+ * @file compile_snapshot.cpp
+ * @brief Compiles the station and connection CSV files into a binary network snapshot.
+ */
+
+#include "../src/MetroNetworkParser.hpp"
+#include "../src/ContractionHierarchy.hpp"
+#include "../src/NodeOrder.hpp"
+
+#include <chrono>
+#include <cstring>
+
+/**
+ * @brief Prints the command line usage.
+ * @param program The name of the executable.
+ */
+void usage(const char* program)
+{
+    std::cerr << "Usage: " << program << " <stations.csv> <connections.csv> <output.snapshot> [--order <id|bfs|rcm|hilbert>] [--stops <stops.txt>] [--contraction-hierarchy] [--distance-table] [--hub-labels]\n"
+              << "  --order                  renumber the stations for memory locality: breadth-first, reverse Cuthill-McKee or Hilbert curve\n"
+              << "  --stops                  GTFS stops file with the station coordinates, required by --order hilbert\n"
+              << "  --contraction-hierarchy  also precompute and store the Contraction Hierarchies index\n"
+              << "  --distance-table         also precompute and store the all-pairs distance table\n"
+              << "  --hub-labels             also precompute and store the hub labels\n";
+}
+
+/**
+ * @brief Reads the CSV files, optionally builds the indexes, and writes the snapshot.
+ * @return 0 on success, 1 on error.
+ */
+int main(int argc, char* argv[])
+{
+    bool hierarchy = false, table = false, labels = false;
+    travel::NodeOrder order = travel::NodeOrder::StationId;
+    std::string stops;
+    for (int i = 4; i < argc; ++i)
+    {
+        if (std::strcmp(argv[i], "--order") == 0 && i + 1 < argc && travel::parse_node_order(argv[i + 1], order))
+        {
+            ++i;
+        }
+        else if (std::strcmp(argv[i], "--stops") == 0 && i + 1 < argc)
+        {
+            stops = argv[++i];
+        }
+        else if (std::strcmp(argv[i], "--contraction-hierarchy") == 0)
+        {
+            hierarchy = true;
+        }
+        else if (std::strcmp(argv[i], "--distance-table") == 0)
+        {
+            table = true;
+        }
+        else if (std::strcmp(argv[i], "--hub-labels") == 0)
+        {
+            labels = true;
+        }
+        else
+        {
+            argc = 0;
+        }
+    }
+    if (argc < 4 || (order == travel::NodeOrder::Hilbert && stops.empty()))
+    {
+        usage(argv[0]);
+        return 1;
+    }
+
+    try
+    {
+        auto begin = std::chrono::steady_clock::now();
+        travel::MetroNetworkParser parser(argv[1], argv[2]);
+        if (order != travel::NodeOrder::StationId)
+        {
+            parser.reorder_nodes(order, stops);
+        }
+        if (hierarchy)
+        {
+            parser.build_contraction_hierarchy();
+        }
+        if (table)
+        {
+            parser.build_distance_table();
+        }
+        if (labels)
+        {
+            parser.build_hub_labels();
+        }
+        parser.save_snapshot(argv[3]);
+        auto elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+
+        std::cout << "Wrote " << argv[3] << ": " << parser.get_station_table().size() << " stations, "
+                  << parser.get_graph().node_count() << " nodes, " << parser.get_graph().edge_count() << " connections"
+                  << (hierarchy ? ", with contraction hierarchy" : "") << (table ? ", with distance table" : "")
+                  << (labels ? ", with hub labels" : "") << (order != travel::NodeOrder::StationId ? ", renumbered" : "") << " in " << elapsed << " ms\n";
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,415 @@
+/**
+ * @file generate_network.cpp
+ * @brief Generates large synthetic multi-region networks in the stations and connections CSV schemas,
+ * and optionally as a binary snapshot, for scaling and memory tests.
+ */
+
+#include "../src/MetroNetworkParser.hpp"
+
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <iomanip>
+#include <random>
+
+namespace {
+
+const double pi = 3.14159265358979323846;
+const double region_spacing = 40000;   // Metres between the centres of neighbouring regions
+const double transfer_radius = 500;    // A stop this close to a station of another line joins it
+const uint32_t min_ride = 30, max_ride = 480;  // Ride durations are clamped to the range of c.csv
+const double origin_latitude = 48.85, origin_longitude = 2.35;  // Position of metre (0, 0) in the stops file
+const double metres_per_degree = 111320;   // Along a meridian
+
+/**
+ * @brief Generator settings, from the command line.
+ */
+struct Settings
+{
+    uint32_t regions = 4;           /**< Regions, laid out on a square grid. */
+    uint32_t lines = 16;            /**< Urban lines per region. */
+    uint32_t stops = 30;            /**< Stops per urban line. */
+    uint32_t seed = 1;              /**< Seed of every random choice. */
+};
+
+/**
+ * @brief A station: the platforms of every line stopping within transfer_radius of its position.
+ */
+struct Cluster
+{
+    double x = 0, y = 0;                /**< Position in metres. */
+    uint32_t name = 0;                  /**< Index of the station name. */
+    std::vector<uint64_t> platforms;    /**< Station IDs of the platforms, one per line. */
+    std::vector<uint32_t> lines;        /**< Line of each platform, recorded as soon as the line is routed through. */
+};
+
+/**
+ * @brief Builds the network line by line and streams the two CSV files.
+ *
+ * Each region gets urban lines that cross it along a jittered straight course, with 400 to 1400 m
+ * between stops, so that they meet near the centre like radial metro lines. A stop within
+ * transfer_radius of an existing station of another line joins it, which creates the transfer
+ * clusters; every pair of platforms of a station is then connected both ways by a walking
+ * transfer. Neighbouring regions are linked by regional lines with a stop every 3 to 6 km,
+ * starting and ending at the busiest station of each region.
+ */
+class Generator
+{
+public:
+    Generator(const Settings& settings, std::ostream& stations, std::ostream& connections, std::ostream* stop_positions = nullptr)
+        : settings(settings), stations(stations), connections(connections), stop_positions(stop_positions), random(settings.seed),
+          side(static_cast<uint32_t>(std::ceil(std::sqrt(double(settings.regions))))) {}
+
+    /**
+     * @brief Generates every line, then the transfers.
+     */
+    void run()
+    {
+        stations << "string_name_station,uint32_s_id,string_short_line,string_adress_station,string_desc_line\n";
+        connections << "uint32_from_stop_id,uint32_to_stop_id,uint32_min_transfer_time\n";
+        if (stop_positions)
+        {
+            *stop_positions << "stop_id,stop_lat,stop_lon\n" << std::fixed << std::setprecision(6);
+        }
+        hubs.assign(settings.regions, std::numeric_limits<uint32_t>::max());
+        for (uint32_t region = 0; region < settings.regions; ++region)
+        {
+            for (uint32_t line = 0; line < settings.lines; ++line)
+            {
+                urban_line(region, line);
+            }
+        }
+        uint32_t regional = 0;
+        for (uint32_t region = 0; region < settings.regions; ++region)
+        {
+            if ((region % side) + 1 < side && region + 1 < settings.regions)
+            {
+                regional_line(region, region + 1, regional++);
+            }
+            if (region + side < settings.regions)
+            {
+                regional_line(region, region + side, regional++);
+            }
+        }
+        transfers();
+    }
+
+    uint64_t platform_count() const { return next_id - 1; }
+    uint64_t connection_count() const { return connections_written; }
+    size_t station_count() const { return clusters.size(); }
+
+private:
+    /**
+     * @brief Generates one urban line of a region.
+     * @param region The region.
+     * @param line The line number within the region.
+     */
+    void urban_line(uint32_t region, uint32_t line)
+    {
+        std::uniform_real_distribution<double> angle(0, pi), offset(-1500, 1500), spacing(400, 1400), turn(-0.25, 0.25);
+        const double heading = angle(random);
+        const double lateral = offset(random);
+        const double length = settings.stops * 900.0;
+        double x = centre_x(region) - std::cos(heading) * length / 2 - std::sin(heading) * lateral;
+        double y = centre_y(region) - std::sin(heading) * length / 2 + std::cos(heading) * lateral;
+
+        std::vector<std::pair<double, double>> course;
+        for (uint32_t stop = 0; stop < settings.stops; ++stop)
+        {
+            course.emplace_back(x, y);
+            const double step = spacing(random), direction = heading + turn(random);
+            x += std::cos(direction) * step;
+            y += std::sin(direction) * step;
+        }
+        add_line(region, std::to_string(region + 1) + "-" + std::to_string(line + 1), course, 28.0 / 3.6, 20);
+    }
+
+    /**
+     * @brief Generates a regional line between the hubs of two regions.
+     * @param from The first region.
+     * @param to The second region.
+     * @param number The number of the regional line.
+     */
+    void regional_line(uint32_t from, uint32_t to, uint32_t number)
+    {
+        if (hubs[from] == std::numeric_limits<uint32_t>::max() || hubs[to] == std::numeric_limits<uint32_t>::max())
+        {
+            return;
+        }
+        std::uniform_real_distribution<double> spacing(3000, 6000);
+        const Cluster& a = clusters[hubs[from]];
+        const Cluster& b = clusters[hubs[to]];
+        const double length = std::hypot(b.x - a.x, b.y - a.y);
+        std::vector<std::pair<double, double>> course;
+        for (double at = 0; at < length; at += spacing(random))
+        {
+            course.emplace_back(a.x + (b.x - a.x) * at / length, a.y + (b.y - a.y) * at / length);
+        }
+        course.emplace_back(b.x, b.y);
+        add_line(from, "R" + std::to_string(number + 1), course, 70.0 / 3.6, 40);
+    }
+
+    /**
+     * @brief Writes the platforms of a line and its rides in both directions.
+     * @param region The region named in the addresses of new stations.
+     * @param line The short name of the line.
+     * @param course The positions of the stops, in order.
+     * @param speed The average speed between stops in m/s.
+     * @param dwell The average stop time in seconds.
+     */
+    void add_line(uint32_t region, const std::string& line, const std::vector<std::pair<double, double>>& course,
+                  double speed, double dwell)
+    {
+        const uint32_t line_index = line_count++;
+        std::vector<uint32_t> stops;
+        for (const auto& position : course)
+        {
+            stops.push_back(station_at(position.first, position.second, line_index, region));
+        }
+        const std::string description = "(" + name(clusters[stops.front()].name) + " <-> " + name(clusters[stops.back()].name) + ")";
+
+        std::normal_distribution<double> jitter(1.0, 0.1);
+        uint64_t previous = 0;
+        for (size_t i = 0; i < stops.size(); ++i)
+        {
+            Cluster& cluster = clusters[stops[i]];
+            const uint64_t id = next_id++;
+            cluster.platforms.push_back(id);
+            stations << name(cluster.name) << ',' << id << ',' << line << ",Region " << region + 1 << " - "
+                     << 10000 + cluster.name % 90000 << ',' << description << '\n';
+            if (stop_positions)
+            {
+                *stop_positions << id << ',' << origin_latitude + cluster.y / metres_per_degree << ',' << origin_longitude + cluster.x / (metres_per_degree * std::cos(origin_latitude * pi / 180)) << '\n';
+            }
+            if (previous != 0)
+            {
+                const Cluster& last = clusters[stops[i - 1]];
+                const double ride = std::hypot(cluster.x - last.x, cluster.y - last.y) / speed + dwell;
+                write_connection(previous, id, clamp(ride * jitter(random)));
+                write_connection(id, previous, clamp(ride * jitter(random)));
+            }
+            previous = id;
+        }
+    }
+
+    /**
+     * @brief Finds the station a stop joins, or opens a new one.
+     *
+     * The stop joins the closest station within transfer_radius that the line does not serve yet,
+     * and the line is recorded there at once so that it never stops twice at the same station.
+     *
+     * @param x The position of the stop.
+     * @param y The position of the stop.
+     * @param line The line stopping there.
+     * @param region The region of the line, whose hub is updated.
+     * @return The index of the station.
+     */
+    uint32_t station_at(double x, double y, uint32_t line, uint32_t region)
+    {
+        const int64_t cx = cell(x), cy = cell(y);
+        uint32_t best = std::numeric_limits<uint32_t>::max();
+        double best_distance = transfer_radius;
+        for (int64_t dx = -1; dx <= 1; ++dx)
+        {
+            for (int64_t dy = -1; dy <= 1; ++dy)
+            {
+                auto found = grid.find(key(cx + dx, cy + dy));
+                if (found == grid.end())
+                {
+                    continue;
+                }
+                for (uint32_t candidate : found->second)
+                {
+                    const Cluster& cluster = clusters[candidate];
+                    const double distance = std::hypot(cluster.x - x, cluster.y - y);
+                    if (distance < best_distance && std::find(cluster.lines.begin(), cluster.lines.end(), line) == cluster.lines.end())
+                    {
+                        best = candidate;
+                        best_distance = distance;
+                    }
+                }
+            }
+        }
+        if (best == std::numeric_limits<uint32_t>::max())
+        {
+            best = static_cast<uint32_t>(clusters.size());
+            Cluster cluster;
+            cluster.x = x;
+            cluster.y = y;
+            cluster.name = best;
+            clusters.push_back(cluster);
+            grid[key(cx, cy)].push_back(best);
+        }
+        clusters[best].lines.push_back(line);
+        uint32_t& hub = hubs[region];
+        if (hub == std::numeric_limits<uint32_t>::max() || clusters[best].lines.size() > clusters[hub].lines.size())
+        {
+            hub = best;
+        }
+        return best;
+    }
+
+    /**
+     * @brief Connects every pair of platforms of every station both ways by a walking transfer.
+     *
+     * As in c.csv, about one transfer in six is a cross-platform change of 0 seconds; the others take
+     * 40 to 420 seconds, most of them under two minutes.
+     */
+    void transfers()
+    {
+        std::uniform_int_distribution<uint32_t> kind(0, 5);
+        std::lognormal_distribution<double> walk(std::log(90.0), 0.5);
+        for (const Cluster& cluster : clusters)
+        {
+            for (uint64_t from : cluster.platforms)
+            {
+                for (uint64_t to : cluster.platforms)
+                {
+                    if (from != to)
+                    {
+                        const uint32_t duration = kind(random) == 0 ? 0 : static_cast<uint32_t>(std::min(420.0, std::max(40.0, walk(random))));
+                        write_connection(from, to, duration);
+                    }
+                }
+            }
+        }
+    }
+
+    void write_connection(uint64_t from, uint64_t to, uint32_t duration)
+    {
+        connections << from << ',' << to << ',' << duration << '\n';
+        ++connections_written;
+    }
+
+    /**
+     * @brief Gets the name of a station: two syllable words and its number, unique by construction.
+     * @param index The index of the station.
+     * @return The name.
+     */
+    static std::string name(uint32_t index)
+    {
+        static const char* const first[] = {"Porte", "Place", "Pont", "Gare", "Rue", "Parc", "Quai", "Avenue", "Cour", "Mont"};
+        static const char* const second[] = {"Saint-Martin", "des Lilas", "Royale", "du Nord", "Vieille", "des Arts",
+                                             "de la Paix", "Haute", "du Marche", "des Fleurs", "Neuve", "du Lac"};
+        return std::string(first[index % 10]) + " " + second[(index / 10) % 12] + " " + std::to_string(index);
+    }
+
+    double centre_x(uint32_t region) const { return (region % side) * region_spacing; }
+    double centre_y(uint32_t region) const { return (region / side) * region_spacing; }
+    static int64_t cell(double coordinate) { return static_cast<int64_t>(std::floor(coordinate / transfer_radius)); }
+    static uint64_t key(int64_t x, int64_t y) { return (uint64_t(x) << 32) ^ uint64_t(uint32_t(y)); }
+    static uint32_t clamp(double ride) { return static_cast<uint32_t>(std::min<double>(max_ride, std::max<double>(min_ride, std::lround(ride)))); }
+
+    const Settings& settings;
+    std::ostream& stations;
+    std::ostream& connections;
+    std::ostream* stop_positions;                                 // GTFS stops file of the platform positions, if asked
+    std::mt19937_64 random;
+    const uint32_t side;                                          // Regions per row of the grid
+    std::vector<Cluster> clusters;                                // Every station
+    std::unordered_map<uint64_t, std::vector<uint32_t>> grid;     // Stations by transfer_radius cell
+    std::vector<uint32_t> hubs;                                   // Busiest station of each region
+    uint64_t next_id = 1;
+    uint32_t line_count = 0;
+    uint64_t connections_written = 0;
+};
+
+/**
+ * @brief Prints the command line usage.
+ * @param program The name of the executable.
+ */
+void usage(const char* program)
+{
+    std::cerr << "Usage: " << program << " <stations.csv> <connections.csv> [--regions <n>] [--lines <n>] [--stops <n>] [--seed <n>] [--snapshot <file>] [--coordinates <stops.txt>]\n"
+              << "  --regions      regions on a square grid, linked by regional lines (default 4)\n"
+              << "  --lines        urban lines per region (default 16)\n"
+              << "  --stops        stops per urban line (default 30); platforms = regions x lines x stops + regional stops\n"
+              << "  --seed         seed of the generator (default 1)\n"
+              << "  --snapshot     also load the generated files and write them as a binary snapshot\n"
+              << "  --coordinates  also write the platform positions as a GTFS stops file, for compile_snapshot --order hilbert\n";
+}
+
+} // namespace
+
+/**
+ * @brief Generates the network, writes the CSV files and optionally the snapshot.
+ * @return 0 on success, 1 on error.
+ */
+int main(int argc, char* argv[])
+{
+    Settings settings;
+    std::string snapshot, coordinates;
+    bool ok = argc >= 3;
+    for (int i = 3; ok && i < argc; ++i)
+    {
+        uint32_t* value = nullptr;
+        if (std::strcmp(argv[i], "--regions") == 0)
+            value = &settings.regions;
+        else if (std::strcmp(argv[i], "--lines") == 0)
+            value = &settings.lines;
+        else if (std::strcmp(argv[i], "--stops") == 0)
+            value = &settings.stops;
+        else if (std::strcmp(argv[i], "--seed") == 0)
+            value = &settings.seed;
+        ok = i + 1 < argc;
+        if (ok && value)
+        {
+            *value = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+        }
+        else if (ok && std::strcmp(argv[i], "--snapshot") == 0)
+        {
+            snapshot = argv[++i];
+        }
+        else if (ok && std::strcmp(argv[i], "--coordinates") == 0)
+        {
+            coordinates = argv[++i];
+        }
+        else
+        {
+            ok = false;
+        }
+    }
+    if (!ok || settings.regions == 0 || settings.lines == 0 || settings.stops < 2)
+    {
+        usage(argv[0]);
+        return 1;
+    }
+
+    try
+    {
+        auto begin = std::chrono::steady_clock::now();
+        std::ofstream stations(argv[1]), connections(argv[2]), stops;
+        if (!coordinates.empty())
+        {
+            stops.open(coordinates);
+        }
+        if (!stations || !connections || (!coordinates.empty() && !stops))
+        {
+            throw std::runtime_error("Cannot write the CSV files (generate_network)");
+        }
+        Generator generator(settings, stations, connections, coordinates.empty() ? nullptr : &stops);
+        generator.run();
+        stations.close();
+        connections.close();
+        stops.close();
+        auto elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+        std::cout << "Wrote " << argv[1] << " and " << argv[2] << ": " << generator.platform_count() << " platforms in "
+                  << generator.station_count() << " stations, " << generator.connection_count() << " connections in "
+                  << elapsed << " ms\n";
+
+        if (!snapshot.empty())
+        {
+            begin = std::chrono::steady_clock::now();
+            travel::MetroNetworkParser parser(argv[1], argv[2]);
+            parser.save_snapshot(snapshot);
+            elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+            std::cout << "Wrote " << snapshot << " in " << elapsed << " ms\n";
+        }
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,257 @@
+/**
+ * @file generate_timetable.cpp
+ * @brief Generates a GTFS stop_times file for a network in the stations and connections CSV schemas,
+ * running trips along every line at a fixed headway with the ride durations of the connections.
+ */
+
+#include "../src/MetroNetworkParser.hpp"
+#include "../src/Timetable.hpp"
+
+#include <chrono>
+#include <cstring>
+#include <map>
+#include <set>
+
+namespace {
+
+const size_t max_routes_per_line = 64;  // Bounds the branch combinations walked on a line
+
+/**
+ * @brief Generator settings, from the command line.
+ */
+struct Settings
+{
+    uint32_t first = 5 * 3600 + 30 * 60;    /**< First departure from the start of each route. */
+    uint32_t last = 24 * 3600 + 30 * 60;    /**< Last departure from the start of each route. */
+    uint32_t peak_headway = 180;            /**< Seconds between trips from 07:00 to 09:30 and 16:30 to 19:30. */
+    uint32_t headway = 420;                 /**< Seconds between trips the rest of the day. */
+};
+
+/**
+ * @brief Finds the routes of every line: the longest chains of rides between its platforms.
+ *
+ * A ride is a connection between two platforms of the same line at stations of different names.
+ * Routes start at the platforms no ride of the line leads to, like the termini of the directed
+ * lines of c.csv; on lines ridden both ways between the same platforms they start at the platforms
+ * with a single neighbour, and on loops at the first platform. Every branch makes a route of its own.
+ */
+class RouteFinder
+{
+public:
+    explicit RouteFinder(const travel::MetroNetworkParser& parser) : parser(parser) {}
+
+    /**
+     * @brief Walks every line.
+     * @return The routes, as the station IDs of their stops.
+     */
+    std::vector<std::vector<uint64_t>> run()
+    {
+        const travel::StationTable& stations = parser.get_station_table();
+        std::map<std::string_view, std::vector<uint64_t>> lines;
+        for (uint32_t row = 0; row < stations.size(); ++row)
+        {
+            lines[stations.view(row).line_id].push_back(stations.id(row));
+        }
+        const auto& connections = parser.get_connections_hashmap();
+        for (const auto& line : lines)
+        {
+            rides.clear();
+            std::map<uint64_t, uint32_t> incoming;
+            std::map<uint64_t, std::set<uint64_t>> neighbours;
+            for (uint64_t from : line.second)
+            {
+                auto it = connections.find(from);
+                if (it == connections.end())
+                    continue;
+                const travel::StationView station = stations.view(stations.find(from));
+                for (const auto& connection : it->second)
+                {
+                    uint32_t row = stations.find(connection.first);
+                    if (row == travel::StationTable::npos)
+                        continue;
+                    const travel::StationView next = stations.view(row);
+                    if (next.line_id == station.line_id && next.name != station.name)
+                    {
+                        rides[from].push_back(connection.first);
+                        ++incoming[connection.first];
+                        neighbours[from].insert(connection.first);
+                        neighbours[connection.first].insert(from);
+                    }
+                }
+            }
+            for (auto& ride : rides)
+            {
+                std::sort(ride.second.begin(), ride.second.end());
+            }
+
+            std::vector<uint64_t> starts;
+            for (const auto& ride : rides)
+            {
+                if (!incoming.count(ride.first))
+                    starts.push_back(ride.first);
+            }
+            if (starts.empty())
+            {
+                for (const auto& ride : rides)
+                {
+                    if (neighbours[ride.first].size() == 1)
+                        starts.push_back(ride.first);
+                }
+            }
+            if (starts.empty() && !rides.empty())
+            {
+                starts.push_back(rides.begin()->first);
+            }
+            size_t line_routes = 0;
+            for (uint64_t start : starts)
+            {
+                path.assign(1, start);
+                walk(line_routes);
+            }
+        }
+        return std::move(routes);
+    }
+
+private:
+    /**
+     * @brief Extends the current path along every ride to a platform it does not visit yet.
+     * @param line_routes The routes already found on the line.
+     */
+    void walk(size_t& line_routes)
+    {
+        if (line_routes >= max_routes_per_line)
+            return;
+        bool extended = false;
+        auto it = rides.find(path.back());
+        if (it != rides.end())
+        {
+            for (uint64_t next : it->second)
+            {
+                if (std::find(path.begin(), path.end(), next) != path.end())
+                    continue;
+                extended = true;
+                path.push_back(next);
+                walk(line_routes);
+                path.pop_back();
+            }
+        }
+        if (!extended && path.size() >= 2)
+        {
+            routes.push_back(path);
+            ++line_routes;
+        }
+    }
+
+    const travel::MetroNetworkParser& parser;
+    std::map<uint64_t, std::vector<uint64_t>> rides;    /**< Rides of the current line, by platform. */
+    std::vector<uint64_t> path;                         /**< The route being walked. */
+    std::vector<std::vector<uint64_t>> routes;          /**< The routes found so far. */
+};
+
+/**
+ * @brief Gets the headway at a time of day.
+ * @param settings The generator settings.
+ * @param time The departure time from the start of the route.
+ * @return The seconds until the next departure.
+ */
+uint32_t headway_at(const Settings& settings, uint32_t time)
+{
+    const uint32_t day = time % 86400;
+    const bool peak = (day >= 7 * 3600 && day < 9 * 3600 + 1800) || (day >= 16 * 3600 + 1800 && day < 19 * 3600 + 1800);
+    return std::max<uint32_t>(peak ? settings.peak_headway : settings.headway, 1);
+}
+
+/**
+ * @brief Prints the command line usage.
+ * @param program The name of the executable.
+ */
+void usage(const char* program)
+{
+    std::cerr << "Usage: " << program << " <stations.csv> <connections.csv> <stop_times.csv> [--first HH:MM:SS] [--last HH:MM:SS] [--peak-headway <s>] [--headway <s>]\n"
+              << "  --first         first departure of every route (default 05:30:00)\n"
+              << "  --last          last departure of every route, may exceed 24:00:00 (default 24:30:00)\n"
+              << "  --peak-headway  seconds between trips from 07:00 to 09:30 and 16:30 to 19:30 (default 180)\n"
+              << "  --headway       seconds between trips the rest of the day (default 420)\n";
+}
+
+} // namespace
+
+/**
+ * @brief Reads the network, finds its routes and writes one trip per departure of every route.
+ * @return 0 on success, 1 on error.
+ */
+int main(int argc, char* argv[])
+{
+    Settings settings;
+    bool ok = argc >= 4;
+    for (int i = 4; ok && i < argc; ++i)
+    {
+        ok = i + 1 < argc;
+        if (ok && std::strcmp(argv[i], "--first") == 0)
+            ok = travel::Timetable::parse_time(argv[++i], settings.first);
+        else if (ok && std::strcmp(argv[i], "--last") == 0)
+            ok = travel::Timetable::parse_time(argv[++i], settings.last);
+        else if (ok && std::strcmp(argv[i], "--peak-headway") == 0)
+            settings.peak_headway = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+        else if (ok && std::strcmp(argv[i], "--headway") == 0)
+            settings.headway = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+        else
+            ok = false;
+    }
+    if (!ok || settings.first > settings.last)
+    {
+        usage(argv[0]);
+        return 1;
+    }
+
+    try
+    {
+        auto begin = std::chrono::steady_clock::now();
+        travel::MetroNetworkParser parser(argv[1], argv[2]);
+        const auto& connections = parser.get_connections_hashmap();
+        std::vector<std::vector<uint64_t>> routes = RouteFinder(parser).run();
+
+        std::ofstream out(argv[3]);
+        if (!out)
+        {
+            throw std::runtime_error("Cannot write the stop_times file (generate_timetable)");
+        }
+        out << "trip_id,arrival_time,departure_time,stop_id,stop_sequence\n";
+        uint64_t trips = 0, rows = 0;
+        for (size_t route = 0; route < routes.size(); ++route)
+        {
+            const std::vector<uint64_t>& stops = routes[route];
+            // Stagger the routes so that they do not all leave at the same second.
+            uint32_t departure = settings.first + static_cast<uint32_t>(route * 97 % headway_at(settings, settings.first));
+            for (uint32_t trip = 0; departure <= settings.last; ++trip, departure += headway_at(settings, departure))
+            {
+                uint32_t time = departure;
+                for (size_t stop = 0; stop < stops.size(); ++stop)
+                {
+                    if (stop)
+                    {
+                        time += static_cast<uint32_t>(connections.at(stops[stop - 1]).at(stops[stop]));
+                    }
+                    const std::string text = travel::Timetable::format_time(time);
+                    out << 'R' << route << '_' << trip << ',' << text << ',' << text << ',' << stops[stop] << ',' << stop + 1 << '\n';
+                }
+                ++trips;
+                rows += stops.size();
+            }
+        }
+        out.close();
+        if (!out)
+        {
+            throw std::runtime_error("Cannot write the stop_times file (generate_timetable)");
+        }
+        auto elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+        std::cout << "Wrote " << argv[3] << ": " << routes.size() << " routes, " << trips << " trips, " << rows
+                  << " stop times in " << elapsed << " ms\n";
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}